@@ -33,6 +33,7 @@ typedef enum {
     cps_api_int_obj_INTERFACE=1,//!< db_int_obj_INTERFACE
     cps_api_int_obj_INTERFACE_ADDR,
     cps_api_int_obj_HW_LINK_STATE,
+    cps_api_int_obj_NETLINK_RECONCILE,
 }cps_api_interface_sub_category_t ;
 
 static inline void cps_api_int_if_key_create(
@@ -133,5 +134,15 @@ typedef enum {
     cps_api_if_STRUCT_A_MAX
 }cps_api_if_STRUCT_ATTR;
 
+//cps_api_int_obj_NETLINK_RECONCILE - published once the first kernel dump of a VRF
+//has been reconciled against the warm restart snapshot
+typedef enum {
+    cps_api_if_RECONCILE_A_VRF_NAME=0, //char *
+    cps_api_if_RECONCILE_A_PUBLISHED=1, //uint32_t - objects published (new or changed)
+    cps_api_if_RECONCILE_A_UNCHANGED=2, //uint32_t - objects suppressed as unchanged
+    cps_api_if_RECONCILE_A_DELETED=3, //uint32_t - snapshot objects gone from the kernel
+    cps_api_if_RECONCILE_A_COMPLETE=4, //uint32_t - 1 when all the VRFs are reconciled
+}cps_api_if_RECONCILE_ATTR;
+
 
 #endif /* DB_EVENT_INTERFACE_H_ */
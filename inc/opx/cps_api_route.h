@@ -40,6 +40,7 @@ typedef enum {
     cps_api_if_NEIGH_A_EXPIRE=8, //uint32_t
     cps_api_if_NEIGH_A_FLAGS=9, //uint32_t
     cps_api_if_NEIGH_A_STATE=10, //uint32_t
+    cps_api_if_NEIGH_A_PAGE_COUNT=11, //uint32_t - max objects of a read (get filter only)
     cps_api_if_NEIGH_A_MAX
 }cps_api_if_NEIGH_ATTR;
 
@@ -60,6 +61,7 @@ typedef enum {
     cps_api_if_ROUTE_A_NH=12,
     cps_api_if_ROUTE_A_FAMILY=13,
     cps_api_if_ROUTE_A_RT_TYPE=14,
+    cps_api_if_ROUTE_A_PAGE_COUNT=15, //uint32_t - max objects of a read (get filter only)
     cps_api_if_ROUTE_A_MAX
 }cps_api_if_ROUTE_ATTR;
 
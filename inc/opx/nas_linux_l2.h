@@ -41,6 +41,27 @@ extern "C" {
 
 t_std_error nl_int_update_stp_state(cps_api_object_t obj);
 
+typedef struct {
+    hal_ifindex_t ifindex;  /* Port or LAG interface index */
+    hal_vlan_id_t vlan_id;  /* VLAN of the port, 0 for the port itself */
+    uint8_t state;          /* BASE_STG_INTERFACE_STATE_* */
+} nas_os_stp_port_state_t;
+
+/*
+ * @brief Update the STP state of many (port, VLAN) pairs in the kernel, typically all
+ *        the members of an MSTP instance. Tagged sub-interfaces are resolved once per
+ *        port and the updates are sent in batches.
+ *
+ * @entries - (port, VLAN, state) list
+ * @count   - number of entries
+ * @err     - errno of each entry (0 if programmed, already in the state or not a
+ *            VLAN member), count entries, can be NULL
+ *
+ * @return STD_ERR_OK if all the entries are programmed, otherwise different error code
+ */
+
+t_std_error nl_int_update_stp_state_bulk(const nas_os_stp_port_state_t *entries, size_t count, int *err);
+
 /*
  * @brief Add/Update MAC entry in the kernel
  *
@@ -62,6 +83,35 @@ t_std_error nas_os_mac_update_entry(cps_api_object_t obj);
 
 t_std_error nas_os_mac_change_learning(hal_ifindex_t ifindex,bool enable);
 
+typedef enum {
+    NAS_OS_MAC_LEARN_SCOPE_PORT = 0,    /* Port or LAG only */
+    NAS_OS_MAC_LEARN_SCOPE_TAGGED,      /* Tagged sub-interfaces of the port only */
+    NAS_OS_MAC_LEARN_SCOPE_ALL,         /* Port and all its tagged sub-interfaces */
+} nas_os_mac_learn_scope_t;
+
+typedef struct {
+    hal_ifindex_t ifindex;  /* Bridge port programmed */
+    t_std_error rc;         /* STD_ERR_OK or the kernel error of the port */
+} nas_os_mac_learn_result_t;
+
+/*
+ * @brief Change the MAC learning in the kernel for a port and/or its tagged
+ *        sub-interfaces. All the bridge ports are programmed with one batch of
+ *        netlink messages and the kernel result of each one is returned.
+ *
+ * @ifindex - interface index of the port
+ * @enable  - disable/enable learning
+ * @scope   - bridge ports to be programmed
+ * @results - optional per bridge port results
+ * @count   - in: number of entries in results, out: number of bridge ports
+ *            programmed (may be more than the entries filled in)
+ *
+ * @return STD_ERR_OK if all the bridge ports are updated, otherwise different error code
+ */
+
+t_std_error nas_os_mac_set_learning(hal_ifindex_t ifindex, bool enable, nas_os_mac_learn_scope_t scope,
+                                    nas_os_mac_learn_result_t *results, size_t *count);
+
 /*
  * @brief Get the MAC learning state in the kernel for a given interface
  *
@@ -72,6 +122,26 @@ t_std_error nas_os_mac_change_learning(hal_ifindex_t ifindex,bool enable);
 
 bool nas_os_mac_get_learning(hal_ifindex_t ifindex);
 
+typedef struct {
+    uint64_t depth;             /* Dynamic MACs waiting for their port to forward */
+    uint64_t parked;            /* Dynamic MACs the kernel rejected and were queued */
+    uint64_t replayed;          /* Queued MACs programmed on a forwarding transition */
+    uint64_t replay_failed;     /* Queued MACs the kernel rejected again on replay */
+    uint64_t expired;           /* Queued MACs dropped after the bridge ageing time */
+    uint64_t replays;           /* Forwarding transitions replayed */
+    uint64_t last_replay_us;    /* Time from the forwarding event to the end of the replay */
+    uint64_t max_replay_us;
+    uint64_t total_replay_us;
+} nas_os_mac_pending_stats_t;
+
+/*
+ * @brief Get the counters of the dynamic MACs queued until their port forwards
+ *
+ * @stats - returned counters
+ */
+
+void nas_os_mac_pending_stats_get(nas_os_mac_pending_stats_t *stats);
+
 /*
  * @brief - Get the stp state for an interface
  *
@@ -27,6 +27,8 @@
 #include "std_error_codes.h"
 #include "ds_common_types.h"
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -47,6 +49,10 @@ extern "C" {
 #define NAS_OS_IF_OBJ_ID_RES_START 4
 #define NAS_OS_IF_FLAGS_ID (NAS_OS_IF_OBJ_ID_RES_START) //reserve 4 inside the object for flags
 #define NAS_OS_IF_ALIAS (NAS_OS_IF_OBJ_ID_RES_START+1)
+/* Statistics served by the stats engine, the counters are embedded under the counter attribute id */
+#define NAS_OS_IF_STATS_INTERVAL_MS (NAS_OS_IF_OBJ_ID_RES_START+2) //uint32_t - time between the last two samples
+#define NAS_OS_IF_STATS_DELTA (NAS_OS_IF_OBJ_ID_RES_START+3) //uint64_t - counter increase between the last two samples
+#define NAS_OS_IF_STATS_RATE (NAS_OS_IF_OBJ_ID_RES_START+4) //uint64_t - per second over the samples, bits for the octets
 
 typedef struct _nas_nflog_params {
     uint16_t     hw_protocol;
@@ -56,6 +62,38 @@ typedef struct _nas_nflog_params {
     int          payload_len;
 } nas_nflog_params_t;
 
+/* Packet of a batched NFLOG datagram, payload points into the receive buffer */
+typedef struct _nas_nflog_pkt {
+    uint16_t       hw_protocol;
+    unsigned int   in_ifindex;
+    unsigned int   out_ifindex;
+    const uint8_t *payload;
+    int            payload_len;
+} nas_nflog_pkt_t;
+
+/* NFLOG socket and kernel instance configuration, 0 selects the default */
+typedef struct _nas_nflog_cfg {
+    int          sock_buf_len;      /* socket receive buffer in bytes */
+    uint32_t     copy_range;        /* bytes of each packet copied to user space */
+    uint32_t     nlbufsiz;          /* kernel batch buffer in bytes */
+    uint32_t     qthreshold;        /* packets queued in the kernel before a datagram is sent */
+    uint32_t     flush_timeout_ms;  /* max time a partial batch is held in the kernel */
+} nas_nflog_cfg_t;
+
+#define NL_NFLOG_DEF_SOCK_BUFFER    (4*1024*1024)
+#define NL_NFLOG_DEF_COPY_RANGE     0xff
+#define NL_NFLOG_DEF_NLBUFSIZ       (64*1024)
+#define NL_NFLOG_DEF_QTHRESHOLD     64
+#define NL_NFLOG_DEF_FLUSH_MS       10
+
+typedef struct _nas_nflog_stats {
+    uint64_t     datagrams;         /* datagrams received */
+    uint64_t     packets;           /* packets returned to the caller */
+    uint64_t     dropped;           /* packets lost - sequence gaps and packets not fitting the caller array */
+    uint64_t     overruns;          /* socket receive buffer overruns (ENOBUFS) */
+    uint64_t     errors;            /* malformed or truncated messages */
+} nas_nflog_stats_t;
+
 
 /**
  * @brief : API to delete interface from kernel
@@ -119,6 +157,49 @@ int nas_os_nl_nflog_init ();
 int nas_os_nl_get_nflog_params  (uint8_t *buf, int size,
                                  nas_nflog_params_t *p_nas_nflog_params);
 
+/**
+ * Initializes the NFLOG socket with batched delivery - the kernel queues up to
+ * qthreshold packets (or flush_timeout_ms) into one datagram
+ *
+ * @param cfg socket and kernel queue configuration, NULL for the defaults
+ * @return fd of the socket that is initialized when successful otherwise -1
+ */
+int nas_os_nl_nflog_init_cfg (const nas_nflog_cfg_t *cfg);
+
+/**
+ * Receive one NFLOG datagram and return all the packets carried in it
+ *
+ * @param fd socket returned by nas_os_nl_nflog_init_cfg
+ * @param buf receive buffer, the returned payloads point into it and are
+ *        valid until the buffer is reused
+ * @param size size of buf, should be at least the configured nlbufsiz
+ * @param pkts returned packets
+ * @param max_pkts number of entries in pkts
+ * @return number of packets returned, 0 if none (including a buffer overrun)
+ *         otherwise -1 with errno set
+ */
+int nas_os_nl_nflog_recv (int fd, uint8_t *buf, int size,
+                          nas_nflog_pkt_t *pkts, size_t max_pkts);
+
+/**
+ * Parse all the NFLOG packets of a received datagram
+ *
+ * @param buf received datagram
+ * @param size length of the datagram
+ * @param pkts returned packets, payloads point into buf
+ * @param max_pkts number of entries in pkts
+ * @return number of packets returned
+ */
+int nas_os_nl_nflog_parse (const uint8_t *buf, int size,
+                           nas_nflog_pkt_t *pkts, size_t max_pkts);
+
+/**
+ * Read the NFLOG receive counters
+ *
+ * @param stats returned counters
+ */
+void nas_os_nl_nflog_stats_get (nas_nflog_stats_t *stats);
+
 /**
  * Get the NAS OS object with operational state attribute set from OS interface
  * based on the name provided
@@ -169,6 +250,82 @@ t_std_error nas_os_mgmt_interface_set_attribute(cps_api_object_t obj,cps_api_att
  */
 t_std_error nas_os_get_interface_stats (const char *ifname, cps_api_object_t obj);
 
+/* Interface admin/oper event dampening configuration */
+typedef struct _nas_os_if_damp_cfg {
+    uint32_t hold_down_ms;       /* Coalescing window per interface, 0 (default) disables dampening */
+    uint32_t flap_penalty;       /* Penalty added on every oper status transition */
+    uint32_t suppress_threshold; /* Penalty above which events are suppressed */
+    uint32_t reuse_threshold;    /* Penalty below which suppression is released */
+    uint32_t half_life_ms;       /* Penalty decay half life */
+    uint32_t max_suppress_ms;    /* Maximum time an interface stays suppressed */
+} nas_os_if_damp_cfg_t;
+
+/* Interface admin/oper event dampening counters */
+typedef struct _nas_os_if_damp_stats {
+    uint64_t transitions;        /* Admin/oper transitions received from kernel */
+    uint64_t published;          /* Transitions published (incl. final state) */
+    uint64_t suppressed;         /* Transitions coalesced or suppressed */
+    uint32_t penalty;            /* Current decayed penalty */
+    bool     is_suppressed;      /* Interface currently suppressed */
+} nas_os_if_damp_stats_t;
+
+/**
+ * Set the admin/oper event dampening configuration used for all interfaces
+ *
+ * @param cfg the dampening configuration
+ * @return STD_ERR_OK if successful otherwise an error code
+ */
+t_std_error nas_os_if_damp_config_set (const nas_os_if_damp_cfg_t *cfg);
+
+/**
+ * Get the admin/oper event dampening configuration
+ *
+ * @param cfg the returned dampening configuration
+ * @return STD_ERR_OK if successful otherwise an error code
+ */
+t_std_error nas_os_if_damp_config_get (nas_os_if_damp_cfg_t *cfg);
+
+/**
+ * Get the admin/oper event dampening counters for an interface
+ *
+ * @param ifindex the kernel interface index
+ * @param stats the returned counters
+ * @return STD_ERR_OK if successful otherwise an error code
+ */
+t_std_error nas_os_if_damp_stats_get (hal_ifindex_t ifindex, nas_os_if_damp_stats_t *stats);
+
+/**
+ * Clear the admin/oper event dampening counters for an interface
+ *
+ * @param ifindex the kernel interface index
+ * @return STD_ERR_OK if successful otherwise an error code
+ */
+t_std_error nas_os_if_damp_stats_clear (hal_ifindex_t ifindex);
+
+/* Interface statistics engine configuration */
+typedef struct _nas_os_if_stats_cfg {
+    uint32_t interval_ms;        /* Sampling interval, 0 stops the engine and reads the kernel on each get */
+    uint32_t ring_len;           /* Samples kept per interface for the rates, at least 2 */
+} nas_os_if_stats_cfg_t;
+
+/**
+ * Set the interface statistics engine configuration. While it runs the
+ * statistics of all the interfaces are sampled in the background and
+ * nas_os_get_interface_stats returns the last sample with the deltas and rates.
+ *
+ * @param cfg the engine configuration
+ * @return STD_ERR_OK if successful otherwise an error code
+ */
+t_std_error nas_os_if_stats_config_set (const nas_os_if_stats_cfg_t *cfg);
+
+/**
+ * Get the interface statistics engine configuration
+ *
+ * @param cfg the returned engine configuration
+ * @return STD_ERR_OK if successful otherwise an error code
+ */
+t_std_error nas_os_if_stats_config_get (nas_os_if_stats_cfg_t *cfg);
+
 /**
  *  \}
  */
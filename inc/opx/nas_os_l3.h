@@ -23,12 +23,30 @@
 #define NAS_OS_L3_H_
 
 #include "cps_api_object.h"
+#include "ds_common_types.h"
 #include "std_error_codes.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* To support the IPv6 route with 256 NHs - 8K buffer is required */
+#define NL_RT_MSG_BUFFER_LEN  8192 /* Buffer len to update the route to kernel */
+#define NL_RT_RMSG_BUFFER_LEN 1024 /* Buffer len to receive reply for the route from kernel */
+
+/*
+ * Route encode buffers - the route APIs keep no state of their own, so they
+ * can be called concurrently as long as every thread passes its own buffers.
+ */
+typedef struct {
+    char msg[NL_RT_MSG_BUFFER_LEN];      /* netlink route request */
+    char reply[NL_RT_RMSG_BUFFER_LEN];   /* kernel reply */
+} nas_os_rt_encode_buf_t;
+
 /**
  * @brief This adds an IPv4/v6 unicast route in kernel
  *
@@ -65,6 +83,68 @@ t_std_error nas_os_set_route (cps_api_object_t obj);
  */
 t_std_error nas_os_update_route_nexthop (cps_api_object_t obj);
 
+/**
+ * @brief Reentrant variants of the route APIs above, encoding into the
+ *        caller provided buffers. The variants without buffers use a buffer
+ *        on the stack of the calling thread.
+ *
+ * @param obj CPS API object which contains route params
+ * @param buf encode buffers owned by the calling thread
+ *
+ * @return STD_ERR_OK if successful, otherwise different error code
+ */
+t_std_error nas_os_add_route_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf);
+
+t_std_error nas_os_del_route_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf);
+
+t_std_error nas_os_set_route_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf);
+
+t_std_error nas_os_update_route_nexthop_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf);
+
+/* Route batch result, see nas_os_route_batch_r() */
+typedef struct {
+    uint32_t added;         /* route not known to be in the kernel */
+    uint32_t replaced;      /* kernel had the route with different next hops */
+    uint32_t skipped;       /* kernel has the same route, nothing sent */
+    uint32_t deleted;
+    uint32_t failed;
+} nas_os_rt_batch_stats_t;
+
+/**
+ * @brief Enable/disable the idempotent route programming. When enabled, a
+ *        route add/set is first compared with the kernel routes reported
+ *        to this process - a route already in the kernel is not sent again,
+ *        and a route with different next hops is sent as a replace. Route
+ *        deletes are always sent.
+ *
+ * @param enable true to enable
+ */
+void nas_os_route_idempotent_mode_set (bool enable);
+
+/**
+ * @brief Get the idempotent route programming mode. The kernel route view
+ *        is only maintained while the mode is enabled, it is learnt from
+ *        the route dumps and events received after it was enabled.
+ *
+ * @return true if enabled
+ */
+bool nas_os_route_idempotent_mode_get (void);
+
+/**
+ * @brief Program a batch of routes, the operation of every object is taken
+ *        from its key (create/set/delete)
+ *
+ * @param objs  route objects
+ * @param count number of objects
+ * @param buf   encode buffers owned by the calling thread
+ * @param stats returned per batch counts
+ *
+ * @return STD_ERR_OK if all the routes are programmed, otherwise the error
+ *         of the last failed route
+ */
+t_std_error nas_os_route_batch_r (cps_api_object_t *objs, size_t count, nas_os_rt_encode_buf_t *buf,
+                                  nas_os_rt_batch_stats_t *stats);
+
 /**
  * @brief This adds a neighbor entry in kernel
  *
@@ -110,6 +190,44 @@ t_std_error nas_os_refresh_neighbor (cps_api_object_t obj);
  */
 t_std_error nas_os_resolve_neighbor (cps_api_object_t obj);
 
+/* Neighbor of a bulk refresh/resolve */
+typedef struct {
+    const char     *vrf_name;   /* NULL for the default VRF */
+    hal_ifindex_t   if_index;
+    hal_ip_addr_t   ip;
+    hal_mac_addr_t  mac;        /* refresh only, all zeros to keep the MAC of the kernel entry */
+} nas_os_nbr_bulk_entry_t;
+
+/* Aggregated result of a bulk refresh/resolve */
+typedef struct {
+    uint32_t ok;
+    uint32_t failed;
+    int      first_err;         /* errno of the first failed entry */
+    uint32_t elapsed_ms;
+} nas_os_nbr_bulk_result_t;
+
+/**
+ * @brief Refresh (NUD_DELAY) or resolve (NTF_USE) a list of neighbors. The
+ *        RTM_NEWNEIGH messages are sent back to back on one socket per VRF
+ *        and spread evenly over the pacing window to avoid ARP/ND bursts.
+ *
+ * @param entries   neighbors
+ * @param count     number of entries
+ * @param pace_window_ms    time over which the messages are spread, 0 to
+ *                          send them as fast as the kernel takes them
+ * @param err       optional per entry errno, count entries
+ * @param result    optional aggregated result
+ *
+ * @return STD_ERR_OK if all the entries are updated, error otherwise
+ */
+t_std_error nas_os_refresh_neighbor_bulk (const nas_os_nbr_bulk_entry_t *entries, size_t count,
+                                          uint32_t pace_window_ms, int *err,
+                                          nas_os_nbr_bulk_result_t *result);
+
+t_std_error nas_os_resolve_neighbor_bulk (const nas_os_nbr_bulk_entry_t *entries, size_t count,
+                                          uint32_t pace_window_ms, int *err,
+                                          nas_os_nbr_bulk_result_t *result);
+
 /**
  * @brief : This creates the VRF in the kernel
  *
@@ -24,14 +24,24 @@
 
 #include "cps_api_object.h"
 #include "ds_common_types.h"
+#include "std_error_codes.h"
 #include <linux/netlink.h>
 
+/* MDB changes within the window are coalesced before being published */
+#define NAS_OS_MDB_COALESCE_MS 100
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 bool nl_to_mcast_snoop_info(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *context);
 
+/* Start the thread publishing the MDB changes per VLAN */
+t_std_error nas_os_mcast_snoop_init(void);
+
+/* Drop the cached names and MDB entries of deleted bridges and ports */
+void nas_os_mcast_snoop_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *if_name);
+
 bool nas_os_refresh_mcast_querier_status(hal_vlan_id_t vlan_id);
 
 #ifdef __cplusplus
@@ -126,6 +126,19 @@ t_std_error nas_os_del_vlan_interface(cps_api_object_t obj);
 
 bool nas_os_set_bridge_default_mac_ageing(hal_ifindex_t br_index);
 
+/**
+ * @brief : Set the default mac ageing time for a batch of kernel bridges,
+ *          one RTM_NEWLINK per bridge sent back to back
+ *
+ * @br_index : bridge indexes
+ *
+ * @count : number of bridges in br_index
+ *
+ * @return : STD_ERR_OK if all the bridges are updated, error otherwise
+ */
+
+t_std_error nas_os_set_bridge_default_mac_ageing_bulk(const hal_ifindex_t *br_index, size_t count);
+
 /**
  * @brief : Check to see if  tagged interface exist
  *
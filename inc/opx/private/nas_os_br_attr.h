@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_br_attr.h
+ *
+ * Cached access to the kernel bridge knobs under /sys/class/net/<br>/bridge.
+ * The sysfs files are kept open per bridge and re-read with pread, values
+ * carried in the bridge RTM_NEWLINK (IFLA_BR_*) are answered without any
+ * system call. Only values parsed from RTM_NEWLINK are cached, a written knob
+ * is read back from sysfs until the link message of the change is received
+ * (kernels without IFLA_BR_* always read sysfs).
+ *
+ * Writes are sent as one RTM_NEWLINK per bridge carrying all the knobs in
+ * IFLA_LINKINFO/IFLA_INFO_DATA, and the messages of a batch of bridges are
+ * sent back to back. Kernels without bridge changelink support fall back to
+ * the sysfs files.
+ */
+
+#ifndef NAS_OS_BR_ATTR_H_
+#define NAS_OS_BR_ATTR_H_
+
+#include "ds_common_types.h"
+#include "std_error_codes.h"
+
+#include <linux/netlink.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    NAS_OS_BR_ATTR_STP_STATE = 0,   /* stp_state */
+    NAS_OS_BR_ATTR_MCAST_QUERIER,   /* multicast_querier */
+    NAS_OS_BR_ATTR_AGEING_TIME,     /* ageing_time */
+    NAS_OS_BR_ATTR_MCAST_SNOOPING,  /* multicast_snooping */
+    NAS_OS_BR_ATTR_MCAST_QUERY_USE_IFADDR, /* multicast_query_use_ifaddr */
+    NAS_OS_BR_ATTR_MCAST_HASH_ELASTICITY,  /* hash_elasticity */
+    NAS_OS_BR_ATTR_MCAST_HASH_MAX,  /* hash_max */
+    NAS_OS_BR_ATTR_MAX,
+} nas_os_br_attr_t;
+
+#define NAS_OS_BR_ATTR_BIT(attr)    (1U << (attr))
+
+typedef struct {
+    hal_ifindex_t br_index;         /* bridge interface index */
+    uint32_t attr_mask;             /* NAS_OS_BR_ATTR_BIT() of the knobs set in val */
+    long val[NAS_OS_BR_ATTR_MAX];
+} nas_os_br_attr_cfg_t;
+
+/**
+ * @brief Read a bridge knob
+ *
+ * @param br_index  bridge interface index
+ * @param br_name   bridge name, NULL to look it up from the index
+ * @param attr      knob
+ * @param val       returned value
+ *
+ * @return true if the value is returned, false otherwise
+ */
+bool nas_os_br_attr_get(hal_ifindex_t br_index, const char *br_name, nas_os_br_attr_t attr, long *val);
+
+/**
+ * @brief Write a bridge knob
+ *
+ * @param br_index  bridge interface index
+ * @param br_name   bridge name, NULL to look it up from the index
+ * @param attr      knob
+ * @param val       value to be written
+ *
+ * @return true if the value is written, false otherwise
+ */
+bool nas_os_br_attr_set(hal_ifindex_t br_index, const char *br_name, nas_os_br_attr_t attr, long val);
+
+/**
+ * @brief Write the knobs of a batch of bridges, the knobs of a bridge are
+ *        applied together with a single RTM_NEWLINK
+ *
+ * @param cfg       bridges and knobs to be written
+ * @param count     number of entries in cfg
+ * @param rc        optional per bridge result, count entries
+ *
+ * @return STD_ERR_OK if all the bridges are updated, error otherwise
+ */
+t_std_error nas_os_br_attr_set_bulk(const nas_os_br_attr_cfg_t *cfg, size_t count, t_std_error *rc);
+
+/**
+ * @brief Update the cache from a link message of the default VRF, drops the
+ *        cached handles of deleted and renamed bridges, links of other kinds
+ *        are ignored
+ *
+ * @param rt_msg_type   RTM_NEWLINK/RTM_DELLINK
+ * @param ifindex       interface index
+ * @param if_name       interface name from the message, may be NULL
+ * @param info_kind     IFLA_INFO_KIND of the link, may be NULL
+ * @param info_data     IFLA_INFO_DATA of the link, may be NULL
+ */
+void nas_os_br_attr_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *if_name,
+                               const char *info_kind, struct nlattr *info_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_BR_ATTR_H_ */
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_ctl_sock.h
+ *
+ * Pool of the AF_INET datagram sockets used for the interface ioctls, one
+ * per VRF namespace. A socket is created on the first use in the VRF and
+ * shared by all the threads, it is closed on VRF delete once no longer in use.
+ */
+
+#ifndef NAS_OS_CTL_SOCK_H_
+#define NAS_OS_CTL_SOCK_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t gets;
+    uint64_t creates;       /* sockets opened */
+    uint64_t failures;
+    uint64_t entries;
+} nas_os_ctl_sock_stats_t;
+
+/**
+ * @brief Get the control socket of a VRF, released with nas_os_ctl_sock_put
+ *
+ * @param vrf_name  VRF name, NULL for the default VRF
+ *
+ * @return socket, -1 if it can't be created (errno set)
+ */
+int nas_os_ctl_sock_get(const char *vrf_name);
+
+/**
+ * @brief Release a socket returned by nas_os_ctl_sock_get
+ *
+ * @param sock  socket
+ */
+void nas_os_ctl_sock_put(int sock);
+
+/**
+ * @brief Close the socket of a deleted VRF
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_ctl_sock_vrf_del(const char *vrf_name);
+
+/**
+ * @brief Get the pool statistics
+ *
+ * @param stats returned statistics
+ */
+void nas_os_ctl_sock_stats_get(nas_os_ctl_sock_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_CTL_SOCK_H_ */
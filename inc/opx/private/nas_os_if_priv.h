@@ -36,6 +36,7 @@
 
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_api_object_t obj, bool* p_pub_evt,
@@ -49,6 +50,17 @@ extern "C"
 cps_api_return_code_t _get_interfaces( cps_api_object_list_t list, hal_ifindex_t ifix, bool get_all,
                                        uint_t if_type );
 
+/* Interface get filter, a field left zero/empty matches all the interfaces */
+typedef struct {
+    hal_ifindex_t ifindex;
+    std::string if_name;
+    BASE_CMN_INTERFACE_TYPE_t if_type;
+    hal_ifindex_t master_idx;
+    std::string vrf_name;       // Empty or default VRF - served from the interface cache
+} if_query_t;
+
+cps_api_return_code_t _get_interfaces_query(cps_api_object_list_t list, const if_query_t &query);
+
 typedef struct {
     bool admin; /* Admin status of the interface in OS */
     if_change_t ev_mask; // Mask interface netlink event publish
@@ -61,10 +73,15 @@ typedef struct {
     hal_ifindex_t parent_idx; // used by VLAN and MACVLAN type of interface to store parent index
     bool oper; /* Operational status of the interface in OS, this field helps the Apps
                   (e.g nbr-mgr) that only depend on OS netlink events for any operations. */
+    /* Management interface link settings, refreshed in the background on link events */
+    bool link_valid;
+    ethtool_cmd_data_t eth_cmd;
+    IF_INTERFACES_STATE_INTERFACE_OPER_STATUS_t oper_status;
 }if_info_t;
 
 using os_if_map_t = std::unordered_map <hal_ifindex_t, if_info_t>;
 using name_to_ifindex_map_t = std::unordered_map <std::string, hal_ifindex_t>;
+using ifindex_set_t = std::unordered_set <hal_ifindex_t>;
 
 struct if_details {
     cps_api_operation_types_t _op;
@@ -85,9 +102,15 @@ class INTERFACE {
 
     os_if_map_t if_map_;
     name_to_ifindex_map_t name_ifindex_map_;
+    /* Secondary indexes of the interface gets */
+    std::unordered_map <int, ifindex_set_t> type_index_;
+    std::unordered_map <hal_ifindex_t, ifindex_set_t> master_index_;
 
     std_rw_lock_t rw_lock;
 
+    void if_index_add(hal_ifindex_t ifx, const if_info_t& if_info);
+    void if_index_del(hal_ifindex_t ifx, const if_info_t& if_info);
+
     enum {
         PHY=0, LAG, VLAN, MACVLAN, VXLAN, STG, IP, DUMMY, BRIDGE, MGMT, MAX
     };
@@ -141,7 +164,15 @@ public:
     bool if_info_get_admin(hal_ifindex_t ifx, bool& admin);
     bool get_ifindex_from_name(std::string &if_name, hal_ifindex_t &if_index);
     void for_each_mbr(std::function <void (int ix, if_info_t& if_info)> fn);
+    void for_each_match(const if_query_t& query, std::function <void (int ix, if_info_t& if_info)> fn);
+    bool if_info_set_link(hal_ifindex_t ifx, const ethtool_cmd_data_t& eth_cmd,
+                          IF_INTERFACES_STATE_INTERFACE_OPER_STATUS_t oper_status);
+    void if_info_stats(size_t& entries, size_t& types, size_t& masters);
 };
 
+/* Background refresh of the management interface link settings in the cache */
+t_std_error os_interface_mgmt_refresh_init(void);
+void os_interface_mgmt_refresh(hal_ifindex_t ifx, const std::string &if_name);
+
 t_std_error os_interface_object_reg(cps_api_operation_handle_t handle);
 #endif /* NAS_OS_IF_PRIV_H_ */
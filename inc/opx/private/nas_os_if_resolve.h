@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_if_resolve.h
+ *
+ * Cache of the interface name resolution done when route next hops and
+ * neighbors are given by name. An entry holds the result of the NAS interface
+ * lookup and, for management interfaces, the kernel ifindex in the VRF. The
+ * entries are dropped on link delete/rename and on VRF delete.
+ */
+
+#ifndef NAS_OS_IF_RESOLVE_H_
+#define NAS_OS_IF_RESOLVE_H_
+
+#include "ds_common_types.h"
+#include "std_error_codes.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;     /* entries dropped by link and VRF events */
+    uint64_t entries;
+} nas_os_if_resolve_stats_t;
+
+/**
+ * @brief Resolve an interface name to the ifindex to be programmed in the VRF
+ *
+ * @param vrf_name  VRF name
+ * @param if_name   interface name
+ * @param if_index  returned ifindex, the kernel ifindex in the VRF for
+ *                  management interfaces
+ * @param int_type  returned NAS interface type (nas_int_type_t), may be NULL
+ *
+ * @return STD_ERR_OK if the name is resolved, error otherwise
+ */
+t_std_error nas_os_if_resolve(const char *vrf_name, const char *if_name,
+                              hal_ifindex_t *if_index, uint32_t *int_type);
+
+/**
+ * @brief Drop the entries of a deleted or renamed link, called for the link
+ *        messages of every VRF
+ *
+ * @param rt_msg_type   RTM_NEWLINK/RTM_DELLINK
+ * @param ifindex       interface index
+ * @param if_name       interface name from the message, may be NULL
+ */
+void nas_os_if_resolve_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *if_name);
+
+/**
+ * @brief Drop the entries of a deleted VRF
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_if_resolve_vrf_del(const char *vrf_name);
+
+/**
+ * @brief Get the cache statistics
+ *
+ * @param stats returned statistics
+ */
+void nas_os_if_resolve_stats_get(nas_os_if_resolve_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_IF_RESOLVE_H_ */
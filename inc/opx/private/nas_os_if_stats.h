@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_if_stats.h
+ *
+ * Bulk interface statistics of a VRF, read with one RTM_GETSTATS dump of the
+ * 64 bit link counters (IFLA_STATS_LINK_64) instead of the ethtool ioctls
+ * done per interface by nas_os_util_int_stats_get(). RTM_GETSTATS needs kernel
+ * 4.7, built against older headers the poll dumps the links and falls back to
+ * the ethtool read of each interface.
+ *
+ * A table is created for a VRF with a max number of interfaces, the entries
+ * and the netlink socket are allocated once and reused by every poll. A
+ * table is used by one thread at a time.
+ */
+
+#ifndef NAS_OS_IF_STATS_H_
+#define NAS_OS_IF_STATS_H_
+
+#include "nas_os_int_utils.h"
+#include "ds_common_types.h"
+#include "std_error_codes.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bit of a counter of os_int_stats_t in the valid and wrap32 masks */
+#define NAS_OS_IF_STATS_CTR_BIT(field) \
+    (1U << (offsetof(os_int_stats_t, field)/sizeof(uint64_t)))
+
+typedef struct {
+    hal_ifindex_t ifindex;
+    os_int_stats_t stats;
+    uint32_t valid;         /* counters read, the others are 0 */
+    uint32_t wrap32;        /* counters that may be 32 bit and wrap at 2^32 */
+} nas_os_if_stats_ent_t;
+
+typedef struct {
+    size_t entries;         /* interfaces of the last poll */
+    size_t skipped;         /* interfaces of the last poll left out by the table size */
+    uint64_t polls;
+    uint64_t last_poll_us;
+    uint64_t max_poll_us;
+} nas_os_if_stats_tbl_stats_t;
+
+typedef struct nas_os_if_stats_tbl_s nas_os_if_stats_tbl_t;
+
+/**
+ * @brief Create a statistics table
+ *
+ * @param vrf_name  VRF name, NULL for the default VRF
+ * @param max_if    max interfaces kept by a poll
+ *
+ * @return table, NULL if out of memory
+ */
+nas_os_if_stats_tbl_t * nas_os_if_stats_tbl_create(const char *vrf_name, size_t max_if);
+
+/**
+ * @brief Delete a statistics table
+ *
+ * @param tbl   table
+ */
+void nas_os_if_stats_tbl_delete(nas_os_if_stats_tbl_t *tbl);
+
+/**
+ * @brief Add or remove an interface of the filter, with an empty filter all
+ *        the interfaces of the VRF are polled
+ *
+ * @param tbl       table
+ * @param ifindex   interface index
+ * @param enable    true to add the interface to the filter
+ */
+void nas_os_if_stats_tbl_filter(nas_os_if_stats_tbl_t *tbl, hal_ifindex_t ifindex, bool enable);
+
+/**
+ * @brief Read the counters of the interfaces with one kernel dump, the
+ *        previous entries of the table are replaced
+ *
+ * @param tbl   table
+ *
+ * @return STD_ERR_OK if the dump is read
+ */
+t_std_error nas_os_if_stats_tbl_poll(nas_os_if_stats_tbl_t *tbl);
+
+/**
+ * @brief Get the entries of the last poll
+ *
+ * @param tbl   table
+ * @param count returned number of entries
+ *
+ * @return entries, valid until the next poll
+ */
+const nas_os_if_stats_ent_t * nas_os_if_stats_tbl_entries(nas_os_if_stats_tbl_t *tbl, size_t *count);
+
+/**
+ * @brief Get the counters of an interface from the last poll
+ *
+ * @param tbl       table
+ * @param ifindex   interface index
+ *
+ * @return counters, NULL if the interface was not polled
+ */
+const os_int_stats_t * nas_os_if_stats_tbl_get(nas_os_if_stats_tbl_t *tbl, hal_ifindex_t ifindex);
+
+/**
+ * @brief Get the table statistics
+ *
+ * @param tbl   table
+ * @param stats returned statistics
+ */
+void nas_os_if_stats_tbl_stats_get(nas_os_if_stats_tbl_t *tbl, nas_os_if_stats_tbl_stats_t *stats);
+
+/*
+ * Statistics engine - the tables of the VRFs read are polled at the configured
+ * interval (nas_os_if_stats_config_set) into a ring of samples per interface,
+ * the readers share the last sample instead of reading the kernel.
+ */
+typedef struct {
+    os_int_stats_t stats;       /* last sample */
+    os_int_stats_t delta;       /* increase between the last two samples */
+    os_int_stats_t rate;        /* per second over the ring, bits for the octet counters */
+    uint32_t interval_ms;       /* time between the last two samples */
+    uint32_t valid;             /* counters read, NAS_OS_IF_STATS_CTR_BIT */
+} nas_os_if_stats_sample_t;
+
+/**
+ * @brief Increase of a counter between two samples. A decrease of a counter
+ *        that may be 32 bit is a wrap if the previous value fits in 32 bits,
+ *        any other decrease is a reset and the counter is the increase
+ *
+ * @param prev      previous value
+ * @param cur       current value
+ * @param wrap32    counter may be 32 bit
+ *
+ * @return increase
+ */
+uint64_t nas_os_if_stats_ctr_delta(uint64_t prev, uint64_t cur, bool wrap32);
+
+/**
+ * @brief Get the last sample of an interface, the VRF is sampled from the
+ *        next interval if not yet
+ *
+ * @param vrf_name  VRF name, NULL for the default VRF
+ * @param ifindex   interface index
+ * @param sample    returned sample
+ *
+ * @return false if the engine is stopped or there are not two samples yet
+ */
+bool nas_os_if_stats_engine_get(const char *vrf_name, hal_ifindex_t ifindex, nas_os_if_stats_sample_t *sample);
+
+/**
+ * @brief Drop the samples of an interface whose counters start again from
+ *        zero (interface deleted or counters cleared), the next deltas and
+ *        rates are from the samples after it
+ *
+ * @param ifindex   interface index
+ */
+void nas_os_if_stats_engine_if_reset(hal_ifindex_t ifindex);
+
+/**
+ * @brief Stop sampling a deleted VRF
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_if_stats_engine_vrf_del(const char *vrf_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_IF_STATS_H_ */
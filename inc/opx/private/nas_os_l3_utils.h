@@ -21,6 +21,10 @@
 #ifndef NAS_OS_L3_UTILS_H_
 #define NAS_OS_L3_UTILS_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,6 +37,46 @@ typedef enum _nas_rt_msg_type {
     NAS_RT_RESOLVE
 }nas_rt_msg_type;
 
+#define NAS_OS_RT_MAX_NH  256
+
+/* Next hop of a decoded route object, pointers refer to the object data */
+typedef struct {
+    const void *addr;           /* NH_ADDR, NULL if not present */
+    const char *if_name;        /* IFNAME, NULL if not present */
+    size_t      if_name_len;
+    uint32_t    ifindex;        /* IFINDEX, valid if has_ifindex */
+    uint32_t    weight;         /* WEIGHT, valid if has_weight */
+    bool        has_ifindex;
+    bool        has_weight;
+} nas_os_rt_nh_t;
+
+/* Route object decoded in one pass over its attributes */
+typedef struct {
+    const char *vrf_name;
+    const char *nh_vrf_name;
+    const void *prefix;         /* NULL if not present */
+    uint32_t    af;
+    uint32_t    prefix_len;
+    uint32_t    nh_count;
+    uint32_t    spl_nh_type;
+    bool        has_af;
+    bool        has_prefix_len;
+    bool        has_nh_count;
+    bool        has_spl_nh;
+    size_t      nh_seen;        /* nh[] entries initialized by the decoder */
+    nas_os_rt_nh_t nh[NAS_OS_RT_MAX_NH];  /* indexed by the NH_LIST position */
+} nas_os_rt_decoded_t;
+
+/**
+ * @brief Decode a BASE_ROUTE_OBJ_ENTRY object with a single walk of its
+ *        attributes, the first instance of an attribute wins as with
+ *        cps_api_object_attr_get/cps_api_object_e_get
+ *
+ * @param obj   route object
+ * @param rt    decoded route, the pointers refer to the object data
+ */
+void nas_os_rt_decode(cps_api_object_t obj, nas_os_rt_decoded_t *rt);
+
 t_std_error nas_os_update_vrf(cps_api_object_t obj, nas_rt_msg_type m_type);
 t_std_error nas_os_handle_intf_to_mgmt_vrf(cps_api_object_t obj, nas_rt_msg_type m_type);
 t_std_error nas_os_handle_intf_to_vrf(cps_api_object_t obj, nas_rt_msg_type m_type);
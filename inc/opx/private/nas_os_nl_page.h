@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_nl_page.h
+ *
+ * Page of a kernel table read (routes, neighbors) served from a netlink dump.
+ *
+ * Every dumped entry is given a fixed length binary key, compared with memcmp.
+ * A page holds the entries with a key above the start key, up to the max
+ * count, in key order - so the last object of a page is the start key of the
+ * next page whatever the order of the dump. Only the objects of the page are
+ * kept while the dump is read.
+ *
+ * The leading cursor_len bytes of the key identify an entry for the start
+ * key, the rest only orders the entries sharing them (e.g. the same prefix in
+ * several tables). Such entries are never split across pages, a page may then
+ * go over the max count.
+ *
+ * Without a max count the page is the whole table, appended in dump order.
+ */
+
+#ifndef NAS_OS_NL_PAGE_H_
+#define NAS_OS_NL_PAGE_H_
+
+#include "cps_api_object.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NAS_OS_NL_PAGE_KEY_LEN      32
+/* Max count of a page whose count is given as 0 */
+#define NAS_OS_NL_PAGE_DFLT_COUNT   1000
+
+typedef struct {
+    uint8_t key[NAS_OS_NL_PAGE_KEY_LEN];
+    cps_api_object_t obj;
+} nas_os_nl_page_ent_t;
+
+typedef struct {
+    cps_api_object_list_t list;     /* objects of the page are appended here */
+    size_t max_count;               /* 0 - no limit */
+    size_t cursor_len;
+    bool has_start;
+    uint8_t start[NAS_OS_NL_PAGE_KEY_LEN];
+
+    nas_os_nl_page_ent_t *ents;     /* page in key order, max count set */
+    size_t count;
+    size_t size;
+
+    size_t scanned;                 /* entries of the dump looked at */
+    size_t returned;
+    uint64_t start_us;
+    uint64_t first_match_us;        /* time to the first match of the dump, the page is
+                                       only returned once the whole dump is scanned */
+    uint64_t total_us;
+} nas_os_nl_page_t;
+
+/**
+ * @brief Start a page
+ *
+ * @param page          page
+ * @param list          list the objects are appended to
+ * @param max_count     max objects, 0 for the whole table
+ * @param cursor_len    bytes of the key compared with the start key
+ * @param start         start key - only the keys above it are returned, may be NULL
+ */
+void nas_os_nl_page_init(nas_os_nl_page_t *page, cps_api_object_list_t list, size_t max_count,
+                         size_t cursor_len, const uint8_t *start);
+
+/**
+ * @brief Check if a dumped entry goes in the page, before it is converted
+ *
+ * @param page  page
+ * @param key   key of the entry
+ *
+ * @return true if the entry has to be added
+ */
+bool nas_os_nl_page_want(nas_os_nl_page_t *page, const uint8_t *key);
+
+/**
+ * @brief Add the object of a wanted entry, the page owns the object
+ *
+ * @param page  page
+ * @param key   key of the entry
+ * @param obj   object
+ *
+ * @return false if out of memory
+ */
+bool nas_os_nl_page_add(nas_os_nl_page_t *page, const uint8_t *key, cps_api_object_t obj);
+
+/**
+ * @brief Append the page to the list and release it
+ *
+ * @param page  page
+ * @param name  table name for the log
+ */
+void nas_os_nl_page_done(nas_os_nl_page_t *page, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_NL_PAGE_H_ */
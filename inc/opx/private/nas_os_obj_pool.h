@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_obj_pool.h
+ *
+ * Per thread pool of CPS object buffers used for the objects built and
+ * published from the netlink event path.
+ */
+
+#ifndef NAS_OS_OBJ_POOL_H_
+#define NAS_OS_OBJ_POOL_H_
+
+#include "cps_api_object.h"
+#include "cps_api_errors.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    NAS_OS_OBJ_POOL_SMALL = 0,  /* Address, neighbor, netconf, mdb and STG objects */
+    NAS_OS_OBJ_POOL_LARGE,      /* Link and route objects */
+    NAS_OS_OBJ_POOL_MAX,
+} nas_os_obj_pool_class_t;
+
+typedef struct {
+    uint32_t buf_size;      /* Size of every buffer in the class */
+    uint64_t allocs;        /* Objects handed out */
+    uint64_t reused;        /* Objects handed out from a recycled buffer */
+    uint32_t in_use;        /* Objects currently outstanding (all threads) */
+    uint32_t high_water;    /* Highest number of outstanding objects */
+    uint32_t cached;        /* Free buffers held by all thread pools */
+} nas_os_obj_pool_stats_t;
+
+/**
+ * @brief Get the buffer class used for objects built from a netlink message type
+ *
+ * @param rt_msg_type   netlink message type (RTM_*)
+ *
+ * @return the pool class
+ */
+nas_os_obj_pool_class_t nas_os_obj_pool_class(int rt_msg_type);
+
+/**
+ * @brief Get an empty CPS object from the calling thread's pool, the buffer is
+ *        sized for the netlink message type. Returned object must be given back
+ *        with nas_os_obj_pool_release (or nas_os_obj_pool_publish) on the same thread.
+ *
+ * @param rt_msg_type   netlink message type (RTM_*) the object is built from
+ *
+ * @return CPS object or NULL on failure
+ */
+cps_api_object_t nas_os_obj_pool_alloc(int rt_msg_type);
+
+/**
+ * @brief Return an object obtained from nas_os_obj_pool_alloc to the pool
+ *
+ * @param obj   object to be recycled
+ */
+void nas_os_obj_pool_release(cps_api_object_t obj);
+
+/**
+ * @brief Publish an object obtained from nas_os_obj_pool_alloc and recycle it
+ *
+ * @param obj   object to be published and recycled
+ *
+ * @return return code of the publish
+ */
+cps_api_return_code_t nas_os_obj_pool_publish(cps_api_object_t obj);
+
+/**
+ * @brief Get the counters of a pool class aggregated over all threads
+ *
+ * @param cls       pool class
+ * @param stats     returned counters
+ *
+ * @return true if the class is valid, false otherwise
+ */
+bool nas_os_obj_pool_stats_get(nas_os_obj_pool_class_t cls, nas_os_obj_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_OBJ_POOL_H_ */
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_rt_shadow.h
+ *
+ * In-process view of the main table unicast routes of every VRF, built from
+ * the kernel route dumps and events. It is only maintained in the idempotent
+ * programming mode and checked before a route is sent to the kernel. Routes
+ * are keyed by VRF, table, metric and prefix.
+ *
+ * Only what the kernel reported is kept: a route written by this process is
+ * dropped from the view until its event is received, and the routes on an
+ * interface going down or losing an address are dropped since the kernel
+ * flushes them without events. A route that is not in the view is unknown,
+ * never known to be absent.
+ */
+
+#ifndef NAS_OS_RT_SHADOW_H_
+#define NAS_OS_RT_SHADOW_H_
+
+#include "ds_common_types.h"
+
+#include <linux/netlink.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    NAS_OS_RT_SHADOW_UNKNOWN = 0,   /* route not in the view */
+    NAS_OS_RT_SHADOW_SAME,          /* kernel has the route with the same next hops */
+    NAS_OS_RT_SHADOW_DIFF,          /* kernel has the route with different next hops */
+} nas_os_rt_shadow_state_t;
+
+typedef struct {
+    uint64_t same;
+    uint64_t diff;
+    uint64_t unknown;
+    uint64_t invalidations;     /* routes dropped by writes, link and address events */
+    uint64_t entries;
+} nas_os_rt_shadow_stats_t;
+
+/**
+ * @brief Update the view from a kernel route message (dump or event)
+ *
+ * @param rt_msg_type   RTM_NEWROUTE/RTM_DELROUTE
+ * @param vrf_name      VRF the message was received on
+ * @param nlh           route message
+ */
+void nas_os_rt_shadow_event(int rt_msg_type, const char *vrf_name, struct nlmsghdr *nlh);
+
+/**
+ * @brief Compare an encoded RTM_NEWROUTE request with the view
+ *
+ * @param vrf_name  VRF the request is sent to
+ * @param nlh       encoded route request
+ *
+ * @return state of the route in the kernel
+ */
+nas_os_rt_shadow_state_t nas_os_rt_shadow_check(const char *vrf_name, struct nlmsghdr *nlh);
+
+/**
+ * @brief Drop the route of an encoded request about to be sent, until the
+ *        kernel reports the result
+ *
+ * @param vrf_name  VRF the request is sent to
+ * @param nlh       encoded route request
+ */
+void nas_os_rt_shadow_invalidate(const char *vrf_name, struct nlmsghdr *nlh);
+
+/**
+ * @brief Drop the routes going through an interface, called for the link
+ *        messages of every VRF and for address deletes
+ *
+ * @param rt_msg_type   RTM_NEWLINK/RTM_DELLINK/RTM_DELADDR
+ * @param ifindex       interface index
+ * @param if_flags      IFF_* flags of a link message, ignored otherwise
+ */
+void nas_os_rt_shadow_if_event(int rt_msg_type, hal_ifindex_t ifindex, uint32_t if_flags);
+
+/**
+ * @brief Drop the routes of a deleted VRF
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_rt_shadow_vrf_del(const char *vrf_name);
+
+/**
+ * @brief Drop the routes of every VRF, the view is rebuilt from the next
+ *        route dumps and events
+ */
+void nas_os_rt_shadow_clear(void);
+
+/**
+ * @brief Get the view statistics
+ *
+ * @param stats returned statistics
+ */
+void nas_os_rt_shadow_stats_get(nas_os_rt_shadow_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_RT_SHADOW_H_ */
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_snapshot.h
+ *
+ * Warm restart snapshot of the interface, address, route and neighbor objects
+ * published from the kernel. The snapshot is periodically written to a
+ * versioned file, on restart it is loaded and the first kernel dump of every
+ * VRF only publishes the objects that changed, followed by the deletes of the
+ * objects that are gone and a cps_api_int_obj_NETLINK_RECONCILE marker event.
+ * The events published after the reconcile keep updating the snapshot, so it
+ * holds the objects as currently published.
+ */
+
+#ifndef NAS_OS_SNAPSHOT_H_
+#define NAS_OS_SNAPSHOT_H_
+
+#include "cps_api_object.h"
+#include "std_error_codes.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NAS_OS_SNAPSHOT_FILE            "/run/nas_os_linux.snapshot"
+#define NAS_OS_SNAPSHOT_PERIOD_SEC      30
+#define NAS_OS_SNAPSHOT_RECONCILE_SEC   300
+
+/**
+ * @brief Load the snapshot of the previous run and start the periodic writer,
+ *        to be called before the netlink sockets are created
+ *
+ * @return STD_ERR_OK on success (also when there is no snapshot to load)
+ */
+t_std_error nas_os_snapshot_init(void);
+
+/**
+ * @brief Check whether a valid snapshot was loaded on startup
+ *
+ * @return true if the objects are being reconciled against a snapshot
+ */
+bool nas_os_snapshot_warm_restart(void);
+
+/**
+ * @brief Track the objects of a new VRF until it is deleted
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_snapshot_vrf_add(const char *vrf_name);
+
+/**
+ * @brief Record an object about to be published from the netlink event path,
+ *        a no-op for the VRFs that are not tracked
+ *
+ * @param rt_msg_type   netlink message type (RTM_*) the object is built from
+ * @param vrf_name      VRF the message is received from
+ * @param obj           object to be published
+ *
+ * @return false if the object is unchanged since the snapshot and must not be
+ *         published, true otherwise
+ */
+bool nas_os_snapshot_track(int rt_msg_type, const char *vrf_name, cps_api_object_t obj);
+
+/**
+ * @brief First kernel dump of the VRF is done - publish the deletes of the
+ *        snapshot objects not seen in the dump and the reconcile marker
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_snapshot_vrf_synced(const char *vrf_name);
+
+/**
+ * @brief Forget the objects of a deleted VRF
+ *
+ * @param vrf_name  VRF name
+ */
+void nas_os_snapshot_vrf_del(const char *vrf_name);
+
+/**
+ * @brief Write the tracked objects to a snapshot file now
+ *
+ * @param file  snapshot file, NAS_OS_SNAPSHOT_FILE is written periodically
+ *
+ * @return STD_ERR_OK on success
+ */
+t_std_error nas_os_snapshot_save(const char *file);
+
+/**
+ * @brief Load a snapshot file, its VRFs are reconciled against their next
+ *        kernel dump as on a warm restart
+ *
+ * @param file  snapshot file
+ *
+ * @return STD_ERR_OK on success
+ */
+t_std_error nas_os_snapshot_load(const char *file);
+
+typedef struct {
+    uint32_t published;     /* Changed or new since the snapshot */
+    uint32_t unchanged;     /* Suppressed */
+    uint32_t deleted;       /* Gone since the snapshot */
+    bool reconciled;
+} nas_os_snapshot_stats_t;
+
+/**
+ * @brief Reconcile stats of a VRF
+ *
+ * @param vrf_name  VRF name
+ * @param stats     filled on success
+ *
+ * @return false if the VRF was not reconciled against a snapshot
+ */
+bool nas_os_snapshot_vrf_stats_get(const char *vrf_name, nas_os_snapshot_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAS_OS_SNAPSHOT_H_ */
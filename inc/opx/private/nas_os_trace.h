@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: nas_os_trace.h
+ *
+ * Low overhead tracing for the netlink event and kernel programming hot paths,
+ * kept next to the EV_LOGGING logs of the same paths. A trace record is binary:
+ * the call site (with its format string) and up to NAS_OS_TRACE_MAX_ARGS integer
+ * arguments go to an in-memory ring and are only formatted when the ring is
+ * dumped (os_debug_trace_print). Tracing is off by default, arguments are
+ * evaluated only when it is enabled and every call site is rate limited by its
+ * own token bucket.
+ *
+ * Only integer conversions (%d %u %x %c %p, with any length modifier) are
+ * supported in the format, strings can't be recorded.
+ */
+
+#ifndef NAS_OS_TRACE_H_
+#define NAS_OS_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NAS_OS_TRACE_MAX_ARGS   8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per call site state - one static instance is created by every NAS_OS_TRACE */
+typedef struct _nas_os_trace_site {
+    const char *id;
+    const char *fmt;
+    const char *file;
+    int line;
+    unsigned char lock;         /* Protects the token bucket */
+    unsigned char registered;   /* Linked into the site list */
+    uint32_t tokens;
+    uint64_t refill_us;
+    uint64_t written;
+    uint64_t dropped;
+    struct _nas_os_trace_site *next;
+} nas_os_trace_site_t;
+
+extern volatile bool nas_os_trace_on;
+
+/**
+ * @brief Take a token from the call site bucket
+ *
+ * @param site  call site
+ *
+ * @return true if the record may be written, false if it is rate limited
+ */
+bool nas_os_trace_admit(nas_os_trace_site_t *site);
+
+/**
+ * @brief Copy a record into the trace ring, use NAS_OS_TRACE instead
+ *
+ * @param site  call site
+ * @param args  integer arguments of the site format
+ * @param nargs number of arguments, the ones above NAS_OS_TRACE_MAX_ARGS are dropped
+ */
+void nas_os_trace_write(nas_os_trace_site_t *site, const uint64_t *args, size_t nargs);
+
+/**
+ * @brief Enable or disable tracing
+ */
+void nas_os_trace_enable(bool enable);
+
+/**
+ * @brief Set the per call site rate limit
+ *
+ * @param rate_per_sec  records per second refilled into every call site bucket
+ * @param burst         bucket depth
+ */
+void nas_os_trace_rate_set(uint32_t rate_per_sec, uint32_t burst);
+
+/**
+ * @brief Discard all the records in the trace ring
+ */
+void nas_os_trace_clear(void);
+
+/**
+ * @brief Get the records written and rate limited, summed over all the call sites
+ *
+ * @param written   returned records written to the ring
+ * @param dropped   returned records rate limited
+ */
+void nas_os_trace_stats_get(uint64_t *written, uint64_t *dropped);
+
+#ifdef __cplusplus
+}
+
+template <typename... T>
+static inline void nas_os_trace_args_write(nas_os_trace_site_t *site, T... args)
+{
+    const uint64_t arr[] = { 0, (uint64_t)args... };
+    nas_os_trace_write(site, arr + 1, sizeof...(args));
+}
+
+#define NAS_OS_TRACE_WRITE(site, ...) nas_os_trace_args_write(site, ##__VA_ARGS__)
+#else
+#define NAS_OS_TRACE_WRITE(site, ...) \
+    do { \
+        const uint64_t _nas_os_trace_args[] = { 0, ##__VA_ARGS__ }; \
+        nas_os_trace_write(site, _nas_os_trace_args + 1, \
+                           sizeof(_nas_os_trace_args)/sizeof(_nas_os_trace_args[0]) - 1); \
+    } while (0)
+#endif
+
+#define NAS_OS_TRACE(ID, fmt, ...) \
+    do { \
+        static nas_os_trace_site_t _nas_os_trace_site = { ID, fmt, __FILE__, __LINE__ }; \
+        if (nas_os_trace_on && nas_os_trace_admit(&_nas_os_trace_site)) { \
+            NAS_OS_TRACE_WRITE(&_nas_os_trace_site, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif /* NAS_OS_TRACE_H_ */
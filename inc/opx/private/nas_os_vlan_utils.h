@@ -24,6 +24,7 @@
 
 #include "ds_common_types.h"
 #include <stdbool.h>
+#include <linux/netlink.h>
 #include "std_error_codes.h"
 
 #ifdef __cplusplus
@@ -38,6 +39,41 @@ bool nas_os_physical_to_vlan_ifindex(hal_ifindex_t intf_index, hal_vlan_id_t vla
 bool nas_os_sub_intf_name_to_intf_ifindex(char *sub_intf_name, hal_ifindex_t * index);
 bool nas_os_sub_intf_to_phy_intf_name(char *sub_intf_name,  char * phy_intf_name);
 
+/**
+ * @brief Look up the tagged sub-interface of a port, no system call involved
+ *
+ * @param parent      port or LAG interface index
+ * @param vlan_id     VLAN id of the sub-interface
+ * @param vlan_index  returned sub-interface index
+ *
+ * @return true if the sub-interface is known, false otherwise
+ */
+bool nas_os_tagged_intf_get(hal_ifindex_t parent, hal_vlan_id_t vlan_id, hal_ifindex_t *vlan_index);
+
+/**
+ * @brief Look up the port and VLAN id of a tagged sub-interface
+ *
+ * @param vlan_index  sub-interface index
+ * @param parent      returned port or LAG interface index, may be NULL
+ * @param vlan_id     returned VLAN id, may be NULL
+ *
+ * @return true if vlan_index is a known tagged sub-interface, false otherwise
+ */
+bool nas_os_tagged_intf_parent_get(hal_ifindex_t vlan_index, hal_ifindex_t *parent, hal_vlan_id_t *vlan_id);
+
+/**
+ * @brief Update the tagged sub-interface index from a link message of the
+ *        default VRF
+ *
+ * @param rt_msg_type   RTM_NEWLINK/RTM_DELLINK
+ * @param ifindex       interface index
+ * @param info_kind     IFLA_INFO_KIND of the link, may be NULL
+ * @param link          IFLA_LINK of the link, may be NULL
+ * @param info_data     IFLA_INFO_DATA of the link, may be NULL
+ */
+void nas_os_tagged_intf_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *info_kind,
+                                   struct nlattr *link, struct nlattr *info_data);
+
 bool nas_os_is_port_part_of_vlan(hal_ifindex_t vlan_ifindex, hal_ifindex_t port_ifindex);
 
 t_std_error nas_os_handle_mac_port_chg(const char *vlan_name, const char *mac_str, hal_mac_addr_t *mac,
@@ -31,6 +31,7 @@
 #include "nas_vrf_utils.h"
 
 #include <stddef.h>
+#include <stdint.h>
 #include <linux/rtnetlink.h>
 #include <stdbool.h>
 
@@ -99,6 +100,20 @@ bool nl_send_request(int sock, int type, int flags, int seq, void * req, size_t
 
 bool nl_send_nlmsg(int sock, struct nlmsghdr *m);
 
+/**
+ * Send len bytes of netlink messages packed back to back in buff, the kernel
+ * processes them in order as if they were sent one by one
+ */
+bool nl_send_nlmsg_batch(int sock, void *buff, size_t len);
+
+/**
+ * Wait for the ACKs of the messages [first, last) of a batch sent with the
+ * sequence numbers seq_base + ix. err[ix] is -1 for the pending messages and
+ * is set to the errno of the message (0 on success) when its ACK is read.
+ * If no ACK arrives for 2 seconds the pending messages fail with ETIMEDOUT.
+ */
+void nl_read_batch_acks(int sock, uint32_t seq_base, size_t first, size_t last, size_t pending, int *err);
+
 t_std_error nl_do_set_request(const char *vrf_name, nas_nl_sock_TYPES type,struct nlmsghdr *m,
                               void *buff, size_t bufflen);
 
@@ -112,6 +127,30 @@ bool os_nflog_enable ();
 
 t_std_error os_create_netlink_sock(const char *vrf_name, uint32_t vrf_id);
 t_std_error os_del_netlink_sock(const char *vrf_name);
+
+/**
+ * Set the number of VRFs dumped concurrently on startup and VRF re-sync, the
+ * dump phases of a VRF are always run in order (interfaces, addresses, neighbors,
+ * routes, netconf)
+ */
+void os_refresh_max_parallel_set(size_t max_parallel);
+
+typedef struct {
+    uint32_t count;         /* Dumps done */
+    uint32_t pending;       /* Dumps queued or running */
+    uint64_t wait_us;       /* Time the last dump was queued */
+    uint64_t total_us;      /* Duration of the last dump */
+} os_refresh_vrf_stats_t;
+
+/**
+ * Dump stats of a VRF, false if the VRF has not been dumped or queued
+ */
+bool os_refresh_vrf_stats_get(const char *vrf_name, os_refresh_vrf_stats_t *stats);
+
+/**
+ * Highest number of VRFs dumped at the same time since the limit was last set
+ */
+size_t os_refresh_active_max_get(void);
 t_std_error os_sock_create(const char *vrf_name, e_std_socket_domain_t domain,
                            e_std_sock_type_t type, int protocol, int *sock);
 
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * filename: os_interface_damp.h
+ *
+ * Per ifindex debounce/dampening of the admin/oper link events published
+ * from the netlink thread.
+ */
+
+#ifndef OS_INTERFACE_DAMP_H_
+#define OS_INTERFACE_DAMP_H_
+
+#include "cps_api_object.h"
+#include "ds_common_types.h"
+#include "std_error_codes.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Check whether an admin/oper only link event can be published now.
+ *        When the interface is inside its hold-down window or suppressed by the
+ *        dampening penalty, a copy of the object is kept as the pending final state
+ *        and false is returned.
+ *
+ * @param ifindex       kernel interface index
+ * @param track_change  if_change_t mask computed by the interface cache
+ * @param obj           fully built interface event object
+ *
+ * @return true if the event should be published right away, false if it is held
+ */
+bool os_if_damp_event(hal_ifindex_t ifindex, int track_change, cps_api_object_t obj);
+
+/**
+ * @brief Note that a non-dampened event carrying the current state of the
+ *        interface was published, any pending final state is dropped.
+ *
+ * @param ifindex   kernel interface index
+ * @param obj       published interface event object
+ */
+void os_if_damp_published(hal_ifindex_t ifindex, cps_api_object_t obj);
+
+/**
+ * @brief Remove the dampening state of an interface on delete
+ *
+ * @param ifindex   kernel interface index
+ */
+void os_if_damp_delete(hal_ifindex_t ifindex);
+
+/**
+ * @brief Time until the earliest pending final state is due
+ *
+ * @param wait_us   returned wait time in micro seconds
+ *
+ * @return true if there is a pending final state, false otherwise
+ */
+bool os_if_damp_next_timeout(uint64_t *wait_us);
+
+/* Publishes a final state object and deletes it */
+typedef void (*os_if_damp_publish_fn)(cps_api_object_t obj);
+
+/**
+ * @brief Publish the final state of all interfaces whose hold-down window
+ *        or suppression expired. Called from the netlink thread.
+ *
+ * @param publish   called for each final state once the dampening lock is released
+ */
+void os_if_damp_flush(os_if_damp_publish_fn publish);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OS_INTERFACE_DAMP_H_ */
@@ -27,10 +27,17 @@ import bytearray_utils as ba
 import threading
 import time
 import Queue
+import socket
+import struct
+import errno
+import ifindex_utils
 
 iplink_cmd = '/sbin/ip'
 bridge_cmd = '/sbin/bridge'
 
+# Interface name by ifindex of the bridges and member ports in the MDB, refreshed on every audit
+_mdb_if_names = {}
+
 igmp_global_key = 'igmp-mld-snooping/rt/routing/control-plane-protocols/igmp-snooping/global'
 mld_global_key = 'igmp-mld-snooping/rt/routing/control-plane-protocols/mld-snooping/global'
 
@@ -102,6 +109,43 @@ MCAST_SNOOP_POLLING_INTERVAL = 5
 # Maximum trying times to set mdb hash_max after enabling multicast snooping
 MAX_HASHMAX_CFG_TRY_COUNT = 50
 
+# Interval for auditing the event driven group cache against a kernel MDB dump
+MCAST_SNOOP_AUDIT_INTERVAL = 60
+
+# Netlink MDB definitions from linux/rtnetlink.h and linux/if_bridge.h
+NETLINK_ROUTE = 0
+NLMSG_HDR_LEN = 16
+NLMSG_ERROR = 2
+NLMSG_DONE = 3
+NLM_F_REQUEST = 0x1
+NLM_F_DUMP = 0x300
+RTM_NEWLINK = 16
+RTM_DELLINK = 17
+RTM_NEWMDB = 84
+RTM_DELMDB = 85
+RTM_GETMDB = 86
+RTNLGRP_LINK = 1
+RTNLGRP_MDB = 26
+IFINFOMSG_LEN = 16
+IFLA_IFNAME = 3
+AF_BRIDGE = 7
+BR_PORT_MSG_LEN = 8
+BR_MDB_ENTRY_LEN = 28
+MDBA_MDB = 1
+MDBA_MDB_ENTRY = 1
+MDBA_MDB_ENTRY_INFO = 1
+MDBA_MDB_EATTR_TIMER = 1
+MDBA_ROUTER = 2
+MDBA_ROUTER_PORT = 1
+MDBA_ROUTER_PATTR_TIMER = 1
+MDBA_ROUTER_PATTR_TYPE = 2
+MDB_PERMANENT = 1
+MDB_RTR_TYPE_PERM = 2
+ETH_P_IP = 0x0800
+ETH_P_IPV6 = 0x86DD
+NL_RECV_BUF_LEN = 65536
+NL_EVENT_SOCK_RCVBUF = 4 * 1024 * 1024
+
 mcast_path_prefix = "/sys/devices/virtual/net/"
 
 rules = ['-p IPv6 --ip6-proto ipv6-icmp --ip6-icmp-type 132/0:255 --mark 0x1 -j ACCEPT',
@@ -165,6 +209,46 @@ def run_command(cmd, respose, show_debug = True):
          log_err(log_msg)
     return -1
 
+def _bridge_link_set(br_name, knobs):
+    # Apply all the bridge knobs with a single RTM_NEWLINK (ip link set ... type bridge)
+    if len(knobs) == 0: return True
+    cmd = [iplink_cmd, 'link', 'set', 'dev', str(br_name), 'type', 'bridge']
+    for (k, v) in knobs:
+        cmd.extend((k, str(v)))
+    res = []
+    if run_command(cmd, res) != 0:
+        log_err('Failed to set %s on bridge %s: %s' % (str(knobs), str(br_name), str(res)))
+        return False
+    return True
+
+def _bridge_link_set_batch(br_knobs):
+    # Apply the knobs of many bridges with one ip process, br_knobs is a list of (bridge, knobs).
+    # Returns the list of bridges that failed
+    lines = []
+    for (br_name, knobs) in br_knobs:
+        lines.append('link set dev %s type bridge %s' % (str(br_name),
+                     ' '.join('%s %s' % (k, str(v)) for (k, v) in knobs)))
+    if len(lines) == 0: return []
+    try:
+        p = subprocess.Popen([iplink_cmd, '-force', '-batch', '-'], shell=False,
+                             stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out, err = p.communicate('\n'.join(lines) + '\n')
+    except Exception as e:
+        log_err('Exception: ' + str(e))
+        return [br_name for (br_name, knobs) in br_knobs]
+    if p.returncode == 0:
+        return []
+    # Failed lines are reported as "Command failed -:<line>"
+    failed = []
+    for m in re.finditer('Command failed -:(\d+)', err):
+        idx = int(m.group(1)) - 1
+        if idx >= 0 and idx < len(br_knobs):
+            failed.append(br_knobs[idx][0])
+    if len(failed) == 0:
+        log_err('Batch bridge update failed: %s' % err)
+        return [br_name for (br_name, knobs) in br_knobs]
+    return failed
+
 def cps_convert_attr_data( raw_elem ):
     d={}
     obj = cps_object.CPSObject(obj=raw_elem)
@@ -263,7 +347,10 @@ def _handle_mcast_snoop_configs(cmd, data, vlan_name, igmp_events, op, snoop_cfg
     return True
 
 def _handle_mcast_snoop_configs_fs(data, vlan_name, igmp_events, op):
-    ret = True
+    # All the knobs of the request are applied to the bridge with a single RTM_NEWLINK
+    knobs = []
+    events_data = []
+    snoop_enable = False
     for k in _ip_link_cmd_params:
         for path in _ip_link_cmd_params[k]['obj_path']:
           if path in data:
@@ -283,59 +370,57 @@ def _handle_mcast_snoop_configs_fs(data, vlan_name, igmp_events, op):
               else: val = str(data[path])
 
               # Update Multicast Snooping on a VLAN
-              ret = ret and (_update_file_system(_get_path_per_vlan_configs(vlan_name, _ip_link_cmd_params[k]['file_name']), val))
+              knobs.append((k, val))
 
               # Publish CPS Events if required
-              event_data = {}
               if _ip_link_cmd_params[k]['publish_events']:
                   ev_key = path.split("/")[-1]
                   if _keys['vlan_id_key']['igmp'] in data:  id = data[_keys['vlan_id_key']['igmp']]
                   elif _keys['vlan_id_key']['mld'] in data:  id = data[_keys['vlan_id_key']['mld']]
-                  event_data = {'vlan-id': str(id), ev_key :str( data[path])}
-
-              if ret and event_data:
-                 obj = events.MCast_CpsEvents()
-                 # Since snoop config variables like mcast status are common for both IPv4 and IPv6, publishing the corresponding events on both igmp and mld state objects
-                 obj.publish_igmp_events(event_data, op)
-                 obj.publish_mld_events(event_data, op)
-                 log_debug("Publishing CPS Event: %s" %(str(event_data)))
+                  events_data.append({'vlan-id': str(id), ev_key :str( data[path])})
 
               # In case of igmp/mld enable, set the max groups as 16k and hash_elasticity as 8
               if k == 'mcast_snooping' and data[path] == 1:
-                  ret = ret and polling_thread.hashmax_cfg_to_queue(vlan_name, max_grps)
-                  ret = ret and (_update_file_system(_get_path_per_vlan_configs(vlan_name, "hash_elasticity"),
-                                                            def_mcast_hash_elasticity))
+                  snoop_enable = True
+                  knobs.append(('mcast_hash_elasticity', def_mcast_hash_elasticity))
 
-              # In case of multicast query interval, kernel doesn't update multicast membership interval file and multicast_querier_interval file, hence updating it manually
+              # In case of multicast query interval, kernel doesn't update multicast membership interval and multicast querier interval, hence updating it manually
               if k == 'mcast_query_interval':
-                  mcast_query_response_interval = _read_file_system(_get_path_per_vlan_configs(vlan_name, "multicast_query_response_interval"))
+                  mcast_query_response_interval = None
+                  for resp_path in _ip_link_cmd_params['mcast_query_response_interval']['obj_path']:
+                      if resp_path in data: mcast_query_response_interval = data[resp_path]
+                  if mcast_query_response_interval is None:
+                      mcast_query_response_interval = _read_file_system(_get_path_per_vlan_configs(vlan_name, "multicast_query_response_interval"))
                   if not mcast_query_response_interval: return False
 
                   #As per RFC The Group Membership Interval value MUST be ((the Robustness Variable) times (the Query Interval)) plus (one Query Response Interval)
                   val = ((data[path]*2)+(int(mcast_query_response_interval)/100))*100
-                  ret = ret and (_update_file_system(_get_path_per_vlan_configs(vlan_name, "multicast_membership_interval"), val))
+                  knobs.append(('mcast_membership_interval', val))
 
                   #As per RFC The Other Querier Present Interval value MUST be ((the Robustness Variable) times (the Query Interval)) plus (one half of one Query Response Interval)
                   val = ((data[path]*2)+((int(mcast_query_response_interval)/100)/2))*100
-                  ret = ret and (_update_file_system(_get_path_per_vlan_configs(vlan_name, "multicast_querier_interval"), val))
-    return ret
+                  knobs.append(('mcast_querier_interval', val))
+
+    if not _bridge_link_set(vlan_name, knobs): return False
+
+    for event_data in events_data:
+        obj = events.MCast_CpsEvents()
+        # Since snoop config variables like mcast status are common for both IPv4 and IPv6, publishing the corresponding events on both igmp and mld state objects
+        obj.publish_igmp_events(event_data, op)
+        obj.publish_mld_events(event_data, op)
+        log_debug("Publishing CPS Event: %s" %(str(event_data)))
+
+    if snoop_enable:
+        return polling_thread.hashmax_cfg_to_queue(vlan_name, max_grps)
+    return True
 
 def _handle_mcast_querier_functionality(op, vlan_name):
     # mcast_querier values
     mcast_querier = '0'
     if op == "create" or op == "set" : mcast_querier = '1'
 
-    obj_paths = ['mcast_querier', 'mcast_query_use_ifaddr']
-    cmd = [iplink_cmd, 'link', 'set', vlan_name, 'type', 'bridge']
-
-    ret = True
-    for path in obj_paths:
-        cmd.extend((path,  mcast_querier))
-        res = []
-        if (run_command(cmd, res) != 0): ret = ret and False
-        cmd = [iplink_cmd, 'link', 'set', vlan_name, 'type', 'bridge']
-
-    return ret
+    return _bridge_link_set(vlan_name, [('mcast_querier', mcast_querier),
+                                        ('mcast_query_use_ifaddr', mcast_querier)])
 
 def _is_ip_addr(ipv4_flag, ip_addr):
     try:
@@ -462,10 +547,8 @@ def handle_configs_fs(params):
         # mcast_querier values
         mcast_querier = '0'
         if params['operation'] == "create" or params['operation'] == "set" : mcast_querier = '1'
-        files = ['multicast_querier', 'multicast_query_use_ifaddr']
-        ret = True
-        for f in files:
-            ret = ret and (_update_file_system(_get_path_per_vlan_configs(vlan_name, f), mcast_querier ))
+        ret = _bridge_link_set(vlan_name, [('mcast_querier', mcast_querier),
+                                           ('mcast_query_use_ifaddr', mcast_querier)])
     ret = ret and (_handle_mcast_snoop_configs_fs(data, vlan_name, igmp_events, params['operation']) )
 
     #Handle static group programming
@@ -580,11 +663,12 @@ def remove_ifname_tag(if_name):
     return if_name
 
 class McastRouterInfo(object):
-    def __init__(self, br_name, if_name, expire = None):
+    def __init__(self, br_name, if_name, expire = None, permanent = False):
         self.br_name = br_name
         self.raw_if_name = if_name
         self.if_name = remove_ifname_tag(if_name)
         self.expire = expire
+        self.permanent = permanent
 
     def __eq__(self, other):
         return (self.br_name == other.br_name and
@@ -610,13 +694,17 @@ class McastRouterInfo(object):
         return ret
 
 class McastGroupInfo(object):
-    def __init__(self, br_name, grp_ip, if_name, is_igmp, expire = None):
+    def __init__(self, br_name, grp_ip, if_name, is_igmp, expire = None, permanent = False):
         self.br_name = br_name
         self.grp_ip_str = grp_ip
         self.grp_ip = ba.ipv4str_to_ba('ipv4', grp_ip) if is_igmp else ba.ipv6str_to_ba('ipv6', grp_ip)
+        self.raw_if_name = if_name
         self.if_name = remove_ifname_tag(if_name)
         self.is_igmp = is_igmp
         self.expire = expire
+        self.permanent = permanent
+        # Time the expire value was read, the remaining time is reported from it
+        self.stamp = time.time()
 
     def __eq__(self, other):
         return (self.br_name == other.br_name and
@@ -638,107 +726,185 @@ class McastGroupInfo(object):
             ret += ' expire %f' % self.expire
         return ret
 
-def get_igmp_snooping_route(ip_type, br_name = None, cache_update = False):
-    cmd_response = []
-    if cache_update:
-        ret_val = {'mrouter': set(), 'group': set()}
-    else:
-        ret_val = {}
-    if run_command([bridge_cmd, '-s', '-d', 'mdb', 'show'], cmd_response, False) != 0:
-        log_err('Show MDB commmand execution failed')
-        return None
-    for line in cmd_response:
-        tokens = line.strip().split(None, 1)
-        if len(tokens) >= 2:
-            exp_time = None
-            rt_type = 'permanent'
-            if tokens[0] == 'dev':
-                m = re.search(
-                        'dev\s+(\S+)\s+port\s+(\S+)\s+grp\s+(\S+)\s+(permanent|temp)(.*)', line)
-                if m is None:
-                    log_err('Unknown MDB entry line format: %s' % line)
-                    return None
-                (dev_name, if_name, grp_ip, rt_type, tail_str) = m.groups()
-                if len(tail_str) > 0:
-                    m1 = re.search('\s+(offload|)\s+(vid\s+\S+\s+|)(\S+)', tail_str)
-                    if m1 is not None:
-                        (_, _, exp_time) = m1.groups()
-                is_entry = True
-            elif tokens[0] == 'router':
-                m = re.search('router ports on (\S+):(.*)', line)
-                if m is None:
-                    log_err('Unknown MROUTER entry line format: %s' % line)
-                    return None
-                (dev_name, tail_str) = m.groups()
-                mr_tokens = tail_str.split()
-                if len(mr_tokens) == 3 and (mr_tokens[2] == 'temp' or mr_tokens[2] == 'permanent'):
-                    try:
-                        exp_time = float(mr_tokens[1])
-                        single_line = False
-                    except ValueError:
-                        single_line = True
-                else:
-                    single_line = True
-                if single_line:
-                    if_list = mr_tokens
-                else:
-                    if_list = [mr_tokens[0]]
-                    rt_type = mr_tokens[2]
-                is_entry = False
-            else:
-                log_err('Unknown line format: %s' % line)
-                return None
-            if br_name is not None and br_name != dev_name:
-                continue
-
-            if not cache_update and dev_name not in ret_val:
-                ret_val[dev_name] = {}
+def _mdb_if_indextoname(ifindex):
+    if ifindex not in _mdb_if_names:
+        try:
+            _mdb_if_names[ifindex] = ifindex_utils.if_indextoname(ifindex)
+        except RuntimeError:
+            log_err('Interface index %d not found' % ifindex)
+            return None
+    return _mdb_if_names[ifindex]
+
+def _mdb_link_event(data, offset, end, nl_type):
+    # Drop the cached name of a deleted or renamed interface, offset is the ifinfomsg of the message
+    if offset + IFINFOMSG_LEN > end:
+        return
+    ifindex = struct.unpack_from('=i', data, offset + 4)[0]
+    if ifindex not in _mdb_if_names:
+        return
+    if nl_type == RTM_DELLINK:
+        del _mdb_if_names[ifindex]
+        return
+    for (attr_type, start, stop) in _nl_attrs(data, offset + IFINFOMSG_LEN, end):
+        if attr_type == IFLA_IFNAME:
+            if data[start:stop].rstrip('\0') != _mdb_if_names[ifindex]:
+                del _mdb_if_names[ifindex]
+            return
 
-            if is_entry:
-                if not ((ip_type == 'ipv4' and cps_utils.is_ipv4_addr(grp_ip)) or
-                        (ip_type == 'ipv6' and cps_utils.is_ipv6_addr(grp_ip)) or
-                        (ip_type == 'all')):
+def _nl_attrs(data, offset, end):
+    # Iterate (type, payload start, payload end) of the netlink attributes in data[offset:end]
+    while offset + 4 <= end:
+        nla_len, nla_type = struct.unpack_from('=HH', data, offset)
+        if nla_len < 4 or offset + nla_len > end:
+            break
+        yield (nla_type & 0x3fff, offset + 4, offset + nla_len)
+        offset += (nla_len + 3) & ~3
+
+def _parse_mdb_msg(data, offset, end, mdb_info, br_index = 0, rtr_permanent = True):
+    # Add the groups and mrouter ports of a RTM_NEWMDB/RTM_DELMDB message body to mdb_info.
+    # Mrouter port type is only carried by the dumps of newer kernels, rtr_permanent is used otherwise
+    if offset + BR_PORT_MSG_LEN > end:
+        return
+    _, msg_br_index = struct.unpack_from('=B3xI', data, offset)
+    if br_index != 0 and msg_br_index != br_index:
+        return
+    br_name = _mdb_if_indextoname(msg_br_index)
+    if br_name is None:
+        return
+
+    for (attr_type, start, stop) in _nl_attrs(data, offset + BR_PORT_MSG_LEN, end):
+        if attr_type == MDBA_MDB:
+            for (ent_type, ent_start, ent_stop) in _nl_attrs(data, start, stop):
+                if ent_type != MDBA_MDB_ENTRY:
                     continue
-                if ip_type == 'all':
-                    if cps_utils.is_ipv4_addr(grp_ip):
-                        is_igmp = True
-                    elif cps_utils.is_ipv6_addr(grp_ip):
-                        is_igmp = False
+                for (info_type, info_start, info_stop) in _nl_attrs(data, ent_start, ent_stop):
+                    if info_type != MDBA_MDB_ENTRY_INFO or info_stop - info_start < BR_MDB_ENTRY_LEN:
+                        continue
+                    # struct br_mdb_entry: ifindex, state, (flags, vid), addr.u at 8, addr.proto at 24
+                    port_index, state = struct.unpack_from('=IB', data, info_start)
+                    proto = struct.unpack_from('!H', data, info_start + 24)[0]
+                    if proto == ETH_P_IP:
+                        grp_ip = socket.inet_ntoa(data[info_start + 8:info_start + 12])
+                    elif proto == ETH_P_IPV6:
+                        grp_ip = socket.inet_ntop(socket.AF_INET6, data[info_start + 8:info_start + 24])
                     else:
-                        log_err('Invalid IP address format: %s' % grp_ip)
                         continue
-                else:
-                    is_igmp = (ip_type == 'ipv4')
+                    exp_time = None
+                    for (eattr_type, eattr_start, _) in _nl_attrs(data, info_start + BR_MDB_ENTRY_LEN, info_stop):
+                        if eattr_type == MDBA_MDB_EATTR_TIMER:
+                            exp_time = struct.unpack_from('=I', data, eattr_start)[0] / HZ
+                    if_name = _mdb_if_indextoname(port_index)
+                    if if_name is None:
+                        continue
+                    mdb_info['group'].add(McastGroupInfo(br_name, grp_ip, if_name, proto == ETH_P_IP,
+                                                         exp_time, state == MDB_PERMANENT))
+        elif attr_type == MDBA_ROUTER:
+            for (port_type, port_start, port_stop) in _nl_attrs(data, start, stop):
+                if port_type != MDBA_ROUTER_PORT or port_stop - port_start < 4:
+                    continue
+                port_index = struct.unpack_from('=I', data, port_start)[0]
+                exp_time = None
+                permanent = rtr_permanent
+                for (pattr_type, pattr_start, _) in _nl_attrs(data, port_start + 4, port_stop):
+                    if pattr_type == MDBA_ROUTER_PATTR_TIMER:
+                        exp_time = struct.unpack_from('=I', data, pattr_start)[0] / HZ
+                    elif pattr_type == MDBA_ROUTER_PATTR_TYPE:
+                        permanent = (struct.unpack_from('=B', data, pattr_start)[0] == MDB_RTR_TYPE_PERM)
+                if_name = _mdb_if_indextoname(port_index)
+                if if_name is None:
+                    continue
+                mdb_info['mrouter'].add(McastRouterInfo(br_name, if_name, exp_time, permanent))
 
-                if cache_update:
-                    ret_val['group'].add(McastGroupInfo(dev_name, grp_ip, if_name,
-                                                        is_igmp, exp_time))
-                else:
-                    if rt_type == 'permanent':
-                        attr_name = 'static-l2-multicast-group'
-                        group_info = {'group': grp_ip, 'interface': if_name}
-                    else:
-                        attr_name ='group'
-                        if exp_time is None:
-                            exp_time = 0.0
-                        group_info = {'address': grp_ip, 'interface': if_name, 'expire': int(float(exp_time))}
-                    if attr_name not in ret_val[dev_name]:
-                        ret_val[dev_name][attr_name] = {0: group_info}
-                    else:
-                        attr_idx = len(ret_val[dev_name][attr_name])
-                        ret_val[dev_name][attr_name][attr_idx] = group_info
-            else:
-                if cache_update:
-                    for if_name in if_list:
-                        ret_val['mrouter'].add(McastRouterInfo(dev_name, if_name, exp_time))
-                else:
-                    attr_name = 'static-mrouter-interface' if rt_type == 'permanent' else 'mrouter-interface'
-                    if attr_name not in ret_val[dev_name]:
-                        ret_val[dev_name][attr_name] = if_list
-                    else:
-                        ret_val[dev_name][attr_name].extend(if_list)
+def _mdb_dump(br_name = None):
+    # Read the groups and mrouter ports of one or all bridges with a RTM_GETMDB dump
+    br_index = 0
+    if br_name is not None:
+        try:
+            br_index = ifindex_utils.if_nametoindex(br_name)
+        except RuntimeError:
+            log_err('Bridge %s not found' % br_name)
+            return None
+
+    mdb_info = {'mrouter': set(), 'group': set()}
+    seq = int(time.time()) & 0xffffffff
+    req = struct.pack('=IHHII', NLMSG_HDR_LEN + BR_PORT_MSG_LEN, RTM_GETMDB, NLM_F_REQUEST | NLM_F_DUMP, seq, 0)
+    req += struct.pack('=B3xI', AF_BRIDGE, br_index)
+    sock = None
+    try:
+        sock = socket.socket(socket.AF_NETLINK, socket.SOCK_RAW, NETLINK_ROUTE)
+        sock.bind((0, 0))
+        sock.send(req)
+        done = False
+        while not done:
+            data = sock.recv(NL_RECV_BUF_LEN)
+            offset = 0
+            while offset + NLMSG_HDR_LEN <= len(data):
+                nl_len, nl_type, _, nl_seq, _ = struct.unpack_from('=IHHII', data, offset)
+                if nl_len < NLMSG_HDR_LEN or offset + nl_len > len(data):
+                    break
+                if nl_seq == seq:
+                    if nl_type == NLMSG_DONE:
+                        done = True
+                        break
+                    if nl_type == NLMSG_ERROR:
+                        err = struct.unpack_from('=i', data, offset + NLMSG_HDR_LEN)[0]
+                        if err != 0:
+                            log_err('MDB dump failed, error %d' % -err)
+                            return None
+                    elif nl_type == RTM_NEWMDB:
+                        _parse_mdb_msg(data, offset + NLMSG_HDR_LEN, offset + nl_len, mdb_info, br_index)
+                offset += (nl_len + 3) & ~3
+    except socket.error as e:
+        log_err('MDB dump failed: %s' % str(e))
+        return None
+    finally:
+        if sock is not None:
+            sock.close()
+    return mdb_info
+
+def _mdb_to_routes(groups, mrouters, ip_type, br_name = None):
+    # Convert group and mrouter entries to the per bridge attributes of the state object
+    ret_val = {}
+    now = time.time()
+    for group in groups:
+        if br_name is not None and br_name != group.br_name:
+            continue
+        if ip_type != 'all' and group.is_igmp != (ip_type == 'ipv4'):
+            continue
+        if group.br_name not in ret_val:
+            ret_val[group.br_name] = {}
+        if group.permanent:
+            attr_name = 'static-l2-multicast-group'
+            group_info = {'group': group.grp_ip_str, 'interface': group.raw_if_name}
+        else:
+            attr_name = 'group'
+            exp_time = 0.0
+            if group.expire is not None:
+                exp_time = max(0.0, group.expire - (now - group.stamp))
+            group_info = {'address': group.grp_ip_str, 'interface': group.raw_if_name, 'expire': int(round(exp_time))}
+        attrs = ret_val[group.br_name]
+        if attr_name not in attrs:
+            attrs[attr_name] = {0: group_info}
+        else:
+            attrs[attr_name][len(attrs[attr_name])] = group_info
+    for mrouter in mrouters:
+        if br_name is not None and br_name != mrouter.br_name:
+            continue
+        if mrouter.br_name not in ret_val:
+            ret_val[mrouter.br_name] = {}
+        attr_name = 'static-mrouter-interface' if mrouter.permanent else 'mrouter-interface'
+        ret_val[mrouter.br_name].setdefault(attr_name, []).append(mrouter.raw_if_name)
     return ret_val
 
+def get_igmp_snooping_route(ip_type, br_name = None, cache_update = False):
+    mdb_info = _mdb_dump(br_name)
+    if mdb_info is None:
+        log_err('MDB dump failed')
+        return None
+    if cache_update:
+        return mdb_info
+    return _mdb_to_routes(mdb_info['group'], mdb_info['mrouter'], ip_type, br_name)
+
 def get_intf_ip_addr(ip_type, if_name):
     info_list = ip_tool.get_if_details(if_name)
     if len(info_list) == 0:
@@ -819,14 +985,17 @@ def get_igmp_snooping_int(resp, module_name, ip_type, iplink_get_state, vlan_id)
         log_err('Failed to get VLAN ID to name mapping')
         return False
 
+    br_name = None
     if vlan_id is not None:
         log_info('Get IGMP information for VLAN %d' % vlan_id)
         if not vlan_id in vlan_map:
             log_err('VLAN ID %d is not in map' % vlan_id)
             return False
-        route_list = get_igmp_snooping_route(ip_type, vlan_map[vlan_id])
-    else:
-        route_list = get_igmp_snooping_route(ip_type)
+        br_name = vlan_map[vlan_id]
+    # Served from the event driven cache once it is synced with the kernel
+    route_list = polling_thread.get_routes(ip_type, br_name)
+    if route_list is None:
+        route_list = get_igmp_snooping_route(ip_type, br_name)
     if route_list is None:
         log_err('Failed to read IGMP route info')
         return False
@@ -887,6 +1056,15 @@ class McastSnoopCacheMgr(threading.Thread):
         self.vlan_map = {}
         # Queue for hash_max configuration
         self.hashmax_cfg_q = Queue.Queue()
+        # Netlink socket listening to kernel MDB changes
+        self.event_sock = None
+        # Set when MDB events were lost and the cache needs to be audited
+        self.resync = threading.Event()
+        # Cache was loaded from the kernel and can serve get requests
+        self.synced = False
+        # Kernel sends MDB notifications for mrouter ports (not sent by 3.16), until one
+        # is seen the mrouter ports are polled every MCAST_SNOOP_POLLING_INTERVAL
+        self.mrouter_events = False
 
         self.lock = threading.Lock()
 
@@ -960,6 +1138,24 @@ class McastSnoopCacheMgr(threading.Thread):
             else:
                 evt_obj.publish_mld_events(evt_data, op)
 
+    def map_add(self, item):
+        if isinstance(item, McastGroupInfo):
+            self.br_group_map.setdefault(item.br_name, set()).add(item)
+        else:
+            self.br_mrouter_map.setdefault(item.br_name, set()).add(item.if_name)
+
+    def map_remove(self, item):
+        if isinstance(item, McastGroupInfo):
+            if item.br_name in self.br_group_map:
+                self.br_group_map[item.br_name].discard(item)
+            else:
+                log_err('Bridge %s not found in cached group map' % item.br_name)
+        else:
+            if item.br_name in self.br_mrouter_map:
+                self.br_mrouter_map[item.br_name].discard(item.if_name)
+            else:
+                log_err('Bridge %s not found in cached mrouter map' % item.br_name)
+
     def update_cache_set(self, new_set, mc_group):
         if mc_group:
             old_set = self.group_set
@@ -967,52 +1163,133 @@ class McastSnoopCacheMgr(threading.Thread):
             old_set = self.mrouter_set
         del_set = old_set.difference(new_set)
         if len(del_set) > 0:
-            log_info('Polling status: %d %s were deleted' % (len(del_set),
-                                                             'groups' if mc_group else 'mrouters'))
+            log_info('Audit status: %d %s were deleted' % (len(del_set),
+                                                           'groups' if mc_group else 'mrouters'))
         add_set = new_set.difference(old_set)
         if len(add_set) > 0:
-            log_info('Polling status: %d %s were added' % (len(add_set),
+            log_info('Audit status: %d %s were added' % (len(add_set),
                      'groups' if mc_group else 'mrouters'))
+        self.publish_event(del_set, 'delete')
+        self.publish_event(add_set, 'create')
         if mc_group:
-            self.publish_event(del_set, 'delete')
-            for group in del_set:
-                if group.br_name in self.br_group_map:
-                    self.br_group_map[group.br_name].discard(group)
-                else:
-                    log_err('Bridge %s not found in cached group map' % group.br_name)
-            self.publish_event(add_set, 'create')
-            for group in add_set:
-                if group.br_name not in self.br_group_map:
-                    self.br_group_map[group.br_name] = set()
-                self.br_group_map[group.br_name].add(group)
+            # Group map is rebuilt so that the kept groups carry the expire time of the dump
+            self.br_group_map.clear()
+            for group in new_set:
+                self.map_add(group)
             self.group_set = new_set
         else:
-            self.publish_event(del_set, 'delete')
             for mrouter in del_set:
-                if mrouter.br_name in self.br_mrouter_map:
-                    self.br_mrouter_map[mrouter.br_name].discard(mrouter.if_name)
-                else:
-                    log_err('Bridge %s not found in cached mrouter map' % mrouter.br_name)
-            self.publish_event(add_set, 'create')
+                self.map_remove(mrouter)
             for mrouter in add_set:
-                if mrouter.br_name not in self.br_mrouter_map:
-                    self.br_mrouter_map[mrouter.br_name] = set()
-                self.br_mrouter_map[mrouter.br_name].add(mrouter.if_name)
+                self.map_add(mrouter)
             self.mrouter_set = new_set
         return True
 
     def update_cache(self):
         self.vlan_map.clear()
+        _mdb_if_names.clear()
         mc_snoop_info = get_igmp_snooping_route('all', None, True)
         if mc_snoop_info is None:
             log_err('Failed reading multicast snooping info')
-            return
+            return False
         if not self.update_cache_set(mc_snoop_info['mrouter'], False):
             log_err('Failed to update cached mrouter set')
-            return
+            return False
         if not self.update_cache_set(mc_snoop_info['group'], True):
             log_err('Failed to update cached group set')
-            return
+            return False
+        return True
+
+    def update_mrouters(self):
+        # Short poll of the mrouter ports for kernels that do not notify their changes
+        mdb_info = _mdb_dump()
+        if mdb_info is None:
+            log_err('Failed reading multicast snooping mrouter info')
+            return False
+        return self.update_cache_set(mdb_info['mrouter'], False)
+
+    def apply_event(self, mdb_info, is_add):
+        # Apply the groups and mrouters of a kernel MDB event to the cache
+        for (new_set, mc_group) in ((mdb_info['group'], True), (mdb_info['mrouter'], False)):
+            cache_set = self.group_set if mc_group else self.mrouter_set
+            if is_add:
+                # Known entries are kept, expire time and router type are refreshed by the audit
+                add_set = new_set.difference(cache_set)
+                self.publish_event(add_set, 'create')
+                for item in add_set:
+                    self.map_add(item)
+                    cache_set.add(item)
+            else:
+                del_set = new_set.intersection(cache_set)
+                self.publish_event(del_set, 'delete')
+                for item in del_set:
+                    self.map_remove(item)
+                    cache_set.discard(item)
+
+    def open_event_sock(self):
+        try:
+            sock = socket.socket(socket.AF_NETLINK, socket.SOCK_RAW, NETLINK_ROUTE)
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, NL_EVENT_SOCK_RCVBUF)
+            # Link events keep the cached interface names current
+            sock.bind((0, (1 << (RTNLGRP_MDB - 1)) | (1 << (RTNLGRP_LINK - 1))))
+        except socket.error as e:
+            log_err('Failed to open MDB event socket: %s' % str(e))
+            return False
+        self.event_sock = sock
+        return True
+
+    def event_loop(self):
+        while True:
+            try:
+                data = self.event_sock.recv(NL_RECV_BUF_LEN)
+            except socket.error as e:
+                if e.errno == errno.ENOBUFS:
+                    log_info('MDB events were lost, re-sync with kernel')
+                    self.resync.set()
+                elif e.errno != errno.EINTR:
+                    log_err('Failed to read MDB event: %s' % str(e))
+                    time.sleep(1)
+                continue
+            self.handle_event(data)
+
+    def handle_event(self, data):
+        # Apply the netlink messages read from the event socket
+        offset = 0
+        while offset + NLMSG_HDR_LEN <= len(data):
+            nl_len, nl_type = struct.unpack_from('=IH', data, offset)
+            if nl_len < NLMSG_HDR_LEN or offset + nl_len > len(data):
+                break
+            if nl_type == RTM_NEWMDB or nl_type == RTM_DELMDB:
+                mdb_info = {'mrouter': set(), 'group': set()}
+                self.lock.acquire()
+                _parse_mdb_msg(data, offset + NLMSG_HDR_LEN, offset + nl_len, mdb_info,
+                               rtr_permanent = False)
+                if len(mdb_info['mrouter']) > 0:
+                    self.mrouter_events = True
+                if self.synced:
+                    self.apply_event(mdb_info, nl_type == RTM_NEWMDB)
+                self.lock.release()
+            elif nl_type == RTM_NEWLINK or nl_type == RTM_DELLINK:
+                self.lock.acquire()
+                _mdb_link_event(data, offset + NLMSG_HDR_LEN, offset + nl_len, nl_type)
+                self.lock.release()
+            offset += (nl_len + 3) & ~3
+
+    def get_routes(self, ip_type, br_name = None):
+        # Answer get request from the cache, None if it is not synced with kernel yet
+        self.lock.acquire()
+        try:
+            if not self.synced:
+                return None
+            if br_name is None:
+                groups = self.group_set
+                mrouters = self.mrouter_set
+            else:
+                groups = self.br_group_map.get(br_name, set())
+                mrouters = [m for m in self.mrouter_set if m.br_name == br_name]
+            return _mdb_to_routes(groups, mrouters, ip_type, br_name)
+        finally:
+            self.lock.release()
 
     def apply_static_mrouter_configs(self):
         # Apply static mrouter port configuration
@@ -1034,13 +1311,28 @@ class McastSnoopCacheMgr(threading.Thread):
         return True
 
     def run(self):
+        # Subscribe before the initial dump so that no change is missed in between
+        if self.open_event_sock():
+            event_thread = threading.Thread(target = self.event_loop,
+                                            name = 'Multicast Snooping event listener')
+            event_thread.daemon = True
+            event_thread.start()
         polling_timeout = MCAST_SNOOP_POLLING_INTERVAL
         do_polling = True
+        last_audit = None
         while True:
             if do_polling:
                 self.lock.acquire()
                 self.apply_static_mrouter_configs()
-                self.update_cache()
+                # Kernel events keep the cache current, the full dump only audits it
+                if (last_audit is None or self.resync.is_set() or self.event_sock is None or
+                    time.time() - last_audit >= MCAST_SNOOP_AUDIT_INTERVAL):
+                    self.resync.clear()
+                    if self.update_cache():
+                        last_audit = time.time()
+                        self.synced = self.event_sock is not None
+                elif not self.mrouter_events:
+                    self.update_mrouters()
                 self.lock.release()
             try:
                 start_time = time.time()
@@ -1056,22 +1348,28 @@ class McastSnoopCacheMgr(threading.Thread):
                 polling_timeout = MCAST_SNOOP_POLLING_INTERVAL
                 do_polling = True
                 continue
-            log_debug('Setting hash_max %d to bridge %s' % (max_grps, br_name))
-            if not _update_file_system(_get_path_per_vlan_configs(br_name, "hash_max"), max_grps):
-                # File update might fail because kernel need some "grace period" to release old hash table after mdb rebuild
-                # by multicast snooping enabling operation, and does not allow setting hash_max during the meantime. So we have
-                # to wait and re-try
-                try_count += 1
-                if try_count >= MAX_HASHMAX_CFG_TRY_COUNT:
-                    log_err('Failed to set hash_mas after re-trying %d times' % MAX_HASHMAX_CFG_TRY_COUNT)
-                else:
-                    if self.hashmax_cfg_to_queue(br_name, max_grps, try_count):
-                        continue
-                    else:
+            # Drain the queued bridges and set hash_max on all of them with one batch
+            pending = [(br_name, max_grps, try_count)]
+            while True:
+                try:
+                    pending.append(self.hashmax_cfg_q.get_nowait())
+                except Queue.Empty:
+                    break
+            log_debug('Setting hash_max on %d bridges' % len(pending))
+            failed = _bridge_link_set_batch([(br, [('mcast_hash_max', grps)]) for (br, grps, cnt) in pending])
+            for (br_name, max_grps, try_count) in pending:
+                if br_name in failed:
+                    # Setting might fail because kernel need some "grace period" to release old hash table after mdb rebuild
+                    # by multicast snooping enabling operation, and does not allow setting hash_max during the meantime. So we have
+                    # to wait and re-try
+                    try_count += 1
+                    if try_count >= MAX_HASHMAX_CFG_TRY_COUNT:
+                        log_err('Failed to set hash_mas after re-trying %d times' % MAX_HASHMAX_CFG_TRY_COUNT)
+                    elif not self.hashmax_cfg_to_queue(br_name, max_grps, try_count):
                         log_err('Failed to set task for bridge %s back to queue' % br_name)
-            else:
-                log_debug('Successfully setting hash_max for bridge %s' % br_name)
-            self.hashmax_cfg_q.task_done()
+                else:
+                    log_debug('Successfully setting hash_max for bridge %s' % br_name)
+                self.hashmax_cfg_q.task_done()
 
 polling_thread = McastSnoopCacheMgr()
 polling_thread.daemon = True
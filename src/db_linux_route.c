@@ -39,18 +39,27 @@
 #include "std_utils.h"
 #include "ds_api_linux_route.h"
 #include "nas_os_l3_utils.h"
+#include "nas_os_trace.h"
+#include "nas_os_nl_page.h"
 
 #include <arpa/inet.h>
 #include <linux/netlink.h>
 #include <sys/socket.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 typedef struct {
     int family;
+    size_t max_count;                       /* 0 - whole table */
+    bool has_start;
+    uint8_t start[NAS_OS_NL_PAGE_KEY_LEN];  /* routes above this key */
 } route_filter_t;
 
+/* Dump buffer - large enough for a full dump message batch of the kernel */
+#define NL_DUMP_BUFF_LEN                  (32*1024)
+
 #define NAS_RT_V4_PREFIX_LEN              (8 * HAL_INET4_LEN)
 #define NAS_RT_V6_PREFIX_LEN              (8 * HAL_INET6_LEN)
 
@@ -175,6 +184,11 @@ static inline void nas_os_log_route_info(struct nlmsghdr *hdr, int rt_msg_type,
                             ((struct in6_addr *) nla_data((struct nlattr*)attrs[RTA_GATEWAY])),
                             addr_str1, INET6_ADDRSTRLEN))) : "NA"),
                ((attrs[RTA_OIF]!=NULL) ? *((unsigned int *)nla_data(attrs[RTA_OIF])): -1));
+
+    NAS_OS_TRACE("ROUTE-EVENT", "NLM type:0x%x flags:0x%x VRF-id:%d af:%d len:%d tbl:%d proto:%d type:%d oif:%d",
+                 hdr->nlmsg_type, hdr->nlmsg_flags, vrf_id, rtmsg->rtm_family, rtmsg->rtm_dst_len,
+                 rtmsg->rtm_table, rtmsg->rtm_protocol, rtmsg->rtm_type,
+                 ((attrs[RTA_OIF]!=NULL) ? *((int *)nla_data(attrs[RTA_OIF])): -1));
 }
 
 //db_route_t
@@ -433,20 +447,60 @@ bool nl_to_route_info(int rt_msg_type, struct nlmsghdr *hdr, cps_api_object_t ob
     return true;
 }
 
+/* Page key of a route: family, prefix, prefix length | table, metric */
+#define NAS_RT_PAGE_CURSOR_LEN (1 + HAL_INET6_LEN + 1)
+
+static void nas_rt_page_key(uint8_t *key, uint8_t family, const void *prefix, size_t prefix_len,
+                            uint8_t dst_len, uint32_t table, uint32_t priority) {
+    memset(key, 0, NAS_OS_NL_PAGE_KEY_LEN);
+    key[0] = family;
+    if (prefix != NULL) {
+        memcpy(&key[1], prefix, (prefix_len < HAL_INET6_LEN) ? prefix_len : HAL_INET6_LEN);
+    }
+    key[1 + HAL_INET6_LEN] = dst_len;
+    table = htonl(table);
+    priority = htonl(priority);
+    memcpy(&key[NAS_RT_PAGE_CURSOR_LEN], &table, sizeof(table));
+    memcpy(&key[NAS_RT_PAGE_CURSOR_LEN + sizeof(table)], &priority, sizeof(priority));
+}
+
+static bool nl_route_page_key(struct nlmsghdr *nh, uint8_t *key) {
+    struct rtmsg *rtmsg = (struct rtmsg *)NLMSG_DATA(nh);
+    if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(*rtmsg))) return false;
+
+    struct nlattr *attrs[__RTA_MAX];
+    memset(attrs,0,sizeof(attrs));
+    if (nla_parse(attrs,__RTA_MAX,nlmsg_attrdata(nh, sizeof(*rtmsg)),
+                  nlmsg_attrlen(nh,sizeof(*rtmsg)))!=0) {
+        return false;
+    }
+    uint32_t table = (attrs[RTA_TABLE] != NULL) ? *(uint32_t *)nla_data(attrs[RTA_TABLE]) : rtmsg->rtm_table;
+    uint32_t priority = (attrs[RTA_PRIORITY] != NULL) ? *(uint32_t *)nla_data(attrs[RTA_PRIORITY]) : 0;
+    nas_rt_page_key(key, rtmsg->rtm_family,
+                    (attrs[RTA_DST] != NULL) ? nla_data(attrs[RTA_DST]) : NULL,
+                    (attrs[RTA_DST] != NULL) ? nla_len(attrs[RTA_DST]) : 0,
+                    rtmsg->rtm_dst_len, table, priority);
+    return true;
+}
+
 static bool process_route_and_add_to_list(int sock, int rt_msg_type, struct nlmsghdr *nh,
         void *context, uint32_t vrf_id) {
-    cps_api_object_list_t *list = (cps_api_object_list_t*) context;
-    cps_api_object_t obj=cps_api_object_create();
+    nas_os_nl_page_t *page = (nas_os_nl_page_t*) context;
+    uint8_t key[NAS_OS_NL_PAGE_KEY_LEN];
 
-    if (!cps_api_object_list_append(*list,obj)) {
-        cps_api_object_delete(obj);
-        return false;
+    /* Routes not in the page are skipped before the conversion */
+    if (!nl_route_page_key(nh, key) || !nas_os_nl_page_want(page, key)) {
+        return true;
     }
+    cps_api_object_t obj=cps_api_object_create();
+    if (obj == NULL) return false;
 
+    /* Routes not published (local, link local, cloned..) are skipped, the rest of the dump is still read */
     if (!nl_to_route_info(nh->nlmsg_type,nh,obj,context, NAS_DEFAULT_VRF_ID)) {
-        return false;
+        cps_api_object_delete(obj);
+        return true;
     }
-    return true;
+    return nas_os_nl_page_add(page, key, obj);
 }
 
 bool nl_request_existing_routes(int sock, int family, int req_id) {
@@ -457,17 +511,52 @@ bool read_all_routes(cps_api_object_list_t list, route_filter_t *filter) {
     int sock = nas_nl_sock_create(NL_DEFAULT_VRF_NAME, nas_nl_sock_T_ROUTE, false);
     const int RANDOM_REQ_ID = 0x101;
     if (sock==-1) return false;
-    bool rc = nl_request_existing_routes(sock,filter->family, RANDOM_REQ_ID);
 
+    nas_os_nl_page_t page;
+    nas_os_nl_page_init(&page, list, filter->max_count, NAS_RT_PAGE_CURSOR_LEN,
+                        filter->has_start ? filter->start : NULL);
+
+    bool rc = nl_request_existing_routes(sock,filter->family, RANDOM_REQ_ID);
     if (rc) {
-        char buff[1024];
-        rc = netlink_tools_process_socket(sock,process_route_and_add_to_list,&list,
-                buff,sizeof(buff),&RANDOM_REQ_ID,NULL, NL_DEFAULT_VRF_ID);
+        char *buff = (char*)malloc(NL_DUMP_BUFF_LEN);
+        rc = (buff != NULL) && netlink_tools_process_socket(sock,process_route_and_add_to_list,&page,
+                buff,NL_DUMP_BUFF_LEN,&RANDOM_REQ_ID,NULL, NL_DEFAULT_VRF_ID);
+        free(buff);
     }
     close(sock);
+    nas_os_nl_page_done(&page, "Route");
     return rc;
 }
 
+/*
+ * A filter with a page count is a paged read, its prefix is the start key (the last
+ * object of the previous page). Otherwise the family selects the routes of a family.
+ */
+static void nas_rt_read_filter(cps_api_object_t filt, route_filter_t *rf) {
+    if (filt == NULL) return;
+
+    cps_api_object_attr_t af = cps_api_object_attr_get(filt, BASE_ROUTE_OBJ_ENTRY_AF);
+    cps_api_object_attr_t prefix = cps_api_object_attr_get(filt, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX);
+    cps_api_object_attr_t pref_len = cps_api_object_attr_get(filt, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN);
+    cps_api_object_attr_t count = cps_api_object_attr_get(filt, cps_api_if_ROUTE_A_PAGE_COUNT);
+
+    if (count != NULL) rf->max_count = cps_api_object_attr_data_u32(count);
+    if (af == NULL) return;
+
+    uint32_t family = cps_api_object_attr_data_u32(af);
+    /* The default route has no prefix, only a prefix length */
+    if ((count == NULL) || ((prefix == NULL) && (pref_len == NULL))) {
+        rf->family = family;
+        return;
+    }
+    rf->has_start = true;
+    nas_rt_page_key(rf->start, family, (prefix != NULL) ? cps_api_object_attr_data_bin(prefix) : NULL,
+                    (prefix != NULL) ? cps_api_object_attr_len(prefix) : 0,
+                    (pref_len != NULL) ? cps_api_object_attr_data_u32(pref_len) : 0, 0, 0);
+    /* IPv4 routes are ahead of the IPv6 routes in the key order */
+    if (family == AF_INET6) rf->family = AF_INET6;
+    if (rf->max_count == 0) rf->max_count = NAS_OS_NL_PAGE_DFLT_COUNT;
+}
 
 static cps_api_return_code_t db_read_function (void * context, cps_api_get_params_t * param, size_t key_ix) {
     cps_api_return_code_t rc = cps_api_ret_code_OK;
@@ -480,7 +569,7 @@ static cps_api_return_code_t db_read_function (void * context, cps_api_get_param
 
     route_filter_t rf;
     memset(&rf,0,sizeof(rf));
-    //!TODO need to handle the filter requests (using the received key)
+    nas_rt_read_filter(cps_api_object_list_get(param->filters,key_ix), &rf);
     read_all_routes(param->list,&rf);
 
     return rc;
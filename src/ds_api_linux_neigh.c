@@ -38,9 +38,12 @@
 #include "cps_class_map.h"
 #include "nas_os_l3_utils.h"
 #include "hal_if_mapping.h"
+#include "nas_os_nl_page.h"
 
 #include <sys/socket.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <stdio.h>
@@ -245,43 +248,128 @@ bool nl_to_neigh_info(int rt_msg_type, struct nlmsghdr *hdr, cps_api_object_t ob
     return true;
 }
 
-static bool process_neigh_and_add_to_list(int sock, int rt_msg_type, struct nlmsghdr *nh, void *context, uint32_t vrf_id) {
-    cps_api_object_list_t *list = (cps_api_object_list_t*) context;
-    cps_api_object_t obj=cps_api_object_create();
-    if (!cps_api_object_list_append(*list,obj)) {
-        cps_api_object_delete(obj);
-        return false;
+/* Page key of a neighbor: family, address, ifindex */
+#define NAS_NBR_PAGE_CURSOR_LEN (1 + HAL_INET6_LEN + sizeof(uint32_t))
+
+static void nas_nbr_page_key(uint8_t *key, uint8_t family, const void *addr, size_t addr_len,
+                             uint32_t ifindex) {
+    memset(key, 0, NAS_OS_NL_PAGE_KEY_LEN);
+    key[0] = family;
+    if (addr != NULL) {
+        memcpy(&key[1], addr, (addr_len < HAL_INET6_LEN) ? addr_len : HAL_INET6_LEN);
     }
-    if (!nl_to_neigh_info(nh->nlmsg_type,nh,obj,context, vrf_id)) {
+    ifindex = htonl(ifindex);
+    memcpy(&key[1 + HAL_INET6_LEN], &ifindex, sizeof(ifindex));
+}
+
+static bool nl_neigh_page_key(struct nlmsghdr *nh, uint8_t *key) {
+    struct ndmsg *ndmsg = (struct ndmsg *)NLMSG_DATA(nh);
+    if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(*ndmsg))) return false;
+
+    struct nlattr *attrs[__NDA_MAX];
+    memset(attrs,0,sizeof(attrs));
+    if (nla_parse(attrs,__NDA_MAX,nlmsg_attrdata(nh, sizeof(*ndmsg)),
+                  nlmsg_attrlen(nh,sizeof(*ndmsg)))!=0) {
         return false;
     }
+    nas_nbr_page_key(key, ndmsg->ndm_family,
+                     (attrs[NDA_DST] != NULL) ? nla_data(attrs[NDA_DST]) : NULL,
+                     (attrs[NDA_DST] != NULL) ? nla_len(attrs[NDA_DST]) : 0,
+                     ndmsg->ndm_ifindex);
     return true;
 }
 
-static bool read_all_neighbours(cps_api_object_list_t list, uint32_t vrf_id) {
+static bool process_neigh_and_add_to_list(int sock, int rt_msg_type, struct nlmsghdr *nh, void *context, uint32_t vrf_id) {
+    nas_os_nl_page_t *page = (nas_os_nl_page_t*) context;
+    uint8_t key[NAS_OS_NL_PAGE_KEY_LEN];
+
+    /* Neighbors not in the page are skipped before the conversion */
+    if (!nl_neigh_page_key(nh, key) || !nas_os_nl_page_want(page, key)) {
+        return true;
+    }
+    cps_api_object_t obj=cps_api_object_create();
+    if (obj == NULL) return false;
+
+    /* Neighbors not published (probe, reserved interfaces..) are skipped, the rest of the dump is still read */
+    if (!nl_to_neigh_info(nh->nlmsg_type,nh,obj,context, vrf_id)) {
+        cps_api_object_delete(obj);
+        return true;
+    }
+    return nas_os_nl_page_add(page, key, obj);
+}
+
+typedef struct {
+    int family;                             /* AF_UNSPEC - IPv4 and IPv6 */
+    size_t max_count;                       /* 0 - whole table */
+    bool has_start;
+    uint8_t start[NAS_OS_NL_PAGE_KEY_LEN];  /* neighbors above this key */
+} nbr_filter_t;
+
+/* Dump buffer - large enough for a full dump message batch of the kernel */
+#define NL_DUMP_BUFF_LEN (32*1024)
+
+static bool read_all_neighbours(cps_api_object_list_t list, uint32_t vrf_id, nbr_filter_t *filter) {
     int sock = nas_nl_sock_create(NL_DEFAULT_VRF_NAME, nas_nl_sock_T_NEI,false);
     if (sock<0) return false;
 
-    bool rc = false;
+    char *buff = (char*)malloc(NL_DUMP_BUFF_LEN);
+    if (buff == NULL) {
+        close(sock);
+        return false;
+    }
+
+    nas_os_nl_page_t page;
+    nas_os_nl_page_init(&page, list, filter->max_count, NAS_NBR_PAGE_CURSOR_LEN,
+                        filter->has_start ? filter->start : NULL);
+
+    /* IPv4 neighbors are ahead of the IPv6 neighbors in the key order */
+    bool rc = true;
     int RANDOM_ID=21323;
-    if (nl_neigh_get_all_request(sock,AF_INET,RANDOM_ID)) {
-        char buff[1024];
+    if ((filter->family != AF_INET6) && nl_neigh_get_all_request(sock,AF_INET,RANDOM_ID)) {
         rc = netlink_tools_process_socket(sock,
-                process_neigh_and_add_to_list,&list,
-                buff,sizeof(buff),&RANDOM_ID,NULL, vrf_id);
+                process_neigh_and_add_to_list,&page,
+                buff,NL_DUMP_BUFF_LEN,&RANDOM_ID,NULL, vrf_id);
     }
 
-    if (rc && nl_neigh_get_all_request(sock,AF_INET6,++RANDOM_ID)) {
-        char buff[1024];
+    if (rc && (filter->family != AF_INET) && nl_neigh_get_all_request(sock,AF_INET6,++RANDOM_ID)) {
         rc = netlink_tools_process_socket(sock,
-                process_neigh_and_add_to_list,&list,
-                buff,sizeof(buff),&RANDOM_ID,NULL, vrf_id);
+                process_neigh_and_add_to_list,&page,
+                buff,NL_DUMP_BUFF_LEN,&RANDOM_ID,NULL, vrf_id);
     }
 
+    free(buff);
     close(sock);
+    nas_os_nl_page_done(&page, "Neighbor");
     return rc;
 }
 
+/*
+ * A filter with a page count is a paged read, its address is the start key (the last
+ * object of the previous page). Otherwise the family selects the neighbors of a family.
+ */
+static void nas_nbr_read_filter(cps_api_object_t filt, nbr_filter_t *nf) {
+    if (filt == NULL) return;
+
+    cps_api_object_attr_t af = cps_api_object_attr_get(filt, BASE_ROUTE_OBJ_NBR_AF);
+    cps_api_object_attr_t addr = cps_api_object_attr_get(filt, BASE_ROUTE_OBJ_NBR_ADDRESS);
+    cps_api_object_attr_t ifindex = cps_api_object_attr_get(filt, BASE_ROUTE_OBJ_NBR_IFINDEX);
+    cps_api_object_attr_t count = cps_api_object_attr_get(filt, cps_api_if_NEIGH_A_PAGE_COUNT);
+
+    if (count != NULL) nf->max_count = cps_api_object_attr_data_u32(count);
+    if (af == NULL) return;
+
+    uint32_t family = cps_api_object_attr_data_u32(af);
+    if ((count == NULL) || (addr == NULL)) {
+        nf->family = family;
+        return;
+    }
+    nf->has_start = true;
+    nas_nbr_page_key(nf->start, family, cps_api_object_attr_data_bin(addr), cps_api_object_attr_len(addr),
+                     (ifindex != NULL) ? cps_api_object_attr_data_u32(ifindex) : 0);
+    if (family == AF_INET6) nf->family = AF_INET6;
+    if (nf->max_count == 0) nf->max_count = NAS_OS_NL_PAGE_DFLT_COUNT;
+}
+
 static cps_api_return_code_t db_read_function (void * context, cps_api_get_params_t * param,
         size_t key_ix) {
 
@@ -293,8 +381,12 @@ static cps_api_return_code_t db_read_function (void * context, cps_api_get_param
         return cps_api_ret_code_OK;
     }
 
+    nbr_filter_t nf;
+    memset(&nf,0,sizeof(nf));
+    nas_nbr_read_filter(cps_api_object_list_get(param->filters,key_ix), &nf);
+
     /* @@TODO Use the appropriate vrf-id to read the neighbors from non-default VRF context */
-    read_all_neighbours(param->list, NL_DEFAULT_VRF_ID);
+    read_all_neighbours(param->list, NL_DEFAULT_VRF_ID, &nf);
 
     return rc;
 }
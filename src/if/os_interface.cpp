@@ -23,12 +23,21 @@
 #include "private/os_interface_cache_utils.h"
 #include "private/nas_os_if_conversion_utils.h"
 #include "private/nas_os_l3_utils.h"
+#include "private/os_interface_damp.h"
+#include "private/nas_os_trace.h"
+#include "private/nas_os_br_attr.h"
+#include "private/nas_os_vlan_utils.h"
+#include "private/nas_os_if_resolve.h"
+#include "private/nas_os_rt_shadow.h"
+#include "private/nas_os_if_stats.h"
+#include "nas_os_mcast_snoop.h"
 
 #include "netlink_tools.h"
 #include "nas_nlmsg.h"
 #include "nas_nlmsg_object_utils.h"
 #include "nas_os_int_utils.h"
 #include "nas_os_interface.h"
+#include "nas_os_l3.h"
 #include "vrf-mgmt.h"
 #include "std_utils.h"
 
@@ -47,6 +56,7 @@
 #include "dell-base-if-vlan.h"
 #include "dell-base-common.h"
 #include "ds_api_linux_interface.h"
+#include "hal_if_mapping.h"
 
 #include "iana-if-type.h"
 #include "ietf-interfaces.h"
@@ -64,6 +74,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <atomic>
 #include <map>
 #include <unordered_map>
 
@@ -266,6 +277,8 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
 
     EV_LOGGING(NAS_OS, INFO, "NET-MAIN", "VRF-id:%d msgType %d, ifindex %d change 0x%x flags 0x%x\n",
            vrf_id, rt_msg_type, ifmsg->ifi_index, ifmsg->ifi_change, ifmsg->ifi_flags);
+    NAS_OS_TRACE("NET-MAIN", "VRF-id:%d msgType %d, ifindex %d change 0x%x flags 0x%x",
+                 vrf_id, rt_msg_type, ifmsg->ifi_index, ifmsg->ifi_change, ifmsg->ifi_flags);
 
     auto it = _to_op_type.find(rt_msg_type);
     if (it==_to_op_type.end()) {
@@ -295,6 +308,8 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
         (ifmsg->ifi_flags & IFF_UP) ? true :false);
 
     ifinfo.parent_idx = 0;
+    ifinfo.master_idx = 0;
+    ifinfo.link_valid = false;
     ifinfo.ev_mask = OS_IF_CHANGE_NONE;
     ifinfo.admin = (ifmsg->ifi_flags & IFF_UP) ? true :false;
     ifinfo.oper = (ifmsg->ifi_flags & IFF_RUNNING) ? true :false;
@@ -333,6 +348,27 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
         details.if_name = static_cast <char *> (nla_data(details._attrs[IFLA_IFNAME]));
     }
 
+    if (details._family != AF_BRIDGE) {
+        nas_os_if_resolve_link_event(rt_msg_type, details._ifindex,
+                                     details._attrs[IFLA_IFNAME] ? details.if_name.c_str() : NULL);
+        if (nas_os_route_idempotent_mode_get()) {
+            nas_os_rt_shadow_if_event(rt_msg_type, details._ifindex, ifmsg->ifi_flags);
+        }
+        /* An index re-used by a new interface counts again from zero */
+        if (rt_msg_type == RTM_DELLINK) nas_os_if_stats_engine_if_reset(details._ifindex);
+    }
+
+    if (vrf_id == NAS_DEFAULT_VRF_ID && details._family != AF_BRIDGE) {
+        /* Bridge knobs carried in the link message are answered without sysfs reads */
+        nas_os_br_attr_link_event(rt_msg_type, details._ifindex,
+                                  details._attrs[IFLA_IFNAME] ? details.if_name.c_str() : NULL,
+                                  details._info_kind, details._linkinfo[IFLA_INFO_DATA]);
+        nas_os_mcast_snoop_link_event(rt_msg_type, details._ifindex,
+                                      details._attrs[IFLA_IFNAME] ? details.if_name.c_str() : NULL);
+        nas_os_tagged_intf_link_event(rt_msg_type, details._ifindex, details._info_kind,
+                                      details._attrs[IFLA_LINK], details._linkinfo[IFLA_INFO_DATA]);
+    }
+
     if(details._attrs[IFLA_MTU]!=NULL) {
         int *mtu = (int *) nla_data(details._attrs[IFLA_MTU]);
         cps_api_object_attr_add_u32(obj, DELL_IF_IF_INTERFACES_INTERFACE_MTU,(*mtu + NAS_LINK_MTU_HDR_SIZE));
@@ -352,6 +388,7 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
 
         cps_api_object_attr_add_u32(obj,BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_MASTER,
                                    *(int *)nla_data(details._attrs[IFLA_MASTER]));
+        ifinfo.master_idx = *(int *)nla_data(details._attrs[IFLA_MASTER]);
     }
     if (details._info_kind != nullptr) {
         if ( nas_os_info_kind_to_intf_type(details._info_kind, &details._type) != STD_ERR_OK) {
@@ -378,6 +415,7 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
     ifinfo.parent_idx = details.parent_idx;
 
     bool evt_publish = true;
+    bool damp_candidate = false;
     /* Dont update the intf cache for non-default VRF since if-index can be same in multiple VRFs */
     if (vrf_id == NAS_DEFAULT_VRF_ID) {
         if (!fill) {
@@ -385,6 +423,9 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
         } else {
             track_change = fill->if_info_update(ifmsg->ifi_index, ifinfo);
         }
+        if (details._type == BASE_CMN_INTERFACE_TYPE_MANAGEMENT && _if_op != cps_api_oper_DELETE) {
+            os_interface_mgmt_refresh(ifmsg->ifi_index, details.if_name);
+        }
 
         /*
          * Delete the interface from cache if interface type is not vlan or lag
@@ -404,8 +445,11 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
             }
         }
 
-        if((details._type == BASE_CMN_INTERFACE_TYPE_L2_PORT) ||
-           ((details._type == BASE_CMN_INTERFACE_TYPE_LAG) && (details._attrs[IFLA_MASTER]!=NULL))) {
+        bool mbr_update = (details._type == BASE_CMN_INTERFACE_TYPE_L2_PORT) ||
+            ((details._type == BASE_CMN_INTERFACE_TYPE_LAG) && (details._attrs[IFLA_MASTER]!=NULL));
+        damp_candidate = !mbr_update && (details._op == cps_api_oper_SET);
+
+        if(mbr_update) {
             /*
              * If member addition/deletion in the LAG or bridge
              */
@@ -452,10 +496,6 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
                 evt_publish = false;
         }
     }
-    if (p_pub_evt != NULL) {
-        *p_pub_evt = evt_publish;
-    }
-
     const char *vrf_name = nas_os_get_vrf_name(vrf_id);
     if (vrf_name == NULL) {
         EV_LOGGING(NAS_OS, ERR, "NET-MAIN", "VRF id:%d to name mapping not present, index %d type %d!",
@@ -474,6 +514,25 @@ t_std_error os_interface_to_object (int rt_msg_type, struct nlmsghdr *hdr, cps_a
     cps_api_object_attr_add_u32(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE, details._type);
     EV_LOGGING(NAS_OS, INFO, "NET-MAIN"," NAS  OS interface event type \n %s",
             (track_change ==OS_IF_CHANGE_ALL) ? "Change all" : "Interface Update");
+
+    /*
+     * Debounce admin/oper only updates on the event path, the first transition is
+     * published and the rest are coalesced into one final state per hold-down window.
+     */
+    if (p_pub_evt != NULL && vrf_id == NAS_DEFAULT_VRF_ID) {
+        if (_if_op == cps_api_oper_DELETE) {
+            os_if_damp_delete(ifmsg->ifi_index);
+        } else if (evt_publish && damp_candidate && track_change != OS_IF_CHANGE_NONE &&
+                   !(track_change & ~(OS_IF_ADM_CHANGE | OS_IF_OPER_CHANGE))) {
+            evt_publish = os_if_damp_event(ifmsg->ifi_index, track_change, obj);
+        } else if (evt_publish) {
+            os_if_damp_published(ifmsg->ifi_index, obj);
+        }
+    }
+    if (p_pub_evt != NULL) {
+        *p_pub_evt = evt_publish;
+    }
+
     EV_LOGGING(NAS_OS, INFO, "NET-MAIN"," NAS  OS interface event publish\n %s", cps_api_object_to_c_string(obj).c_str());
 
     return STD_ERR_OK;
@@ -496,14 +555,32 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
     return true;
 }
 
+static void os_interface_link_to_object(const ethtool_cmd_data_t& eth_cmd, cps_api_object_t obj)
+{
+    cps_api_object_attr_add_u32(obj, DELL_IF_IF_INTERFACES_INTERFACE_SPEED,
+            eth_cmd.speed);
+    cps_api_object_attr_add_u32(obj, DELL_IF_IF_INTERFACES_STATE_INTERFACE_DUPLEX,
+            eth_cmd.duplex);
+    cps_api_object_attr_add(obj, DELL_IF_IF_INTERFACES_STATE_INTERFACE_AUTO_NEGOTIATION,
+            &eth_cmd.autoneg, sizeof(eth_cmd.autoneg));
+    for (uint32_t idx = 0; idx < BASE_IF_SPEED_MAX; idx++) {
+        if (eth_cmd.supported_speed[idx] == true) {
+            cps_api_object_attr_add_u32(obj,
+                    DELL_IF_IF_INTERFACES_STATE_INTERFACE_SUPPORTED_SPEED, idx);
+        }
+    }
+}
+
 static bool os_interface_info_to_object(hal_ifindex_t ifix, if_info_t& ifinfo, cps_api_object_t obj)
 {
     char if_name[HAL_IF_NAME_SZ+1];
-    if(cps_api_interface_if_index_to_name(ifix, if_name, sizeof(if_name)) == NULL) {
+    if (!ifinfo.if_name.empty()) {
+        safestrncpy(if_name, ifinfo.if_name.c_str(), sizeof(if_name));
+    } else if(cps_api_interface_if_index_to_name(ifix, if_name, sizeof(if_name)) == NULL) {
         EV_LOGGING(NAS_OS, ERR, "NAS-OS", "Failure getting interface name for %d", ifix);
         return false;
-    } else
-        cps_api_object_attr_add(obj, IF_INTERFACES_INTERFACE_NAME, if_name, (strlen(if_name)+1));
+    }
+    cps_api_object_attr_add(obj, IF_INTERFACES_INTERFACE_NAME, if_name, (strlen(if_name)+1));
     cps_api_key_from_attr_with_qual(cps_api_object_key(obj), BASE_IF_LINUX_IF_INTERFACES_INTERFACE_OBJ,
             cps_api_qualifier_OBSERVED);
 
@@ -517,90 +594,89 @@ static bool os_interface_info_to_object(hal_ifindex_t ifix, if_info_t& ifinfo, c
     cps_api_object_attr_add_u32(obj, DELL_IF_IF_INTERFACES_INTERFACE_MTU,
                                 (ifinfo.mtu  + NAS_LINK_MTU_HDR_SIZE));
     cps_api_object_attr_add_u32(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE, ifinfo.if_type);
+    if (ifinfo.master_idx != 0) {
+        cps_api_object_attr_add_u32(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_MASTER, ifinfo.master_idx);
+    }
+
+    if (ifinfo.if_type == BASE_CMN_INTERFACE_TYPE_MANAGEMENT) {
+        if (ifinfo.link_valid) {
+            os_interface_link_to_object(ifinfo.eth_cmd, obj);
+            cps_api_object_attr_add_u32(obj, IF_INTERFACES_STATE_INTERFACE_OPER_STATUS, ifinfo.oper_status);
+        } else {
+            /* Not refreshed yet */
+            os_get_interface_ethtool_cmd_data(if_name, obj);
+            os_get_interface_oper_status(if_name, obj);
+        }
+    }
     return true;
 }
 
-static cps_api_return_code_t _get_db_interface( cps_api_object_list_t *list, hal_ifindex_t ifix,
-                                                bool get_all, uint_t if_type )
+/* Interface get statistics */
+static std::atomic<uint64_t> _if_get_cache_cnt {0};
+static std::atomic<uint64_t> _if_get_dump_cnt {0};
+static std::atomic<uint64_t> _if_get_last_objs {0};
+static std::atomic<uint64_t> _if_get_last_us {0};
+static std::atomic<uint64_t> _if_get_max_us {0};
+
+static bool _get_db_interface( cps_api_object_list_t list, const if_query_t& query )
 {
     INTERFACE *fill = os_get_if_db_hdlr();
 
-    if (!fill) return cps_api_ret_code_ERR;
+    if (!fill) return false;
 
-    if_info_t ifinfo;
-    if(!get_all && fill->if_info_get(ifix, ifinfo)) {
-        EV_LOGGING(NAS_OS, INFO,"NET-MAIN", "Get ifinfo for %d", ifix);
+    size_t found = 0;
+    fill->for_each_match(query, [&list, &found](int idx, if_info_t& ifinfo) {
+        ++found;
+        EV_LOGGING(NAS_OS, DEBUG, "NET-MAIN", "Get ifinfo for %d", idx);
 
         cps_api_object_t obj = cps_api_object_create();
-        if(obj == nullptr) return cps_api_ret_code_ERR;
-        if(!os_interface_info_to_object(ifix, ifinfo, obj)) {
+        if(obj == nullptr) return;
+        if(!os_interface_info_to_object(idx, ifinfo, obj)) {
             cps_api_object_delete(obj);
-            return cps_api_ret_code_ERR;
+            return;
         }
-
         cps_api_object_set_type_operation(cps_api_object_key(obj),cps_api_oper_NULL);
-        if (cps_api_object_list_append(*list,obj)) {
-            return cps_api_ret_code_OK;
-        }
-        else {
+        if (!cps_api_object_list_append(list,obj)) {
             cps_api_object_delete(obj);
-            return cps_api_ret_code_ERR;
         }
-    } else if (get_all) {
-        fill->for_each_mbr([if_type, &list](int idx, if_info_t& ifinfo) {
-            if(if_type != 0 && ifinfo.if_type != static_cast<BASE_CMN_INTERFACE_TYPE_t>(if_type)) {
-                return;
-            }
+    });
 
-            EV_LOGGING(NAS_OS, INFO, "NET-MAIN", "Get all ifinfo for %d", idx);
-
-            cps_api_object_t obj = cps_api_object_create();
-            if(obj == nullptr) return;
-            if(!os_interface_info_to_object(idx, ifinfo, obj)) {
-                cps_api_object_delete(obj);
-                return;
-            }
-            cps_api_object_attr_t attr_id = cps_api_object_attr_get(obj,
-                    BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE);
-            if (attr_id != NULL) {
-                BASE_CMN_INTERFACE_TYPE_t type = (BASE_CMN_INTERFACE_TYPE_t)
-                                                  cps_api_object_attr_data_uint(attr_id);
-                if (type == BASE_CMN_INTERFACE_TYPE_MANAGEMENT) {
-                    attr_id = cps_api_object_attr_get(obj, IF_INTERFACES_INTERFACE_NAME);
-                    if (attr_id != NULL) {
-                        char if_name[HAL_IF_NAME_SZ+1];
-                        safestrncpy(if_name, (const char*)cps_api_object_attr_data_bin(attr_id),
-                                HAL_IF_NAME_SZ);
-                        os_get_interface_ethtool_cmd_data(if_name, obj);
-                        os_get_interface_oper_status(if_name, obj);
-                    }
-                }
-            }
-            cps_api_object_set_type_operation(cps_api_object_key(obj),cps_api_oper_NULL);
-            if (cps_api_object_list_append(*list,obj)) {
-                return;
-            } else {
-                cps_api_object_delete(obj);
-                return;
-            }
+    /* The cache holds all the default VRF interfaces, only a single interface is looked up in the kernel */
+    return (found != 0) || (query.ifindex == 0 && query.if_name.empty());
+}
 
-        });
-        return cps_api_ret_code_OK;
+static bool _query_match(const if_query_t& query, cps_api_object_t obj)
+{
+    cps_api_object_attr_t attr;
+    if (!query.if_name.empty()) {
+        attr = cps_api_object_attr_get(obj, IF_INTERFACES_INTERFACE_NAME);
+        if (attr == nullptr || query.if_name != (const char *)cps_api_object_attr_data_bin(attr)) return false;
     }
-
-    return cps_api_ret_code_ERR;
+    if (query.if_type != BASE_CMN_INTERFACE_TYPE_NULL) {
+        attr = cps_api_object_attr_get(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE);
+        if (attr == nullptr || cps_api_object_attr_data_uint(attr) != query.if_type) return false;
+    }
+    if (query.master_idx != 0) {
+        attr = cps_api_object_attr_get(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_MASTER);
+        if (attr == nullptr || cps_api_object_attr_data_uint(attr) != (uint32_t)query.master_idx) return false;
+    }
+    return true;
 }
-cps_api_return_code_t _get_interfaces( cps_api_object_list_t list, hal_ifindex_t ifix,
-                                       bool get_all, uint_t if_type )
-{
 
-    if(_get_db_interface(&list, ifix, get_all, if_type) == cps_api_ret_code_OK)
-        return cps_api_ret_code_OK;
+static cps_api_return_code_t _get_kernel_interface( cps_api_object_list_t list, const if_query_t& query )
+{
+    const char *vrf_name = query.vrf_name.empty() ? NL_DEFAULT_VRF_NAME : query.vrf_name.c_str();
+    uint32_t vrf_id = NL_DEFAULT_VRF_ID;
+    if (strcmp(vrf_name, NL_DEFAULT_VRF_NAME) != 0 &&
+        nas_get_vrf_internal_id_from_vrf_name(vrf_name, &vrf_id) != STD_ERR_OK) {
+        EV_LOGGING(NAS_OS, ERR, "NET-MAIN", "VRF %s not present for get", vrf_name);
+        return cps_api_ret_code_ERR;
+    }
 
-    EV_LOGGING(NAS_OS, INFO, "NET-MAIN", "Get interface info for ifindex %d", ifix);
+    EV_LOGGING(NAS_OS, INFO, "NET-MAIN", "Get interface info for VRF %s ifindex %d", vrf_name, query.ifindex);
     int if_sock = 0;
-    if((if_sock = nas_nl_sock_create(NL_DEFAULT_VRF_NAME, nas_nl_sock_T_INT,false)) < 0) {
-        EV_LOGGING(NAS_OS, ERR, "NET-MAIN", "soc create failure for get ifindex %d", ifix);
+    if((if_sock = nas_nl_sock_create(vrf_name, nas_nl_sock_T_INT,false)) < 0) {
+        EV_LOGGING(NAS_OS, ERR, "NET-MAIN", "soc create failure for get ifindex %d", query.ifindex);
         return cps_api_ret_code_ERR;
     }
 
@@ -611,22 +687,33 @@ cps_api_return_code_t _get_interfaces( cps_api_object_list_t list, hal_ifindex_t
     struct ifinfomsg ifmsg;
     memset(&ifmsg,0,sizeof(ifmsg));
 
-    nas_os_pack_if_hdr(&ifmsg, AF_NETLINK, 0, ifix );
+    nas_os_pack_if_hdr(&ifmsg, AF_NETLINK, 0, query.ifindex );
 
     int seq = (int)pthread_self();
     int dump_flags = NLM_F_ROOT| NLM_F_DUMP;
 
+    cps_api_object_list_guard lg(cps_api_object_list_create());
+    if (lg.get() == nullptr) {
+        close(if_sock);
+        return cps_api_ret_code_ERR;
+    }
+    cps_api_object_list_t dump = lg.get();
     if (nl_send_request(if_sock, RTM_GETLINK,
-            (NLM_F_REQUEST | NLM_F_ACK | (get_all ? dump_flags : 0)),
+            (NLM_F_REQUEST | NLM_F_ACK | ((query.ifindex == 0) ? dump_flags : 0)),
             seq,&ifmsg, sizeof(ifmsg))) {
         netlink_tools_process_socket(if_sock,get_netlink_data,
-                &list,buff,sizeof(buff),&seq,NULL, NL_DEFAULT_VRF_ID);
+                &dump,buff,sizeof(buff),&seq,NULL, vrf_id);
     }
+    close(if_sock);
 
-    size_t mx = cps_api_object_list_size(list);
-    for (size_t ix = 0 ; ix < mx ; ++ix ) {
-        cps_api_object_t ret = cps_api_object_list_get(list,ix);
+    while (cps_api_object_list_size(dump) > 0) {
+        cps_api_object_t ret = cps_api_object_list_get(dump,0);
+        cps_api_object_list_remove(dump,0);
         STD_ASSERT(ret!=NULL);
+        if (!_query_match(query, ret)) {
+            cps_api_object_delete(ret);
+            continue;
+        }
         cps_api_object_set_type_operation(cps_api_object_key(ret),cps_api_oper_NULL);
         cps_api_object_attr_t attr_id = cps_api_object_attr_get(ret,
                 BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE);
@@ -644,12 +731,58 @@ cps_api_return_code_t _get_interfaces( cps_api_object_list_t list, hal_ifindex_t
                }
            }
         }
+        if (!cps_api_object_list_append(list, ret)) {
+            cps_api_object_delete(ret);
+        }
     }
-
-    close(if_sock);
     return cps_api_ret_code_OK;
 }
 
+cps_api_return_code_t _get_interfaces_query(cps_api_object_list_t list, const if_query_t &query)
+{
+    uint64_t start_us = std_get_uptime(NULL);
+    size_t prev = cps_api_object_list_size(list);
+    cps_api_return_code_t rc = cps_api_ret_code_OK;
+
+    /* The interface cache only holds the default VRF interfaces */
+    if ((query.vrf_name.empty() || query.vrf_name == NL_DEFAULT_VRF_NAME) &&
+        _get_db_interface(list, query)) {
+        ++_if_get_cache_cnt;
+    } else {
+        ++_if_get_dump_cnt;
+        rc = _get_kernel_interface(list, query);
+    }
+
+    uint64_t elapsed = std_get_uptime(NULL) - start_us;
+    _if_get_last_objs = cps_api_object_list_size(list) - prev;
+    _if_get_last_us = elapsed;
+    if (elapsed > _if_get_max_us) _if_get_max_us = elapsed;
+    return rc;
+}
+
+cps_api_return_code_t _get_interfaces( cps_api_object_list_t list, hal_ifindex_t ifix,
+                                       bool get_all, uint_t if_type )
+{
+    if_query_t query;
+    query.ifindex = get_all ? 0 : ifix;
+    query.if_type = get_all ? (BASE_CMN_INTERFACE_TYPE_t)if_type : BASE_CMN_INTERFACE_TYPE_NULL;
+    query.master_idx = 0;
+    return _get_interfaces_query(list, query);
+}
+
+extern "C" void os_debug_if_cache_print ()
+{
+    INTERFACE *fill = os_get_if_db_hdlr();
+    size_t entries = 0, types = 0, masters = 0;
+    if (fill) fill->if_info_stats(entries, types, masters);
+
+    printf("\r\n INTERFACE CACHE entries:%lu types:%lu masters:%lu\r\n", entries, types, masters);
+    printf("\r gets from cache:%lu from kernel:%lu\r\n", (unsigned long)_if_get_cache_cnt,
+           (unsigned long)_if_get_dump_cnt);
+    printf("\r last get: %lu objects in %luus, max %luus\r\n", (unsigned long)_if_get_last_objs,
+           (unsigned long)_if_get_last_us, (unsigned long)_if_get_max_us);
+}
+
 cps_api_return_code_t __rd(void * context, cps_api_get_params_t * param,  size_t key_ix) {
 
     cps_api_object_t obj = cps_api_object_list_get(param->filters,key_ix);
@@ -678,6 +811,10 @@ t_std_error os_interface_object_reg(cps_api_operation_handle_t handle) {
         return STD_ERR(INTERFACE,FAIL,0);
     }
 
+    if (os_interface_mgmt_refresh_init() != STD_ERR_OK) {
+        return STD_ERR(INTERFACE,FAIL,0);
+    }
+
     f.handle = handle;
     f._read_function = __rd;
     f._write_function = __wr;
@@ -737,7 +874,6 @@ extern "C" t_std_error os_get_interface_oper_status(const char *ifname, cps_api_
 extern "C"  t_std_error os_get_interface_ethtool_cmd_data(const char *ifname, cps_api_object_t obj)
 {
     ethtool_cmd_data_t eth_cmd;
-    uint32_t           idx = 0;
     cps_api_object_attr_t   attr = cps_api_object_attr_get(obj, VRF_MGMT_NI_IF_INTERFACES_INTERFACE_VRF_ID);
     uint32_t           vrf_id = NAS_DEFAULT_VRF_ID;
     const char  *vrf_name = NULL;
@@ -750,18 +886,7 @@ extern "C"  t_std_error os_get_interface_ethtool_cmd_data(const char *ifname, cp
 
     t_std_error ret = nas_os_util_int_ethtool_cmd_data_get(vrf_name, ifname, &eth_cmd);
     if (ret == STD_ERR_OK) {
-        cps_api_object_attr_add_u32(obj, DELL_IF_IF_INTERFACES_INTERFACE_SPEED,
-                eth_cmd.speed);
-        cps_api_object_attr_add_u32(obj, DELL_IF_IF_INTERFACES_STATE_INTERFACE_DUPLEX,
-                eth_cmd.duplex);
-        cps_api_object_attr_add(obj, DELL_IF_IF_INTERFACES_STATE_INTERFACE_AUTO_NEGOTIATION,
-                &eth_cmd.autoneg, sizeof(eth_cmd.autoneg));
-        for (idx = 0; idx < BASE_IF_SPEED_MAX; idx++) {
-            if (eth_cmd.supported_speed[idx] == true) {
-                cps_api_object_attr_add_u32(obj,
-                        DELL_IF_IF_INTERFACES_STATE_INTERFACE_SUPPORTED_SPEED, idx);
-            }
-        }
+        os_interface_link_to_object(eth_cmd, obj);
     }
     return ret;
 }
@@ -801,9 +926,68 @@ extern "C"  t_std_error os_set_interface_ethtool_cmd_data (const char *ifname, c
 
     ret = nas_os_util_int_ethtool_cmd_data_set(vrf_name, ifname, &eth_cmd);
 
+    /* Link settings of the cache, only the default VRF interfaces are cached */
+    INTERFACE *fill = os_get_if_db_hdlr();
+    std::string name(ifname);
+    hal_ifindex_t ifx = 0;
+    if (ret == STD_ERR_OK && vrf_name == NULL && fill && fill->get_ifindex_from_name(name, ifx)) {
+        os_interface_mgmt_refresh(ifx, name);
+    }
     return ret;
 }
 
+static bool os_get_interface_stats_sample(const char *vrf_name, const char *ifname,
+                                          nas_os_if_stats_sample_t *sample)
+{
+    nas_os_if_stats_cfg_t cfg;
+    if (nas_os_if_stats_config_get(&cfg) != STD_ERR_OK || cfg.interval_ms == 0) return false;
+
+    hal_ifindex_t ifx = 0;
+    INTERFACE *fill = os_get_if_db_hdlr();
+    std::string name(ifname);
+    /* Only the default VRF interfaces are cached */
+    if (vrf_name != NULL || fill == NULL || !fill->get_ifindex_from_name(name, ifx)) {
+        if (nas_os_util_int_if_index_get(vrf_name, ifname, &ifx) != STD_ERR_OK) return false;
+    }
+    return nas_os_if_stats_engine_get(vrf_name, ifx, sample);
+}
+
+static void os_interface_stats_sample_to_object(const nas_os_if_stats_sample_t& sample, cps_api_object_t obj)
+{
+    /* Counters of the sample, the link stats have no output multicast and invalid protocol */
+    static const struct {
+        cps_api_attr_id_t id;
+        size_t offset;
+    } ctrs[] = {
+        {DELL_IF_IF_INTERFACES_STATE_INTERFACE_STATISTICS_IN_PKTS, offsetof(os_int_stats_t, input_packets)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_IN_OCTETS, offsetof(os_int_stats_t, input_bytes)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_IN_MULTICAST_PKTS, offsetof(os_int_stats_t, input_multicast)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_IN_ERRORS, offsetof(os_int_stats_t, input_errors)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_IN_DISCARDS, offsetof(os_int_stats_t, input_discards)},
+        {DELL_IF_IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_PKTS, offsetof(os_int_stats_t, output_packets)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_OCTETS, offsetof(os_int_stats_t, output_bytes)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_MULTICAST_PKTS, offsetof(os_int_stats_t, output_multicast)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_ERRORS, offsetof(os_int_stats_t, output_errors)},
+        {IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_DISCARDS, offsetof(os_int_stats_t, output_invalid_protocol)},
+    };
+
+    for (auto &ctr : ctrs) {
+        if ((sample.valid & (1U << (ctr.offset/sizeof(uint64_t)))) == 0) continue;
+
+        uint64_t val = *(const uint64_t *)((const char *)&sample.stats + ctr.offset);
+        cps_api_object_attr_add_u64(obj, ctr.id, val);
+
+        cps_api_attr_id_t ids[2] = {NAS_OS_IF_STATS_DELTA, ctr.id};
+        val = *(const uint64_t *)((const char *)&sample.delta + ctr.offset);
+        cps_api_object_e_add(obj, ids, 2, cps_api_object_ATTR_T_U64, &val, sizeof(val));
+
+        ids[0] = NAS_OS_IF_STATS_RATE;
+        val = *(const uint64_t *)((const char *)&sample.rate + ctr.offset);
+        cps_api_object_e_add(obj, ids, 2, cps_api_object_ATTR_T_U64, &val, sizeof(val));
+    }
+    cps_api_object_attr_add_u32(obj, NAS_OS_IF_STATS_INTERVAL_MS, sample.interval_ms);
+}
+
 extern "C"  t_std_error os_get_interface_stats (const char *ifname, cps_api_object_t obj)
 {
     os_int_stats_t data;
@@ -817,6 +1001,30 @@ extern "C"  t_std_error os_get_interface_stats (const char *ifname, cps_api_obje
     }
     memset(&data, 0, sizeof(data));
 
+    /* Last sample of the statistics engine shared by all the readers, when running */
+    nas_os_if_stats_sample_t sample;
+    if (os_get_interface_stats_sample(vrf_name, ifname, &sample)) {
+        os_interface_stats_sample_to_object(sample, obj);
+        /*
+         * Counters not in the link stats are read from ethtool as before, without
+         * delta and rate; left out if the interface has no ethtool statistics
+         */
+        const uint32_t ethtool_only = NAS_OS_IF_STATS_CTR_BIT(output_multicast) |
+                                      NAS_OS_IF_STATS_CTR_BIT(output_invalid_protocol);
+        if ((sample.valid & ethtool_only) != ethtool_only &&
+            nas_os_util_int_stats_get(vrf_name, ifname, &data) == STD_ERR_OK) {
+            if ((sample.valid & NAS_OS_IF_STATS_CTR_BIT(output_multicast)) == 0) {
+                cps_api_object_attr_add_u64(obj, IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_MULTICAST_PKTS,
+                        data.output_multicast);
+            }
+            if ((sample.valid & NAS_OS_IF_STATS_CTR_BIT(output_invalid_protocol)) == 0) {
+                cps_api_object_attr_add_u64(obj, IF_INTERFACES_STATE_INTERFACE_STATISTICS_OUT_DISCARDS,
+                        data.output_invalid_protocol);
+            }
+        }
+        return STD_ERR_OK;
+    }
+
     t_std_error ret = nas_os_util_int_stats_get(vrf_name, ifname, &data);
     if (ret == STD_ERR_OK) {
         cps_api_object_attr_add_u64(obj, DELL_IF_IF_INTERFACES_STATE_INTERFACE_STATISTICS_IN_PKTS,
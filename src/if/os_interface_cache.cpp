@@ -35,10 +35,26 @@ int INTERFACE::if_info_update(hal_ifindex_t ifx, if_info_t& if_info)
         if (!(if_info.if_name.empty())) {
             name_ifindex_map_[if_info.if_name] = ifx;
         }
+        if_index_add(ifx, if_info);
         if_map_.insert(std::make_pair(ifx, std::move(if_info)));
         track_ = OS_IF_CHANGE_ALL;
     } else {
         EV_LOGGING(NAS_OS, INFO, "NAS-OS-CACHE", " #### Update for ifindex %d", ifx);
+        if(it->second.master_idx != if_info.master_idx) {
+            track_ |= OS_IF_MASTER_CHANGE;
+        }
+        /* Renamed or moved to another master - the indexes follow */
+        if ((!if_info.if_name.empty() && it->second.if_name != if_info.if_name) ||
+            (it->second.master_idx != if_info.master_idx)) {
+            if_index_del(ifx, it->second);
+            if (!if_info.if_name.empty() && it->second.if_name != if_info.if_name) {
+                if (!it->second.if_name.empty()) name_ifindex_map_.erase(it->second.if_name);
+                name_ifindex_map_[if_info.if_name] = ifx;
+                it->second.if_name = if_info.if_name;
+            }
+            it->second.master_idx = if_info.master_idx;
+            if_index_add(ifx, it->second);
+        }
         if(it->second.admin != if_info.admin) {
             track_ |= OS_IF_ADM_CHANGE;
             it->second.admin = if_info.admin;
@@ -53,10 +69,6 @@ int INTERFACE::if_info_update(hal_ifindex_t ifx, if_info_t& if_info)
             track_ |= OS_IF_MTU_CHANGE;
             it->second.mtu = if_info.mtu;
         }
-        if(it->second.master_idx != if_info.master_idx) {
-            track_ |= OS_IF_MASTER_CHANGE;
-            it->second.master_idx = if_info.master_idx;
-        }
 
         const hal_mac_addr_t zero_mac = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
@@ -176,7 +188,11 @@ void INTERFACE::if_info_delete(hal_ifindex_t ifx, std::string &name) {
 
     EV_LOGGING(NAS_OS, INFO, "NAS-OS-CACHE", "Deleting ifix %d", ifx);
 
-    if_map_.erase(ifx);
+    auto it = if_map_.find(ifx);
+    if (it != if_map_.end()) {
+        if_index_del(ifx, it->second);
+        if_map_.erase(it);
+    }
     if (name.empty()) {
        EV_LOGGING(NAS_OS, ERR, "NAS-OS-CACHE", "Deleting ifix %d name is empty", ifx);
     } else {
@@ -208,6 +224,87 @@ void INTERFACE::for_each_mbr(std::function <void (int ix, if_info_t& if_info)> f
         fn(it->first, it->second);
 }
 
+void INTERFACE::if_index_add(hal_ifindex_t ifx, const if_info_t& if_info)
+{
+    type_index_[if_info.if_type].insert(ifx);
+    if (if_info.master_idx != 0) {
+        master_index_[if_info.master_idx].insert(ifx);
+    }
+}
+
+void INTERFACE::if_index_del(hal_ifindex_t ifx, const if_info_t& if_info)
+{
+    auto t_it = type_index_.find(if_info.if_type);
+    if (t_it != type_index_.end()) {
+        t_it->second.erase(ifx);
+        if (t_it->second.empty()) type_index_.erase(t_it);
+    }
+    auto m_it = master_index_.find(if_info.master_idx);
+    if (m_it != master_index_.end()) {
+        m_it->second.erase(ifx);
+        if (m_it->second.empty()) master_index_.erase(m_it);
+    }
+}
+
+void INTERFACE::for_each_match(const if_query_t& query, std::function <void (int ix, if_info_t& if_info)> fn)
+{
+    std_rw_lock_read_guard lg(&rw_lock);
+
+    auto match = [&query](const if_info_t& info) -> bool {
+        if (!query.if_name.empty() && info.if_name != query.if_name) return false;
+        if (query.if_type != BASE_CMN_INTERFACE_TYPE_NULL && info.if_type != query.if_type) return false;
+        if (query.master_idx != 0 && info.master_idx != query.master_idx) return false;
+        return true;
+    };
+    auto visit = [&](hal_ifindex_t ifx) {
+        auto it = if_map_.find(ifx);
+        if (it != if_map_.end() && match(it->second)) fn(it->first, it->second);
+    };
+
+    /* Most selective index first */
+    if (query.ifindex != 0) {
+        visit(query.ifindex);
+    } else if (!query.if_name.empty()) {
+        auto it = name_ifindex_map_.find(query.if_name);
+        if (it != name_ifindex_map_.end()) visit(it->second);
+    } else if (query.master_idx != 0) {
+        auto it = master_index_.find(query.master_idx);
+        if (it == master_index_.end()) return;
+        for (auto ifx : it->second) visit(ifx);
+    } else if (query.if_type != BASE_CMN_INTERFACE_TYPE_NULL) {
+        auto it = type_index_.find(query.if_type);
+        if (it == type_index_.end()) return;
+        for (auto ifx : it->second) visit(ifx);
+    } else {
+        for (auto it = if_map_.begin(); it != if_map_.end(); ++it)
+            fn(it->first, it->second);
+    }
+}
+
+bool INTERFACE::if_info_set_link(hal_ifindex_t ifx, const ethtool_cmd_data_t& eth_cmd,
+                                 IF_INTERFACES_STATE_INTERFACE_OPER_STATUS_t oper_status)
+{
+    std_rw_lock_write_guard lg(&rw_lock);
+
+    auto it = if_map_.find(ifx);
+    if(it == if_map_.end()) {
+        return false;
+    }
+    it->second.eth_cmd = eth_cmd;
+    it->second.oper_status = oper_status;
+    it->second.link_valid = true;
+    return true;
+}
+
+void INTERFACE::if_info_stats(size_t& entries, size_t& types, size_t& masters)
+{
+    std_rw_lock_read_guard lg(&rw_lock);
+
+    entries = if_map_.size();
+    types = type_index_.size();
+    masters = master_index_.size();
+}
+
 void if_mbr_data::member_add(hal_ifindex_t master_idx, hal_ifindex_t mbr_idx)
 {
     auto it = mbr_map_.find(master_idx);
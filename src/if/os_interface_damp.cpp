@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   os_interface_damp.cpp
+ * \brief  Debounce and dampening of interface admin/oper netlink events
+ */
+
+#include "private/os_interface_damp.h"
+#include "nas_os_int_utils.h"
+#include "nas_os_interface.h"
+
+#include "dell-base-if-linux.h"
+#include "event_log.h"
+#include "std_time_tools.h"
+
+#include <net/if.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * The first admin/oper transition of an interface is published immediately and opens
+ * a hold-down window. Transitions received inside the window only replace the pending
+ * final state which is published when the window expires, so at most one consolidated
+ * event is published per window. Every oper transition also adds a penalty that decays
+ * exponentially, once it crosses the suppress threshold the window is extended until the
+ * penalty decays below the reuse threshold (bounded by max suppress time).
+ */
+
+typedef struct {
+    uint64_t window_end_us;     /* End of the current hold-down/suppress window */
+    uint64_t suppress_start_us; /* Start of the current suppression */
+    uint64_t decay_us;          /* Time when penalty was last decayed */
+    double penalty;
+    bool suppressed;
+    unsigned int pub_flags;     /* IFF_UP/IFF_RUNNING of the last published event */
+    cps_api_object_t pending;   /* Final state to be published at window end */
+    nas_os_if_damp_stats_t stats;
+} os_if_damp_entry_t;
+
+static const unsigned int os_if_damp_flags_mask = IFF_UP | IFF_RUNNING;
+
+static std::mutex _damp_mutex;
+static auto & _damp_map = *(new std::unordered_map<hal_ifindex_t, os_if_damp_entry_t>);
+static nas_os_if_damp_cfg_t _damp_cfg = {
+    0,      /* hold_down_ms - off until configured */
+    1000,   /* flap_penalty */
+    3000,   /* suppress_threshold */
+    1500,   /* reuse_threshold */
+    2000,   /* half_life_ms */
+    10000,  /* max_suppress_ms */
+};
+
+static unsigned int os_if_damp_obj_flags(cps_api_object_t obj)
+{
+    cps_api_object_attr_t attr = cps_api_object_attr_get(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_FLAGS);
+    if (attr == nullptr) return 0;
+    return cps_api_object_attr_data_u32(attr) & os_if_damp_flags_mask;
+}
+
+static void os_if_damp_decay(os_if_damp_entry_t &entry, uint64_t now)
+{
+    if (entry.penalty > 0 && _damp_cfg.half_life_ms != 0 && now > entry.decay_us) {
+        double elapsed_ms = (double)(now - entry.decay_us) / 1000;
+        entry.penalty *= pow(0.5, elapsed_ms / _damp_cfg.half_life_ms);
+    }
+    entry.decay_us = now;
+    entry.stats.penalty = (uint32_t)entry.penalty;
+}
+
+/* Window end while suppressed: time for the penalty to decay to the reuse threshold */
+static uint64_t os_if_damp_reuse_time(os_if_damp_entry_t &entry, uint64_t now)
+{
+    uint64_t end = now + (uint64_t)_damp_cfg.hold_down_ms * 1000;
+    if (_damp_cfg.reuse_threshold != 0 && entry.penalty > _damp_cfg.reuse_threshold) {
+        double wait_ms = _damp_cfg.half_life_ms * log2(entry.penalty / _damp_cfg.reuse_threshold);
+        uint64_t reuse = now + (uint64_t)(wait_ms * 1000);
+        if (reuse > end) end = reuse;
+    }
+    uint64_t max_end = entry.suppress_start_us + (uint64_t)_damp_cfg.max_suppress_ms * 1000;
+    return (end > max_end) ? max_end : end;
+}
+
+static void os_if_damp_drop_pending(os_if_damp_entry_t &entry)
+{
+    if (entry.pending != nullptr) {
+        cps_api_object_delete(entry.pending);
+        entry.pending = nullptr;
+    }
+}
+
+bool os_if_damp_event(hal_ifindex_t ifindex, int track_change, cps_api_object_t obj)
+{
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+
+    if (_damp_cfg.hold_down_ms == 0) return true;
+
+    uint64_t now = std_get_uptime(nullptr);
+    os_if_damp_entry_t &entry = _damp_map[ifindex];
+    unsigned int flags = os_if_damp_obj_flags(obj);
+
+    entry.stats.transitions++;
+    os_if_damp_decay(entry, now);
+
+    /* Only oper transitions are penalized, admin changes are user driven */
+    if (track_change & OS_IF_OPER_CHANGE) {
+        entry.penalty += _damp_cfg.flap_penalty;
+        entry.stats.penalty = (uint32_t)entry.penalty;
+        if (!entry.suppressed && _damp_cfg.suppress_threshold != 0 &&
+            entry.penalty >= _damp_cfg.suppress_threshold) {
+            EV_LOGGING(NAS_OS, NOTICE, "NAS-OS-DAMP", "Suppressing link events for ifindex %d penalty %u",
+                       ifindex, entry.stats.penalty);
+            entry.suppressed = true;
+            entry.suppress_start_us = now;
+        }
+    }
+
+    if (entry.suppressed) {
+        entry.window_end_us = os_if_damp_reuse_time(entry, now);
+    } else if (now >= entry.window_end_us) {
+        /* Leading edge of a new window - publish right away */
+        entry.window_end_us = now + (uint64_t)_damp_cfg.hold_down_ms * 1000;
+        entry.pub_flags = flags;
+        entry.stats.published++;
+        os_if_damp_drop_pending(entry);
+        return true;
+    }
+
+    if (entry.pending == nullptr) {
+        entry.pending = cps_api_object_create();
+        if (entry.pending == nullptr) {
+            /* Never lose the state change - publish it */
+            entry.pub_flags = flags;
+            entry.stats.published++;
+            return true;
+        }
+    }
+    if (!cps_api_object_clone(entry.pending, obj)) {
+        os_if_damp_drop_pending(entry);
+        entry.pub_flags = flags;
+        entry.stats.published++;
+        return true;
+    }
+    entry.stats.suppressed++;
+    return false;
+}
+
+void os_if_damp_published(hal_ifindex_t ifindex, cps_api_object_t obj)
+{
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+
+    auto it = _damp_map.find(ifindex);
+    if (it == _damp_map.end()) return;
+
+    os_if_damp_drop_pending(it->second);
+    it->second.pub_flags = os_if_damp_obj_flags(obj);
+}
+
+void os_if_damp_delete(hal_ifindex_t ifindex)
+{
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+
+    auto it = _damp_map.find(ifindex);
+    if (it == _damp_map.end()) return;
+
+    os_if_damp_drop_pending(it->second);
+    _damp_map.erase(it);
+}
+
+bool os_if_damp_next_timeout(uint64_t *wait_us)
+{
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+
+    bool found = false;
+    uint64_t earliest = 0;
+    for (auto &it : _damp_map) {
+        if (it.second.pending == nullptr) continue;
+        if (!found || it.second.window_end_us < earliest) {
+            earliest = it.second.window_end_us;
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    uint64_t now = std_get_uptime(nullptr);
+    *wait_us = (earliest > now) ? (earliest - now) : 1;
+    return true;
+}
+
+void os_if_damp_flush(os_if_damp_publish_fn publish)
+{
+    std::vector<cps_api_object_t> objs;
+    {
+        std::lock_guard<std::mutex> lock(_damp_mutex);
+
+        uint64_t now = std_get_uptime(nullptr);
+        for (auto &it : _damp_map) {
+            os_if_damp_entry_t &entry = it.second;
+            if (entry.pending == nullptr || now < entry.window_end_us) continue;
+
+            if (entry.suppressed) {
+                os_if_damp_decay(entry, now);
+                uint64_t max_end = entry.suppress_start_us + (uint64_t)_damp_cfg.max_suppress_ms * 1000;
+                if (entry.penalty > _damp_cfg.reuse_threshold && now < max_end) {
+                    entry.window_end_us = os_if_damp_reuse_time(entry, now);
+                    continue;
+                }
+                EV_LOGGING(NAS_OS, NOTICE, "NAS-OS-DAMP", "Releasing link event suppression for ifindex %d",
+                           it.first);
+                entry.suppressed = false;
+            }
+
+            cps_api_object_t obj = entry.pending;
+            entry.pending = nullptr;
+            entry.window_end_us = now + (uint64_t)_damp_cfg.hold_down_ms * 1000;
+
+            unsigned int flags = os_if_damp_obj_flags(obj);
+            if (flags == entry.pub_flags) {
+                /* Flapped back to the last published state - nothing to report */
+                cps_api_object_delete(obj);
+                continue;
+            }
+            entry.pub_flags = flags;
+            entry.stats.published++;
+            EV_LOGGING(NAS_OS, INFO, "NAS-OS-DAMP", "Publishing final link state 0x%x for ifindex %d",
+                       flags, it.first);
+            objs.push_back(obj);
+        }
+    }
+    /* Published without the lock, the event path takes it for every link event */
+    for (auto obj : objs) {
+        publish(obj);
+    }
+}
+
+extern "C" {
+
+t_std_error nas_os_if_damp_config_set (const nas_os_if_damp_cfg_t *cfg)
+{
+    if (cfg == nullptr) return STD_ERR(INTERFACE, PARAM, 0);
+    if (cfg->reuse_threshold > cfg->suppress_threshold) {
+        EV_LOGGING(NAS_OS, ERR, "NAS-OS-DAMP", "Reuse threshold %u above suppress threshold %u",
+                   cfg->reuse_threshold, cfg->suppress_threshold);
+        return STD_ERR(INTERFACE, PARAM, 0);
+    }
+
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+    _damp_cfg = *cfg;
+    if (_damp_cfg.hold_down_ms == 0) {
+        /* Dampening disabled, pending states are published by the next kernel event */
+        for (auto &it : _damp_map) {
+            os_if_damp_drop_pending(it.second);
+            it.second.suppressed = false;
+        }
+    }
+    return STD_ERR_OK;
+}
+
+t_std_error nas_os_if_damp_config_get (nas_os_if_damp_cfg_t *cfg)
+{
+    if (cfg == nullptr) return STD_ERR(INTERFACE, PARAM, 0);
+
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+    *cfg = _damp_cfg;
+    return STD_ERR_OK;
+}
+
+t_std_error nas_os_if_damp_stats_get (hal_ifindex_t ifindex, nas_os_if_damp_stats_t *stats)
+{
+    if (stats == nullptr) return STD_ERR(INTERFACE, PARAM, 0);
+
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+    auto it = _damp_map.find(ifindex);
+    if (it == _damp_map.end()) return STD_ERR(INTERFACE, FAIL, 0);
+
+    os_if_damp_decay(it->second, std_get_uptime(nullptr));
+    *stats = it->second.stats;
+    stats->is_suppressed = it->second.suppressed;
+    return STD_ERR_OK;
+}
+
+t_std_error nas_os_if_damp_stats_clear (hal_ifindex_t ifindex)
+{
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+    auto it = _damp_map.find(ifindex);
+    if (it == _damp_map.end()) return STD_ERR(INTERFACE, FAIL, 0);
+
+    it->second.stats.transitions = 0;
+    it->second.stats.published = 0;
+    it->second.stats.suppressed = 0;
+    return STD_ERR_OK;
+}
+
+void os_debug_if_damp_print ()
+{
+    std::lock_guard<std::mutex> lock(_damp_mutex);
+
+    printf("\r\n LINK EVENT DAMPENING hold-down:%ums penalty:%u suppress:%u reuse:%u "
+           "half-life:%ums max-suppress:%ums\r\n", _damp_cfg.hold_down_ms, _damp_cfg.flap_penalty,
+           _damp_cfg.suppress_threshold, _damp_cfg.reuse_threshold, _damp_cfg.half_life_ms,
+           _damp_cfg.max_suppress_ms);
+    printf("\r %-10s | %-12s | %-12s | %-12s | %-10s | %-10s\r\n",
+           "ifindex", "#transitions", "#published", "#suppressed", "penalty", "suppressed");
+    for (auto &it : _damp_map) {
+        printf("\r %-10d | %-12lu | %-12lu | %-12lu | %-10u | %-10s\r\n", it.first,
+               (unsigned long)it.second.stats.transitions, (unsigned long)it.second.stats.published,
+               (unsigned long)it.second.stats.suppressed, it.second.stats.penalty,
+               it.second.suppressed ? "yes" : "no");
+    }
+}
+
+}
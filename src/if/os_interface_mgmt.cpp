@@ -19,11 +19,20 @@
  */
 
 #include "private/nas_os_if_priv.h"
+#include "private/os_if_utils.h"
 #include "dell-base-common.h"
 #include "cps_api_object.h"
+#include "nas_os_int_utils.h"
+#include "std_thread_tools.h"
+#include "event_log.h"
 
 #include <string.h>
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
 #define MGMT_INTF_NAME      "eth0"
 
 bool INTERFACE::os_interface_mgmt_attrs_handler(if_details *details, cps_api_object_t obj)
@@ -36,3 +45,60 @@ bool INTERFACE::os_interface_mgmt_attrs_handler(if_details *details, cps_api_obj
 
     return true;
 }
+
+/*
+ * Link settings and oper status of the management interfaces are read with ethtool
+ * ioctls on link events, off the netlink thread, and kept in the interface cache
+ */
+static std::mutex _mgmt_mutex;
+static std::condition_variable _mgmt_cv;
+static auto & _mgmt_pending = *(new std::map<hal_ifindex_t, std::string>);
+static std_thread_create_param_t _mgmt_thr;
+
+static void os_interface_mgmt_refresher()
+{
+    while (true) {
+        std::map<hal_ifindex_t, std::string> pending;
+        {
+            std::unique_lock<std::mutex> lock(_mgmt_mutex);
+            _mgmt_cv.wait(lock, [] { return !_mgmt_pending.empty(); });
+            pending.swap(_mgmt_pending);
+        }
+
+        INTERFACE *fill = os_get_if_db_hdlr();
+        if (!fill) continue;
+
+        for (auto &it : pending) {
+            ethtool_cmd_data_t eth_cmd;
+            IF_INTERFACES_STATE_INTERFACE_OPER_STATUS_t oper_status;
+            memset(&eth_cmd, 0, sizeof(eth_cmd));
+
+            if (nas_os_util_int_ethtool_cmd_data_get(NULL, it.second.c_str(), &eth_cmd) != STD_ERR_OK ||
+                nas_os_util_int_oper_status_get(NULL, it.second.c_str(), &oper_status) != STD_ERR_OK) {
+                EV_LOGGING(NAS_OS, INFO, "NET-MAIN", "Link settings of %s not read", it.second.c_str());
+                continue;
+            }
+            fill->if_info_set_link(it.first, eth_cmd, oper_status);
+        }
+    }
+}
+
+t_std_error os_interface_mgmt_refresh_init(void)
+{
+    std_thread_init_struct(&_mgmt_thr);
+    _mgmt_thr.name = "db-api-linux-mgmt-link";
+    _mgmt_thr.thread_function = (std_thread_function_t)os_interface_mgmt_refresher;
+    if (std_thread_create(&_mgmt_thr) != STD_ERR_OK) {
+        EV_LOGGING(NAS_OS, ERR, "NET-MAIN", "Failed to create management link refresher");
+        return STD_ERR(INTERFACE, FAIL, 0);
+    }
+    return STD_ERR_OK;
+}
+
+void os_interface_mgmt_refresh(hal_ifindex_t ifx, const std::string &if_name)
+{
+    /* Kept until the refresher is started */
+    std::lock_guard<std::mutex> lock(_mgmt_mutex);
+    _mgmt_pending[ifx] = if_name;
+    _mgmt_cv.notify_one();
+}
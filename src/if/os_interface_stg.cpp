@@ -23,50 +23,33 @@
 #include "nas_nlmsg.h"
 #include "event_log.h"
 #include "net_publish.h"
+#include "nas_os_obj_pool.h"
 #include "ds_api_linux_interface.h"
 #include "nas_os_vlan_utils.h"
 #include "nas_linux_l2.h"
+#include "nas_os_br_attr.h"
 
 #include <linux/if_link.h>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <linux/rtnetlink.h>
 #include <string>
 
 static const size_t os_stp_state_frwd = 3;
 bool os_bridge_stp_enabled (if_details *details)
 {
-    const std::string SYSFS_CLASS_NET = "/sys/class/net/";
-    std::stringstream str_stream;
     int master;
     if(details->_attrs[IFLA_MASTER]){
         master = *(int *) nla_data(details->_attrs[IFLA_MASTER]);
     }else{
         return false;
     }
-    char intf_name[HAL_IF_NAME_SZ+1];
-    if(cps_api_interface_if_index_to_name(master,intf_name,sizeof(intf_name))==NULL){
-        EV_LOGGING(NAS_OS,DEBUG,"NAS-LINUX-INTERFACE","Invalid Interface Index %d ",master);
-        return false;
-    }
-    str_stream << SYSFS_CLASS_NET << intf_name << "/bridge/stp_state";
-
-    std::string path = str_stream.str();
 
-    std::ifstream in(path);
-    if(!in.good()) {
+    long stp_state = 0;
+    if(!nas_os_br_attr_get(master, NULL, NAS_OS_BR_ATTR_STP_STATE, &stp_state)){
         return false;
     }
 
-    std::string s;
-
-    int stp_state = 0;
-    if(getline(in, s)) {
-        stp_state = stoi(s);
-    }
-
-    EV_LOG(INFO, NAS_OS, ev_log_s_MINOR, "NAS-OS", "STP %s, path %s state %d",
-            details->if_name.c_str(), path.c_str(), stp_state);
+    EV_LOG(INFO, NAS_OS, ev_log_s_MINOR, "NAS-OS", "STP %s, bridge %d state %ld",
+            details->if_name.c_str(), master, stp_state);
 
     return ((stp_state)? true:false);
 }
@@ -86,10 +69,8 @@ bool INTERFACE::os_interface_stg_attrs_handler(if_details *details, cps_api_obje
              */
             if(get_if_stp_state(details->_ifindex,&cur_stp_state) == STD_ERR_OK){
                 if( stp_state != cur_stp_state){
-                    cps_api_object_t stg_obj = cps_api_object_create();
-                    if(stg_obj == nullptr){
-                        return false;
-                    }
+                    char buff[CPS_API_MIN_OBJ_LEN];
+                    cps_api_object_t stg_obj = cps_api_object_init(buff, sizeof(buff));
                     EV_LOGGING(NAS_OS,INFO,"NAS-OS-STG","Reverting the STP state to %d for interface index %d",
                                                 cur_stp_state, details->_ifindex);
                     cps_api_object_attr_add_u32(stg_obj, BASE_STG_ENTRY_INTF_IF_INDEX_IFINDEX, details->_ifindex);
@@ -123,9 +104,15 @@ bool INTERFACE::os_interface_stg_attrs_handler(if_details *details, cps_api_obje
 
             if(os_bridge_stp_enabled(details)){
 
-                cps_api_object_t cln_obj = cps_api_object_create();
+                cps_api_object_t cln_obj = nas_os_obj_pool_alloc(RTM_NEWLINK);
+                if (cln_obj == nullptr) {
+                    return false;
+                }
 
-                cps_api_object_clone(cln_obj,obj);
+                if (!cps_api_object_clone(cln_obj,obj)) {
+                    nas_os_obj_pool_release(cln_obj);
+                    return false;
+                }
 
                 cps_api_key_init(cps_api_object_key(cln_obj),cps_api_qualifier_TARGET,
                         (cps_api_object_category_types_t) cps_api_obj_CAT_BASE_STG,BASE_STG_ENTRY_OBJ,0);
@@ -140,14 +127,14 @@ bool INTERFACE::os_interface_stg_attrs_handler(if_details *details, cps_api_obje
 
                 hal_ifindex_t ifindex;
                 if(!nas_os_physical_to_vlan_ifindex(details->_ifindex,0,false,&ifindex)){
-                    cps_api_object_delete(cln_obj);
+                    nas_os_obj_pool_release(cln_obj);
                     return false;
                 }
 
                 cps_api_object_e_add(cln_obj,ids,ids_len,cps_api_object_ATTR_T_U32,&ifindex,
                                     sizeof(ifindex));
 
-                net_publish_event(cln_obj);
+                nas_os_obj_pool_publish(cln_obj);
             }
 
         }
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_br_attr.cpp
+ * \brief  Cached sysfs handles and netlink values of the bridge knobs
+ */
+
+#include "nas_os_br_attr.h"
+#include "nas_nlmsg.h"
+#include "netlink_tools.h"
+#include "ds_api_linux_interface.h"
+#include "std_time_tools.h"
+#include "event_log.h"
+
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef IFLA_BR_MAX
+#define _BR_NLA(nla) (nla)
+#else
+#define _BR_NLA(nla) 0
+#endif
+
+/* Bridge RTM_NEWLINK messages are sent in batches of back to back messages, a batch
+ * holds no more messages than the ACKs the socket receive buffer can queue */
+#define NL_BR_BATCH_LEN (32*1024)
+#define NL_BR_BATCH_MSGS 128
+#define NL_BR_MSG_LEN 256
+#define NL_BR_ACK_TIMEOUT_SEC 2
+
+typedef struct {
+    const char *file;       /* sysfs file under /sys/class/net/<br>/bridge */
+    int nla;                /* IFLA_BR_* attribute, 0 if not known to the headers */
+    int nla_len;
+} nas_os_br_attr_desc_t;
+
+static const nas_os_br_attr_desc_t _br_attr_desc[NAS_OS_BR_ATTR_MAX] = {
+    { "stp_state",                  _BR_NLA(IFLA_BR_STP_STATE),                 sizeof(uint32_t) },
+    { "multicast_querier",          _BR_NLA(IFLA_BR_MCAST_QUERIER),             sizeof(uint8_t) },
+    { "ageing_time",                _BR_NLA(IFLA_BR_AGEING_TIME),               sizeof(uint32_t) },
+    { "multicast_snooping",         _BR_NLA(IFLA_BR_MCAST_SNOOPING),            sizeof(uint8_t) },
+    { "multicast_query_use_ifaddr", _BR_NLA(IFLA_BR_MCAST_QUERY_USE_IFADDR),    sizeof(uint8_t) },
+    { "hash_elasticity",            _BR_NLA(IFLA_BR_MCAST_HASH_ELASTICITY),     sizeof(uint32_t) },
+    { "hash_max",                   _BR_NLA(IFLA_BR_MCAST_HASH_MAX),            sizeof(uint32_t) },
+};
+
+typedef struct {
+    std::string name;
+    int fd[NAS_OS_BR_ATTR_MAX];
+    bool nl_valid[NAS_OS_BR_ATTR_MAX];  /* Value seen in the last RTM_NEWLINK */
+    long nl_val[NAS_OS_BR_ATTR_MAX];
+} nas_os_br_entry_t;
+
+static std::mutex _br_attr_mutex;
+static auto & _br_attr_db = *(new std::unordered_map<hal_ifindex_t, nas_os_br_entry_t>);
+
+static void _br_entry_close(nas_os_br_entry_t &ent) {
+    for (size_t ix = 0; ix < NAS_OS_BR_ATTR_MAX; ++ix) {
+        if (ent.fd[ix] != -1) close(ent.fd[ix]);
+        ent.fd[ix] = -1;
+        ent.nl_valid[ix] = false;
+    }
+}
+
+/* Find or create the bridge entry, _br_attr_mutex is held */
+static nas_os_br_entry_t * _br_entry_get(hal_ifindex_t br_index, const char *br_name) {
+    auto it = _br_attr_db.find(br_index);
+    if (it != _br_attr_db.end()) {
+        if (br_name == nullptr || it->second.name == br_name) return &it->second;
+        /* Renamed - reopen under the new name */
+        _br_entry_close(it->second);
+        it->second.name = br_name;
+        return &it->second;
+    }
+
+    char if_name[HAL_IF_NAME_SZ+1];
+    if (br_name == nullptr) {
+        if (cps_api_interface_if_index_to_name(br_index, if_name, sizeof(if_name)) == NULL) {
+            EV_LOGGING(NAS_OS, DEBUG, "NAS-OS-BR-ATTR", "Invalid Interface Index %d", br_index);
+            return nullptr;
+        }
+        br_name = if_name;
+    }
+    nas_os_br_entry_t &ent = _br_attr_db[br_index];
+    ent.name = br_name;
+    for (size_t ix = 0; ix < NAS_OS_BR_ATTR_MAX; ++ix) {
+        ent.fd[ix] = -1;
+        ent.nl_valid[ix] = false;
+        ent.nl_val[ix] = 0;
+    }
+    return &ent;
+}
+
+static int _br_attr_fd(nas_os_br_entry_t &ent, nas_os_br_attr_t attr) {
+    if (ent.fd[attr] != -1) return ent.fd[attr];
+
+    std::string path = "/sys/class/net/" + ent.name + "/bridge/" + _br_attr_desc[attr].file;
+    int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd == -1) fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        EV_LOGGING(NAS_OS, DEBUG, "NAS-OS-BR-ATTR", "Path %s does not exist", path.c_str());
+        return -1;
+    }
+    ent.fd[attr] = fd;
+    return fd;
+}
+
+/* Write a knob through its sysfs file, _br_attr_mutex is held */
+static int _br_attr_sysfs_write(nas_os_br_entry_t &ent, nas_os_br_attr_t attr, long val) {
+    int fd = _br_attr_fd(ent, attr);
+    if (fd == -1) return ENOENT;
+
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%ld\n", val);
+    if (pwrite(fd, buf, len, 0) != len) {
+        int err = errno;
+        close(fd);
+        ent.fd[attr] = -1;
+        return err;
+    }
+    return 0;
+}
+
+#ifdef IFLA_BR_MAX
+static struct nlmsghdr * _br_nl_msg_build(void *buff, size_t len, const nas_os_br_attr_cfg_t &cfg, uint32_t seq) {
+    memset(buff, 0, len);
+    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff, len, sizeof(struct nlmsghdr));
+    if (nlh == NULL) return NULL;
+    struct ifinfomsg *ifmsg = (struct ifinfomsg *) nlmsg_reserve(nlh, len, sizeof(struct ifinfomsg));
+    if (ifmsg == NULL) return NULL;
+
+    nlh->nlmsg_pid = 0;
+    nlh->nlmsg_seq = seq;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    nlh->nlmsg_type = RTM_NEWLINK;
+
+    ifmsg->ifi_family = AF_UNSPEC;
+    ifmsg->ifi_index = cfg.br_index;
+
+    /* IFLA_LINKINFO(IFLA_INFO_KIND, IFLA_INFO_DATA(IFLA_BR_*)) */
+    struct nlattr *info = nlmsg_nested_start(nlh, len);
+    if (info == NULL) return NULL;
+    info->nla_len = 0;
+    info->nla_type = IFLA_LINKINFO;
+
+    const char *info_kind = "bridge";
+    if (nlmsg_add_attr(nlh, len, IFLA_INFO_KIND, info_kind, strlen(info_kind)+1) == -1) return NULL;
+
+    struct nlattr *data = nlmsg_nested_start(nlh, len);
+    if (data == NULL) return NULL;
+    data->nla_len = 0;
+    data->nla_type = IFLA_INFO_DATA;
+
+    for (size_t ix = 0; ix < NAS_OS_BR_ATTR_MAX; ++ix) {
+        if (!(cfg.attr_mask & NAS_OS_BR_ATTR_BIT(ix))) continue;
+        const nas_os_br_attr_desc_t &desc = _br_attr_desc[ix];
+        if (desc.nla == 0) return NULL;
+
+        uint32_t val32 = (uint32_t)cfg.val[ix];
+        uint8_t val8 = (uint8_t)cfg.val[ix];
+        const void *val = (desc.nla_len == sizeof(uint8_t)) ? (const void *)&val8 : (const void *)&val32;
+        if (nlmsg_add_attr(nlh, len, desc.nla, val, desc.nla_len) == -1) return NULL;
+    }
+    nlmsg_nested_end(nlh, data);
+    nlmsg_nested_end(nlh, info);
+    return nlh;
+}
+
+/* Send the knobs of every bridge as one RTM_NEWLINK, err is the errno of each entry */
+static void _br_nl_set_bulk(const nas_os_br_attr_cfg_t *cfg, size_t count, std::vector<int> &err) {
+    int sock = nas_nl_sock_create(NL_DEFAULT_VRF_NAME, nas_nl_sock_T_INT, false);
+    if (sock == -1) {
+        EV_LOGGING(NAS_OS, ERR, "NAS-OS-BR-ATTR", "Failed to create socket for bridge update err-no:%d", errno);
+        err.assign(count, EOPNOTSUPP);
+        return;
+    }
+    /* A lost ACK fails the bridge instead of blocking the caller */
+    struct timeval tv = { NL_BR_ACK_TIMEOUT_SEC, 0 };
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0) {
+        EV_LOGGING(NAS_OS, ERR, "NAS-OS-BR-ATTR", "Failed to set ACK timeout err-no:%d", errno);
+    }
+
+    std::vector<char> batch(NL_BR_BATCH_LEN);
+    uint32_t seq_base = (uint32_t)std_get_uptime(NULL);
+    size_t first = 0;
+    while (first < count) {
+        size_t off = 0, last = first, pending = 0;
+        for (; last < count && pending < NL_BR_BATCH_MSGS && off + NL_BR_MSG_LEN <= batch.size(); ++last) {
+            if (cfg[last].attr_mask == 0) {
+                err[last] = 0;
+                continue;
+            }
+            struct nlmsghdr *nlh = _br_nl_msg_build(&batch[off], NL_BR_MSG_LEN, cfg[last], seq_base + last);
+            if (nlh == NULL) {
+                /* Knob not known to the netlink headers */
+                err[last] = EOPNOTSUPP;
+                continue;
+            }
+            off += NLMSG_ALIGN(nlh->nlmsg_len);
+            err[last] = -1;
+            ++pending;
+        }
+        if (pending > 0) {
+            if (nl_send_nlmsg_batch(sock, &batch[0], off)) {
+                nl_read_batch_acks(sock, seq_base, first, last, pending, &err[0]);
+            } else {
+                int rc = errno;
+                for (size_t ix = first; ix < last; ++ix) {
+                    if (err[ix] == -1) err[ix] = rc;
+                }
+            }
+        }
+        first = last;
+    }
+    close(sock);
+}
+#endif
+
+extern "C" {
+
+bool nas_os_br_attr_get(hal_ifindex_t br_index, const char *br_name, nas_os_br_attr_t attr, long *val)
+{
+    if (attr >= NAS_OS_BR_ATTR_MAX || val == nullptr) return false;
+
+    std::lock_guard<std::mutex> lock(_br_attr_mutex);
+    nas_os_br_entry_t *ent = _br_entry_get(br_index, br_name);
+    if (ent == nullptr) return false;
+    if (ent->nl_valid[attr]) {
+        *val = ent->nl_val[attr];
+        return true;
+    }
+
+    int fd = _br_attr_fd(*ent, attr);
+    if (fd == -1) return false;
+
+    char buf[32];
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        /* Stale handle - opened again on the next access */
+        close(fd);
+        ent->fd[attr] = -1;
+        return false;
+    }
+    buf[len] = '\0';
+    *val = strtol(buf, nullptr, 0);
+    return true;
+}
+
+bool nas_os_br_attr_set(hal_ifindex_t br_index, const char *br_name, nas_os_br_attr_t attr, long val)
+{
+    if (attr >= NAS_OS_BR_ATTR_MAX) return false;
+
+    if (br_name != nullptr) {
+        /* Refresh the name of the cached entry before a sysfs fallback */
+        std::lock_guard<std::mutex> lock(_br_attr_mutex);
+        if (_br_entry_get(br_index, br_name) == nullptr) return false;
+    }
+
+    nas_os_br_attr_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.br_index = br_index;
+    cfg.attr_mask = NAS_OS_BR_ATTR_BIT(attr);
+    cfg.val[attr] = val;
+    return nas_os_br_attr_set_bulk(&cfg, 1, nullptr) == STD_ERR_OK;
+}
+
+t_std_error nas_os_br_attr_set_bulk(const nas_os_br_attr_cfg_t *cfg, size_t count, t_std_error *rc)
+{
+    if (cfg == nullptr && count != 0) return STD_ERR(NAS_OS, PARAM, 0);
+
+    std::vector<int> err(count, EOPNOTSUPP);
+#ifdef IFLA_BR_MAX
+    _br_nl_set_bulk(cfg, count, err);
+#endif
+
+    size_t failed = 0;
+    std::lock_guard<std::mutex> lock(_br_attr_mutex);
+    for (size_t pos = 0; pos < count; ++pos) {
+        const nas_os_br_attr_cfg_t &ent_cfg = cfg[pos];
+        auto it = _br_attr_db.find(ent_cfg.br_index);
+        nas_os_br_entry_t *ent = (it != _br_attr_db.end()) ? &it->second : nullptr;
+
+        /* Kernel without bridge changelink (3.16) - one sysfs write per knob */
+        if (err[pos] == EOPNOTSUPP) {
+            ent = _br_entry_get(ent_cfg.br_index, nullptr);
+            err[pos] = (ent == nullptr) ? ENODEV : 0;
+            for (size_t ix = 0; ent != nullptr && ix < NAS_OS_BR_ATTR_MAX; ++ix) {
+                if (!(ent_cfg.attr_mask & NAS_OS_BR_ATTR_BIT(ix))) continue;
+                err[pos] = _br_attr_sysfs_write(*ent, (nas_os_br_attr_t)ix, ent_cfg.val[ix]);
+                if (err[pos] != 0) break;
+            }
+        }
+
+        if (err[pos] != 0) {
+            EV_LOGGING(NAS_OS, ERR, "NAS-OS-BR-ATTR", "Failed to set attributes 0x%x of bridge %d err-no:%d",
+                       ent_cfg.attr_mask, ent_cfg.br_index, err[pos]);
+            if (rc != nullptr) rc[pos] = STD_ERR(NAS_OS, FAIL, err[pos]);
+            ++failed;
+            continue;
+        }
+        if (rc != nullptr) rc[pos] = STD_ERR_OK;
+        if (ent == nullptr) continue;
+        /* Read back from sysfs until the RTM_NEWLINK of the change is seen */
+        for (size_t ix = 0; ix < NAS_OS_BR_ATTR_MAX; ++ix) {
+            if (ent_cfg.attr_mask & NAS_OS_BR_ATTR_BIT(ix)) ent->nl_valid[ix] = false;
+        }
+    }
+    return (failed == 0) ? STD_ERR_OK : STD_ERR(NAS_OS, FAIL, 0);
+}
+
+void nas_os_br_attr_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *if_name,
+                               const char *info_kind, struct nlattr *info_data)
+{
+    if (info_kind == nullptr || strcmp(info_kind, "bridge") != 0) return;
+
+    std::lock_guard<std::mutex> lock(_br_attr_mutex);
+    if (rt_msg_type == RTM_DELLINK) {
+        auto it = _br_attr_db.find(ifindex);
+        if (it != _br_attr_db.end()) {
+            _br_entry_close(it->second);
+            _br_attr_db.erase(it);
+        }
+        return;
+    }
+
+    nas_os_br_entry_t *ent = _br_entry_get(ifindex, if_name);
+    if (ent == nullptr) return;
+
+    for (size_t ix = 0; ix < NAS_OS_BR_ATTR_MAX; ++ix) ent->nl_valid[ix] = false;
+#ifdef IFLA_BR_MAX
+    if (info_data == nullptr) return;
+    struct nlattr *br_attrs[IFLA_BR_MAX+1];
+    memset(br_attrs, 0, sizeof(br_attrs));
+    if (nla_parse_nested(br_attrs, IFLA_BR_MAX+1, info_data) != 0) return;
+
+    for (size_t ix = 0; ix < NAS_OS_BR_ATTR_MAX; ++ix) {
+        const nas_os_br_attr_desc_t &desc = _br_attr_desc[ix];
+        struct nlattr *nla = br_attrs[desc.nla];
+        if (desc.nla == 0 || nla == nullptr) continue;
+        ent->nl_val[ix] = (desc.nla_len == sizeof(uint8_t)) ? *(uint8_t *)nla_data(nla) : *(uint32_t *)nla_data(nla);
+        ent->nl_valid[ix] = true;
+    }
+#endif
+}
+
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_ctl_sock.cpp
+ * \brief  Per VRF pool of the interface ioctl sockets
+ */
+
+#include "nas_os_ctl_sock.h"
+#include "netlink_tools.h"
+#include "event_log.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+typedef struct {
+    std::string vrf_name;
+    int sock;
+    size_t users;
+    bool stale;         /* VRF deleted, closed by the last user */
+} nas_os_ctl_sock_t;
+
+static std::mutex _ctl_mutex;
+static auto & _ctl_by_vrf = *(new std::unordered_map<std::string, nas_os_ctl_sock_t*>);
+static auto & _ctl_by_sock = *(new std::unordered_map<int, nas_os_ctl_sock_t*>);
+
+static uint64_t _ctl_gets = 0;
+static uint64_t _ctl_creates = 0;
+static uint64_t _ctl_failures = 0;
+
+/* Called with the lock held */
+static void _ctl_sock_close(nas_os_ctl_sock_t *ent)
+{
+    EV_LOGGING(NAS_OS, INFO, "CTL-SOCK", "Closing VRF:%s sock:%d", ent->vrf_name.c_str(), ent->sock);
+    _ctl_by_sock.erase(ent->sock);
+    close(ent->sock);
+    delete ent;
+}
+
+extern "C" {
+
+int nas_os_ctl_sock_get(const char *vrf_name)
+{
+    if (vrf_name == NULL) vrf_name = NL_DEFAULT_VRF_NAME;
+
+    std::lock_guard<std::mutex> lock(_ctl_mutex);
+    ++_ctl_gets;
+
+    auto it = _ctl_by_vrf.find(vrf_name);
+    if (it != _ctl_by_vrf.end()) {
+        ++it->second->users;
+        return it->second->sock;
+    }
+
+    /* Created once per VRF - the namespace is only entered here */
+    int sock = -1;
+    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK) {
+        ++_ctl_failures;
+        return -1;
+    }
+    nas_os_ctl_sock_t *ent = new (std::nothrow) nas_os_ctl_sock_t;
+    if (ent == nullptr) {
+        close(sock);
+        ++_ctl_failures;
+        errno = ENOMEM;
+        return -1;
+    }
+    ent->vrf_name = vrf_name;
+    ent->sock = sock;
+    ent->users = 1;
+    ent->stale = false;
+    _ctl_by_vrf[ent->vrf_name] = ent;
+    _ctl_by_sock[sock] = ent;
+    ++_ctl_creates;
+
+    EV_LOGGING(NAS_OS, INFO, "CTL-SOCK", "Opened VRF:%s sock:%d", vrf_name, sock);
+    return sock;
+}
+
+void nas_os_ctl_sock_put(int sock)
+{
+    std::lock_guard<std::mutex> lock(_ctl_mutex);
+
+    auto it = _ctl_by_sock.find(sock);
+    if (it == _ctl_by_sock.end()) return;
+
+    nas_os_ctl_sock_t *ent = it->second;
+    if (ent->users > 0) --ent->users;
+    if (ent->stale && ent->users == 0) {
+        _ctl_sock_close(ent);
+    }
+}
+
+void nas_os_ctl_sock_vrf_del(const char *vrf_name)
+{
+    std::lock_guard<std::mutex> lock(_ctl_mutex);
+
+    auto it = _ctl_by_vrf.find(vrf_name);
+    if (it == _ctl_by_vrf.end()) return;
+
+    nas_os_ctl_sock_t *ent = it->second;
+    _ctl_by_vrf.erase(it);
+    /* A VRF added back with the same name gets a socket in the new namespace */
+    ent->stale = true;
+    if (ent->users == 0) {
+        _ctl_sock_close(ent);
+    }
+}
+
+void nas_os_ctl_sock_stats_get(nas_os_ctl_sock_stats_t *stats)
+{
+    std::lock_guard<std::mutex> lock(_ctl_mutex);
+
+    stats->gets = _ctl_gets;
+    stats->creates = _ctl_creates;
+    stats->failures = _ctl_failures;
+    stats->entries = _ctl_by_vrf.size();
+}
+
+}
+
+void os_debug_ctl_sock_print ()
+{
+    nas_os_ctl_sock_stats_t stats;
+    nas_os_ctl_sock_stats_get(&stats);
+
+    printf("\r\n Gets:%lu Creates:%lu Failures:%lu Entries:%lu\r\n",
+           stats.gets, stats.creates, stats.failures, stats.entries);
+
+    std::lock_guard<std::mutex> lock(_ctl_mutex);
+    for (auto & it : _ctl_by_vrf) {
+        printf("\r\n VRF:%-16s sock:%-6d users:%lu", it.first.c_str(), it.second->sock,
+               it.second->users);
+    }
+    printf("\r\n");
+}
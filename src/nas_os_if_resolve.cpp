@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_if_resolve.cpp
+ * \brief  (VRF, interface name) to ifindex resolution cache
+ */
+
+#include "nas_os_if_resolve.h"
+#include "nas_os_int_utils.h"
+#include "hal_if_mapping.h"
+#include "std_rw_lock.h"
+#include "std_utils.h"
+#include "event_log.h"
+
+#include <linux/rtnetlink.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+typedef struct {
+    std::string vrf_name;
+    std::string if_name;
+    hal_ifindex_t if_index;     /* ifindex to be programmed in the VRF */
+    uint32_t int_type;
+} nas_os_if_resolve_entry_t;
+
+static std_rw_lock_t _resolve_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Entries keyed by "<vrf>/<ifname>" with the indices used for the invalidation */
+static auto & _resolve_cache = *(new std::unordered_map<std::string,nas_os_if_resolve_entry_t>);
+static auto & _resolve_by_name = *(new std::unordered_map<std::string,std::unordered_set<std::string>>);
+static auto & _resolve_by_index = *(new std::unordered_map<hal_ifindex_t,std::unordered_set<std::string>>);
+
+/* Bumped on every invalidation, a lookup racing with an event is not cached */
+static std::atomic<uint64_t> _resolve_gen(0);
+
+static std::atomic<uint64_t> _resolve_hits(0);
+static std::atomic<uint64_t> _resolve_misses(0);
+static std::atomic<uint64_t> _resolve_invalidations(0);
+
+static inline std::string _resolve_key(const char *vrf_name, const char *if_name)
+{
+    std::string key(vrf_name);
+    key.append(1,'/');
+    key.append(if_name);
+    return key;
+}
+
+/* Called with the write lock held */
+static void _resolve_erase(const std::string & key)
+{
+    auto it = _resolve_cache.find(key);
+    if (it == _resolve_cache.end()) return;
+
+    auto name_it = _resolve_by_name.find(it->second.if_name);
+    if (name_it != _resolve_by_name.end()) {
+        name_it->second.erase(key);
+        if (name_it->second.empty()) _resolve_by_name.erase(name_it);
+    }
+    auto idx_it = _resolve_by_index.find(it->second.if_index);
+    if (idx_it != _resolve_by_index.end()) {
+        idx_it->second.erase(key);
+        if (idx_it->second.empty()) _resolve_by_index.erase(idx_it);
+    }
+    _resolve_cache.erase(it);
+    ++_resolve_invalidations;
+}
+
+/* Uncached resolution: NAS interface lookup, kernel lookup in the VRF for management interfaces */
+static t_std_error _resolve_lookup(const char *vrf_name, const char *if_name,
+                                   hal_ifindex_t *if_index, uint32_t *int_type)
+{
+    interface_ctrl_t intf_ctrl;
+    t_std_error rc = STD_ERR_OK;
+
+    memset(&intf_ctrl, 0, sizeof(interface_ctrl_t));
+    intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF_NAME;
+    safestrncpy(intf_ctrl.if_name, if_name, sizeof(intf_ctrl.if_name));
+
+    if ((rc = dn_hal_get_interface_info(&intf_ctrl)) != STD_ERR_OK) {
+        EV_LOGGING(NAS_OS, ERR, "IF-RESOLVE",
+                   "Interface %s to if_index returned error %d", intf_ctrl.if_name, rc);
+        return rc;
+    }
+    if (intf_ctrl.int_type == nas_int_type_MGMT) {
+        int os_index = 0;
+        if ((rc = nas_os_util_int_if_index_get(vrf_name, intf_ctrl.if_name, &os_index)) != STD_ERR_OK) {
+            EV_LOGGING(NAS_OS, ERR, "IF-RESOLVE",
+                       "Interface %s to if_index from OS returned error", intf_ctrl.if_name);
+            return rc;
+        }
+        EV_LOGGING(NAS_OS, INFO, "IF-RESOLVE", "Intf %s(%d) VRF %s OS-intf:%d",
+                   intf_ctrl.if_name, intf_ctrl.if_index, vrf_name, os_index);
+        intf_ctrl.if_index = os_index;
+    }
+    *if_index = intf_ctrl.if_index;
+    *int_type = intf_ctrl.int_type;
+    return STD_ERR_OK;
+}
+
+extern "C" {
+
+t_std_error nas_os_if_resolve(const char *vrf_name, const char *if_name,
+                              hal_ifindex_t *if_index, uint32_t *int_type)
+{
+    std::string key = _resolve_key(vrf_name, if_name);
+    {
+        std_rw_lock_read_guard l(&_resolve_lock);
+        auto it = _resolve_cache.find(key);
+        if (it != _resolve_cache.end()) {
+            *if_index = it->second.if_index;
+            if (int_type != NULL) *int_type = it->second.int_type;
+            ++_resolve_hits;
+            return STD_ERR_OK;
+        }
+    }
+    ++_resolve_misses;
+
+    uint64_t gen = _resolve_gen.load();
+    hal_ifindex_t index = 0;
+    uint32_t type = 0;
+    t_std_error rc = _resolve_lookup(vrf_name, if_name, &index, &type);
+    if (rc != STD_ERR_OK) return rc;
+
+    *if_index = index;
+    if (int_type != NULL) *int_type = type;
+
+    std_rw_lock_write_guard l(&_resolve_lock);
+    if (gen != _resolve_gen.load()) return STD_ERR_OK;
+
+    auto & entry = _resolve_cache[key];
+    entry.vrf_name = vrf_name;
+    entry.if_name = if_name;
+    entry.if_index = index;
+    entry.int_type = type;
+    _resolve_by_name[entry.if_name].insert(key);
+    _resolve_by_index[index].insert(key);
+    return STD_ERR_OK;
+}
+
+void nas_os_if_resolve_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *if_name)
+{
+    std_rw_lock_write_guard l(&_resolve_lock);
+    std::unordered_set<std::string> stale;
+
+    /* Deleted link, or a link renamed or replaced under a cached name */
+    auto idx_it = _resolve_by_index.find(ifindex);
+    if (idx_it != _resolve_by_index.end()) {
+        for (auto & key : idx_it->second) {
+            auto it = _resolve_cache.find(key);
+            if (rt_msg_type == RTM_DELLINK || if_name == NULL || it == _resolve_cache.end() ||
+                it->second.if_name != if_name) {
+                stale.insert(key);
+            }
+        }
+    }
+    if (if_name != NULL) {
+        auto name_it = _resolve_by_name.find(if_name);
+        if (name_it != _resolve_by_name.end()) {
+            for (auto & key : name_it->second) {
+                auto it = _resolve_cache.find(key);
+                if (rt_msg_type == RTM_DELLINK || it == _resolve_cache.end() ||
+                    (it->second.int_type != nas_int_type_MGMT && it->second.if_index != ifindex)) {
+                    stale.insert(key);
+                }
+            }
+        }
+    }
+    if (stale.empty()) return;
+
+    ++_resolve_gen;
+    for (auto & key : stale) {
+        _resolve_erase(key);
+    }
+}
+
+void nas_os_if_resolve_vrf_del(const char *vrf_name)
+{
+    std_rw_lock_write_guard l(&_resolve_lock);
+    std::string prefix = _resolve_key(vrf_name, "");
+
+    ++_resolve_gen;
+    for (auto it = _resolve_cache.begin(); it != _resolve_cache.end(); ) {
+        auto cur = it++;
+        if (cur->first.compare(0, prefix.size(), prefix) == 0) {
+            _resolve_erase(cur->first);
+        }
+    }
+}
+
+void nas_os_if_resolve_stats_get(nas_os_if_resolve_stats_t *stats)
+{
+    stats->hits = _resolve_hits.load();
+    stats->misses = _resolve_misses.load();
+    stats->invalidations = _resolve_invalidations.load();
+
+    std_rw_lock_read_guard l(&_resolve_lock);
+    stats->entries = _resolve_cache.size();
+}
+
+}
+
+void os_debug_if_resolve_print ()
+{
+    nas_os_if_resolve_stats_t stats;
+    nas_os_if_resolve_stats_get(&stats);
+
+    printf("\r\n Hits:%lu Misses:%lu Invalidations:%lu Entries:%lu\r\n",
+           stats.hits, stats.misses, stats.invalidations, stats.entries);
+
+    std_rw_lock_read_guard l(&_resolve_lock);
+    for (auto & it : _resolve_cache) {
+        printf("\r\n VRF:%-16s Intf:%-16s ifindex:%-6d type:%u",
+               it.second.vrf_name.c_str(), it.second.if_name.c_str(),
+               it.second.if_index, it.second.int_type);
+    }
+    printf("\r\n");
+}
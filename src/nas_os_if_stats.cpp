@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_if_stats.cpp
+ * \brief  Bulk interface statistics from an RTM_GETSTATS dump
+ */
+
+#include "nas_os_if_stats.h"
+#include "netlink_tools.h"
+#include "nas_nlmsg.h"
+#include "standard_netlink_requests.h"
+#include "event_log.h"
+#include "std_time_tools.h"
+
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* A stats message with the 64 bit link counters is about 200 bytes */
+#define NL_STATS_BUFF_LEN (32*1024)
+
+struct nas_os_if_stats_tbl_s {
+    std::string vrf_name;
+    int sock;
+    int seq;
+    size_t max_if;
+
+    std::vector<nas_os_if_stats_ent_t> ents;        /* max_if entries, count used */
+    size_t count;
+    std::unordered_map<hal_ifindex_t, size_t> slot;
+    std::unordered_set<hal_ifindex_t> filter;
+    std::vector<char> buff;
+
+    nas_os_if_stats_tbl_stats_t stats;
+};
+
+/* Interface of the dump kept by the poll, checked before its counters are read */
+static bool _if_stats_wanted(nas_os_if_stats_tbl_t *tbl, hal_ifindex_t ifindex)
+{
+    if (!tbl->filter.empty() && tbl->filter.find(ifindex) == tbl->filter.end()) return false;
+
+    if (tbl->count == tbl->max_if) {
+        ++tbl->stats.skipped;
+        return false;
+    }
+    return true;
+}
+
+/* Entry of a wanted interface */
+static nas_os_if_stats_ent_t * _if_stats_ent_add(nas_os_if_stats_tbl_t *tbl, hal_ifindex_t ifindex)
+{
+    nas_os_if_stats_ent_t &ent = tbl->ents[tbl->count];
+    ent.ifindex = ifindex;
+    tbl->slot[ifindex] = tbl->count++;
+    return &ent;
+}
+
+#ifdef IFLA_STATS_LINK_64
+
+/* No output multicast and invalid protocol counters in the link stats, all 64 bit */
+#define NAS_OS_IF_STATS_LINK64_VALID \
+    (~(NAS_OS_IF_STATS_CTR_BIT(output_multicast) | NAS_OS_IF_STATS_CTR_BIT(output_invalid_protocol)))
+
+static void _if_stats_from_link64(const struct rtnl_link_stats64 *link, os_int_stats_t *data)
+{
+    memset(data, 0, sizeof(*data));
+    data->input_packets = link->rx_packets;
+    data->input_bytes = link->rx_bytes;
+    data->input_multicast = link->multicast;
+    data->input_errors = link->rx_errors;
+    data->input_discards = link->rx_dropped;
+    data->output_packets = link->tx_packets;
+    data->output_bytes = link->tx_bytes;
+    data->output_errors = link->tx_errors;
+}
+
+static bool _if_stats_process(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *context, uint32_t vrf_id)
+{
+    nas_os_if_stats_tbl_t *tbl = (nas_os_if_stats_tbl_t *)context;
+    if (rt_msg_type != RTM_NEWSTATS) return true;
+
+    struct if_stats_msg *ifsm = (struct if_stats_msg *)NLMSG_DATA(hdr);
+    int attr_len = nlmsg_attrlen(hdr, sizeof(*ifsm));
+    if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*ifsm)) || attr_len < 0) return true;
+
+    struct nlattr *attrs[__IFLA_STATS_MAX];
+    nla_parse(attrs, __IFLA_STATS_MAX, nlmsg_attrdata(hdr, sizeof(*ifsm)), attr_len);
+    if (attrs[IFLA_STATS_LINK_64] == NULL ||
+        nla_len(attrs[IFLA_STATS_LINK_64]) < (int)sizeof(struct rtnl_link_stats64)) {
+        return true;
+    }
+
+    if (!_if_stats_wanted(tbl, ifsm->ifindex)) return true;
+    nas_os_if_stats_ent_t *ent = _if_stats_ent_add(tbl, ifsm->ifindex);
+    _if_stats_from_link64((const struct rtnl_link_stats64 *)nla_data(attrs[IFLA_STATS_LINK_64]), &ent->stats);
+    ent->valid = NAS_OS_IF_STATS_LINK64_VALID;
+    ent->wrap32 = 0;
+    return true;
+}
+
+static bool _if_stats_request(nas_os_if_stats_tbl_t *tbl, int seq)
+{
+    struct if_stats_msg ifsm;
+    memset(&ifsm, 0, sizeof(ifsm));
+    ifsm.family = AF_UNSPEC;
+    ifsm.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    return nl_send_request(tbl->sock, RTM_GETSTATS, NLM_F_REQUEST | NLM_F_DUMP, seq, &ifsm, sizeof(ifsm));
+}
+
+#else
+
+/*
+ * RTM_GETSTATS is from kernel 4.7, before it the interfaces of the VRF are
+ * dumped with RTM_GETLINK and read with the ethtool ioctls as before.
+ */
+static bool _if_stats_process(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *context, uint32_t vrf_id)
+{
+    nas_os_if_stats_tbl_t *tbl = (nas_os_if_stats_tbl_t *)context;
+    if (rt_msg_type != RTM_NEWLINK) return true;
+
+    struct ifinfomsg *ifmsg = (struct ifinfomsg *)NLMSG_DATA(hdr);
+    int attr_len = nlmsg_attrlen(hdr, sizeof(*ifmsg));
+    if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*ifmsg)) || attr_len < 0) return true;
+    /* Filtered out before the ioctls, a poll of one port reads only that port */
+    if (!_if_stats_wanted(tbl, ifmsg->ifi_index)) return true;
+
+    struct nlattr *attrs[__IFLA_MAX];
+    nla_parse(attrs, __IFLA_MAX, nlmsg_attrdata(hdr, sizeof(*ifmsg)), attr_len);
+    if (attrs[IFLA_IFNAME] == NULL) return true;
+
+    os_int_stats_t data;
+    memset(&data, 0, sizeof(data));
+    /* Interfaces without the ethtool statistics are left out */
+    if (nas_os_util_int_stats_get(tbl->vrf_name.c_str(), (const char *)nla_data(attrs[IFLA_IFNAME]),
+                                  &data) != STD_ERR_OK) {
+        return true;
+    }
+    nas_os_if_stats_ent_t *ent = _if_stats_ent_add(tbl, ifmsg->ifi_index);
+    ent->stats = data;
+    ent->valid = ~0U;
+    /* The width of the driver counters is not known */
+    ent->wrap32 = ~0U;
+    return true;
+}
+
+static bool _if_stats_request(nas_os_if_stats_tbl_t *tbl, int seq)
+{
+    return nl_route_send_get_all(tbl->sock, RTM_GETLINK, AF_PACKET, seq);
+}
+
+#endif
+
+extern "C" {
+
+nas_os_if_stats_tbl_t * nas_os_if_stats_tbl_create(const char *vrf_name, size_t max_if)
+{
+    nas_os_if_stats_tbl_t *tbl = new (std::nothrow) nas_os_if_stats_tbl_t;
+    if (tbl == nullptr) return nullptr;
+
+    try {
+        tbl->vrf_name = (vrf_name != NULL) ? vrf_name : NL_DEFAULT_VRF_NAME;
+        tbl->ents.resize(max_if);
+        tbl->slot.reserve(max_if);
+        tbl->buff.resize(NL_STATS_BUFF_LEN);
+    } catch (std::bad_alloc &) {
+        delete tbl;
+        return nullptr;
+    }
+    tbl->sock = -1;
+    tbl->seq = 0;
+    tbl->max_if = max_if;
+    tbl->count = 0;
+    memset(&tbl->stats, 0, sizeof(tbl->stats));
+    return tbl;
+}
+
+void nas_os_if_stats_tbl_delete(nas_os_if_stats_tbl_t *tbl)
+{
+    if (tbl == nullptr) return;
+    if (tbl->sock != -1) close(tbl->sock);
+    delete tbl;
+}
+
+void nas_os_if_stats_tbl_filter(nas_os_if_stats_tbl_t *tbl, hal_ifindex_t ifindex, bool enable)
+{
+    if (enable) {
+        tbl->filter.insert(ifindex);
+    } else {
+        tbl->filter.erase(ifindex);
+    }
+}
+
+t_std_error nas_os_if_stats_tbl_poll(nas_os_if_stats_tbl_t *tbl)
+{
+    uint64_t start_us = std_get_uptime(NULL);
+
+    tbl->count = 0;
+    tbl->slot.clear();
+    tbl->stats.skipped = 0;
+
+    /* Socket kept across the polls, opened again after a failure (e.g. VRF re-created) */
+    if (tbl->sock == -1) {
+        tbl->sock = nas_nl_sock_create(tbl->vrf_name.c_str(), nas_nl_sock_T_INT, false);
+        if (tbl->sock == -1) {
+            EV_LOGGING(NAS_OS, ERR, "IF-STATS", "Failed to create socket for VRF %s", tbl->vrf_name.c_str());
+            return STD_ERR(INTERFACE, FAIL, errno);
+        }
+    }
+
+    int seq = ++tbl->seq;
+    bool rc = _if_stats_request(tbl, seq) &&
+              netlink_tools_process_socket(tbl->sock, _if_stats_process, tbl, &tbl->buff[0], tbl->buff.size(),
+                                           &seq, NULL, NL_DEFAULT_VRF_ID);
+    if (!rc) {
+        EV_LOGGING(NAS_OS, ERR, "IF-STATS", "Stats dump failed for VRF %s", tbl->vrf_name.c_str());
+        close(tbl->sock);
+        tbl->sock = -1;
+    }
+
+    uint64_t elapsed = std_get_uptime(NULL) - start_us;
+    ++tbl->stats.polls;
+    tbl->stats.entries = tbl->count;
+    tbl->stats.last_poll_us = elapsed;
+    if (elapsed > tbl->stats.max_poll_us) tbl->stats.max_poll_us = elapsed;
+
+    if (tbl->stats.skipped != 0) {
+        EV_LOGGING(NAS_OS, INFO, "IF-STATS", "VRF %s: %zu interfaces over the table size %zu",
+                   tbl->vrf_name.c_str(), tbl->stats.skipped, tbl->max_if);
+    }
+    return rc ? STD_ERR_OK : STD_ERR(INTERFACE, FAIL, 0);
+}
+
+const nas_os_if_stats_ent_t * nas_os_if_stats_tbl_entries(nas_os_if_stats_tbl_t *tbl, size_t *count)
+{
+    *count = tbl->count;
+    return tbl->ents.empty() ? nullptr : &tbl->ents[0];
+}
+
+const os_int_stats_t * nas_os_if_stats_tbl_get(nas_os_if_stats_tbl_t *tbl, hal_ifindex_t ifindex)
+{
+    auto it = tbl->slot.find(ifindex);
+    if (it == tbl->slot.end()) return nullptr;
+    return &tbl->ents[it->second].stats;
+}
+
+void nas_os_if_stats_tbl_stats_get(nas_os_if_stats_tbl_t *tbl, nas_os_if_stats_tbl_stats_t *stats)
+{
+    *stats = tbl->stats;
+}
+
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_if_stats_engine.cpp
+ * \brief  Interface statistics sampled in the background, with deltas and rates
+ */
+
+#include "nas_os_if_stats.h"
+#include "nas_os_interface.h"
+#include "netlink_tools.h"
+#include "event_log.h"
+#include "std_thread_tools.h"
+#include "std_time_tools.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define NAS_OS_IF_STATS_MAX_IF      8192
+#define NAS_OS_IF_STATS_DFLT_RING   4
+#define NAS_OS_IF_STATS_CTR_CNT     (sizeof(os_int_stats_t)/sizeof(uint64_t))
+
+typedef struct {
+    uint64_t time_us;
+    os_int_stats_t stats;
+} nas_os_if_stats_snap_t;
+
+typedef struct {
+    std::vector<nas_os_if_stats_snap_t> snaps;
+    size_t head;        /* next sample written */
+    size_t count;
+    uint64_t gen;       /* last poll the interface was in */
+    uint32_t valid;     /* counters of the last sample */
+    uint32_t wrap32;
+} nas_os_if_stats_ring_t;
+
+using if_stats_rings_t = std::unordered_map<hal_ifindex_t, nas_os_if_stats_ring_t>;
+
+/* Not destroyed at exit, the sampler thread may still be waiting on them */
+static auto & _eng_mutex = *(new std::mutex);
+static auto & _eng_cv = *(new std::condition_variable);
+static nas_os_if_stats_cfg_t _eng_cfg = {0, NAS_OS_IF_STATS_DFLT_RING};
+static bool _eng_started = false;
+static std_thread_create_param_t _eng_thr;
+static uint64_t _eng_gen = 0;
+
+/* Rings of the sampled VRFs, a VRF is added by its first read */
+static auto & _eng_vrfs = *(new std::map<std::string, if_stats_rings_t>);
+
+/* Interfaces reset during the current poll, their polled counters may be from before */
+static auto & _eng_reset = *(new std::unordered_set<hal_ifindex_t>);
+
+/* Tables of the sampled VRFs, only used by the sampler thread */
+static auto & _eng_tbls = *(new std::map<std::string, nas_os_if_stats_tbl_t*>);
+
+static inline uint64_t _ctr(const os_int_stats_t &stats, size_t ix)
+{
+    return ((const uint64_t *)&stats)[ix];
+}
+
+static inline void _ctr_set(os_int_stats_t &stats, size_t ix, uint64_t val)
+{
+    ((uint64_t *)&stats)[ix] = val;
+}
+
+static inline bool _ctr_is_octets(size_t ix)
+{
+    return (ix == offsetof(os_int_stats_t, input_bytes)/sizeof(uint64_t)) ||
+           (ix == offsetof(os_int_stats_t, output_bytes)/sizeof(uint64_t));
+}
+
+static inline const nas_os_if_stats_snap_t & _ring_at(const nas_os_if_stats_ring_t &ring, size_t back)
+{
+    size_t len = ring.snaps.size();
+    return ring.snaps[(ring.head + len - 1 - back) % len];
+}
+
+static void _if_stats_sampler()
+{
+    while (true) {
+        std::vector<std::pair<std::string, nas_os_if_stats_tbl_t*>> polled;
+        {
+            std::unique_lock<std::mutex> lock(_eng_mutex);
+            _eng_cv.wait(lock, [] { return _eng_cfg.interval_ms != 0; });
+            _eng_cv.wait_for(lock, std::chrono::milliseconds(_eng_cfg.interval_ms));
+            if (_eng_cfg.interval_ms == 0) continue;
+
+            for (auto it = _eng_tbls.begin(); it != _eng_tbls.end(); ) {
+                auto cur = it++;
+                if (_eng_vrfs.find(cur->first) == _eng_vrfs.end()) {
+                    nas_os_if_stats_tbl_delete(cur->second);
+                    _eng_tbls.erase(cur);
+                }
+            }
+            for (auto &vrf : _eng_vrfs) {
+                auto &tbl = _eng_tbls[vrf.first];
+                if (tbl == nullptr) tbl = nas_os_if_stats_tbl_create(vrf.first.c_str(), NAS_OS_IF_STATS_MAX_IF);
+                if (tbl != nullptr) polled.push_back(std::make_pair(vrf.first, tbl));
+            }
+            _eng_reset.clear();
+        }
+
+        /* One dump per VRF for all the readers, outside the lock */
+        std::vector<bool> ok(polled.size());
+        for (size_t ix = 0; ix < polled.size(); ++ix) {
+            ok[ix] = (nas_os_if_stats_tbl_poll(polled[ix].second) == STD_ERR_OK);
+        }
+        uint64_t now = std_get_uptime(NULL);
+
+        std::lock_guard<std::mutex> lock(_eng_mutex);
+        ++_eng_gen;
+        for (size_t ix = 0; ix < polled.size(); ++ix) {
+            auto vrf_it = _eng_vrfs.find(polled[ix].first);
+            if (!ok[ix] || vrf_it == _eng_vrfs.end()) continue;
+
+            size_t count = 0;
+            const nas_os_if_stats_ent_t *ents = nas_os_if_stats_tbl_entries(polled[ix].second, &count);
+            for (size_t ent = 0; ent < count; ++ent) {
+                if (_eng_reset.find(ents[ent].ifindex) != _eng_reset.end()) continue;
+                nas_os_if_stats_ring_t &ring = vrf_it->second[ents[ent].ifindex];
+                if (ring.snaps.size() != _eng_cfg.ring_len) {
+                    ring.snaps.resize(_eng_cfg.ring_len);
+                    ring.head = ring.count = 0;
+                }
+                ring.snaps[ring.head].time_us = now;
+                ring.snaps[ring.head].stats = ents[ent].stats;
+                ring.valid = ents[ent].valid;
+                ring.wrap32 = ents[ent].wrap32;
+                ring.head = (ring.head + 1) % ring.snaps.size();
+                if (ring.count < ring.snaps.size()) ++ring.count;
+                ring.gen = _eng_gen;
+            }
+            /* Deleted interfaces */
+            for (auto it = vrf_it->second.begin(); it != vrf_it->second.end(); ) {
+                if (it->second.gen != _eng_gen) {
+                    it = vrf_it->second.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+}
+
+extern "C" {
+
+uint64_t nas_os_if_stats_ctr_delta(uint64_t prev, uint64_t cur, bool wrap32)
+{
+    if (cur >= prev) return cur - prev;
+    /* A 32 bit counter passed 2^32 since the previous sample */
+    if (wrap32 && prev <= UINT32_MAX) return cur + ((uint64_t)UINT32_MAX + 1) - prev;
+    /*
+     * Reset not seen as a link event (counters cleared by the driver), the
+     * increase since the reset is the counter
+     */
+    return cur;
+}
+
+t_std_error nas_os_if_stats_config_set (const nas_os_if_stats_cfg_t *cfg)
+{
+    if (cfg == NULL || cfg->ring_len < 2) return STD_ERR(INTERFACE, PARAM, 0);
+
+    std::lock_guard<std::mutex> lock(_eng_mutex);
+    if (cfg->interval_ms != 0 && !_eng_started) {
+        std_thread_init_struct(&_eng_thr);
+        _eng_thr.name = "db-api-linux-if-stats";
+        _eng_thr.thread_function = (std_thread_function_t)_if_stats_sampler;
+        if (std_thread_create(&_eng_thr) != STD_ERR_OK) {
+            EV_LOGGING(NAS_OS, ERR, "IF-STATS", "Failed to create statistics sampler");
+            return STD_ERR(INTERFACE, FAIL, 0);
+        }
+        _eng_started = true;
+    }
+    /* Samples of another interval or ring length are not mixed */
+    if (cfg->interval_ms == 0 || cfg->interval_ms != _eng_cfg.interval_ms ||
+        cfg->ring_len != _eng_cfg.ring_len) {
+        for (auto &vrf : _eng_vrfs) vrf.second.clear();
+    }
+    if (cfg->interval_ms == 0) _eng_vrfs.clear();
+
+    _eng_cfg = *cfg;
+    _eng_cv.notify_one();
+
+    EV_LOGGING(NAS_OS, INFO, "IF-STATS", "Statistics interval %ums ring %u", cfg->interval_ms, cfg->ring_len);
+    return STD_ERR_OK;
+}
+
+t_std_error nas_os_if_stats_config_get (nas_os_if_stats_cfg_t *cfg)
+{
+    if (cfg == NULL) return STD_ERR(INTERFACE, PARAM, 0);
+
+    std::lock_guard<std::mutex> lock(_eng_mutex);
+    *cfg = _eng_cfg;
+    return STD_ERR_OK;
+}
+
+bool nas_os_if_stats_engine_get(const char *vrf_name, hal_ifindex_t ifindex, nas_os_if_stats_sample_t *sample)
+{
+    if (vrf_name == NULL) vrf_name = NL_DEFAULT_VRF_NAME;
+
+    std::lock_guard<std::mutex> lock(_eng_mutex);
+    if (_eng_cfg.interval_ms == 0) return false;
+
+    auto vrf_it = _eng_vrfs.find(vrf_name);
+    if (vrf_it == _eng_vrfs.end()) {
+        _eng_vrfs[vrf_name];
+        return false;
+    }
+    auto it = vrf_it->second.find(ifindex);
+    if (it == vrf_it->second.end() || it->second.count < 2) return false;
+
+    const nas_os_if_stats_ring_t &ring = it->second;
+    const nas_os_if_stats_snap_t &last = _ring_at(ring, 0);
+    const nas_os_if_stats_snap_t &prev = _ring_at(ring, 1);
+    const nas_os_if_stats_snap_t &first = _ring_at(ring, ring.count - 1);
+
+    memset(sample, 0, sizeof(*sample));
+    sample->stats = last.stats;
+    sample->interval_ms = (last.time_us - prev.time_us) / 1000;
+    sample->valid = ring.valid;
+
+    uint64_t window_us = last.time_us - first.time_us;
+    for (size_t ix = 0; ix < NAS_OS_IF_STATS_CTR_CNT; ++ix) {
+        bool wrap32 = (ring.wrap32 & (1U << ix)) != 0;
+        _ctr_set(sample->delta, ix, nas_os_if_stats_ctr_delta(_ctr(prev.stats, ix), _ctr(last.stats, ix), wrap32));
+
+        /* Summed per sample for the wraps inside the window */
+        uint64_t total = 0;
+        for (size_t back = ring.count - 1; back > 0; --back) {
+            total += nas_os_if_stats_ctr_delta(_ctr(_ring_at(ring, back).stats, ix),
+                                               _ctr(_ring_at(ring, back - 1).stats, ix), wrap32);
+        }
+        if (_ctr_is_octets(ix)) total *= 8;
+        _ctr_set(sample->rate, ix, (window_us != 0) ? (uint64_t)((double)total * 1000000 / window_us) : 0);
+    }
+    return true;
+}
+
+void nas_os_if_stats_engine_if_reset(hal_ifindex_t ifindex)
+{
+    std::lock_guard<std::mutex> lock(_eng_mutex);
+    /* The interface of the index may be in any VRF */
+    for (auto &vrf : _eng_vrfs) vrf.second.erase(ifindex);
+    _eng_reset.insert(ifindex);
+}
+
+void nas_os_if_stats_engine_vrf_del(const char *vrf_name)
+{
+    std::lock_guard<std::mutex> lock(_eng_mutex);
+    _eng_vrfs.erase(vrf_name);
+}
+
+}
+
+void os_debug_if_stats_engine_print ()
+{
+    std::lock_guard<std::mutex> lock(_eng_mutex);
+
+    printf("\r\n Interval:%ums Ring:%u Samples:%lu\r\n", _eng_cfg.interval_ms, _eng_cfg.ring_len, _eng_gen);
+    for (auto &vrf : _eng_vrfs) {
+        printf("\r\n VRF:%-16s interfaces:%lu", vrf.first.c_str(), vrf.second.size());
+    }
+    printf("\r\n");
+}
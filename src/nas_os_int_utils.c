@@ -33,6 +33,7 @@
 #include "dell-base-if-linux.h"
 #include "dell-base-interface-common.h"
 #include "netlink_tools.h"
+#include "nas_os_ctl_sock.h"
 
 #include <net/if_arp.h>
 #include <linux/if.h>
@@ -63,7 +64,7 @@ t_std_error nas_os_util_int_mtu_get(const char *name, unsigned int *mtu) {
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
 
     t_std_error err = STD_ERR_OK;
@@ -77,7 +78,7 @@ t_std_error nas_os_util_int_mtu_get(const char *name, unsigned int *mtu) {
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-GET",STD_ERR_EXT_PRIV(err));
     } while(0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -86,7 +87,7 @@ t_std_error nas_os_util_int_admin_state_get(const char *name, db_interface_state
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
 
     t_std_error err = STD_ERR_OK;
@@ -103,7 +104,7 @@ t_std_error nas_os_util_int_admin_state_get(const char *name, db_interface_state
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-GET",STD_ERR_EXT_PRIV(err));
     } while(0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -111,7 +112,7 @@ t_std_error nas_os_util_int_mac_addr_get(const char *name, hal_mac_addr_t *macAd
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
     t_std_error err = STD_ERR_OK;
 
@@ -124,7 +125,7 @@ t_std_error nas_os_util_int_mac_addr_get(const char *name, hal_mac_addr_t *macAd
         err = STD_ERR(INTERFACE,FAIL,errno);
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-SET",STD_ERR_EXT_PRIV(err));
     } while (0);
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -133,7 +134,7 @@ t_std_error nas_os_util_int_admin_state_set(const char *name, db_interface_state
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
 
     t_std_error err = STD_ERR_OK;
@@ -153,7 +154,7 @@ t_std_error nas_os_util_int_admin_state_set(const char *name, db_interface_state
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-SET",STD_ERR_EXT_PRIV(err));
     } while(0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -162,7 +163,7 @@ t_std_error nas_os_util_int_mtu_set(const char *name, unsigned int mtu)
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
 
     t_std_error err = STD_ERR_OK;
@@ -172,7 +173,7 @@ t_std_error nas_os_util_int_mtu_set(const char *name, unsigned int mtu)
         err = STD_ERR(INTERFACE,FAIL,errno);
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-SET",errno);
     }
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -180,7 +181,7 @@ t_std_error nas_os_util_int_mac_addr_set(const char *name, hal_mac_addr_t *macAd
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
     t_std_error err = STD_ERR_OK;
 
@@ -194,7 +195,7 @@ t_std_error nas_os_util_int_mac_addr_set(const char *name, hal_mac_addr_t *macAd
         err = STD_ERR(INTERFACE,FAIL,errno);
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-SET",STD_ERR_EXT_PRIV(err));
     } while (0);
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -204,7 +205,7 @@ t_std_error nas_os_util_int_flags_get(const char *vrf_name, const char *name, un
     struct ifreq  ifr;
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK) {
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1) {
         return STD_ERR(INTERFACE,FAIL,errno);
     }
 
@@ -219,7 +220,7 @@ t_std_error nas_os_util_int_flags_get(const char *vrf_name, const char *name, un
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-GET",STD_ERR_EXT_PRIV(err));
     } while(0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -229,7 +230,7 @@ t_std_error nas_os_util_int_get_if_details(const char *name, cps_api_object_t ob
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
     const int NAS_LINK_MTU_HDR_SIZE = 32;
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = nas_os_ctl_sock_get(NULL);
     if (sock==-1) return STD_ERR(INTERFACE,FAIL,errno);
 
     t_std_error err = STD_ERR(INTERFACE,FAIL,errno);
@@ -259,7 +260,7 @@ t_std_error nas_os_util_int_get_if_details(const char *name, cps_api_object_t ob
         err = STD_ERR_OK;
     } while(0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -268,7 +269,7 @@ t_std_error nas_os_util_int_if_index_get(const char *vrf_name, const char *if_na
     int sock = 0;
     t_std_error err = STD_ERR(INTERFACE,FAIL,errno);
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK)
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1)
         return err;
 
     struct ifreq  ifr;
@@ -283,7 +284,7 @@ t_std_error nas_os_util_int_if_index_get(const char *vrf_name, const char *if_na
         err = STD_ERR_OK;
     }
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -292,7 +293,7 @@ t_std_error nas_os_util_int_if_name_get(const char *vrf_name, int if_index, char
     int sock = 0;
     t_std_error err = STD_ERR(INTERFACE,FAIL,errno);
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK)
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1)
         return err;
 
     struct ifreq  ifr;
@@ -305,7 +306,7 @@ t_std_error nas_os_util_int_if_name_get(const char *vrf_name, int if_index, char
         err = STD_ERR_OK;
     }
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -315,7 +316,7 @@ t_std_error nas_os_util_int_oper_status_get (const char *vrf_name, const char *n
     int sock = 0;
     t_std_error err = STD_ERR(INTERFACE,FAIL,errno);
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK)
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1)
         return err;
 
     struct ifreq  ifr;
@@ -329,7 +330,7 @@ t_std_error nas_os_util_int_oper_status_get (const char *vrf_name, const char *n
             : IF_INTERFACES_STATE_INTERFACE_OPER_STATUS_DOWN;
         err = STD_ERR_OK;
     }
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 t_std_error nas_os_util_int_ethtool_cmd_data_get (const char *vrf_name, const char *name, ethtool_cmd_data_t *eth_cmd)
@@ -345,7 +346,7 @@ t_std_error nas_os_util_int_ethtool_cmd_data_get (const char *vrf_name, const ch
     memset(&ifr, 0, sizeof(ifr));
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK)
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1)
         return STD_ERR(INTERFACE,FAIL,errno);
 
     ecmd.cmd = ETHTOOL_GSET;
@@ -412,7 +413,7 @@ t_std_error nas_os_util_int_ethtool_cmd_data_get (const char *vrf_name, const ch
 
     } while (0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 }
 
@@ -474,7 +475,7 @@ t_std_error nas_os_util_int_ethtool_cmd_data_set (const char *vrf_name, const ch
     memset(&ifr, 0, sizeof(ifr));
     strncpy(ifr.ifr_ifrn.ifrn_name,name,sizeof(ifr.ifr_ifrn.ifrn_name)-1);
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK)
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1)
         return STD_ERR(INTERFACE,FAIL,errno);
 
     ecmd.cmd = ETHTOOL_SSET;
@@ -521,7 +522,7 @@ t_std_error nas_os_util_int_ethtool_cmd_data_set (const char *vrf_name, const ch
         err = STD_ERR(INTERFACE,FAIL,errno);
         EV_LOG_ERRNO(ev_log_t_INTERFACE,3,"DB-LINUX-SET",errno);
     }
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return err;
 
 }
@@ -579,7 +580,7 @@ t_std_error nas_os_util_int_stats_get (const char *vrf_name, const char *name, o
     int                        sock;
     t_std_error                ret = STD_ERR_OK;
 
-    if (os_sock_create(vrf_name, e_std_sock_INET4, e_std_sock_type_DGRAM, 0, &sock) != STD_ERR_OK)
+    if ((sock = nas_os_ctl_sock_get(vrf_name)) == -1)
         return STD_ERR(INTERFACE,FAIL,errno);
 
     memset(&ifr, 0, sizeof(ifr));
@@ -619,7 +620,7 @@ t_std_error nas_os_util_int_stats_get (const char *vrf_name, const char *name, o
         os_intf_stats_parse(data, secmd, stats);
     } while (0);
 
-    close(sock);
+    nas_os_ctl_sock_put(sock);
     return ret;
 }
 
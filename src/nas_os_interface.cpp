@@ -33,7 +33,10 @@
 #include "nas_os_interface.h"
 #include "nas_os_if_priv.h"
 #include "nas_os_int_utils.h"
+#include "nas_os_l3_utils.h"
 #include "hal_if_mapping.h"
+#include "ietf-network-instance.h"
+#include "vrf-mgmt.h"
 
 #include "nas_nlmsg_object_utils.h"
 #include "ds_api_linux_interface.h"
@@ -134,20 +137,35 @@ extern "C" t_std_error nas_os_get_interface_obj(hal_ifindex_t ifix,cps_api_objec
 }
 
 extern "C" t_std_error nas_os_get_interface(cps_api_object_t filter,cps_api_object_list_t result) {
-    cps_api_object_attr_t ifix =
+    if_query_t query;
+    query.ifindex = 0;
+    query.if_type = BASE_CMN_INTERFACE_TYPE_NULL;
+    query.master_idx = 0;
+
+    cps_api_object_attr_t attr =
                 cps_api_object_attr_get(filter, DELL_BASE_IF_CMN_IF_INTERFACES_INTERFACE_IF_INDEX);
-    hal_ifindex_t ifindex = 0;
-    cps_api_object_attr_t type_attr =
-                cps_api_object_attr_get(filter, IF_INTERFACES_INTERFACE_TYPE);
-    uint_t if_type = 0;
-    if (ifix != nullptr) {
-        ifindex = cps_api_object_attr_data_u32(ifix);
-        type_attr = nullptr; // Won't consider if_type if ifindex is specified
-    } else if (type_attr != nullptr) {
-        const char *ietf_type = (const char *)cps_api_object_attr_data_bin(type_attr);
-        ietf_to_nas_os_if_type_get(ietf_type, (BASE_CMN_INTERFACE_TYPE_t *)&if_type);
+    if (attr != nullptr) {
+        query.ifindex = cps_api_object_attr_data_u32(attr);
+    } else if ((attr = cps_api_object_attr_get(filter, IF_INTERFACES_INTERFACE_NAME)) != nullptr) {
+        query.if_name = (const char *)cps_api_object_attr_data_bin(attr);
+    }
+    /* Won't consider if_type if ifindex is specified */
+    if (query.ifindex == 0 &&
+        (attr = cps_api_object_attr_get(filter, IF_INTERFACES_INTERFACE_TYPE)) != nullptr) {
+        const char *ietf_type = (const char *)cps_api_object_attr_data_bin(attr);
+        ietf_to_nas_os_if_type_get(ietf_type, &query.if_type);
+    }
+    if ((attr = cps_api_object_attr_get(filter, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_MASTER)) != nullptr) {
+        query.master_idx = cps_api_object_attr_data_u32(attr);
+    }
+    if ((attr = cps_api_object_attr_get(filter, NI_IF_INTERFACES_INTERFACE_BIND_NI_NAME)) != nullptr) {
+        query.vrf_name = (const char *)cps_api_object_attr_data_bin(attr);
+    } else if ((attr = cps_api_object_attr_get(filter, VRF_MGMT_NI_IF_INTERFACES_INTERFACE_VRF_ID)) != nullptr) {
+        const char *vrf_name = nas_os_get_vrf_name(cps_api_object_attr_data_u32(attr));
+        if (vrf_name == nullptr) return STD_ERR(NAS_OS,PARAM,0);
+        query.vrf_name = vrf_name;
     }
-    _get_interfaces(result,ifindex, ifix==nullptr, if_type);
+    _get_interfaces_query(result, query);
     return STD_ERR_OK;
 }
 
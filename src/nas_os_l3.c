@@ -44,8 +44,12 @@
 #include "vrf-mgmt.h"
 #include "nas_os_int_utils.h"
 #include "nas_os_l3_utils.h"
+#include "nas_os_if_resolve.h"
+#include "nas_os_rt_shadow.h"
+#include "nas_os_trace.h"
 
 #include <arpa/inet.h>
+#include <stddef.h>
 #include <netinet/in.h>
 #include <linux/netlink.h>
 #include <sys/socket.h>
@@ -53,9 +57,6 @@
 #include <string.h>
 #include <unistd.h>
 
-/* To support the IPv6 route with 256 NHs - 8K buffer is required */
-#define NL_RT_MSG_BUFFER_LEN  8192 /* Buffer len to update the route to kernel */
-#define NL_RT_RMSG_BUFFER_LEN 1024 /* Buffer len to receive reply for the route from kernel */
 #define NL_RT_NBR_MSG_BUFFER_LEN 1024 /* Buffer len to update the neighbor to kernel */
 #define MAX_NL_NH_ECMP_COUNT  256
 #define MAC_STRING_LEN 20
@@ -74,9 +75,20 @@ static inline uint16_t nas_os_get_nl_flags(nas_rt_msg_type m_type, bool is_ack_r
 
 #define MAX_CPS_MSG_SIZE 10000
 
+/* Idempotent route programming - the route writes are checked against the kernel route view */
+static bool nas_os_rt_idempotent = false;
+
+/* Outcome of a route write */
+typedef enum {
+    NAS_OS_RT_PROG_ADDED,       /* route not known to be in the kernel */
+    NAS_OS_RT_PROG_REPLACED,    /* kernel had the route with different next hops */
+    NAS_OS_RT_PROG_SKIPPED,     /* kernel has the same route, nothing sent */
+    NAS_OS_RT_PROG_DELETED,
+} nas_os_rt_prog_t;
+
 static t_std_error nas_os_publish_leaked_route(int rt_msg_type, cps_api_object_t obj, bool is_rt_route_replace)
 {
-    static char buff[MAX_CPS_MSG_SIZE];
+    char buff[MAX_CPS_MSG_SIZE];
 
     cps_api_operation_types_t op;
     if(rt_msg_type == RTM_NEWROUTE) {
@@ -140,7 +152,7 @@ static t_std_error nas_os_publish_leaked_route(int rt_msg_type, cps_api_object_t
 
 static t_std_error nas_os_publish_route(int rt_msg_type, cps_api_object_t obj, bool is_rt_route_replace)
 {
-    static char buff[MAX_CPS_MSG_SIZE];
+    char buff[MAX_CPS_MSG_SIZE];
     hal_vrf_id_t rt_vrf_id = 0;
     hal_vrf_id_t nh_vrf_id = 0;
 
@@ -288,7 +300,7 @@ static t_std_error nas_os_publish_route(int rt_msg_type, cps_api_object_t obj, b
 
 static t_std_error nas_os_publish_leaked_route_nexthop(int rt_msg_type, cps_api_object_t obj, bool is_rt_route_replace)
 {
-    static char buff[MAX_CPS_MSG_SIZE];
+    char buff[MAX_CPS_MSG_SIZE];
 
     cps_api_operation_types_t op;
     if(rt_msg_type == RTM_NEWROUTE) {
@@ -351,7 +363,7 @@ static t_std_error nas_os_publish_leaked_route_nexthop(int rt_msg_type, cps_api_
  */
 static t_std_error nas_os_publish_route_nexthop (int rt_msg_type, cps_api_object_t obj, bool is_rt_route_replace)
 {
-    static char buff[MAX_CPS_MSG_SIZE];
+    char buff[MAX_CPS_MSG_SIZE];
     hal_vrf_id_t rt_vrf_id = 0;
     hal_vrf_id_t nh_vrf_id = 0;
 
@@ -496,38 +508,143 @@ static t_std_error nas_os_publish_route_nexthop (int rt_msg_type, cps_api_object
 }
 
 
+static const nas_os_rt_nh_t nas_os_rt_nh_none;
+
+static inline const nas_os_rt_nh_t *nas_os_rt_nh(const nas_os_rt_decoded_t *rt, size_t ix)
+{
+    return (ix < rt->nh_seen) ? &rt->nh[ix] : &nas_os_rt_nh_none;
+}
+
+static void nas_os_rt_decode_nh(cps_api_object_it_t *nh_it, nas_os_rt_nh_t *nh)
+{
+    cps_api_object_it_t it = *nh_it;
+
+    for (cps_api_object_it_inside(&it); cps_api_object_it_valid(&it); cps_api_object_it_next(&it)) {
+        switch (cps_api_object_attr_id(it.attr)) {
+            case BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR:
+                if (nh->addr == NULL) nh->addr = cps_api_object_attr_data_bin(it.attr);
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFINDEX:
+                if (!nh->has_ifindex) {
+                    nh->ifindex = cps_api_object_attr_data_u32(it.attr);
+                    nh->has_ifindex = true;
+                }
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFNAME:
+                if (nh->if_name == NULL) {
+                    nh->if_name = (const char *)cps_api_object_attr_data_bin(it.attr);
+                    nh->if_name_len = cps_api_object_attr_len(it.attr);
+                }
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT:
+                if (!nh->has_weight) {
+                    nh->weight = cps_api_object_attr_data_u32(it.attr);
+                    nh->has_weight = true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void nas_os_rt_decode(cps_api_object_t obj, nas_os_rt_decoded_t *rt)
+{
+    cps_api_object_it_t it;
+
+    memset(rt, 0, offsetof(nas_os_rt_decoded_t, nh));
+
+    for (cps_api_object_it_begin(obj, &it); cps_api_object_it_valid(&it); cps_api_object_it_next(&it)) {
+        switch (cps_api_object_attr_id(it.attr)) {
+            case BASE_ROUTE_OBJ_VRF_NAME:
+                if (rt->vrf_name == NULL) rt->vrf_name = (const char *)cps_api_object_attr_data_bin(it.attr);
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_NH_VRF_NAME:
+                if (rt->nh_vrf_name == NULL) rt->nh_vrf_name = (const char *)cps_api_object_attr_data_bin(it.attr);
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX:
+                if (rt->prefix == NULL) rt->prefix = cps_api_object_attr_data_bin(it.attr);
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_AF:
+                if (!rt->has_af) {
+                    rt->af = cps_api_object_attr_data_u32(it.attr);
+                    rt->has_af = true;
+                }
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN:
+                if (!rt->has_prefix_len) {
+                    rt->prefix_len = cps_api_object_attr_data_u32(it.attr);
+                    rt->has_prefix_len = true;
+                }
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_NH_COUNT:
+                if (!rt->has_nh_count) {
+                    rt->nh_count = cps_api_object_attr_data_u32(it.attr);
+                    rt->has_nh_count = true;
+                }
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_SPECIAL_NEXT_HOP:
+                if (!rt->has_spl_nh) {
+                    rt->spl_nh_type = cps_api_object_attr_data_u32(it.attr);
+                    rt->has_spl_nh = true;
+                }
+                break;
+            case BASE_ROUTE_OBJ_ENTRY_NH_LIST: {
+                cps_api_object_it_t nh_it = it;
+                for (cps_api_object_it_inside(&nh_it); cps_api_object_it_valid(&nh_it);
+                     cps_api_object_it_next(&nh_it)) {
+                    size_t ix = cps_api_object_attr_id(nh_it.attr);
+                    if (ix >= NAS_OS_RT_MAX_NH) continue;
+                    /* Only the entries in use are cleared */
+                    if (ix >= rt->nh_seen) {
+                        memset(&rt->nh[rt->nh_seen], 0, (ix + 1 - rt->nh_seen) * sizeof(rt->nh[0]));
+                        rt->nh_seen = ix + 1;
+                    }
+                    nas_os_rt_decode_nh(&nh_it, &rt->nh[ix]);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+/* Decoded route of the calling thread, too large (256 next hops) for the stack of the encoder */
+static __thread nas_os_rt_decoded_t _nas_os_rt_decoded;
+
 /* Ensure for any changes made to nas_os_update_route() related to netlink route
  * processing, nas_os_update_route_nexthop() has to be updated accordingly.
  */
-cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type m_type)
+static cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type m_type,
+                                                  nas_os_rt_encode_buf_t *buf, nas_os_rt_prog_t *prog)
 {
-    static char buff[NL_RT_MSG_BUFFER_LEN], buff1[NL_RT_RMSG_BUFFER_LEN]; // Allocate from DS
     char            addr_str[INET6_ADDRSTRLEN];
     int         nhm_count = 0;
     bool        repeat_delete = false;
+    nas_os_rt_decoded_t *rt = &_nas_os_rt_decoded;
 
-    memset(buff,0,sizeof(struct nlmsghdr));
+    memset(buf->msg,0,sizeof(struct nlmsghdr));
 
-    const char *vrf_name           = cps_api_object_get_data(obj,BASE_ROUTE_OBJ_VRF_NAME);
-    cps_api_object_attr_t prefix   = cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX);
-    cps_api_object_attr_t af       = cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_ENTRY_AF);
-    cps_api_object_attr_t nh_count = cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_ENTRY_NH_COUNT);
-    cps_api_object_attr_t pref_len = cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN);
-    cps_api_object_attr_t spl_nexthop_option =
-                            cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_ENTRY_SPECIAL_NEXT_HOP);
+    nas_os_rt_decode(obj, rt);
 
-    if (prefix == CPS_API_ATTR_NULL || af == CPS_API_ATTR_NULL ||  pref_len == CPS_API_ATTR_NULL
-        || (m_type != NAS_RT_DEL && (nh_count == CPS_API_ATTR_NULL && spl_nexthop_option == CPS_API_ATTR_NULL))) {
+    const char *vrf_name = rt->vrf_name;
+
+    if (rt->prefix == NULL || !rt->has_af || !rt->has_prefix_len
+        || (m_type != NAS_RT_DEL && (!rt->has_nh_count && !rt->has_spl_nh))) {
         EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD", "Missing route params");
         return cps_api_ret_code_ERR;
     }
 
-    uint32_t nhc = 0;
-    if (nh_count != CPS_API_ATTR_NULL) nhc = cps_api_object_attr_data_u32(nh_count);
+    uint32_t nhc = rt->nh_count;
+    if (nhc > NAS_OS_RT_MAX_NH) {
+        EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD", "Invalid NH count %d, max %d", nhc, NAS_OS_RT_MAX_NH);
+        return cps_api_ret_code_ERR;
+    }
 
     /* Check whether route and NH are in the different VRF, if yes, it's leaked route,
      * do local publish to handle it in the NAS-L3 for NPU programming only. */
-    const char *nh_vrf_name = cps_api_object_get_data(obj,BASE_ROUTE_OBJ_ENTRY_NH_VRF_NAME);
+    const char *nh_vrf_name = rt->nh_vrf_name;
     if (nh_vrf_name) {
         if (((vrf_name == NULL) && (strncmp(nh_vrf_name, NAS_DEFAULT_VRF_NAME, NAS_VRF_NAME_SZ))) ||
             (vrf_name && (strncmp(vrf_name, nh_vrf_name, NAS_VRF_NAME_SZ)))) {
@@ -540,8 +657,8 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
     }
     uint32_t spl_nh_type = 0;
 
-    if (spl_nexthop_option != CPS_API_ATTR_NULL) {
-        spl_nh_type = cps_api_object_attr_data_u32(spl_nexthop_option);
+    if (rt->has_spl_nh) {
+        spl_nh_type = rt->spl_nh_type;
 
         if (nhc > 1) {
             EV_LOGGING (NAS_OS, ERR, "NAS-RT-CPS-SET",
@@ -553,8 +670,8 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
     }
 
     struct nlmsghdr *nlh = (struct nlmsghdr *)
-                         nlmsg_reserve((struct nlmsghdr *)buff,sizeof(buff),sizeof(struct nlmsghdr));
-    struct rtmsg * rm = (struct rtmsg *) nlmsg_reserve(nlh,sizeof(buff),sizeof(struct rtmsg));
+                         nlmsg_reserve((struct nlmsghdr *)buf->msg,sizeof(buf->msg),sizeof(struct nlmsghdr));
+    struct rtmsg * rm = (struct rtmsg *) nlmsg_reserve(nlh,sizeof(buf->msg),sizeof(struct rtmsg));
     memset(rm, 0, sizeof(struct rtmsg));
 
     uint16_t flags = nas_os_get_nl_flags(m_type,true);
@@ -574,7 +691,7 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
         rm->rtm_scope = RT_SCOPE_NOWHERE;
 
 
-    if (spl_nexthop_option == CPS_API_ATTR_NULL) {
+    if (!rt->has_spl_nh) {
         rm->rtm_type = RTN_UNICAST;
     } else {
         switch (spl_nh_type) {
@@ -601,32 +718,31 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
         }
     }
 
-    rm->rtm_dst_len = cps_api_object_attr_data_u32(pref_len);
-    rm->rtm_family = (unsigned char) cps_api_object_attr_data_u32(af);
+    rm->rtm_dst_len = rt->prefix_len;
+    rm->rtm_family = (unsigned char) rt->af;
 
     uint32_t addr_len = (rm->rtm_family == AF_INET)?HAL_INET4_LEN:HAL_INET6_LEN;
-    nlmsg_add_attr(nlh,sizeof(buff),RTA_DST,cps_api_object_attr_data_bin(prefix),addr_len);
+    nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_DST,rt->prefix,addr_len);
 
     EV_LOGGING (NAS_OS,INFO, "ROUTE-UPD","VRF:%s NH count:%d family:%s msg:%s for prefix:%s len:%d proto:%d scope:%d type:%d",
                 (vrf_name ? vrf_name : ""), nhc,
            ((rm->rtm_family == AF_INET) ? "IPv4" : "IPv6"), ((m_type == NAS_RT_ADD) ? "Route-Add" : ((m_type == NAS_RT_DEL) ? "Route-Del" : "Route-Set")),
            ((rm->rtm_family == AF_INET) ?
-            (inet_ntop(rm->rtm_family, cps_api_object_attr_data_bin(prefix), addr_str, INET_ADDRSTRLEN)) :
-            (inet_ntop(rm->rtm_family, cps_api_object_attr_data_bin(prefix), addr_str, INET6_ADDRSTRLEN))),
+            (inet_ntop(rm->rtm_family, rt->prefix, addr_str, INET_ADDRSTRLEN)) :
+            (inet_ntop(rm->rtm_family, rt->prefix, addr_str, INET6_ADDRSTRLEN))),
            rm->rtm_dst_len, rm->rtm_protocol, rm->rtm_scope, rm->rtm_type);
+    NAS_OS_TRACE("ROUTE-UPD", "NH count:%d af:%d msg:%d len:%d proto:%d scope:%d type:%d",
+                 nhc, rm->rtm_family, m_type, rm->rtm_dst_len, rm->rtm_protocol, rm->rtm_scope, rm->rtm_type);
 
     if (nhc == 1) {
-        cps_api_attr_id_t ids[3] = { BASE_ROUTE_OBJ_ENTRY_NH_LIST,
-                                     0, BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR};
-        const int ids_len = sizeof(ids)/sizeof(*ids);
-        cps_api_object_attr_t gw = cps_api_object_e_get(obj,ids,ids_len);
-        if (gw != CPS_API_ATTR_NULL) {
-            nlmsg_add_attr(nlh,sizeof(buff),RTA_GATEWAY,cps_api_object_attr_data_bin(gw),addr_len);
+        const nas_os_rt_nh_t *nh = nas_os_rt_nh(rt, 0);
+        if (nh->addr != NULL) {
+            nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_GATEWAY,nh->addr,addr_len);
             rm->rtm_scope = RT_SCOPE_UNIVERSE; // set scope to universe when gateway is specified
             EV_LOGGING(NAS_OS, INFO,"ROUTE-UPD","NH:%s scope:%d",
                    ((rm->rtm_family == AF_INET) ?
-                    (inet_ntop(rm->rtm_family, cps_api_object_attr_data_bin(gw), addr_str, INET_ADDRSTRLEN)) :
-                    (inet_ntop(rm->rtm_family, cps_api_object_attr_data_bin(gw), addr_str, INET6_ADDRSTRLEN))),
+                    (inet_ntop(rm->rtm_family, nh->addr, addr_str, INET_ADDRSTRLEN)) :
+                    (inet_ntop(rm->rtm_family, nh->addr, addr_str, INET6_ADDRSTRLEN))),
                    rm->rtm_scope);
         } else {
             EV_LOGGING(NAS_OS, INFO, "ROUTE-UPD", "Missing Gateway, could be intf route");
@@ -635,10 +751,8 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
              */
         }
 
-        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFINDEX;
-        cps_api_object_attr_t gwix = cps_api_object_e_get(obj,ids,ids_len);
-        if (gwix != CPS_API_ATTR_NULL) {
-            if ((gw == CPS_API_ATTR_NULL) && (rm->rtm_type != RTN_LOCAL)) {
+        if (nh->has_ifindex) {
+            if ((nh->addr == NULL) && (rm->rtm_type != RTN_LOCAL)) {
                 rm->rtm_scope = RT_SCOPE_LINK;
                 /* For route create with link scope, change the flags to route replace.
                  * This is needed inorder to overwrite the connected route with RTM created route,
@@ -657,39 +771,21 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
             }
 
             EV_LOGGING(NAS_OS, INFO,"ROUTE-UPD","out-intf: %d scope:%d",
-                   (int)cps_api_object_attr_data_u32(gwix), rm->rtm_scope);
-            nas_nl_add_attr_int(nlh,sizeof(buff),RTA_OIF,gwix);
+                   (int)nh->ifindex, rm->rtm_scope);
+            nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_OIF,&nh->ifindex,sizeof(nh->ifindex));
         } else {
-            ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFNAME;
-            cps_api_object_attr_t gw_if_name = cps_api_object_e_get(obj,ids,ids_len);
-
-            if (gw_if_name != CPS_API_ATTR_NULL) {
+            if (nh->if_name != NULL) {
                 interface_ctrl_t intf_ctrl;
-                t_std_error rc = STD_ERR_OK;
                 memset(&intf_ctrl, 0, sizeof(interface_ctrl_t));
-                intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF_NAME;
-                safestrncpy(intf_ctrl.if_name, (const char *)cps_api_object_attr_data_bin(gw_if_name),
-                            cps_api_object_attr_len(gw_if_name));
+                safestrncpy(intf_ctrl.if_name, nh->if_name, nh->if_name_len);
 
-                if((rc= dn_hal_get_interface_info(&intf_ctrl)) != STD_ERR_OK) {
+                if (nas_os_if_resolve((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), intf_ctrl.if_name,
+                                      &intf_ctrl.if_index, NULL) != STD_ERR_OK) {
                     EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD",
-                               "Interface %s to if_index returned error %d", intf_ctrl.if_name, rc);
+                               "Interface %s to if_index failed", intf_ctrl.if_name);
                     return cps_api_ret_code_ERR;
                 }
-                if (intf_ctrl.int_type == nas_int_type_MGMT) {
-                    int if_index = 0;
-                    if (nas_os_util_int_if_index_get((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME),
-                                                     intf_ctrl.if_name, &if_index) != STD_ERR_OK) {
-                        EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD",
-                                   "Interface %s to if_index from OS returned error",
-                                   intf_ctrl.if_name);
-                        return cps_api_ret_code_ERR;
-                    }
-                    EV_LOGGING(NAS_OS,INFO,"ROUTE-UPD","out-intf: %s(%d) OS-intf:%d",
-                               intf_ctrl.if_name, intf_ctrl.if_index, if_index);
-                    intf_ctrl.if_index = if_index;
-                }
-                if ((gw == CPS_API_ATTR_NULL) && (rm->rtm_type != RTN_LOCAL)) {
+                if ((nh->addr == NULL) && (rm->rtm_type != RTN_LOCAL)) {
                     rm->rtm_scope = RT_SCOPE_LINK;
                     /* For route create with link scope, change the flags to route replace.
                      * This is needed inorder to overwrite the connected route with RTM created route,
@@ -710,76 +806,52 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
 
                 EV_LOGGING(NAS_OS,INFO,"ROUTE-UPD","out-intf: %s(%d)",
                            intf_ctrl.if_name, intf_ctrl.if_index);
-                nlmsg_add_attr(nlh,sizeof(buff),RTA_OIF,&(intf_ctrl.if_index), sizeof(intf_ctrl.if_index));
+                nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_OIF,&(intf_ctrl.if_index), sizeof(intf_ctrl.if_index));
             }
         }
-        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT;
-        cps_api_object_attr_t weight = cps_api_object_e_get(obj,ids,ids_len);
-        if (weight != CPS_API_ATTR_NULL) nas_nl_add_attr_int(nlh,sizeof(buff),RTA_PRIORITY,weight);
+        if (nh->has_weight) {
+            nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_PRIORITY,&nh->weight,sizeof(nh->weight));
+        }
 
     } else if (nhc > 1){
-        struct nlattr * attr_nh = nlmsg_nested_start(nlh, sizeof(buff));
+        struct nlattr * attr_nh = nlmsg_nested_start(nlh, sizeof(buf->msg));
 
         attr_nh->nla_len = 0;
         attr_nh->nla_type = RTA_MULTIPATH;
         size_t ix = 0;
         for (ix = 0; ix < nhc ; ++ix) {
             struct rtnexthop * rtnh =
-                (struct rtnexthop * )nlmsg_reserve(nlh,sizeof(buff), sizeof(struct rtnexthop));
+                (struct rtnexthop * )nlmsg_reserve(nlh,sizeof(buf->msg), sizeof(struct rtnexthop));
             memset(rtnh,0,sizeof(*rtnh));
 
-            cps_api_attr_id_t ids[3] = { BASE_ROUTE_OBJ_ENTRY_NH_LIST,
-                                         ix, BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR};
-            const int ids_len = sizeof(ids)/sizeof(*ids);
-            cps_api_object_attr_t attr = cps_api_object_e_get(obj,ids,ids_len);
-            if (attr != CPS_API_ATTR_NULL) {
-                nlmsg_add_attr(nlh,sizeof(buff),RTA_GATEWAY,
-                               cps_api_object_attr_data_bin(attr),addr_len);
+            const nas_os_rt_nh_t *nh = nas_os_rt_nh(rt, ix);
+            if (nh->addr != NULL) {
+                nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_GATEWAY,nh->addr,addr_len);
                 rm->rtm_scope = RT_SCOPE_UNIVERSE; // set scope to universe when gateway is specified
                 EV_LOGGING(NAS_OS, INFO,"ROUTE-UPD","MP-NH:%lu %s scope:%d",ix,
                        ((rm->rtm_family == AF_INET) ?
-                        (inet_ntop(rm->rtm_family, cps_api_object_attr_data_bin(attr), addr_str, INET_ADDRSTRLEN)) :
-                        (inet_ntop(rm->rtm_family, cps_api_object_attr_data_bin(attr), addr_str, INET6_ADDRSTRLEN))),
+                        (inet_ntop(rm->rtm_family, nh->addr, addr_str, INET_ADDRSTRLEN)) :
+                        (inet_ntop(rm->rtm_family, nh->addr, addr_str, INET6_ADDRSTRLEN))),
                        rm->rtm_scope);
             } else {
                 EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD", "Error - Missing Gateway");
                 return cps_api_ret_code_ERR;
             }
 
-            ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFINDEX;
-            attr = cps_api_object_e_get(obj,ids,ids_len);
-            if (attr != CPS_API_ATTR_NULL) {
-                rtnh->rtnh_ifindex = (int)cps_api_object_attr_data_u32(attr);
+            if (nh->has_ifindex) {
+                rtnh->rtnh_ifindex = (int)nh->ifindex;
             } else {
-                ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFNAME;
-                attr = cps_api_object_e_get(obj,ids,ids_len);
-
-                if (attr != CPS_API_ATTR_NULL) {
+                if (nh->if_name != NULL) {
                     interface_ctrl_t intf_ctrl;
-                    t_std_error rc = STD_ERR_OK;
                     memset(&intf_ctrl, 0, sizeof(interface_ctrl_t));
-                    intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF_NAME;
-                    safestrncpy(intf_ctrl.if_name, (const char *)cps_api_object_attr_data_bin(attr),
-                                cps_api_object_attr_len(attr));
+                    safestrncpy(intf_ctrl.if_name, nh->if_name, nh->if_name_len);
 
-                    if((rc= dn_hal_get_interface_info(&intf_ctrl)) != STD_ERR_OK) {
+                    if (nas_os_if_resolve((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), intf_ctrl.if_name,
+                                          &intf_ctrl.if_index, NULL) != STD_ERR_OK) {
                         EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD",
-                                   "Interface %s to if_index returned error %d", intf_ctrl.if_name, rc);
+                                   "Interface %s to if_index failed", intf_ctrl.if_name);
                         return cps_api_ret_code_ERR;
                     }
-                    if (intf_ctrl.int_type == nas_int_type_MGMT) {
-                        int if_index = 0;
-                        if (nas_os_util_int_if_index_get((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME),
-                                                         intf_ctrl.if_name, &if_index) != STD_ERR_OK) {
-                            EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD",
-                                       "Interface %s to if_index from OS returned error",
-                                       intf_ctrl.if_name);
-                            return cps_api_ret_code_ERR;
-                        }
-                        EV_LOGGING(NAS_OS,INFO,"ROUTE-UPD","out-intf: %s(%d) OS-intf:%d",
-                                   intf_ctrl.if_name, intf_ctrl.if_index, if_index);
-                        intf_ctrl.if_index = if_index;
-                    }
 
                     EV_LOGGING(NAS_OS,INFO,"ROUTE-UPD","out-intf: %s(%d) ",
                                intf_ctrl.if_name, intf_ctrl.if_index);
@@ -787,9 +859,7 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
                 }
             }
 
-            ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT;
-            attr = cps_api_object_e_get(obj,ids,ids_len);
-            if (attr != CPS_API_ATTR_NULL) rtnh->rtnh_hops = (char)cps_api_object_attr_data_u32(attr);
+            if (nh->has_weight) rtnh->rtnh_hops = (char)nh->weight;
 
             rtnh->rtnh_len = (char*)nlmsg_tail(nlh) - (char*)rtnh;
         }
@@ -807,13 +877,38 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
         nhm_count = MAX_NL_NH_ECMP_COUNT;
     }
 
+    const char *nl_vrf_name = (vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME);
+    nas_os_rt_prog_t result = (type == RTM_DELROUTE) ? NAS_OS_RT_PROG_DELETED : NAS_OS_RT_PROG_ADDED;
+
+    bool idempotent = nas_os_route_idempotent_mode_get();
+    if ((type == RTM_NEWROUTE) && idempotent) {
+        switch (nas_os_rt_shadow_check(nl_vrf_name, nlh)) {
+            case NAS_OS_RT_SHADOW_SAME:
+                EV_LOGGING(NAS_OS, INFO, "ROUTE-UPD", "Route unchanged in kernel, skipped");
+                if (prog) *prog = NAS_OS_RT_PROG_SKIPPED;
+                return STD_ERR_OK;
+            case NAS_OS_RT_SHADOW_DIFF:
+                /* Same as the EEXIST handling below, only the IPv4 route is replaced */
+                if (rm->rtm_family == AF_INET) {
+                    nlh->nlmsg_flags &= ~NLM_F_EXCL;
+                    nlh->nlmsg_flags |= NLM_F_REPLACE;
+                }
+                result = NAS_OS_RT_PROG_REPLACED;
+                break;
+            default:
+                break;
+        }
+    }
+    /* Unknown until the kernel reports the result of the write */
+    if (idempotent) nas_os_rt_shadow_invalidate(nl_vrf_name, nlh);
+
     t_std_error rc;
     int err_code;
 
     do  {
 
         uint16_t rt_flags = nlh->nlmsg_flags;
-        rc = nl_do_set_request((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), nas_nl_sock_T_ROUTE,nlh,buff1,sizeof(buff1));
+        rc = nl_do_set_request((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), nas_nl_sock_T_ROUTE,nlh,buf->reply,sizeof(buf->reply));
         nhm_count--;
         err_code = STD_ERR_EXT_PRIV (rc);
         EV_LOGGING(NAS_OS, INFO,"ROUE_UPD","Netlink error_code %d flags:0x%x", err_code, rt_flags);
@@ -853,11 +948,12 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
                     nlh->nlmsg_flags &= ~NLM_F_EXCL;
                     nlh->nlmsg_flags |= NLM_F_REPLACE;
                     rc = nl_do_set_request((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME),
-                                           nas_nl_sock_T_ROUTE,nlh,buff1,sizeof(buff1));
+                                           nas_nl_sock_T_ROUTE,nlh,buf->reply,sizeof(buf->reply));
                     err_code = STD_ERR_EXT_PRIV (rc);
                     EV_LOGGING(NAS_OS, INFO,"ROUE_UPD","Route replace - Netlink error_code %d",
                                err_code);
                 }
+                result = NAS_OS_RT_PROG_REPLACED;
             }
 
             rc = STD_ERR_OK;
@@ -866,6 +962,7 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
 
     } while ((repeat_delete == true) && (nhm_count > 0));
 
+    if (prog) *prog = result;
     return rc;
 
 }
@@ -874,16 +971,15 @@ cps_api_return_code_t nas_os_update_route (cps_api_object_t obj, nas_rt_msg_type
  * Ensure any changes made to nas_os_update_route() related to netlink route
  * processing, take care of updating nas_os_update_route_nexthop() accordingly.
  */
-t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
+t_std_error nas_os_update_route_nexthop_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf)
 {
-    static char buff[NL_RT_MSG_BUFFER_LEN], buff1[NL_RT_RMSG_BUFFER_LEN]; // Allocate from DS
     char        addr_str[INET6_ADDRSTRLEN];
     uint32_t    nhc = 0;
     int         op = 0;
     nas_rt_msg_type    m_type;
     t_std_error rc = STD_ERR_OK;
 
-    memset(buff,0,sizeof(struct nlmsghdr));
+    memset(buf->msg,0,sizeof(struct nlmsghdr));
 
     const char *vrf_name           = cps_api_object_get_data(obj, BASE_ROUTE_ROUTE_NH_OPERATION_INPUT_VRF_NAME);
     cps_api_object_attr_t prefix   = cps_api_object_attr_get(obj, BASE_ROUTE_ROUTE_NH_OPERATION_INPUT_ROUTE_PREFIX);
@@ -917,8 +1013,8 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
     nhc = cps_api_object_attr_data_u32(nh_count);
 
     struct nlmsghdr *nlh = (struct nlmsghdr *)
-                         nlmsg_reserve((struct nlmsghdr *)buff,sizeof(buff),sizeof(struct nlmsghdr));
-    struct rtmsg * rm = (struct rtmsg *) nlmsg_reserve(nlh,sizeof(buff),sizeof(struct rtmsg));
+                         nlmsg_reserve((struct nlmsghdr *)buf->msg,sizeof(buf->msg),sizeof(struct nlmsghdr));
+    struct rtmsg * rm = (struct rtmsg *) nlmsg_reserve(nlh,sizeof(buf->msg),sizeof(struct rtmsg));
     memset(rm, 0, sizeof(struct rtmsg));
 
     uint16_t type = (m_type == NAS_RT_DEL) ? RTM_DELROUTE:RTM_NEWROUTE;
@@ -951,7 +1047,7 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
     rm->rtm_family = (unsigned char) cps_api_object_attr_data_u32(af);
 
     uint32_t addr_len = (rm->rtm_family == AF_INET)?HAL_INET4_LEN:HAL_INET6_LEN;
-    nlmsg_add_attr(nlh,sizeof(buff),RTA_DST,cps_api_object_attr_data_bin(prefix),addr_len);
+    nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_DST,cps_api_object_attr_data_bin(prefix),addr_len);
 
     EV_LOGGING(NAS_OS, INFO, "ROUTE-NH-UPD","VRF:%s NH count:%d family:%s msg:%s for prefix:%s len:%d proto:%d scope:%d type:%d",
                (vrf_name ? vrf_name : ""), nhc,
@@ -968,7 +1064,7 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
         const int ids_len = sizeof(ids)/sizeof(*ids);
         cps_api_object_attr_t gw = cps_api_object_e_get(obj,ids,ids_len);
         if (gw != CPS_API_ATTR_NULL) {
-            nlmsg_add_attr(nlh,sizeof(buff),RTA_GATEWAY,cps_api_object_attr_data_bin(gw),addr_len);
+            nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_GATEWAY,cps_api_object_attr_data_bin(gw),addr_len);
             rm->rtm_scope = RT_SCOPE_UNIVERSE; // set scope to universe when gateway is specified
             EV_LOGGING (NAS_OS, INFO, "ROUTE-NH-UPD","NH:%s scope:%d",
                         ((rm->rtm_family == AF_INET) ?
@@ -991,43 +1087,42 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
 
             EV_LOGGING (NAS_OS, INFO, "ROUTE-NH-UPD","out-intf: %d scope:%d",
                         (int)cps_api_object_attr_data_u32(gwix), rm->rtm_scope);
-            nas_nl_add_attr_int(nlh,sizeof(buff),RTA_OIF,gwix);
+            nas_nl_add_attr_int(nlh,sizeof(buf->msg),RTA_OIF,gwix);
         } else {
             ids[2] = BASE_ROUTE_ROUTE_NH_OPERATION_INPUT_NH_LIST_IFNAME;
             cps_api_object_attr_t gw_if_name = cps_api_object_e_get(obj,ids,ids_len);
 
             if (gw_if_name != CPS_API_ATTR_NULL) {
                 interface_ctrl_t intf_ctrl;
-                t_std_error rc = STD_ERR_OK;
                 memset(&intf_ctrl, 0, sizeof(interface_ctrl_t));
-                intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF_NAME;
                 safestrncpy(intf_ctrl.if_name, (const char *)cps_api_object_attr_data_bin(gw_if_name),
                             cps_api_object_attr_len(gw_if_name));
 
-                if((rc= dn_hal_get_interface_info(&intf_ctrl)) != STD_ERR_OK) {
+                if (nas_os_if_resolve((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), intf_ctrl.if_name,
+                                      &intf_ctrl.if_index, NULL) != STD_ERR_OK) {
                     EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD",
-                               "Interface %s to if_index returned error %d", intf_ctrl.if_name, rc);
+                               "Interface %s to if_index failed", intf_ctrl.if_name);
                     return cps_api_ret_code_ERR;
                 }
                 EV_LOGGING(NAS_OS,INFO,"ROUTE-UPD","out-intf: %s(%d)",
                            intf_ctrl.if_name, intf_ctrl.if_index);
-                nlmsg_add_attr(nlh,sizeof(buff),RTA_OIF,&(intf_ctrl.if_index), sizeof(intf_ctrl.if_index));
+                nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_OIF,&(intf_ctrl.if_index), sizeof(intf_ctrl.if_index));
             }
         }
 
         ids[2] = BASE_ROUTE_ROUTE_NH_OPERATION_INPUT_NH_LIST_WEIGHT;
         cps_api_object_attr_t weight = cps_api_object_e_get(obj,ids,ids_len);
-        if (weight != CPS_API_ATTR_NULL) nas_nl_add_attr_int(nlh,sizeof(buff),RTA_PRIORITY,weight);
+        if (weight != CPS_API_ATTR_NULL) nas_nl_add_attr_int(nlh,sizeof(buf->msg),RTA_PRIORITY,weight);
 
     } else if (nhc > 1){
-        struct nlattr * attr_nh = nlmsg_nested_start(nlh, sizeof(buff));
+        struct nlattr * attr_nh = nlmsg_nested_start(nlh, sizeof(buf->msg));
 
         attr_nh->nla_len = 0;
         attr_nh->nla_type = RTA_MULTIPATH;
         size_t ix = 0;
         for (ix = 0; ix < nhc ; ++ix) {
             struct rtnexthop * rtnh =
-                (struct rtnexthop * )nlmsg_reserve(nlh,sizeof(buff), sizeof(struct rtnexthop));
+                (struct rtnexthop * )nlmsg_reserve(nlh,sizeof(buf->msg), sizeof(struct rtnexthop));
             memset(rtnh,0,sizeof(*rtnh));
 
             cps_api_attr_id_t ids[3] = { BASE_ROUTE_ROUTE_NH_OPERATION_INPUT_NH_LIST,
@@ -1035,7 +1130,7 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
             const int ids_len = sizeof(ids)/sizeof(*ids);
             cps_api_object_attr_t attr = cps_api_object_e_get(obj,ids,ids_len);
             if (attr != CPS_API_ATTR_NULL) {
-                nlmsg_add_attr(nlh,sizeof(buff),RTA_GATEWAY,
+                nlmsg_add_attr(nlh,sizeof(buf->msg),RTA_GATEWAY,
                                cps_api_object_attr_data_bin(attr),addr_len);
                 rm->rtm_scope = RT_SCOPE_UNIVERSE; // set scope to universe when gateway is specified
                 EV_LOGGING (NAS_OS, INFO, "ROUTE-NH-UPD","MP-NH:%lu %s scope:%d",ix,
@@ -1058,15 +1153,14 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
 
                 if (attr != CPS_API_ATTR_NULL) {
                     interface_ctrl_t intf_ctrl;
-                    t_std_error rc = STD_ERR_OK;
                     memset(&intf_ctrl, 0, sizeof(interface_ctrl_t));
-                    intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF_NAME;
                     safestrncpy(intf_ctrl.if_name, (const char *)cps_api_object_attr_data_bin(attr),
                                 cps_api_object_attr_len(attr));
 
-                    if((rc= dn_hal_get_interface_info(&intf_ctrl)) != STD_ERR_OK) {
+                    if (nas_os_if_resolve((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), intf_ctrl.if_name,
+                                          &intf_ctrl.if_index, NULL) != STD_ERR_OK) {
                         EV_LOGGING(NAS_OS, ERR, "ROUTE-UPD",
-                                   "Interface %s to if_index returned error %d", intf_ctrl.if_name, rc);
+                                   "Interface %s to if_index failed", intf_ctrl.if_name);
                         return cps_api_ret_code_ERR;
                     }
 
@@ -1087,7 +1181,10 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
 
     int err_code;
 
-    rc = nl_do_set_request((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), nas_nl_sock_T_ROUTE,nlh,buff1,sizeof(buff1));
+    if (nas_os_route_idempotent_mode_get()) {
+        nas_os_rt_shadow_invalidate((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), nlh);
+    }
+    rc = nl_do_set_request((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), nas_nl_sock_T_ROUTE,nlh,buf->reply,sizeof(buf->reply));
 
     err_code = STD_ERR_EXT_PRIV (rc);
     EV_LOGGING (NAS_OS, INFO, "ROUE-NH-UPD","Netlink error_code %d", err_code);
@@ -1121,10 +1218,15 @@ t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
     return rc;
 }
 
-t_std_error nas_os_add_route (cps_api_object_t obj)
+t_std_error nas_os_update_route_nexthop (cps_api_object_t obj)
 {
+    nas_os_rt_encode_buf_t buf;
+    return nas_os_update_route_nexthop_r(obj, &buf);
+}
 
-    if (nas_os_update_route(obj, NAS_RT_ADD) != cps_api_ret_code_OK) {
+t_std_error nas_os_add_route_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf)
+{
+    if (nas_os_update_route(obj, NAS_RT_ADD, buf, NULL) != cps_api_ret_code_OK) {
         EV_LOGGING(NAS_OS, ERR, "ROUTE-ADD", "Kernel write failed");
         return (STD_ERR(NAS_OS, FAIL, 0));
     }
@@ -1132,9 +1234,15 @@ t_std_error nas_os_add_route (cps_api_object_t obj)
     return STD_ERR_OK;
 }
 
-t_std_error nas_os_set_route (cps_api_object_t obj)
+t_std_error nas_os_add_route (cps_api_object_t obj)
 {
-    if (nas_os_update_route(obj, NAS_RT_SET) != cps_api_ret_code_OK) {
+    nas_os_rt_encode_buf_t buf;
+    return nas_os_add_route_r(obj, &buf);
+}
+
+t_std_error nas_os_set_route_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf)
+{
+    if (nas_os_update_route(obj, NAS_RT_SET, buf, NULL) != cps_api_ret_code_OK) {
         EV_LOGGING(NAS_OS, ERR, "ROUTE-SET", "Kernel write failed");
         return (STD_ERR(NAS_OS, FAIL, 0));
     }
@@ -1142,10 +1250,15 @@ t_std_error nas_os_set_route (cps_api_object_t obj)
     return STD_ERR_OK;
 }
 
-t_std_error nas_os_del_route (cps_api_object_t obj)
+t_std_error nas_os_set_route (cps_api_object_t obj)
 {
+    nas_os_rt_encode_buf_t buf;
+    return nas_os_set_route_r(obj, &buf);
+}
 
-    if (nas_os_update_route(obj, NAS_RT_DEL) != cps_api_ret_code_OK) {
+t_std_error nas_os_del_route_r (cps_api_object_t obj, nas_os_rt_encode_buf_t *buf)
+{
+    if (nas_os_update_route(obj, NAS_RT_DEL, buf, NULL) != cps_api_ret_code_OK) {
         EV_LOGGING(NAS_OS, ERR, "ROUTE-DEL", "Kernel write failed");
         return (STD_ERR(NAS_OS, FAIL, 0));
     }
@@ -1153,6 +1266,66 @@ t_std_error nas_os_del_route (cps_api_object_t obj)
     return STD_ERR_OK;
 }
 
+t_std_error nas_os_del_route (cps_api_object_t obj)
+{
+    nas_os_rt_encode_buf_t buf;
+    return nas_os_del_route_r(obj, &buf);
+}
+
+void nas_os_route_idempotent_mode_set (bool enable)
+{
+    __atomic_store_n(&nas_os_rt_idempotent, enable, __ATOMIC_RELAXED);
+    /* No longer updated from the kernel events */
+    if (!enable) nas_os_rt_shadow_clear();
+    EV_LOGGING(NAS_OS, NOTICE, "ROUTE-UPD", "Idempotent route programming %s",
+               (enable ? "enabled" : "disabled"));
+}
+
+bool nas_os_route_idempotent_mode_get (void)
+{
+    return __atomic_load_n(&nas_os_rt_idempotent, __ATOMIC_RELAXED);
+}
+
+t_std_error nas_os_route_batch_r (cps_api_object_t *objs, size_t count, nas_os_rt_encode_buf_t *buf,
+                                  nas_os_rt_batch_stats_t *stats)
+{
+    t_std_error rc = STD_ERR_OK;
+    size_t ix;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (ix = 0; ix < count; ++ix) {
+        nas_rt_msg_type m_type;
+        switch (cps_api_object_type_operation(cps_api_object_key(objs[ix]))) {
+            case cps_api_oper_CREATE: m_type = NAS_RT_ADD; break;
+            case cps_api_oper_SET:    m_type = NAS_RT_SET; break;
+            case cps_api_oper_DELETE: m_type = NAS_RT_DEL; break;
+            default:
+                EV_LOGGING(NAS_OS, ERR, "ROUTE-BATCH", "Invalid operation for route %lu", ix);
+                ++stats->failed;
+                rc = STD_ERR(NAS_OS, PARAM, 0);
+                continue;
+        }
+
+        nas_os_rt_prog_t prog = (m_type == NAS_RT_DEL) ? NAS_OS_RT_PROG_DELETED : NAS_OS_RT_PROG_ADDED;
+        if (nas_os_update_route(objs[ix], m_type, buf, &prog) != cps_api_ret_code_OK) {
+            ++stats->failed;
+            rc = STD_ERR(NAS_OS, FAIL, 0);
+            continue;
+        }
+        switch (prog) {
+            case NAS_OS_RT_PROG_ADDED:    ++stats->added; break;
+            case NAS_OS_RT_PROG_REPLACED: ++stats->replaced; break;
+            case NAS_OS_RT_PROG_SKIPPED:  ++stats->skipped; break;
+            case NAS_OS_RT_PROG_DELETED:  ++stats->deleted; break;
+        }
+    }
+
+    EV_LOGGING(NAS_OS, INFO, "ROUTE-BATCH", "Routes:%lu added:%u replaced:%u skipped:%u deleted:%u failed:%u",
+               count, stats->added, stats->replaced, stats->skipped, stats->deleted, stats->failed);
+    return rc;
+}
+
 cps_api_return_code_t nas_os_update_neighbor(cps_api_object_t obj, nas_rt_msg_type m_type)
 {
     char buff[NL_RT_NBR_MSG_BUFFER_LEN];
@@ -1185,31 +1358,17 @@ cps_api_return_code_t nas_os_update_neighbor(cps_api_object_t obj, nas_rt_msg_ty
         ndm->ndm_ifindex = cps_api_object_attr_data_u32(if_index);
     } else if (if_name != CPS_API_ATTR_NULL) {
         interface_ctrl_t intf_ctrl;
-        t_std_error rc = STD_ERR_OK;
 
         memset(&intf_ctrl, 0, sizeof(interface_ctrl_t));
-        intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF_NAME;
         safestrncpy(intf_ctrl.if_name, (const char *)cps_api_object_attr_data_bin(if_name),
                     cps_api_object_attr_len(if_name));
 
-        if((rc= dn_hal_get_interface_info(&intf_ctrl)) != STD_ERR_OK) {
+        if (nas_os_if_resolve((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), intf_ctrl.if_name,
+                              &intf_ctrl.if_index, NULL) != STD_ERR_OK) {
             EV_LOGGING(NAS_OS, ERR, "NEIGH-UPD",
-                       "Interface %s to if_index returned error %d", intf_ctrl.if_name, rc);
+                       "Interface %s to if_index failed", intf_ctrl.if_name);
             return cps_api_ret_code_ERR;
         }
-        if (intf_ctrl.int_type == nas_int_type_MGMT) {
-            int if_index = 0;
-            if (nas_os_util_int_if_index_get((vrf_name ? vrf_name : NAS_DEFAULT_VRF_NAME), intf_ctrl.if_name, &if_index) != STD_ERR_OK) {
-                EV_LOGGING(NAS_OS, ERR, "NEIGH-UPD",
-                           "Interface %s to if_index from OS returned error",
-                           intf_ctrl.if_name);
-                return cps_api_ret_code_ERR;
-            }
-            EV_LOGGING(NAS_OS,INFO,"NEIGH-UPD","out-intf: %s(%d) OS-intf:%d",
-                       intf_ctrl.if_name, intf_ctrl.if_index, if_index);
-            intf_ctrl.if_index = if_index;
-        }
-
 
         EV_LOGGING(NAS_OS, INFO, "NEIGH-UPD",
                    "Interface %s to if_index:%d success", intf_ctrl.if_name, intf_ctrl.if_index);
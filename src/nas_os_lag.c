@@ -34,12 +34,14 @@
 #include "ds_api_linux_interface.h"
 #include "hal_if_mapping.h"
 #include "nas_os_l3_utils.h"
+#include "nas_os_obj_pool.h"
 
 #include "std_utils.h"
 #include <sys/socket.h>
 #include <stdio.h>
 #include <string.h>
 #include <net/if.h>
+#include <linux/rtnetlink.h>
 
 #define NL_MSG_BUFF 4096
 //Link detect in 100 msec by kernel
@@ -274,7 +276,7 @@ t_std_error nas_os_add_port_to_lag(cps_api_object_t obj)
     EV_LOGGING(NAS_OS, INFO,"NAS-OS-LAG",
             "Add Port to Lag master_index %d and ifindex %d",lag_index,if_index);
 
-    cps_api_object_t if_obj = cps_api_object_create();
+    cps_api_object_t if_obj = nas_os_obj_pool_alloc(RTM_NEWLINK);
     if(if_obj == NULL) {
         EV_LOGGING(NAS_OS, ERR,"NAS-OS-LAG","Failure creating object");
         return (STD_ERR(NAS_OS,FAIL, 0));
@@ -327,7 +329,7 @@ t_std_error nas_os_add_port_to_lag(cps_api_object_t obj)
         }
     } while (0);
 
-    cps_api_object_delete(if_obj);
+    nas_os_obj_pool_release(if_obj);
 
     return rc;
 }
@@ -348,7 +350,7 @@ t_std_error nas_os_delete_port_from_lag(cps_api_object_t obj)
     EV_LOGGING(NAS_OS, INFO,"NAS-OS-LAG",
             "Delete Port to Lag master_index %d and ifindex %d",lag_index,if_index);
 
-    cps_api_object_t if_obj = cps_api_object_create();
+    cps_api_object_t if_obj = nas_os_obj_pool_alloc(RTM_NEWLINK);
     if(if_obj == NULL) {
         EV_LOGGING(NAS_OS, ERR,"NAS-OS-LAG","Failure creating object");
         return (STD_ERR(NAS_OS,FAIL, 0));
@@ -401,7 +403,7 @@ t_std_error nas_os_delete_port_from_lag(cps_api_object_t obj)
         }
     }while(0);
 
-    cps_api_object_delete(if_obj);
+    nas_os_obj_pool_release(if_obj);
 
     return rc;
 }
@@ -27,31 +27,64 @@
 #include "nas_os_if_conversion_utils.h"
 #include "std_thread_tools.h"
 #include "std_socket_tools.h"
+#include "std_time_tools.h"
+#include "nas_os_br_attr.h"
+#include "nas_linux_l2.h"
 
 #include <string>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <poll.h>
 
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
 #include <mutex>
-#include <sstream>
 #include <vector>
 #include <chrono>
+#include <functional>
 
 
 #define NL_MSG_BUFF_LEN 4096
 #define MAC_STRING_LEN 20
+/*
+ * Learning updates are sent in batches of back to back SETLINK messages, acked one by one.
+ * A batch holds at most 128 messages so that all its ACKs fit in the socket receive buffer.
+ */
+#define NL_LEARN_BATCH_MSGS 128
+#define NL_LEARN_MSG_LEN 64
+#define NL_FDB_MSG_LEN 64
+#define NL_LEARN_BATCH_LEN (NL_LEARN_BATCH_MSGS*NL_LEARN_MSG_LEN)
+#define NL_LEARN_ACK_TIMEOUT_SEC 2
+/* Pending dynamic MACs are aged out every sweep period, default is the bridge default ageing */
+#define NAS_OS_PENDING_MAC_SWEEP_MS (60*1000)
+#define NAS_OS_PENDING_MAC_DEF_AGEING_US (1800ULL*1000000)
 
 static std_rw_lock_t static_mac_lock = PTHREAD_RWLOCK_INITIALIZER;
 static std_rw_lock_t dynamic_mac_lock = PTHREAD_RWLOCK_INITIALIZER;
 static std::mutex _mac_ls_mutex;
+/* Serializes the kernel programming of learning updates, state is guarded by _mac_ls_mutex */
+static std::mutex _mac_ls_prog_mutex;
 static auto _if_mac_learn_state = new std::unordered_map<hal_ifindex_t, bool> ;
 static auto _static_mac_list = *new std::unordered_map<std::string, uint32_t>;
-static auto _dynamic_mac_list = *new std::unordered_map<std::string, uint32_t>;
-static auto _port_to_dynamic_mac_list = *new std::unordered_map<uint32_t,std::unordered_set<std::string>>;
+
+/* Dynamic MAC the kernel rejected because its port was not learning/forwarding */
+typedef struct {
+    hal_mac_addr_t mac;
+    hal_vlan_id_t vid;
+    uint64_t expire_us;     /* uptime the entry ages out at, 0 - never */
+} nas_os_pending_mac_t;
+
+typedef struct {
+    std::unordered_map<uint64_t, nas_os_pending_mac_t> macs;   /* keyed by _pending_mac_key */
+    uint64_t trigger_us;    /* uptime of the first forwarding event not replayed yet */
+} nas_os_pending_port_t;
+
+/* Guarded by dynamic_mac_lock */
+static auto & _pending_mac_ports = *new std::unordered_map<hal_ifindex_t, nas_os_pending_port_t>;
+static auto & _pending_mac_port_of = *new std::unordered_map<uint64_t, hal_ifindex_t>;
+static nas_os_mac_pending_stats_t _pending_mac_stats;
 static std_thread_create_param_t nas_os_mac_thread;
 static int nas_os_mac_fd[2];
 
@@ -72,29 +105,128 @@ static void nas_os_mac_write_pending_mac_if(hal_ifindex_t *ifindex) {
     }
 }
 
-static bool nas_os_update_mac_learning(hal_ifindex_t ifindex, bool enable){
-    char buff[NL_MSG_BUFF_LEN];
-    memset(buff,0,sizeof(nlmsghdr));
-    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff,sizeof(buff),sizeof(struct nlmsghdr));
-    struct ifinfomsg *ifmsg = (struct ifinfomsg *) nlmsg_reserve(nlh,sizeof(buff),sizeof(struct ifinfomsg));
+/*
+ * Build the learning SETLINK of a bridge port in buff,
+ * returns NULL if the buffer is too small
+ */
+static struct nlmsghdr * _nl_learning_msg_build(void *buff, size_t len, hal_ifindex_t ifindex, bool enable,
+                                                uint32_t seq){
+    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff,len,sizeof(struct nlmsghdr));
+    if(nlh == NULL) return NULL;
+    struct ifinfomsg *ifmsg = (struct ifinfomsg *) nlmsg_reserve(nlh,len,sizeof(struct ifinfomsg));
+    if(ifmsg == NULL) return NULL;
 
     nlh->nlmsg_pid = 0 ;
-    nlh->nlmsg_seq = 0 ;
-    nlh->nlmsg_flags = NLM_F_REQUEST;
+    nlh->nlmsg_seq = seq ;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
     nlh->nlmsg_type = RTM_SETLINK ;
     ifmsg->ifi_family = PF_BRIDGE;
     ifmsg->ifi_index = ifindex;
 
-    struct nlattr *mac_attr = nlmsg_nested_start(nlh, sizeof(buff));
+    struct nlattr *mac_attr = nlmsg_nested_start(nlh, len);
+    if(mac_attr == NULL) return NULL;
     mac_attr->nla_len = 0;
     mac_attr->nla_type = IFLA_PROTINFO | NLA_F_NESTED;
     uint8_t learning = (uint8_t)enable;
-    nlmsg_add_attr(nlh,sizeof(buff),IFLA_BRPORT_LEARNING,(void *)&learning,sizeof(uint8_t));
+    if(nlmsg_add_attr(nlh,len,IFLA_BRPORT_LEARNING,(void *)&learning,sizeof(uint8_t)) == -1) return NULL;
     nlmsg_nested_end(nlh, mac_attr);
+    return nlh;
+}
+
+typedef std::function<struct nlmsghdr *(void *buff, size_t len, size_t ix, uint32_t seq)> nl_msg_build_fn;
+
+/*
+ * Send count messages of up to msg_len bytes built by build back to back on one socket
+ * and wait for their ACKs, err is the errno of each message
+ */
+static void _nl_bulk_request(nas_nl_sock_TYPES type, size_t count, size_t msg_len, const nl_msg_build_fn &build,
+                             std::vector<int> &err){
+    err.assign(count, 0);
+    if(count == 0) return;
+
+    int sock = nas_nl_sock_create(NL_DEFAULT_VRF_NAME, type, false);
+    if(sock == -1){
+        EV_LOGGING(NAS_OS,ERR,"NAS-L2-MAC","Failed to create socket for bulk update err-no:%d",errno);
+        err.assign(count, errno);
+        return;
+    }
+    /* A lost ACK fails the rest of the batch instead of blocking the caller */
+    struct timeval tv = { NL_LEARN_ACK_TIMEOUT_SEC, 0 };
+    if(setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0){
+        EV_LOGGING(NAS_OS,ERR,"NAS-L2-MAC","Failed to set ACK timeout err-no:%d",errno);
+    }
+
+    std::vector<char> batch(NL_LEARN_BATCH_LEN);
+    uint32_t seq_base = (uint32_t)std_get_uptime(NULL);
+    size_t first = 0;
+    while(first < count){
+        size_t off = 0, last = first, pending = 0;
+        for(; last < count && pending < NL_LEARN_BATCH_MSGS && off + msg_len <= batch.size(); ++last){
+            memset(&batch[off], 0, msg_len);
+            struct nlmsghdr *nlh = build(&batch[off], msg_len, last, seq_base + last);
+            if(nlh == NULL){
+                err[last] = ENOBUFS;
+                continue;
+            }
+            off += NLMSG_ALIGN(nlh->nlmsg_len);
+            err[last] = -1;
+            ++pending;
+        }
+        if(pending > 0){
+            if(nl_send_nlmsg_batch(sock, &batch[0], off)){
+                nl_read_batch_acks(sock, seq_base, first, last, pending, &err[0]);
+            }else{
+                int rc = errno;
+                for(size_t ix = first; ix < last; ++ix){
+                    if(err[ix] == -1) err[ix] = rc;
+                }
+            }
+        }
+        first = last;
+    }
+    close(sock);
+}
 
-    if(nl_do_set_request(NL_DEFAULT_VRF_NAME, nas_nl_sock_T_INT,nlh, buff, sizeof(buff)) != STD_ERR_OK){
+/* Program the learning state of all the bridge ports, err is the errno of each port */
+static void nas_os_update_mac_learning_bulk(const std::vector<hal_ifindex_t> &ports, bool enable,
+                                            std::vector<int> &err){
+    std::lock_guard<std::mutex> lock(_mac_ls_prog_mutex);
+    _nl_bulk_request(nas_nl_sock_T_INT, ports.size(), NL_LEARN_MSG_LEN,
+                     [&](void *buff, size_t len, size_t ix, uint32_t seq) {
+                         return _nl_learning_msg_build(buff, len, ports[ix], enable, seq);
+                     }, err);
+}
+
+/*
+ * Build the dynamic FDB entry add of a bridge port in buff,
+ * returns NULL if the buffer is too small
+ */
+static struct nlmsghdr * _nl_fdb_msg_build(void *buff, size_t len, hal_ifindex_t ifindex,
+                                           const hal_mac_addr_t mac, uint32_t seq){
+    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff,len,sizeof(struct nlmsghdr));
+    if(nlh == NULL) return NULL;
+    struct ndmsg *req = (struct ndmsg *) nlmsg_reserve(nlh,len,sizeof(struct ndmsg));
+    if(req == NULL) return NULL;
+
+    nlh->nlmsg_seq = seq;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_APPEND;
+    nlh->nlmsg_type = RTM_NEWNEIGH;
+
+    req->ndm_family = PF_BRIDGE;
+    req->ndm_state = NUD_REACHABLE;
+    req->ndm_flags = NTF_MASTER;
+    req->ndm_ifindex = ifindex;
+
+    if(nlmsg_add_attr(nlh,len,NDA_LLADDR,mac,sizeof(hal_mac_addr_t)) == -1) return NULL;
+    return nlh;
+}
+
+static bool nas_os_update_mac_learning(hal_ifindex_t ifindex, bool enable){
+    std::vector<int> err;
+    nas_os_update_mac_learning_bulk(std::vector<hal_ifindex_t>(1, ifindex), enable, err);
+    if(err[0] != 0){
         EV_LOG(ERR,NAS_OS,0,"NAS-L2-MAC","Failed to set mac learn mode to %d for interface %d "
-                "in Kernel",enable,ifindex);
+                "in Kernel err-no:%d",enable,ifindex,err[0]);
         return false;
     }
 
@@ -102,13 +234,69 @@ static bool nas_os_update_mac_learning(hal_ifindex_t ifindex, bool enable){
     return true;
 }
 
-static void nas_mac_split_string(std::string input_str, char delim, std::vector<std::string> & tokenized_strings){
-    std::istringstream ss(input_str);
-    std::string tokenized_string;
-    while(std::getline(ss,tokenized_string,delim)){
-        tokenized_strings.push_back(tokenized_string);
+static uint64_t _pending_mac_key(hal_vlan_id_t vid, const hal_mac_addr_t mac){
+    uint64_t key = vid;
+    for(size_t ix = 0; ix < sizeof(hal_mac_addr_t); ++ix){
+        key = (key << 8) | mac[ix];
+    }
+    return key;
+}
+
+/* Ageing time of the VLAN bridge, entries older than it would have aged out of the FDB anyway */
+static uint64_t _pending_mac_ageing_us(const char *vlan_name){
+    long ageing = 0;
+    hal_ifindex_t br_index = cps_api_interface_name_to_if_index(vlan_name);
+    if(br_index == 0 || !nas_os_br_attr_get(br_index,vlan_name,NAS_OS_BR_ATTR_AGEING_TIME,&ageing)){
+        return NAS_OS_PENDING_MAC_DEF_AGEING_US;
+    }
+    /* Bridge ageing time is in 1/100 seconds */
+    return (uint64_t)ageing * 10000;
+}
+
+/* Callers hold dynamic_mac_lock for write */
+static void _pending_mac_del(uint64_t key){
+    auto it = _pending_mac_port_of.find(key);
+    if(it == _pending_mac_port_of.end()) return;
+    auto port_it = _pending_mac_ports.find(it->second);
+    if(port_it != _pending_mac_ports.end()){
+        port_it->second.macs.erase(key);
+        if(port_it->second.macs.empty()) _pending_mac_ports.erase(port_it);
+    }
+    _pending_mac_port_of.erase(it);
+    --_pending_mac_stats.depth;
+}
+
+static void _pending_mac_add(hal_ifindex_t ifindex, hal_vlan_id_t vid, const hal_mac_addr_t mac,
+                             uint64_t ageing_us){
+    uint64_t key = _pending_mac_key(vid, mac);
+    _pending_mac_del(key);
+
+    nas_os_pending_mac_t &ent = _pending_mac_ports[ifindex].macs[key];
+    memcpy(ent.mac, mac, sizeof(hal_mac_addr_t));
+    ent.vid = vid;
+    ent.expire_us = (ageing_us == 0) ? 0 : std_get_uptime(NULL) + ageing_us;
+    _pending_mac_port_of[key] = ifindex;
+    ++_pending_mac_stats.depth;
+    ++_pending_mac_stats.parked;
+}
+
+/* Drop the entries of the port that aged out, returns the number dropped */
+static size_t _pending_mac_expire(hal_ifindex_t ifindex, nas_os_pending_port_t &port, uint64_t now){
+    size_t expired = 0;
+    for(auto it = port.macs.begin(); it != port.macs.end(); ){
+        if(it->second.expire_us != 0 && it->second.expire_us <= now){
+            EV_LOGGING(NAS_OS,DEBUG,"DMAC-STG-PROGRAM","Pending MAC of VLAN %d aged out on ifindex %d",
+                       it->second.vid,ifindex);
+            _pending_mac_port_of.erase(it->first);
+            it = port.macs.erase(it);
+            ++expired;
+        }else{
+            ++it;
+        }
     }
-    return;
+    _pending_mac_stats.depth -= expired;
+    _pending_mac_stats.expired += expired;
+    return expired;
 }
 
 bool nas_os_update_tagged_intf_mac_learning(hal_ifindex_t ifindex, hal_ifindex_t vlan_index){
@@ -196,53 +384,131 @@ t_std_error nas_os_handle_mac_port_chg(const char *vlan_name, const char *mac_st
  * it from cache when it successfully programs the pending mac.
  */
 
+static void nas_os_mac_replay_pending(hal_ifindex_t ifindex){
+    std_rw_lock_write_guard l(&dynamic_mac_lock);
+
+    auto it = _pending_mac_ports.find(ifindex);
+    if(it == _pending_mac_ports.end()) return;
+    nas_os_pending_port_t &port = it->second;
+
+    uint64_t now = std_get_uptime(NULL);
+    uint64_t trigger_us = (port.trigger_us != 0) ? port.trigger_us : now;
+    port.trigger_us = 0;
+    _pending_mac_expire(ifindex, port, now);
+
+    std::vector<uint64_t> keys;
+    keys.reserve(port.macs.size());
+    for(auto &mac_it : port.macs){
+        keys.push_back(mac_it.first);
+    }
+
+    EV_LOGGING(NAS_OS,DEBUG,"DMAC-STG-PROGRAM","Pending MAC count %lu for ifindex %d",keys.size(),ifindex);
+    std::vector<int> err;
+    _nl_bulk_request(nas_nl_sock_T_NEI, keys.size(), NL_FDB_MSG_LEN,
+                     [&](void *buff, size_t len, size_t ix, uint32_t seq) {
+                         return _nl_fdb_msg_build(buff, len, ifindex, port.macs[keys[ix]].mac, seq);
+                     }, err);
+
+    size_t replayed = 0;
+    for(size_t ix = 0; ix < keys.size(); ++ix){
+        if(err[ix] != 0) continue;
+        port.macs.erase(keys[ix]);
+        _pending_mac_port_of.erase(keys[ix]);
+        ++replayed;
+    }
+    if(port.macs.empty()){
+        _pending_mac_ports.erase(it);
+    }
+
+    uint64_t latency_us = std_get_uptime(NULL) - trigger_us;
+    _pending_mac_stats.depth -= replayed;
+    _pending_mac_stats.replayed += replayed;
+    _pending_mac_stats.replay_failed += keys.size() - replayed;
+    ++_pending_mac_stats.replays;
+    _pending_mac_stats.last_replay_us = latency_us;
+    _pending_mac_stats.total_replay_us += latency_us;
+    if(latency_us > _pending_mac_stats.max_replay_us) _pending_mac_stats.max_replay_us = latency_us;
+
+    EV_LOGGING(NAS_OS,INFO,"DMAC-STG-PROGRAM","Replayed %lu of %lu pending MACs for ifindex %d in %luus",
+               replayed,keys.size(),ifindex,latency_us);
+}
+
+static void nas_os_mac_sweep_pending(void){
+    std_rw_lock_write_guard l(&dynamic_mac_lock);
+    uint64_t now = std_get_uptime(NULL);
+    for(auto it = _pending_mac_ports.begin(); it != _pending_mac_ports.end(); ){
+        _pending_mac_expire(it->first, it->second, now);
+        if(it->second.macs.empty()){
+            it = _pending_mac_ports.erase(it);
+        }else{
+            ++it;
+        }
+    }
+}
+
 static void nas_os_mac_main(void){
      hal_ifindex_t ifindex;
+     struct pollfd pfd = { nas_os_mac_fd[0], POLLIN, 0 };
+     /* Sweep runs on a deadline so that a steady stream of forwarding events cannot starve it */
+     uint64_t sweep_us = std_get_uptime(NULL) + NAS_OS_PENDING_MAC_SWEEP_MS*1000ULL;
 
      while (true) {
-         if (!nas_os_mac_read_pending_mac_if(&ifindex)) {
-             continue;
+         uint64_t now = std_get_uptime(NULL);
+         if (now >= sweep_us) {
+             nas_os_mac_sweep_pending();
+             sweep_us = now + NAS_OS_PENDING_MAC_SWEEP_MS*1000ULL;
          }
-         std_rw_lock_write_guard l(&dynamic_mac_lock);
-
-         auto it = _port_to_dynamic_mac_list.find(ifindex);
-         if(it != _port_to_dynamic_mac_list.end()){
-
-             EV_LOGGING(NAS_OS,DEBUG,"DMAC-STG-PROGRAM","Pending MAC count %d for ifindex %d",it->second.size(),ifindex);
-             for(auto mac_it = it->second.begin(); mac_it != it->second.end() ; ){
-                 std::string key = *mac_it;
-                 std::vector<std::string> t_strings;
-                 nas_mac_split_string(key,'.',t_strings);
-                 if(t_strings.size() != 2) continue;
-                 hal_mac_addr_t mac_addr;
-                 const char * vlan = t_strings[0].c_str();
-                 const char * mac = t_strings[1].c_str();
-                 std_string_to_mac(&mac_addr,mac,t_strings[1].length());
-
-                 if(nas_os_handle_mac_port_chg(vlan,mac,&mac_addr,ifindex,false) == STD_ERR_OK){
-                     mac_it = it->second.erase(mac_it);
-                     _dynamic_mac_list.erase(key);
-                 }else{
-                     ++mac_it;
-                 }
-             }
-
-             if(_port_to_dynamic_mac_list[ifindex].size() == 0){
-                 _port_to_dynamic_mac_list.erase(ifindex);
-             }
+         int rc = poll(&pfd, 1, (int)((sweep_us - now + 999) / 1000));
+         if (rc <= 0 || !nas_os_mac_read_pending_mac_if(&ifindex)) {
+             continue;
          }
+         nas_os_mac_replay_pending(ifindex);
      }
 }
 
 t_std_error nas_os_mac_add_pending_mac_if_event(hal_ifindex_t ifindex){
-    std_rw_lock_read_guard l(&dynamic_mac_lock);
-    auto it = _port_to_dynamic_mac_list.find(ifindex);
-    if(it != _port_to_dynamic_mac_list.end()){
-        nas_os_mac_write_pending_mac_if(&ifindex);
+    std_rw_lock_write_guard l(&dynamic_mac_lock);
+    auto it = _pending_mac_ports.find(ifindex);
+    if(it != _pending_mac_ports.end()){
+        /* One replay per port is enough until the thread picks it up */
+        if(it->second.trigger_us == 0){
+            it->second.trigger_us = std_get_uptime(NULL);
+            nas_os_mac_write_pending_mac_if(&ifindex);
+        }
     }
     return STD_ERR_OK;
 }
 
+void nas_os_mac_pending_stats_get(nas_os_mac_pending_stats_t *stats){
+    std_rw_lock_read_guard l(&dynamic_mac_lock);
+    *stats = _pending_mac_stats;
+}
+
+void os_debug_pending_mac_print (){
+    nas_os_mac_pending_stats_t stats;
+    std::vector<std::pair<hal_ifindex_t,size_t>> ports;
+    {
+        std_rw_lock_read_guard l(&dynamic_mac_lock);
+        stats = _pending_mac_stats;
+        for(auto &it : _pending_mac_ports){
+            ports.push_back({it.first,it.second.macs.size()});
+        }
+    }
+
+    printf("\r\n Pending dynamic MACs:%lu parked:%lu replayed:%lu replay-failed:%lu expired:%lu\r\n",
+           (unsigned long)stats.depth, (unsigned long)stats.parked, (unsigned long)stats.replayed,
+           (unsigned long)stats.replay_failed, (unsigned long)stats.expired);
+    printf("\r Replays:%lu latency last:%luus max:%luus avg:%luus\r\n",
+           (unsigned long)stats.replays, (unsigned long)stats.last_replay_us,
+           (unsigned long)stats.max_replay_us,
+           (unsigned long)(stats.replays ? stats.total_replay_us / stats.replays : 0));
+    printf("\r %-10s %-10s\r\n", "Ifindex", "Pending");
+    printf("\r=====================\r\n");
+    for(auto &it : ports){
+        printf("\r %-10d %-10lu\r\n", it.first, (unsigned long)it.second);
+    }
+}
+
 
 t_std_error nas_os_mac_update_entry(cps_api_object_t obj){
 
@@ -300,11 +566,9 @@ t_std_error nas_os_mac_update_entry(cps_api_object_t obj){
     hal_vlan_id_t vid = cps_api_object_attr_data_u16(vlan_attr);
     hal_ifindex_t ifindex = cps_api_object_attr_data_u32(ifindex_attr);
 
-    if(ifname_attr){
-        char * intf_name = (char *)cps_api_object_attr_data_bin(ifname_attr);
-        char vlan_intf_name[HAL_IF_NAME_SZ+1];
-        nas_os_get_vlan_if_name(intf_name,cps_api_object_attr_len(ifname_attr),vid,vlan_intf_name);
-        get_tagged_intf_index_from_name(vlan_intf_name,ifindex);
+    hal_ifindex_t vlan_ifindex;
+    if(nas_os_tagged_intf_get(ifindex,vid,&vlan_ifindex)){
+        ifindex = vlan_ifindex;
     }
 
     req->ndm_ifindex = ifindex;
@@ -353,19 +617,15 @@ t_std_error nas_os_mac_update_entry(cps_api_object_t obj){
              * In this case cache the failed dynamic mac and when the interface becomes forwarding in kernel
              * and we get a netlink notification re-program the mac in the kernel.
              */
+             uint64_t ageing_us = (op != cps_api_oper_DELETE) ? _pending_mac_ageing_us(vlan_name) : 0;
              std_rw_lock_write_guard l(&dynamic_mac_lock);
 
              if(op == cps_api_oper_DELETE || op == cps_api_oper_SET) {
-                 auto itr = _dynamic_mac_list.find(key);
-                 if (itr != _dynamic_mac_list.end()) {
-                     _port_to_dynamic_mac_list[itr->second].erase(key);
-                     _dynamic_mac_list.erase(itr);
-                 }
+                 _pending_mac_del(_pending_mac_key(vid, *mac_addr));
              }
 
              if(op != cps_api_oper_DELETE){
-                 _dynamic_mac_list[key] = ifindex;
-                 _port_to_dynamic_mac_list[ifindex].insert(key);
+                 _pending_mac_add(ifindex, vid, *mac_addr, ageing_us);
              }
         }
         return STD_ERR_OK;
@@ -381,34 +641,67 @@ t_std_error nas_os_mac_update_entry(cps_api_object_t obj){
 
 extern "C"{
 
-t_std_error nas_os_mac_change_learning(hal_ifindex_t ifindex,bool enable){
+t_std_error nas_os_mac_set_learning(hal_ifindex_t ifindex, bool enable, nas_os_mac_learn_scope_t scope,
+                                    nas_os_mac_learn_result_t *results, size_t *count){
 
-    nas_os_update_mac_learning(ifindex,enable);
+    uint64_t start_us = std_get_uptime(NULL);
+    std::vector<hal_ifindex_t> ports;
+    if(scope != NAS_OS_MAC_LEARN_SCOPE_TAGGED){
+        ports.push_back(ifindex);
+    }
+    if(scope != NAS_OS_MAC_LEARN_SCOPE_PORT){
+        std::unordered_set<hal_ifindex_t> _intf_list;
+        if (get_tagged_intf_list(ifindex, _intf_list)){
+            ports.insert(ports.end(), _intf_list.begin(), _intf_list.end());
+        }
+    }
 
-    std::lock_guard<std::mutex> lock(_mac_ls_mutex);
-    auto it = _if_mac_learn_state->find(ifindex);
-    if(it == _if_mac_learn_state->end()){
-        if(!enable){
-        _if_mac_learn_state->insert({ifindex,enable});
+    /*
+     * State is updated before the kernel is programmed so that sub-interfaces created in the
+     * meantime pick it up from nas_os_update_tagged_intf_mac_learning. The tagged scope leaves
+     * the port itself alone, so its state is not touched either.
+     */
+    if(scope != NAS_OS_MAC_LEARN_SCOPE_TAGGED){
+        std::lock_guard<std::mutex> lock(_mac_ls_mutex);
+        if(enable){
+            _if_mac_learn_state->erase(ifindex);
         }else{
-            return STD_ERR_OK;
+            (*_if_mac_learn_state)[ifindex] = enable;
         }
-    }else{
-        it->second = enable;
     }
 
+    std::vector<int> err;
+    nas_os_update_mac_learning_bulk(ports, enable, err);
 
-    std::unordered_set<hal_ifindex_t> _intf_list;
-    if (get_tagged_intf_list(ifindex, _intf_list)){
-        for (auto it : _intf_list){
-            nas_os_update_mac_learning(it,enable);
+    size_t max_results = (count != NULL) ? *count : 0;
+    size_t failed = 0;
+    for(size_t ix = 0; ix < ports.size(); ++ix){
+        if(err[ix] != 0){
+            ++failed;
+            EV_LOGGING(NAS_OS,ERR,"NAS-L2-MAC","Failed to set mac learn mode to %d for interface %d "
+                       "in Kernel err-no:%d",enable,ports[ix],err[ix]);
+        }
+        if(results != NULL && ix < max_results){
+            results[ix].ifindex = ports[ix];
+            results[ix].rc = (err[ix] == 0) ? STD_ERR_OK : STD_ERR(L2MAC,FAIL,err[ix]);
         }
     }
+    if(count != NULL) *count = ports.size();
 
-    if(enable){
-        _if_mac_learn_state->erase(ifindex);
-    }
+    EV_LOGGING(NAS_OS,INFO,"NAS-L2-MAC","Set the MAC learning for interface index %d to %d scope %d "
+               "bridge ports:%lu failed:%lu in %luus",ifindex,enable,scope,ports.size(),failed,
+               std_get_uptime(NULL) - start_us);
+    return (failed == 0) ? STD_ERR_OK : STD_ERR(L2MAC,FAIL,0);
+}
 
+t_std_error nas_os_mac_change_learning(hal_ifindex_t ifindex,bool enable){
+
+    /* Tagged sub-interfaces only need an update when learning was disabled on the port */
+    nas_os_mac_learn_scope_t scope = NAS_OS_MAC_LEARN_SCOPE_ALL;
+    if(enable && nas_os_mac_get_learning(ifindex)){
+        scope = NAS_OS_MAC_LEARN_SCOPE_PORT;
+    }
+    nas_os_mac_set_learning(ifindex, enable, scope, NULL, NULL);
     return STD_ERR_OK;
 
 }
@@ -28,6 +28,9 @@
 #include "ietf-igmp-mld-snooping.h"
 #include "netlink_stats.h"
 #include "net_publish.h"
+#include "nas_os_br_attr.h"
+#include "nas_os_obj_pool.h"
+#include "std_thread_tools.h"
 
 #include <unordered_map>
 #include <arpa/inet.h>
@@ -35,12 +38,17 @@
 #include <linux/netlink.h>
 #include <linux/if_bridge.h>
 #include <sys/socket.h>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <string>
-
-static const int MAX_NETLINK_BUF = 10000;
+#include <thread>
+#include <tuple>
+#include <vector>
 
 static const auto _ipv4_cps_keymap = new std::unordered_map<std::string, cps_api_attr_id_t> {
         {"vlan", IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_IGMP_SNOOPING_VLANS_VLAN},
@@ -64,59 +72,6 @@ static const auto _cps_keymap = new std::unordered_map<std::string, std::unorder
     };
 
 
-static bool _populate_mdb_entry_object(struct br_mdb_entry *br_entry, int msg_type, hal_vlan_id_t vlan_id, char *if_name, cps_api_object_t obj) {
-
-    std::string _addr_proto;
-    char *grp_addr = nullptr;
-    size_t grp_addr_len = 0;
-    if (ntohs(br_entry->addr.proto) == ETH_P_IP) {
-        struct in_addr ip_addr;
-        ip_addr.s_addr = br_entry->addr.u.ip4;
-
-        grp_addr = inet_ntoa(ip_addr);
-        grp_addr_len = strlen(grp_addr);
-        _addr_proto = "ipv4";
-    }
-    else if (ntohs(br_entry->addr.proto) == ETH_P_IPV6) {
-        char ip6_grp_addr[INET6_ADDRSTRLEN];
-        inet_ntop(AF_INET6, &(br_entry->addr.u.ip6), ip6_grp_addr, INET6_ADDRSTRLEN);
-
-        grp_addr = ip6_grp_addr;
-        grp_addr_len = INET6_ADDRSTRLEN;
-        _addr_proto = "ipv6";
-
-    }
-    else return false;
-
-    cps_api_key_from_attr_with_qual(cps_api_object_key(obj), (*_cps_keymap)[_addr_proto]["vlan"], cps_api_qualifier_OBSERVED);
-
-    cps_api_operation_types_t op;
-    std::string msg = "mdb";
-    if (msg_type == RTM_NEWMDB ) { op = cps_api_oper_CREATE; msg = "new_mdb"; }
-    else if  (msg_type == RTM_DELMDB ) { op = cps_api_oper_DELETE; msg = "del_mdb"; }
-    else return false;
-
-    cps_api_object_set_type_operation(cps_api_object_key(obj), op);
-
-    cps_api_object_attr_add_u16(obj, (*_cps_keymap)[_addr_proto]["vlan_id"], vlan_id);
-
-    cps_api_attr_id_t ids[3] = {(*_cps_keymap)[_addr_proto]["grp_list"], 0, (*_cps_keymap)[_addr_proto]["interface"]};
-    const int ids_len = sizeof(ids)/sizeof(ids[0]);
-
-    cps_api_object_e_add(obj, ids,ids_len, cps_api_object_ATTR_T_BIN, if_name,HAL_IF_NAME_SZ);
-
-
-    ids[2] = (*_cps_keymap)[_addr_proto]["grp_addr"];
-
-    cps_api_object_e_add(obj, ids, ids_len, cps_api_object_ATTR_T_BIN, grp_addr, grp_addr_len+1);
-    EV_LOGGING(NETLINK_MCAST_SNOOP,DEBUG,"NAS-LINUX-MCAST-SNOOP", "Group address %s ", grp_addr);
-
-    // INFO log with all information
-    EV_LOGGING(NETLINK_MCAST_SNOOP,INFO,"NAS-LINUX-MCAST-SNOOP", "Message Type %s Protocol %s Vlan ID %d Member port %s Group address %s", msg.c_str(), _addr_proto.c_str(), vlan_id, if_name, grp_addr);
-
-    return true;
-}
-
 static bool _populate_mdb_router_object(int msg_type, hal_vlan_id_t vlan_id, char *if_name, cps_api_object_t obj,
                                         bool is_mld) {
 
@@ -153,26 +108,316 @@ static bool _populate_mdb_router_object(int msg_type, hal_vlan_id_t vlan_id, cha
     return true;
 }
 
-static bool _get_ifname(uint32_t ifindex, char *if_name, unsigned int len) {
-    char *saveptr;
-    char name[HAL_IF_NAME_SZ];
+/*
+ * MDB entries and mrouter ports learnt from the kernel keyed by (bridge, port, group),
+ * mrouter ports use proto 0. Netlink updates only mark the entries dirty, the flush
+ * thread publishes the entries whose state differs from the published one after the
+ * coalescing window - a join and leave within the window is never published.
+ */
+typedef struct {
+    hal_ifindex_t br_index;
+    hal_ifindex_t port_index;
+    uint16_t proto;             /* ETH_P_IP, ETH_P_IPV6 or 0 for a mrouter port */
+    uint8_t grp[16];
+} nas_os_mdb_key_t;
+
+typedef struct {
+    bool present;               /* Last state from the kernel */
+    bool published;             /* Last state published */
+    bool dirty;                 /* In the dirty list */
+} nas_os_mdb_entry_t;
+
+struct nas_os_mdb_key_hash {
+    size_t operator()(const nas_os_mdb_key_t &key) const {
+        const uint8_t *p = (const uint8_t *)&key;
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t ix = 0; ix < sizeof(key); ++ix) {
+            h ^= p[ix];
+            h *= 0x100000001b3ULL;
+        }
+        return (size_t)h;
+    }
+};
+
+struct nas_os_mdb_key_eq {
+    bool operator()(const nas_os_mdb_key_t &lhs, const nas_os_mdb_key_t &rhs) const {
+        return memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+    }
+};
 
-    if(cps_api_interface_if_index_to_name( ifindex,name, HAL_IF_NAME_SZ)==NULL){
-        EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Member port Interface not found");
+/* Changes of one VLAN and operation published together */
+typedef struct {
+    hal_vlan_id_t vlan_id;
+    uint16_t proto;
+    cps_api_operation_types_t op;
+    std::vector<std::pair<std::string, nas_os_mdb_key_t>> members;
+} nas_os_mdb_batch_t;
+
+typedef struct {
+    uint64_t nl_updates;        /* Entries received from netlink */
+    uint64_t coalesced;         /* Changes reverted within the window */
+    uint64_t published;         /* Entries published */
+    uint64_t objects;           /* CPS objects published */
+    uint64_t flushes;
+} nas_os_mdb_stats_t;
+
+static std::mutex _mdb_mutex;
+static std::condition_variable _mdb_cv;
+static auto & _mdb_table = *(new std::unordered_map<nas_os_mdb_key_t, nas_os_mdb_entry_t,
+                                                    nas_os_mdb_key_hash, nas_os_mdb_key_eq>);
+static auto & _mdb_dirty = *(new std::vector<nas_os_mdb_key_t>);
+static auto & _mdb_vlan_cache = *(new std::unordered_map<hal_ifindex_t, hal_vlan_id_t>);
+static auto & _mdb_port_cache = *(new std::unordered_map<hal_ifindex_t, std::string>);
+static auto & _mdb_gone = *(new std::vector<hal_ifindex_t>);  /* Cached until their deletes are out */
+static nas_os_mdb_stats_t _mdb_stats;
+static int _mdb_nl_sock = -1;
+static std_thread_create_param_t _mdb_thr;
+
+/* Group list entries carried in a single published object */
+#define NAS_OS_MDB_BATCH_GROUPS 16
+
+static void _mdb_update(hal_ifindex_t br_index, hal_ifindex_t port_index, uint16_t proto,
+                        const void *grp, size_t grp_len, bool present) {
+    nas_os_mdb_key_t key;
+    memset(&key, 0, sizeof(key));
+    key.br_index = br_index;
+    key.port_index = port_index;
+    key.proto = proto;
+    if (grp != nullptr) memcpy(key.grp, grp, std::min(grp_len, sizeof(key.grp)));
+
+    ++_mdb_stats.nl_updates;
+    auto it = _mdb_table.find(key);
+    if (it == _mdb_table.end()) {
+        /* Delete of an entry that is not known */
+        if (!present) return;
+        it = _mdb_table.insert(std::make_pair(key, nas_os_mdb_entry_t{false, false, false})).first;
+    }
+    it->second.present = present;
+    if (!it->second.dirty) {
+        it->second.dirty = true;
+        _mdb_dirty.push_back(key);
+    }
+}
+
+/* Member port name without the VLAN suffix, looked up without _mdb_mutex on a cache miss */
+static bool _mdb_port_name(hal_ifindex_t ifindex, std::string &name) {
+    {
+        std::lock_guard<std::mutex> lock(_mdb_mutex);
+        auto it = _mdb_port_cache.find(ifindex);
+        if (it != _mdb_port_cache.end()) {
+            name = it->second;
+            return true;
+        }
+    }
+    char if_name[HAL_IF_NAME_SZ];
+    if (cps_api_interface_if_index_to_name(ifindex, if_name, sizeof(if_name)) == NULL) {
+        EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Member port Interface %d not found", ifindex);
         return false;
     }
-    char *converted_intf_name = strtok_r(name,".",&saveptr);
-    safestrncpy(if_name, converted_intf_name, HAL_IF_NAME_SZ);
-    EV_LOGGING(NETLINK_MCAST_SNOOP,DEBUG,"NAS-LINUX-MCAST-SNOOP", "Member port Interface (%s)", if_name);
+    char *dot = strchr(if_name, '.');
+    if (dot != nullptr) *dot = '\0';
+    name = if_name;
+    std::lock_guard<std::mutex> lock(_mdb_mutex);
+    _mdb_port_cache[ifindex] = name;
     return true;
 }
 
+/* VLAN ID of the bridge, looked up without _mdb_mutex on a cache miss */
+static bool _mdb_vlan_id(hal_ifindex_t br_index, hal_vlan_id_t &vlan_id) {
+    {
+        std::lock_guard<std::mutex> lock(_mdb_mutex);
+        auto it = _mdb_vlan_cache.find(br_index);
+        if (it != _mdb_vlan_cache.end()) {
+            vlan_id = it->second;
+            return true;
+        }
+    }
+    interface_ctrl_t intf_ctrl;
+    memset(&intf_ctrl, 0, sizeof(intf_ctrl));
+    intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF;
+    intf_ctrl.if_index = br_index;
+    if (dn_hal_get_interface_info(&intf_ctrl) != STD_ERR_OK) {
+        EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "VLAN (%d) not found", br_index);
+        return false;
+    }
+    vlan_id = intf_ctrl.vlan_id;
+    std::lock_guard<std::mutex> lock(_mdb_mutex);
+    _mdb_vlan_cache[br_index] = vlan_id;
+    return true;
+}
+
+static void _mdb_grp_to_str(const nas_os_mdb_key_t &key, char *buf, size_t len) {
+    inet_ntop((key.proto == ETH_P_IP) ? AF_INET : AF_INET6, key.grp, buf, len);
+}
+
+static void _mdb_publish(cps_api_object_t obj, int msg_type) {
+    int sock = _mdb_nl_sock;
+    nas_nl_stats_update_pub_msg(sock, msg_type);
+    if (nas_os_obj_pool_publish(obj) != cps_api_ret_code_OK) {
+        EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failure to publish mdb update");
+        nas_nl_stats_update_pub_msg_failed(sock, msg_type);
+    }
+}
+
+static size_t _mdb_publish_groups(const nas_os_mdb_batch_t &batch) {
+    const std::string proto = (batch.proto == ETH_P_IP) ? "ipv4" : "ipv6";
+    auto &keymap = (*_cps_keymap)[proto];
+    int msg_type = (batch.op == cps_api_oper_CREATE) ? RTM_NEWMDB : RTM_DELMDB;
+    size_t objects = 0;
+
+    for (size_t start = 0; start < batch.members.size(); start += NAS_OS_MDB_BATCH_GROUPS) {
+        cps_api_object_t obj = nas_os_obj_pool_alloc(msg_type);
+        if (obj == nullptr) return objects;
+
+        cps_api_key_from_attr_with_qual(cps_api_object_key(obj), keymap["vlan"], cps_api_qualifier_OBSERVED);
+        cps_api_object_set_type_operation(cps_api_object_key(obj), batch.op);
+        cps_api_object_attr_add_u16(obj, keymap["vlan_id"], batch.vlan_id);
+
+        size_t end = std::min(start + NAS_OS_MDB_BATCH_GROUPS, batch.members.size());
+        for (size_t ix = start; ix < end; ++ix) {
+            const std::string &if_name = batch.members[ix].first;
+            char grp_addr[INET6_ADDRSTRLEN];
+            _mdb_grp_to_str(batch.members[ix].second, grp_addr, sizeof(grp_addr));
+
+            char name[HAL_IF_NAME_SZ] = {0};
+            safestrncpy(name, if_name.c_str(), sizeof(name));
+            cps_api_attr_id_t ids[3] = {keymap["grp_list"], (cps_api_attr_id_t)(ix - start), keymap["interface"]};
+            const int ids_len = sizeof(ids)/sizeof(ids[0]);
+            cps_api_object_e_add(obj, ids, ids_len, cps_api_object_ATTR_T_BIN, name, HAL_IF_NAME_SZ);
+            ids[2] = keymap["grp_addr"];
+            cps_api_object_e_add(obj, ids, ids_len, cps_api_object_ATTR_T_BIN, grp_addr, strlen(grp_addr)+1);
+
+            EV_LOGGING(NETLINK_MCAST_SNOOP,INFO,"NAS-LINUX-MCAST-SNOOP", "Message Type %s Protocol %s Vlan ID %d Member port %s Group address %s",
+                       (msg_type == RTM_NEWMDB) ? "new_mdb" : "del_mdb", proto.c_str(), batch.vlan_id, name, grp_addr);
+        }
+        _mdb_publish(obj, msg_type);
+        ++objects;
+    }
+    return objects;
+}
+
+static size_t _mdb_publish_routers(const nas_os_mdb_batch_t &batch) {
+    int msg_type = (batch.op == cps_api_oper_CREATE) ? RTM_NEWMDB : RTM_DELMDB;
+    size_t objects = 0;
+
+    for (auto &member : batch.members) {
+        char name[HAL_IF_NAME_SZ] = {0};
+        safestrncpy(name, member.first.c_str(), sizeof(name));
+
+        /* Kernel does not indicates or has facility to indicate it IGMP or MLD mrouter port.
+           So just publishing it as IGMP alone is not sufficient and the mrouter port will
+           not added to MLD routes. So here both IGMP and MLD object needs to be published
+           separately.
+        */
+        for (bool is_mld : {false, true}) {
+            cps_api_object_t obj = nas_os_obj_pool_alloc(msg_type);
+            if (obj == nullptr) return objects;
+            _populate_mdb_router_object(msg_type, batch.vlan_id, name, obj, is_mld);
+            _mdb_publish(obj, msg_type);
+            ++objects;
+        }
+    }
+    return objects;
+}
+
+static void _mdb_flush(void) {
+    std::vector<std::pair<nas_os_mdb_key_t, bool>> changes;
+    std::vector<hal_ifindex_t> gone;
+    {
+        std::lock_guard<std::mutex> lock(_mdb_mutex);
+        std::vector<nas_os_mdb_key_t> dirty;
+        dirty.swap(_mdb_dirty);
+        gone.swap(_mdb_gone);
+
+        for (auto &key : dirty) {
+            auto it = _mdb_table.find(key);
+            if (it == _mdb_table.end()) continue;
+            nas_os_mdb_entry_t &ent = it->second;
+            ent.dirty = false;
+            if (ent.present != ent.published) {
+                changes.push_back(std::make_pair(key, ent.present));
+                continue;
+            }
+            ++_mdb_stats.coalesced;
+            if (!ent.present) _mdb_table.erase(it);
+        }
+    }
+
+    /* Names and VLAN IDs are resolved without the lock, netlink updates are not held up */
+    std::vector<nas_os_mdb_batch_t> batches;
+    std::vector<std::pair<nas_os_mdb_key_t, bool>> unresolved;
+    /* Batch index per (bridge, proto, op) */
+    std::map<std::tuple<hal_ifindex_t, uint16_t, int>, size_t> batch_ix;
+    for (auto &change : changes) {
+        const nas_os_mdb_key_t &key = change.first;
+        hal_vlan_id_t vlan_id;
+        std::string if_name;
+        if (!_mdb_vlan_id(key.br_index, vlan_id) || !_mdb_port_name(key.port_index, if_name)) {
+            unresolved.push_back(change);
+            continue;
+        }
+
+        cps_api_operation_types_t op = change.second ? cps_api_oper_CREATE : cps_api_oper_DELETE;
+        auto bkey = std::make_tuple(key.br_index, key.proto, (int)op);
+        auto bit = batch_ix.find(bkey);
+        if (bit == batch_ix.end()) {
+            bit = batch_ix.insert(std::make_pair(bkey, batches.size())).first;
+            batches.push_back(nas_os_mdb_batch_t{vlan_id, key.proto, op, {}});
+        }
+        batches[bit->second].members.push_back(std::make_pair(if_name, key));
+    }
+
+    size_t objects = 0;
+    size_t published = 0;
+    for (auto &batch : batches) {
+        objects += (batch.proto == 0) ? _mdb_publish_routers(batch) : _mdb_publish_groups(batch);
+        published += batch.members.size();
+    }
+
+    std::lock_guard<std::mutex> lock(_mdb_mutex);
+    /* Only the entries added to a batch are published, the kernel may have changed them since */
+    for (auto &batch : batches) {
+        for (auto &member : batch.members) {
+            auto it = _mdb_table.find(member.second);
+            if (it == _mdb_table.end()) continue;
+            nas_os_mdb_entry_t &ent = it->second;
+            ent.published = (batch.op == cps_api_oper_CREATE);
+            if (!ent.present && !ent.published && !ent.dirty) _mdb_table.erase(it);
+        }
+    }
+    /* Names not resolved yet - retried on the next flush */
+    for (auto &change : unresolved) {
+        auto it = _mdb_table.find(change.first);
+        if (it == _mdb_table.end() || it->second.dirty) continue;
+        it->second.dirty = true;
+        _mdb_dirty.push_back(change.first);
+    }
+    _mdb_stats.published += published;
+    _mdb_stats.objects += objects;
+    ++_mdb_stats.flushes;
+    for (auto ifindex : gone) {
+        _mdb_vlan_cache.erase(ifindex);
+        _mdb_port_cache.erase(ifindex);
+    }
+}
+
+static void _mdb_flush_main(void) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mdb_mutex);
+            _mdb_cv.wait(lock, [] { return !_mdb_dirty.empty(); });
+        }
+        /* Let the group churn of the window settle before publishing */
+        std::this_thread::sleep_for(std::chrono::milliseconds(NAS_OS_MDB_COALESCE_MS));
+        _mdb_flush();
+    }
+}
+
 bool nl_to_mcast_snoop_info(int sock, int msg_type, struct nlmsghdr *hdr, void *context) {
     struct nlattr *nest_attr;
     struct nlattr *info_attr;
     struct br_mdb_entry *br_entry;
     struct br_port_msg *brp_msg = (struct br_port_msg *)NLMSG_DATA(hdr);
-    static char netlink_buf[MAX_NETLINK_BUF];
 
     EV_LOGGING(NETLINK_MCAST_SNOOP,DEBUG,"NAS-LINUX-MCAST-SNOOP", "message type %d Family %d VLAN ifindex %d ", msg_type, brp_msg->family, brp_msg->ifindex);
 
@@ -181,17 +426,11 @@ bool nl_to_mcast_snoop_info(int sock, int msg_type, struct nlmsghdr *hdr, void *
         EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Unsupported msg type ");
         return false;
     }
+    bool present = (msg_type == RTM_NEWMDB);
 
-
-    interface_ctrl_t intf_ctrl;
-    memset(&intf_ctrl, 0, sizeof(intf_ctrl));
-    intf_ctrl.q_type = HAL_INTF_INFO_FROM_IF;
-    intf_ctrl.if_index = brp_msg->ifindex;
-    if (dn_hal_get_interface_info(&intf_ctrl) != STD_ERR_OK) {
-        EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "VLAN (%d) not found",  brp_msg->ifindex);
-        return false;
-    }
-    EV_LOGGING(NETLINK_MCAST_SNOOP,DEBUG,"NAS-LINUX-MCAST-SNOOP", "VLAN name (%s) ID (%d)",  intf_ctrl.if_name, intf_ctrl.vlan_id);
+    std::lock_guard<std::mutex> lock(_mdb_mutex);
+    _mdb_nl_sock = sock;
+    bool was_idle = _mdb_dirty.empty();
 
     int attrlen = nlmsg_attrlen(hdr,sizeof(struct br_port_msg));
     struct nlattr *attr = nlmsg_attrdata(hdr, sizeof(struct br_port_msg));
@@ -204,29 +443,18 @@ bool nl_to_mcast_snoop_info(int sock, int msg_type, struct nlmsghdr *hdr, void *
                     info_attr = (nlattr*)nla_data(nest_attr);
                     if (nla_type(info_attr) == MDBA_MDB_ENTRY_INFO) {
                         br_entry = (struct br_mdb_entry *)nla_data(info_attr);
-                        EV_LOGGING(NETLINK_MCAST_SNOOP,DEBUG,"NAS-LINUX-MCAST-SNOOP", "Member port ifindex %d Protocol %s ", br_entry->ifindex, (ntohs(br_entry->addr.proto) == ETH_P_IP) ? "ipv4": "ipv6");
-
-                       // Get member port interface name from ifindex
-                       char if_name[HAL_IF_NAME_SZ] = {0};
-                       if (! _get_ifname(br_entry->ifindex, if_name, HAL_IF_NAME_SZ)) {
-                           EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failure in getting member port interface name for ifindex %d ", br_entry->ifindex);
-                           return false;
-                       }
-
-                       // Populate CPS Object
-                       cps_api_object_t obj = cps_api_object_init(netlink_buf,sizeof(netlink_buf));
-
-                       if( !_populate_mdb_entry_object(br_entry, msg_type, intf_ctrl.vlan_id, if_name, obj) ) {
-                           EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Invalid protocol ");
-                       }
-                       else {
-                           nas_nl_stats_update_pub_msg (sock, msg_type);
-                           if (net_publish_event(obj) != cps_api_ret_code_OK) {
-                               EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failure to publish route update");
-                               nas_nl_stats_update_pub_msg_failed (sock, msg_type);
-                           }
-                       }
-
+                        uint16_t proto = ntohs(br_entry->addr.proto);
+                        EV_LOGGING(NETLINK_MCAST_SNOOP,DEBUG,"NAS-LINUX-MCAST-SNOOP", "Member port ifindex %d Protocol %s ", br_entry->ifindex, (proto == ETH_P_IP) ? "ipv4": "ipv6");
+
+                        if (proto == ETH_P_IP) {
+                            _mdb_update(brp_msg->ifindex, br_entry->ifindex, proto, &br_entry->addr.u.ip4,
+                                        sizeof(br_entry->addr.u.ip4), present);
+                        } else if (proto == ETH_P_IPV6) {
+                            _mdb_update(brp_msg->ifindex, br_entry->ifindex, proto, &br_entry->addr.u.ip6,
+                                        sizeof(br_entry->addr.u.ip6), present);
+                        } else {
+                            EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Invalid protocol ");
+                        }
                     }
                 }
             }
@@ -234,91 +462,101 @@ bool nl_to_mcast_snoop_info(int sock, int msg_type, struct nlmsghdr *hdr, void *
         else if (attr_type == MDBA_ROUTER) {
             nla_for_each_nested(nest_attr, attr, attrlen) {
                 if (nla_type(nest_attr) == MDBA_ROUTER_PORT) {
-                     uint32_t ifindex = *((uint32_t *)(nla_data(nest_attr)));
-
-                     // Get Mrouter port interface name from ifindex
-                       char if_name[HAL_IF_NAME_SZ] = {0};
-                       if(! _get_ifname(ifindex, if_name, HAL_IF_NAME_SZ)) {
-                           EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failure in getting Mrouter port interface name for ifindex %d ", ifindex);
-                           return false;
-                       }
-
-                     /* Kernel does not indicates or has facility to indicate it IGMP or MLD mrouter port.
-                        So just publishing it as IGMP alone is not sufficient and the mrouter port will
-                        not added to MLD routes. So here both IGMP and MLD object needs to be published
-                        separately.
-                     */
-
-                     cps_api_object_t igmp_obj = cps_api_object_init(netlink_buf, sizeof(netlink_buf));
-
-                     _populate_mdb_router_object(msg_type, intf_ctrl.vlan_id, if_name, igmp_obj, 1);
-                     nas_nl_stats_update_pub_msg (sock, msg_type);
-
-                     if (net_publish_event(igmp_obj) != cps_api_ret_code_OK) {
-                         EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failure to publish MLD Mrouter port %s ", if_name);
-                         nas_nl_stats_update_pub_msg_failed (sock, msg_type);
-                     }
-
-                     cps_api_object_t mld_obj = cps_api_object_init(netlink_buf,sizeof(netlink_buf));
-
-                     _populate_mdb_router_object(msg_type, intf_ctrl.vlan_id, if_name, mld_obj, 0);
-
-                     nas_nl_stats_update_pub_msg (sock, msg_type);
-                     if (net_publish_event(igmp_obj) != cps_api_ret_code_OK) {
-                         EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failure to publish IGMP Mrouter port %s ", if_name);
-                         nas_nl_stats_update_pub_msg_failed (sock, msg_type);
-                     }
-                 }
-             }
+                    uint32_t ifindex = *((uint32_t *)(nla_data(nest_attr)));
+                    _mdb_update(brp_msg->ifindex, ifindex, 0, nullptr, 0, present);
+                }
+            }
         }
 
         attr = nla_next(attr, &attrlen);
     }
 
+    if (was_idle && !_mdb_dirty.empty()) _mdb_cv.notify_one();
     return true;
 }
 
+void nas_os_mcast_snoop_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *if_name)
+{
+    std::lock_guard<std::mutex> lock(_mdb_mutex);
+    if (rt_msg_type != RTM_DELLINK) {
+        auto it = _mdb_port_cache.find(ifindex);
+        if (it != _mdb_port_cache.end() && if_name != nullptr) {
+            std::string name(if_name, strcspn(if_name, "."));
+            if (it->second != name) it->second = name;
+        }
+        return;
+    }
 
-static bool nas_os_get_mcast_querier_status(const char * vlan_name){
-    std::stringstream str_stream;
-    str_stream << "/sys/devices/virtual/net/" << vlan_name << "/bridge/multicast_querier";
-    std::string path = str_stream.str();
+    /* Deletes of the entries of a deleted bridge or port are published even if the
+     * RTM_DELMDB of the kernel flush is missed, the names stay cached until then */
+    bool was_idle = _mdb_dirty.empty();
+    bool found = false;
+    for (auto &it : _mdb_table) {
+        if (it.first.br_index != ifindex && it.first.port_index != ifindex) continue;
+        found = true;
+        it.second.present = false;
+        if (!it.second.dirty) {
+            it.second.dirty = true;
+            _mdb_dirty.push_back(it.first);
+        }
+    }
+    if (!found) {
+        _mdb_vlan_cache.erase(ifindex);
+        _mdb_port_cache.erase(ifindex);
+        return;
+    }
+    _mdb_gone.push_back(ifindex);
+    if (was_idle) _mdb_cv.notify_one();
+}
 
-    std::ifstream in(path);
-    if(!in.good()) {
-        return false;
+t_std_error nas_os_mcast_snoop_init(void)
+{
+    memset(&_mdb_stats, 0, sizeof(_mdb_stats));
+    std_thread_init_struct(&_mdb_thr);
+    _mdb_thr.name = "db-api-linux-mdb";
+    _mdb_thr.thread_function = (std_thread_function_t)_mdb_flush_main;
+    if (std_thread_create(&_mdb_thr) != STD_ERR_OK) {
+        EV_LOGGING(NETLINK_MCAST_SNOOP,ERR,"NAS-LINUX-MCAST-SNOOP", "Failed to create mdb publish thread");
+        return STD_ERR(NAS_OS, FAIL, 0);
     }
+    return STD_ERR_OK;
+}
+
+extern "C" void os_debug_mdb_print ()
+{
+    std::lock_guard<std::mutex> lock(_mdb_mutex);
+    size_t groups = 0, routers = 0;
+    for (auto &ent : _mdb_table) {
+        if (ent.first.proto == 0) ++routers;
+        else ++groups;
+    }
+    printf("\r\n NAS OS MDB entries:%lu mrouters:%lu dirty:%lu window:%ums\r\n",
+           (unsigned long)groups, (unsigned long)routers, (unsigned long)_mdb_dirty.size(), NAS_OS_MDB_COALESCE_MS);
+    printf("\r=========================================================================\r\n");
+    printf("\r netlink updates:%lu coalesced:%lu published:%lu objects:%lu flushes:%lu\r\n",
+           (unsigned long)_mdb_stats.nl_updates, (unsigned long)_mdb_stats.coalesced,
+           (unsigned long)_mdb_stats.published, (unsigned long)_mdb_stats.objects,
+           (unsigned long)_mdb_stats.flushes);
+    printf("\r cached VLANs:%lu ports:%lu\r\n",
+           (unsigned long)_mdb_vlan_cache.size(), (unsigned long)_mdb_port_cache.size());
+}
 
-    std::string s;
-    int querier_status = 0;
 
-    if(getline(in, s)) {
-        querier_status = stoi(s);
+static bool nas_os_get_mcast_querier_status(hal_ifindex_t br_index, const char * vlan_name){
+    long querier_status = 0;
+    if(!nas_os_br_attr_get(br_index, vlan_name, NAS_OS_BR_ATTR_MCAST_QUERIER, &querier_status)) {
+        return false;
     }
 
-    EV_LOGGING(NAS_OS, DEBUG, "NAS-OS", "Bridge %s Querier state %d",
+    EV_LOGGING(NAS_OS, DEBUG, "NAS-OS", "Bridge %s Querier state %ld",
                 vlan_name,querier_status);
 
     return ((querier_status)? true:false);
 }
 
 
-static bool nas_os_set_macst_querier_status(const char * vlan_name, bool enable){
-    std::stringstream str_stream;
-    str_stream << "/sys/devices/virtual/net/" << vlan_name << "/bridge/multicast_querier";
-
-    std::string path = str_stream.str();
-
-    std::ofstream out(path);
-    if(!out.good()) {
-        return false;
-    }
-
-    const char * querier_status = enable ? "1" : "0";
-
-    try{
-        out.write(querier_status,1);
-    }catch(...){
+static bool nas_os_set_macst_querier_status(hal_ifindex_t br_index, const char * vlan_name, bool enable){
+    if(!nas_os_br_attr_set(br_index, vlan_name, NAS_OS_BR_ATTR_MCAST_QUERIER, enable ? 1 : 0)) {
         EV_LOGGING(NAS_OS,ERR,"NAS-OS","Failed to update the querier status to %d for %s",enable,vlan_name);
         return false;
     }
@@ -343,9 +581,9 @@ bool nas_os_refresh_mcast_querier_status(hal_vlan_id_t vlan_id){
         return false;
     }
 
-    if(nas_os_get_mcast_querier_status(intf_ctrl.if_name)){
-        return nas_os_set_macst_querier_status(intf_ctrl.if_name,false) &&
-                nas_os_set_macst_querier_status(intf_ctrl.if_name,true);
+    if(nas_os_get_mcast_querier_status(intf_ctrl.if_index,intf_ctrl.if_name)){
+        return nas_os_set_macst_querier_status(intf_ctrl.if_index,intf_ctrl.if_name,false) &&
+                nas_os_set_macst_querier_status(intf_ctrl.if_index,intf_ctrl.if_name,true);
     }
 
     return false;
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_nbr_bulk.cpp
+ * \brief  Paced bulk neighbor refresh/resolve
+ */
+
+#include "nas_os_l3.h"
+#include "netlink_tools.h"
+#include "nas_nlmsg.h"
+#include "event_log.h"
+#include "std_time_tools.h"
+
+#include <linux/neighbour.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Neighbor RTM_NEWNEIGH messages are sent in batches of back to back messages, a batch
+ * is kept small enough for all its ACKs to fit in the socket receive buffer
+ */
+#define NL_NBR_BATCH_MSGS 128
+#define NL_NBR_MSG_LEN 128
+#define NL_NBR_BATCH_LEN (NL_NBR_BATCH_MSGS*NL_NBR_MSG_LEN)
+/* Granularity of the pacing - the messages of an interval are sent in one batch */
+#define NL_NBR_PACE_INTERVAL_MS 10
+
+static inline const char * _nbr_vrf(const nas_os_nbr_bulk_entry_t &ent)
+{
+    return (ent.vrf_name != nullptr) ? ent.vrf_name : NL_DEFAULT_VRF_NAME;
+}
+
+static struct nlmsghdr * _nbr_msg_build(void *buff, size_t len, const nas_os_nbr_bulk_entry_t &ent,
+                                        bool resolve, uint32_t seq)
+{
+    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff,len,sizeof(struct nlmsghdr));
+    if (nlh == NULL) return NULL;
+    struct ndmsg *ndm = (struct ndmsg *) nlmsg_reserve(nlh,len,sizeof(struct ndmsg));
+    if (ndm == NULL) return NULL;
+
+    nlh->nlmsg_seq = seq;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE;
+    nlh->nlmsg_type = RTM_NEWNEIGH;
+
+    /* Same as nas_os_update_neighbor() - DELAY makes the kernel probe the neighbor */
+    ndm->ndm_family = (ent.ip.af_index == HAL_INET4_FAMILY) ? AF_INET : AF_INET6;
+    ndm->ndm_ifindex = ent.if_index;
+    ndm->ndm_state = NUD_DELAY;
+    ndm->ndm_type = RTN_UNICAST;
+    if (resolve) ndm->ndm_flags = NTF_USE;
+
+    if (ndm->ndm_family == AF_INET) {
+        if (nlmsg_add_attr(nlh,len,NDA_DST,&ent.ip.u.v4_addr,HAL_INET4_LEN) == -1) return NULL;
+    } else {
+        if (nlmsg_add_attr(nlh,len,NDA_DST,ent.ip.u.v6_addr,HAL_INET6_LEN) == -1) return NULL;
+    }
+
+    static const hal_mac_addr_t zero_mac = {0};
+    if (!resolve && memcmp(ent.mac, zero_mac, sizeof(zero_mac)) != 0) {
+        if (nlmsg_add_attr(nlh,len,NDA_LLADDR,ent.mac,HAL_MAC_ADDR_LEN) == -1) return NULL;
+    }
+    return nlh;
+}
+
+static t_std_error _nbr_bulk_update(const nas_os_nbr_bulk_entry_t *entries, size_t count, uint32_t pace_window_ms,
+                                    bool resolve, int *err_out, nas_os_nbr_bulk_result_t *result)
+{
+    if (entries == nullptr && count != 0) return STD_ERR(NAS_OS, PARAM, 0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    /* Entries grouped by VRF, one socket per VRF namespace */
+    std::vector<size_t> order(count);
+    for (size_t ix = 0; ix < count; ++ix) order[ix] = ix;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return strcmp(_nbr_vrf(entries[a]), _nbr_vrf(entries[b])) < 0;
+    });
+
+    size_t intervals = std::max<size_t>(1, pace_window_ms / NL_NBR_PACE_INTERVAL_MS);
+    size_t per_interval = std::max<size_t>(1, (count + intervals - 1) / intervals);
+
+    /* errno of the entries in the send order */
+    std::vector<int> err(count, 0);
+    std::vector<char> batch(NL_NBR_BATCH_LEN);
+    uint32_t seq_base = (uint32_t)std_get_uptime(NULL);
+    int sock = -1;
+    std::string sock_vrf;
+
+    size_t first = 0;
+    while (first < count) {
+        const char *vrf_name = _nbr_vrf(entries[order[first]]);
+        if (sock == -1 || sock_vrf != vrf_name) {
+            if (sock != -1) close(sock);
+            sock_vrf = vrf_name;
+            sock = nas_nl_sock_create(vrf_name, nas_nl_sock_T_NEI, false);
+            if (sock == -1) {
+                int rc = errno;
+                EV_LOGGING(NAS_OS, ERR, "NEIGH-BULK", "Failed to create socket for VRF %s err-no:%d",
+                           vrf_name, rc);
+                for (; first < count && sock_vrf == _nbr_vrf(entries[order[first]]); ++first) {
+                    err[first] = rc;
+                }
+                continue;
+            }
+        }
+
+        /* Message k is due at k/count of the window */
+        if (pace_window_ms != 0) {
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(
+                                          (uint64_t)pace_window_ms * first / count));
+        }
+
+        size_t off = 0, last = first, pending = 0;
+        size_t limit = std::min<size_t>(per_interval, NL_NBR_BATCH_MSGS);
+        for (; last < count && last - first < limit && sock_vrf == _nbr_vrf(entries[order[last]]); ++last) {
+            memset(&batch[off], 0, NL_NBR_MSG_LEN);
+            struct nlmsghdr *nlh = _nbr_msg_build(&batch[off], NL_NBR_MSG_LEN, entries[order[last]],
+                                                  resolve, seq_base + last);
+            if (nlh == NULL) {
+                err[last] = ENOBUFS;
+                continue;
+            }
+            off += NLMSG_ALIGN(nlh->nlmsg_len);
+            err[last] = -1;
+            ++pending;
+        }
+        if (pending > 0) {
+            if (nl_send_nlmsg_batch(sock, &batch[0], off)) {
+                nl_read_batch_acks(sock, seq_base, first, last, pending, &err[0]);
+            } else {
+                int rc = errno;
+                for (size_t ix = first; ix < last; ++ix) {
+                    if (err[ix] == -1) err[ix] = rc;
+                }
+            }
+        }
+        first = last;
+    }
+    if (sock != -1) close(sock);
+
+    nas_os_nbr_bulk_result_t res;
+    memset(&res, 0, sizeof(res));
+    for (size_t ix = 0; ix < count; ++ix) {
+        if (err_out != nullptr) err_out[order[ix]] = err[ix];
+        if (err[ix] == 0) {
+            ++res.ok;
+        } else {
+            if (res.failed == 0) res.first_err = err[ix];
+            ++res.failed;
+        }
+    }
+    res.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start).count();
+    if (result != nullptr) *result = res;
+
+    EV_LOGGING(NAS_OS, INFO, "NEIGH-BULK", "%s of %zu neighbors over %u ms: ok:%u failed:%u err:%d",
+               (resolve ? "Resolve" : "Refresh"), count, res.elapsed_ms, res.ok, res.failed, res.first_err);
+
+    return (res.failed == 0) ? STD_ERR_OK : STD_ERR(NAS_OS, FAIL, 0);
+}
+
+extern "C" {
+
+t_std_error nas_os_refresh_neighbor_bulk (const nas_os_nbr_bulk_entry_t *entries, size_t count,
+                                          uint32_t pace_window_ms, int *err,
+                                          nas_os_nbr_bulk_result_t *result)
+{
+    return _nbr_bulk_update(entries, count, pace_window_ms, false, err, result);
+}
+
+t_std_error nas_os_resolve_neighbor_bulk (const nas_os_nbr_bulk_entry_t *entries, size_t count,
+                                          uint32_t pace_window_ms, int *err,
+                                          nas_os_nbr_bulk_result_t *result)
+{
+    return _nbr_bulk_update(entries, count, pace_window_ms, true, err, result);
+}
+
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * nas_os_nl_page.c
+ */
+
+#include "nas_os_nl_page.h"
+#include "event_log.h"
+#include "std_time_tools.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+void nas_os_nl_page_init(nas_os_nl_page_t *page, cps_api_object_list_t list, size_t max_count,
+                         size_t cursor_len, const uint8_t *start)
+{
+    memset(page, 0, sizeof(*page));
+    page->list = list;
+    page->max_count = max_count;
+    page->cursor_len = (cursor_len < NAS_OS_NL_PAGE_KEY_LEN) ? cursor_len : NAS_OS_NL_PAGE_KEY_LEN;
+    if (start != NULL) {
+        page->has_start = true;
+        memcpy(page->start, start, NAS_OS_NL_PAGE_KEY_LEN);
+    }
+    page->start_us = std_get_uptime(NULL);
+}
+
+bool nas_os_nl_page_want(nas_os_nl_page_t *page, const uint8_t *key)
+{
+    ++page->scanned;
+    if (page->has_start && memcmp(key, page->start, page->cursor_len) <= 0) {
+        return false;
+    }
+    /* Once full, only the keys up to the last entry of the page */
+    if ((page->max_count != 0) && (page->count >= page->max_count) &&
+        (memcmp(key, page->ents[page->max_count-1].key, page->cursor_len) > 0)) {
+        return false;
+    }
+    return true;
+}
+
+bool nas_os_nl_page_add(nas_os_nl_page_t *page, const uint8_t *key, cps_api_object_t obj)
+{
+    if (page->first_match_us == 0) {
+        page->first_match_us = std_get_uptime(NULL) - page->start_us;
+    }
+
+    if (page->max_count == 0) {
+        if (!cps_api_object_list_append(page->list, obj)) {
+            cps_api_object_delete(obj);
+            return false;
+        }
+        ++page->returned;
+        return true;
+    }
+
+    if (page->count == page->size) {
+        size_t size = (page->size == 0) ? page->max_count + 1 : page->size * 2;
+        nas_os_nl_page_ent_t *ents = (nas_os_nl_page_ent_t *)realloc(page->ents, size * sizeof(*ents));
+        if (ents == NULL) {
+            cps_api_object_delete(obj);
+            return false;
+        }
+        page->ents = ents;
+        page->size = size;
+    }
+
+    /* After the entries with the same key - the dump order is kept for them */
+    size_t lo = 0, hi = page->count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (memcmp(page->ents[mid].key, key, NAS_OS_NL_PAGE_KEY_LEN) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    memmove(&page->ents[lo+1], &page->ents[lo], (page->count - lo) * sizeof(*page->ents));
+    memcpy(page->ents[lo].key, key, NAS_OS_NL_PAGE_KEY_LEN);
+    page->ents[lo].obj = obj;
+    ++page->count;
+
+    /* Drop the entries pushed out of the page, but not a part of the last cursor key */
+    while ((page->count > page->max_count) &&
+           (memcmp(page->ents[page->count-1].key, page->ents[page->max_count-1].key,
+                   page->cursor_len) != 0)) {
+        cps_api_object_delete(page->ents[--page->count].obj);
+    }
+    return true;
+}
+
+void nas_os_nl_page_done(nas_os_nl_page_t *page, const char *name)
+{
+    size_t ix = 0;
+    for ( ; ix < page->count; ++ix) {
+        if (cps_api_object_list_append(page->list, page->ents[ix].obj)) {
+            ++page->returned;
+        } else {
+            cps_api_object_delete(page->ents[ix].obj);
+        }
+    }
+    free(page->ents);
+    page->ents = NULL;
+    page->count = page->size = 0;
+
+    page->total_us = std_get_uptime(NULL) - page->start_us;
+    EV_LOGGING(NETLINK, INFO, "NL-READ", "%s read: scanned:%zu returned:%zu max:%zu start-key:%d "
+               "first match in %" PRIu64 "us, total %" PRIu64 "us", name, page->scanned, page->returned,
+               page->max_count, page->has_start, page->first_match_us, page->total_us);
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_obj_pool.cpp
+ * \brief  Per thread pool of CPS object buffers for the netlink event path
+ */
+
+#include "nas_os_obj_pool.h"
+#include "net_publish.h"
+#include "event_log.h"
+
+#include <linux/rtnetlink.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <vector>
+
+/*
+ * Every thread owns its free lists so no locking is needed on alloc/release, only
+ * the counters are shared. Buffers are never given back to the heap while the thread
+ * is alive unless more than MAX_CACHED buffers of a class are free.
+ */
+
+static const size_t _pool_buf_size[NAS_OS_OBJ_POOL_MAX] = {
+    4096,   /* NAS_OS_OBJ_POOL_SMALL */
+    12000,  /* NAS_OS_OBJ_POOL_LARGE */
+};
+
+static const size_t MAX_CACHED = 16;
+
+typedef struct {
+    std::atomic<uint64_t> allocs;
+    std::atomic<uint64_t> reused;
+    std::atomic<uint32_t> in_use;
+    std::atomic<uint32_t> high_water;
+    std::atomic<uint32_t> cached;
+} nas_os_obj_pool_cntrs_t;
+
+static nas_os_obj_pool_cntrs_t _pool_cntrs[NAS_OS_OBJ_POOL_MAX];
+
+struct nas_os_obj_pool_buf_t {
+    cps_api_object_t obj;
+    char *buf;
+    nas_os_obj_pool_class_t cls;
+};
+
+class nas_os_obj_pool {
+    std::vector<char *> free_[NAS_OS_OBJ_POOL_MAX];
+    std::vector<nas_os_obj_pool_buf_t> used_;
+public:
+    ~nas_os_obj_pool() {
+        for (auto &it : used_) {
+            cps_api_object_delete(it.obj);
+            delete [] it.buf;
+            _pool_cntrs[it.cls].in_use--;
+        }
+        for (size_t cls = 0; cls < NAS_OS_OBJ_POOL_MAX; ++cls) {
+            for (auto buf : free_[cls]) delete [] buf;
+            _pool_cntrs[cls].cached -= free_[cls].size();
+        }
+    }
+
+    cps_api_object_t alloc(nas_os_obj_pool_class_t cls) {
+        char *buf = nullptr;
+        bool reused = false;
+        if (!free_[cls].empty()) {
+            buf = free_[cls].back();
+            free_[cls].pop_back();
+            _pool_cntrs[cls].cached--;
+            reused = true;
+        } else {
+            buf = new (std::nothrow) char[_pool_buf_size[cls]];
+            if (buf == nullptr) return nullptr;
+        }
+
+        cps_api_object_t obj = cps_api_object_init(buf, _pool_buf_size[cls]);
+        if (obj == nullptr) {
+            free_[cls].push_back(buf);
+            _pool_cntrs[cls].cached++;
+            return nullptr;
+        }
+        used_.push_back({obj, buf, cls});
+
+        _pool_cntrs[cls].allocs++;
+        if (reused) _pool_cntrs[cls].reused++;
+        uint32_t in_use = ++_pool_cntrs[cls].in_use;
+        uint32_t hw = _pool_cntrs[cls].high_water;
+        while (in_use > hw && !_pool_cntrs[cls].high_water.compare_exchange_weak(hw, in_use)) {}
+        return obj;
+    }
+
+    bool release(cps_api_object_t obj) {
+        /* Few objects are outstanding at a time, most recent one is released first */
+        for (auto it = used_.rbegin(); it != used_.rend(); ++it) {
+            if (it->obj != obj) continue;
+            nas_os_obj_pool_buf_t ent = *it;
+            used_.erase(std::next(it).base());
+
+            /* Releases anything the object allocated beyond the pool buffer */
+            cps_api_object_delete(ent.obj);
+            _pool_cntrs[ent.cls].in_use--;
+            if (free_[ent.cls].size() < MAX_CACHED) {
+                free_[ent.cls].push_back(ent.buf);
+                _pool_cntrs[ent.cls].cached++;
+            } else {
+                delete [] ent.buf;
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+static nas_os_obj_pool & _thread_pool() {
+    static thread_local nas_os_obj_pool pool;
+    return pool;
+}
+
+extern "C" {
+
+nas_os_obj_pool_class_t nas_os_obj_pool_class(int rt_msg_type)
+{
+    if ((rt_msg_type >= RTM_NEWLINK && rt_msg_type <= RTM_SETLINK) ||
+        (rt_msg_type >= RTM_NEWROUTE && rt_msg_type <= RTM_GETROUTE)) {
+        return NAS_OS_OBJ_POOL_LARGE;
+    }
+    return NAS_OS_OBJ_POOL_SMALL;
+}
+
+cps_api_object_t nas_os_obj_pool_alloc(int rt_msg_type)
+{
+    nas_os_obj_pool_class_t cls = nas_os_obj_pool_class(rt_msg_type);
+    cps_api_object_t obj = _thread_pool().alloc(cls);
+    if (obj == nullptr) {
+        EV_LOGGING(NETLINK, ERR, "NL-OBJ-POOL", "Failed to get object of size %lu for msg type %d",
+                   _pool_buf_size[cls], rt_msg_type);
+    }
+    return obj;
+}
+
+void nas_os_obj_pool_release(cps_api_object_t obj)
+{
+    if (obj == nullptr) return;
+    if (!_thread_pool().release(obj)) {
+        EV_LOGGING(NETLINK, ERR, "NL-OBJ-POOL", "Object not owned by the thread pool");
+    }
+}
+
+cps_api_return_code_t nas_os_obj_pool_publish(cps_api_object_t obj)
+{
+    cps_api_return_code_t rc = nas_os_publish_event(obj);
+    nas_os_obj_pool_release(obj);
+    return rc;
+}
+
+bool nas_os_obj_pool_stats_get(nas_os_obj_pool_class_t cls, nas_os_obj_pool_stats_t *stats)
+{
+    if (cls >= NAS_OS_OBJ_POOL_MAX || stats == nullptr) return false;
+
+    stats->buf_size = _pool_buf_size[cls];
+    stats->allocs = _pool_cntrs[cls].allocs;
+    stats->reused = _pool_cntrs[cls].reused;
+    stats->in_use = _pool_cntrs[cls].in_use;
+    stats->high_water = _pool_cntrs[cls].high_water;
+    stats->cached = _pool_cntrs[cls].cached;
+    return true;
+}
+
+void os_debug_obj_pool_print ()
+{
+    static const char *cls_str[NAS_OS_OBJ_POOL_MAX] = { "Small", "Large" };
+
+    printf("\r\n NETLINK EVENT OBJECT POOL\r\n");
+    printf("\r %-8s %-10s %-14s %-14s %-8s %-10s %-8s\r\n",
+           "Class", "Buf-size", "Allocs", "Reused", "In-use", "High-water", "Cached");
+    printf("\r==========================================================================\r\n");
+    for (size_t cls = 0; cls < NAS_OS_OBJ_POOL_MAX; ++cls) {
+        nas_os_obj_pool_stats_t stats;
+        if (!nas_os_obj_pool_stats_get((nas_os_obj_pool_class_t)cls, &stats)) continue;
+        printf("\r %-8s %-10u %-14lu %-14lu %-8u %-10u %-8u\r\n", cls_str[cls], stats.buf_size,
+               stats.allocs, stats.reused, stats.in_use, stats.high_water, stats.cached);
+    }
+}
+
+}
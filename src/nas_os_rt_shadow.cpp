@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_rt_shadow.cpp
+ * \brief  Kernel route view used by the idempotent route programming
+ */
+
+#include "nas_os_rt_shadow.h"
+#include "nas_nlmsg.h"
+#include "std_rw_lock.h"
+#include "event_log.h"
+
+#include <linux/rtnetlink.h>
+#include <linux/ipv6_route.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+typedef struct {
+    uint8_t  gw[16];
+    uint8_t  gw_len;            /* 0 if there is no gateway */
+    uint8_t  hops;
+    uint32_t oif;               /* 0 if not given, matches any interface in a request */
+} rt_shadow_nh_t;
+
+typedef struct {
+    uint8_t  family;
+    uint8_t  protocol;
+    uint8_t  scope;
+    uint8_t  type;
+    std::vector<rt_shadow_nh_t> nh;   /* sorted by gateway */
+} rt_shadow_route_t;
+
+static std_rw_lock_t _shadow_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Routes keyed by "<vrf>\0<table><metric><af><prefix len><prefix>" and the routes using an ifindex */
+static auto & _shadow_routes = *(new std::unordered_map<std::string,rt_shadow_route_t>);
+static auto & _shadow_by_oif = *(new std::unordered_map<uint32_t,std::unordered_set<std::string>>);
+
+static std::atomic<uint64_t> _shadow_same(0);
+static std::atomic<uint64_t> _shadow_diff(0);
+static std::atomic<uint64_t> _shadow_unknown(0);
+static std::atomic<uint64_t> _shadow_invalidations(0);
+
+static bool _shadow_nh_less(const rt_shadow_nh_t & a, const rt_shadow_nh_t & b)
+{
+    if (a.gw_len != b.gw_len) return a.gw_len < b.gw_len;
+    return memcmp(a.gw, b.gw, a.gw_len) < 0;
+}
+
+static void _shadow_nh_fill(rt_shadow_nh_t & nh, struct nlattr *gw, uint32_t oif, uint8_t hops)
+{
+    memset(&nh, 0, sizeof(nh));
+    if (gw != nullptr && nla_len(gw) <= (int)sizeof(nh.gw)) {
+        nh.gw_len = nla_len(gw);
+        memcpy(nh.gw, nla_data(gw), nh.gw_len);
+    }
+    nh.oif = oif;
+    nh.hops = hops;
+}
+
+/*
+ * Decode a main table unicast route message into its key and next hops, the
+ * same decoding is used for the kernel messages and the encoded requests.
+ */
+static bool _shadow_parse(const char *vrf_name, struct nlmsghdr *nlh, std::string & key,
+                          rt_shadow_route_t *rt)
+{
+    struct rtmsg *rtm = (struct rtmsg *)NLMSG_DATA(nlh);
+
+    if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*rtm))) return false;
+    if ((rtm->rtm_family != AF_INET) && (rtm->rtm_family != AF_INET6)) return false;
+    if (rtm->rtm_flags & RTM_F_CLONED) return false;
+
+    struct nlattr *attrs[__IFLA_MAX];
+    memset(attrs, 0, sizeof(attrs));
+    if (nla_parse(attrs, __IFLA_MAX, nlmsg_attrdata(nlh, sizeof(*rtm)),
+                  nlmsg_attrlen(nlh, sizeof(*rtm))) != 0) {
+        return false;
+    }
+
+    uint32_t table = rtm->rtm_table;
+    if (attrs[RTA_TABLE] != nullptr) table = *(uint32_t *)nla_data(attrs[RTA_TABLE]);
+    if (table != RT_TABLE_MAIN) return false;
+
+    uint32_t priority = (attrs[RTA_PRIORITY] != nullptr) ? *(uint32_t *)nla_data(attrs[RTA_PRIORITY]) : 0;
+    /* The kernel reports the default metric of the IPv6 routes added without one */
+    if (priority == 0 && rtm->rtm_family == AF_INET6) priority = IP6_RT_PRIO_USER;
+
+    key.assign(vrf_name);
+    key.append(1, '\0');
+    key.append((const char *)&table, sizeof(table));
+    key.append((const char *)&priority, sizeof(priority));
+    key.append(1, (char)rtm->rtm_family);
+    key.append(1, (char)rtm->rtm_dst_len);
+    if (attrs[RTA_DST] != nullptr) {
+        key.append((const char *)nla_data(attrs[RTA_DST]), nla_len(attrs[RTA_DST]));
+    }
+
+    if (rt == nullptr) return true;
+
+    rt->family = rtm->rtm_family;
+    rt->protocol = rtm->rtm_protocol;
+    rt->scope = rtm->rtm_scope;
+    rt->type = rtm->rtm_type;
+    rt->nh.clear();
+
+    if (attrs[RTA_MULTIPATH] != nullptr) {
+        struct rtnexthop *rtnh = (struct rtnexthop *)nla_data(attrs[RTA_MULTIPATH]);
+        int remaining = nla_len(attrs[RTA_MULTIPATH]);
+
+        while (RTNH_OK(rtnh, remaining)) {
+            struct nlattr *nhattr[__IFLA_MAX];
+            memset(nhattr, 0, sizeof(nhattr));
+            nhrt_parse(nhattr, __IFLA_MAX, rtnh);
+
+            rt_shadow_nh_t nh;
+            _shadow_nh_fill(nh, nhattr[RTA_GATEWAY], rtnh->rtnh_ifindex, rtnh->rtnh_hops);
+            rt->nh.push_back(nh);
+
+            remaining -= NLMSG_ALIGN(rtnh->rtnh_len);
+            rtnh = RTNH_NEXT(rtnh);
+        }
+    } else if (attrs[RTA_GATEWAY] != nullptr || attrs[RTA_OIF] != nullptr) {
+        rt_shadow_nh_t nh;
+        _shadow_nh_fill(nh, attrs[RTA_GATEWAY],
+                        (attrs[RTA_OIF] != nullptr) ? *(uint32_t *)nla_data(attrs[RTA_OIF]) : 0, 0);
+        rt->nh.push_back(nh);
+    }
+    std::stable_sort(rt->nh.begin(), rt->nh.end(), _shadow_nh_less);
+    return true;
+}
+
+/* Called with the write lock held */
+static bool _shadow_erase(const std::string & key)
+{
+    auto it = _shadow_routes.find(key);
+    if (it == _shadow_routes.end()) return false;
+
+    for (auto & nh : it->second.nh) {
+        auto oif_it = _shadow_by_oif.find(nh.oif);
+        if (oif_it == _shadow_by_oif.end()) continue;
+        oif_it->second.erase(key);
+        if (oif_it->second.empty()) _shadow_by_oif.erase(oif_it);
+    }
+    _shadow_routes.erase(it);
+    return true;
+}
+
+/* Called with the write lock held */
+static void _shadow_add(const std::string & key, rt_shadow_route_t & rt, bool append)
+{
+    auto it = _shadow_routes.find(key);
+    if (append && it != _shadow_routes.end()) {
+        /* IPv6 multipath routes may be reported one next hop at a time */
+        rt.nh.insert(rt.nh.end(), it->second.nh.begin(), it->second.nh.end());
+        std::stable_sort(rt.nh.begin(), rt.nh.end(), _shadow_nh_less);
+    }
+    _shadow_erase(key);
+
+    for (auto & nh : rt.nh) {
+        _shadow_by_oif[nh.oif].insert(key);
+    }
+    _shadow_routes[key] = std::move(rt);
+}
+
+static bool _shadow_route_equal(const rt_shadow_route_t & req, const rt_shadow_route_t & cur)
+{
+    if (req.protocol != cur.protocol || req.type != cur.type || req.nh.size() != cur.nh.size()) {
+        return false;
+    }
+    /* IPv6 routes are always reported with the universe scope */
+    if (req.family == AF_INET && req.scope != cur.scope) return false;
+    for (size_t ix = 0; ix < req.nh.size(); ++ix) {
+        const rt_shadow_nh_t & a = req.nh[ix];
+        const rt_shadow_nh_t & b = cur.nh[ix];
+        if (a.gw_len != b.gw_len || memcmp(a.gw, b.gw, a.gw_len) != 0 || a.hops != b.hops) {
+            return false;
+        }
+        /* The kernel resolves the interface of a gateway only next hop */
+        if (a.oif != 0 && a.oif != b.oif) return false;
+    }
+    return true;
+}
+
+extern "C" void nas_os_rt_shadow_event(int rt_msg_type, const char *vrf_name, struct nlmsghdr *nlh)
+{
+    if (vrf_name == nullptr) return;
+
+    std::string key;
+    rt_shadow_route_t rt;
+    if (!_shadow_parse(vrf_name, nlh, key, &rt)) return;
+
+    std_rw_lock_write_guard l(&_shadow_lock);
+    if (rt_msg_type == RTM_NEWROUTE) {
+        _shadow_add(key, rt, (nlh->nlmsg_flags & NLM_F_APPEND) != 0);
+    } else if (rt_msg_type == RTM_DELROUTE) {
+        _shadow_erase(key);
+    }
+}
+
+extern "C" nas_os_rt_shadow_state_t nas_os_rt_shadow_check(const char *vrf_name, struct nlmsghdr *nlh)
+{
+    std::string key;
+    rt_shadow_route_t rt;
+    if (!_shadow_parse(vrf_name, nlh, key, &rt)) {
+        ++_shadow_unknown;
+        return NAS_OS_RT_SHADOW_UNKNOWN;
+    }
+
+    std_rw_lock_read_guard l(&_shadow_lock);
+    auto it = _shadow_routes.find(key);
+    if (it == _shadow_routes.end()) {
+        ++_shadow_unknown;
+        return NAS_OS_RT_SHADOW_UNKNOWN;
+    }
+    if (_shadow_route_equal(rt, it->second)) {
+        ++_shadow_same;
+        return NAS_OS_RT_SHADOW_SAME;
+    }
+    ++_shadow_diff;
+    return NAS_OS_RT_SHADOW_DIFF;
+}
+
+extern "C" void nas_os_rt_shadow_invalidate(const char *vrf_name, struct nlmsghdr *nlh)
+{
+    std::string key;
+    if (!_shadow_parse(vrf_name, nlh, key, nullptr)) return;
+
+    std_rw_lock_write_guard l(&_shadow_lock);
+    if (_shadow_erase(key)) ++_shadow_invalidations;
+}
+
+extern "C" void nas_os_rt_shadow_if_event(int rt_msg_type, hal_ifindex_t ifindex, uint32_t if_flags)
+{
+    if (rt_msg_type == RTM_NEWLINK &&
+        (if_flags & IFF_UP) && (if_flags & IFF_RUNNING)) {
+        return;
+    }
+
+    std_rw_lock_write_guard l(&_shadow_lock);
+    auto oif_it = _shadow_by_oif.find((uint32_t)ifindex);
+    if (oif_it == _shadow_by_oif.end()) return;
+
+    /* The ifindex is per VRF, the routes of every VRF using it are dropped */
+    std::vector<std::string> keys(oif_it->second.begin(), oif_it->second.end());
+    for (auto & key : keys) {
+        if (_shadow_erase(key)) ++_shadow_invalidations;
+    }
+}
+
+extern "C" void nas_os_rt_shadow_vrf_del(const char *vrf_name)
+{
+    if (vrf_name == nullptr) return;
+
+    std::string prefix(vrf_name);
+    prefix.append(1, '\0');
+
+    std_rw_lock_write_guard l(&_shadow_lock);
+    std::vector<std::string> keys;
+    for (auto & it : _shadow_routes) {
+        if (it.first.compare(0, prefix.size(), prefix) == 0) keys.push_back(it.first);
+    }
+    for (auto & key : keys) {
+        _shadow_erase(key);
+    }
+}
+
+extern "C" void nas_os_rt_shadow_clear(void)
+{
+    std_rw_lock_write_guard l(&_shadow_lock);
+    _shadow_routes.clear();
+    _shadow_by_oif.clear();
+}
+
+extern "C" void nas_os_rt_shadow_stats_get(nas_os_rt_shadow_stats_t *stats)
+{
+    stats->same = _shadow_same;
+    stats->diff = _shadow_diff;
+    stats->unknown = _shadow_unknown;
+    stats->invalidations = _shadow_invalidations;
+
+    std_rw_lock_read_guard l(&_shadow_lock);
+    stats->entries = _shadow_routes.size();
+}
+
+void os_debug_rt_shadow_print ()
+{
+    nas_os_rt_shadow_stats_t stats;
+    nas_os_rt_shadow_stats_get(&stats);
+
+    printf("\r\n Same:%lu Diff:%lu Unknown:%lu Invalidations:%lu Entries:%lu\r\n",
+           stats.same, stats.diff, stats.unknown, stats.invalidations, stats.entries);
+}
@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_snapshot.cpp
+ * \brief  Warm restart snapshot and reconciliation of the published kernel objects
+ */
+
+#include "nas_os_snapshot.h"
+#include "nas_os_obj_pool.h"
+#include "netlink_tools.h"
+#include "net_publish.h"
+#include "cps_api_interface_types.h"
+#include "cps_api_object_key.h"
+#include "cps_class_map.h"
+#include "event_log.h"
+#include "std_thread_tools.h"
+#include "std_time_tools.h"
+
+#include "dell-base-if.h"
+#include "dell-base-if-linux.h"
+#include "dell-base-ip.h"
+#include "dell-base-routing.h"
+#include "ietf-interfaces.h"
+#include "os-routing-events.h"
+
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Every tracked object is kept as a 64 bit hash of its identity (object type and the
+ * attributes that make it unique), a 64 bit hash of its content and the minimal
+ * object needed to publish its delete. The file is written to a temporary file, synced
+ * and renamed over the previous snapshot so a crash never leaves a partial snapshot.
+ *
+ * File layout (host byte order):
+ *   header  : magic, version, payload length, payload checksum
+ *   per VRF : u16 name length, name, u32 object count
+ *   object  : u64 identity hash, u64 content hash, u16 delete object length, delete object
+ *   delete  : u8 type, { u64 attr id, u16 length, data } ...
+ */
+
+#define NAS_OS_SNAPSHOT_MAGIC    0x4e4c534eU     /* "NSLN" */
+#define NAS_OS_SNAPSHOT_VERSION  1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t len;
+    uint64_t checksum;
+} nas_os_snapshot_hdr_t;
+
+typedef enum {
+    SNAP_T_LINK = 0,
+    SNAP_T_IPV4,
+    SNAP_T_IPV6,
+    SNAP_T_ROUTE,
+    SNAP_T_NBR,
+    SNAP_T_MAX,
+} snap_obj_type_t;
+
+typedef struct {
+    cps_api_attr_id_t key;
+    cps_api_attr_id_t key_data;             /* Attribute copied to the key, 0 if none */
+    std::vector<cps_api_attr_id_t> ident;   /* Make the object unique in a VRF */
+    std::vector<cps_api_attr_id_t> del;     /* Also carried in the delete */
+} snap_obj_info_t;
+
+static const auto & _snap_obj_info = *(new std::vector<snap_obj_info_t> {
+    /* SNAP_T_LINK */
+    { BASE_IF_LINUX_IF_INTERFACES_INTERFACE_OBJ, 0,
+      { DELL_BASE_IF_CMN_IF_INTERFACES_INTERFACE_IF_INDEX },
+      { IF_INTERFACES_INTERFACE_NAME, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE } },
+    /* SNAP_T_IPV4 */
+    { BASE_IP_IPV4_OBJ, BASE_IP_IPV4_IFINDEX,
+      { BASE_IP_IPV4_IFINDEX, BASE_IP_IPV4_ADDRESS_IP, BASE_IP_IPV4_ADDRESS_PREFIX_LENGTH },
+      { BASE_IP_IPV4_VRF_NAME, BASE_IP_IPV4_NAME } },
+    /* SNAP_T_IPV6 */
+    { BASE_IP_IPV6_OBJ, BASE_IP_IPV6_IFINDEX,
+      { BASE_IP_IPV6_IFINDEX, BASE_IP_IPV6_ADDRESS_IP, BASE_IP_IPV6_ADDRESS_PREFIX_LENGTH },
+      { BASE_IP_IPV6_VRF_NAME, BASE_IP_IPV6_NAME } },
+    /* SNAP_T_ROUTE */
+    { OS_RE_BASE_ROUTE_OBJ_ENTRY_OBJ, 0,
+      { BASE_ROUTE_OBJ_ENTRY_AF, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN },
+      { BASE_ROUTE_OBJ_VRF_NAME, BASE_ROUTE_OBJ_VRF_ID, BASE_ROUTE_OBJ_ENTRY_VRF_ID } },
+    /* SNAP_T_NBR - MAC address is part of the identity only for the bridge FDB entries */
+    { OS_RE_BASE_ROUTE_OBJ_NBR_OBJ, 0,
+      { BASE_ROUTE_OBJ_NBR_AF, BASE_ROUTE_OBJ_NBR_ADDRESS, BASE_ROUTE_OBJ_NBR_IFINDEX },
+      { BASE_ROUTE_OBJ_VRF_NAME, OS_RE_BASE_ROUTE_OBJ_NBR_VRF_ID, BASE_ROUTE_OBJ_NBR_MAC_ADDR } },
+});
+
+typedef struct {
+    uint64_t content;
+    std::string del;
+} snap_entry_t;
+
+typedef std::unordered_map<uint64_t, snap_entry_t> snap_table_t;
+
+typedef struct {
+    uint32_t published;
+    uint32_t unchanged;
+    uint32_t deleted;
+    uint64_t done_us;
+} snap_reconcile_t;
+
+static std::mutex _snap_mutex;
+static std::condition_variable _snap_cv;
+static auto & _snap_live = *(new std::map<std::string, snap_table_t>);
+static auto & _snap_old = *(new std::map<std::string, snap_table_t>);   /* Not yet seen in the dump */
+static auto & _snap_pending = *(new std::set<std::string>);             /* VRFs not reconciled yet */
+static auto & _snap_tracked = *(new std::set<std::string>);             /* VRFs added and not deleted */
+static std::atomic<size_t> _snap_tracked_cnt(0);
+static auto & _snap_reconcile = *(new std::map<std::string, snap_reconcile_t>);
+static bool _snap_loaded = false;
+static bool _snap_dirty = false;
+static uint64_t _snap_start_us = 0;
+static uint64_t _snap_load_us = 0;
+static uint64_t _snap_load_cnt = 0;
+static uint64_t _snap_write_us = 0;
+static uint64_t _snap_write_len = 0;
+static uint64_t _snap_write_cnt = 0;
+static std_thread_create_param_t _snap_thr;
+
+static inline uint64_t snap_hash(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t ix = 0; ix < len; ++ix) {
+        h ^= p[ix];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static const uint64_t SNAP_HASH_INIT = 0xcbf29ce484222325ULL;
+
+static bool snap_obj_type(int rt_msg_type, cps_api_object_t obj, snap_obj_type_t *type) {
+    if (rt_msg_type <= RTM_SETLINK) {
+        *type = SNAP_T_LINK;
+    } else if (rt_msg_type <= RTM_GETADDR) {
+        if (cps_api_object_attr_get(obj, BASE_IP_IPV4_IFINDEX) != nullptr) {
+            *type = SNAP_T_IPV4;
+        } else if (cps_api_object_attr_get(obj, BASE_IP_IPV6_IFINDEX) != nullptr) {
+            *type = SNAP_T_IPV6;
+        } else {
+            return false;
+        }
+    } else if (rt_msg_type <= RTM_GETROUTE) {
+        *type = SNAP_T_ROUTE;
+    } else if (rt_msg_type <= RTM_GETNEIGH) {
+        *type = SNAP_T_NBR;
+    } else {
+        /* Netconf and MDB are always published */
+        return false;
+    }
+    return true;
+}
+
+static bool snap_nbr_is_fdb(cps_api_object_t obj) {
+    cps_api_object_attr_t af = cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_NBR_AF);
+    return (af != nullptr && cps_api_object_attr_data_u32(af) == AF_BRIDGE);
+}
+
+static void snap_attr_append(std::string &out, cps_api_object_t obj, cps_api_attr_id_t id) {
+    cps_api_object_attr_t attr = cps_api_object_attr_get(obj, id);
+    if (attr == nullptr) return;
+    uint64_t aid = id;
+    uint16_t len = (uint16_t)cps_api_object_attr_len(attr);
+    out.append((const char *)&aid, sizeof(aid));
+    out.append((const char *)&len, sizeof(len));
+    out.append((const char *)cps_api_object_attr_data_bin(attr), len);
+}
+
+static uint64_t snap_ident_hash(snap_obj_type_t type, cps_api_object_t obj) {
+    const snap_obj_info_t &info = _snap_obj_info[type];
+    std::string ident(1, (char)type);
+    for (auto id : info.ident) snap_attr_append(ident, obj, id);
+    if (type == SNAP_T_NBR && snap_nbr_is_fdb(obj)) {
+        snap_attr_append(ident, obj, BASE_ROUTE_OBJ_NBR_MAC_ADDR);
+    }
+    return snap_hash(SNAP_HASH_INIT, ident.data(), ident.size());
+}
+
+/* Operation is not part of the content, the dump and the events differ only in it */
+static uint64_t snap_content_hash(cps_api_object_t obj) {
+    uint64_t h = SNAP_HASH_INIT;
+    cps_api_object_it_t it;
+    for (cps_api_object_it_begin(obj, &it); cps_api_object_it_valid(&it); cps_api_object_it_next(&it)) {
+        cps_api_attr_id_t id = cps_api_object_attr_id(it.attr);
+        h = snap_hash(h, &id, sizeof(id));
+        h = snap_hash(h, cps_api_object_attr_data_bin(it.attr), cps_api_object_attr_len(it.attr));
+    }
+    return h;
+}
+
+static std::string snap_del_obj(snap_obj_type_t type, cps_api_object_t obj) {
+    const snap_obj_info_t &info = _snap_obj_info[type];
+    std::string del(1, (char)type);
+    for (auto id : info.ident) snap_attr_append(del, obj, id);
+    for (auto id : info.del) snap_attr_append(del, obj, id);
+    return del;
+}
+
+/* Build the delete object, false if the stored delete is malformed */
+static bool snap_del_to_obj(const std::string &del, cps_api_object_t obj) {
+    if (del.empty() || (uint8_t)del[0] >= SNAP_T_MAX) return false;
+    const snap_obj_info_t &info = _snap_obj_info[(uint8_t)del[0]];
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj), info.key, cps_api_qualifier_OBSERVED);
+    size_t off = 1;
+    while (off < del.size()) {
+        uint64_t aid;
+        uint16_t len;
+        if (off + sizeof(aid) + sizeof(len) > del.size()) return false;
+        memcpy(&aid, &del[off], sizeof(aid));
+        memcpy(&len, &del[off + sizeof(aid)], sizeof(len));
+        off += sizeof(aid) + sizeof(len);
+        if (off + len > del.size()) return false;
+        if (info.key_data != 0 && aid == info.key_data) {
+            cps_api_set_key_data(obj, info.key_data, cps_api_object_ATTR_T_U32, &del[off], len);
+        }
+        cps_api_object_attr_add(obj, (cps_api_attr_id_t)aid, &del[off], len);
+        off += len;
+    }
+    cps_api_object_set_type_operation(cps_api_object_key(obj), cps_api_oper_DELETE);
+    return true;
+}
+
+static void snap_publish_marker(const std::string &vrf_name, const snap_reconcile_t &stats, bool complete) {
+    char buff[CPS_API_MIN_OBJ_LEN];
+    cps_api_object_t obj = cps_api_object_init(buff, sizeof(buff));
+    cps_api_key_init(cps_api_object_key(obj), cps_api_qualifier_OBSERVED, cps_api_obj_cat_INTERFACE,
+                     cps_api_int_obj_NETLINK_RECONCILE, 0);
+    cps_api_object_attr_add(obj, cps_api_if_RECONCILE_A_VRF_NAME, vrf_name.c_str(), vrf_name.size() + 1);
+    cps_api_object_attr_add_u32(obj, cps_api_if_RECONCILE_A_PUBLISHED, stats.published);
+    cps_api_object_attr_add_u32(obj, cps_api_if_RECONCILE_A_UNCHANGED, stats.unchanged);
+    cps_api_object_attr_add_u32(obj, cps_api_if_RECONCILE_A_DELETED, stats.deleted);
+    cps_api_object_attr_add_u32(obj, cps_api_if_RECONCILE_A_COMPLETE, complete ? 1 : 0);
+    nas_os_publish_event(obj);
+    cps_api_object_delete(obj);
+}
+
+/* Publish the deletes of the snapshot objects of the VRF that were not seen and the marker */
+static void snap_vrf_reconciled(const std::string &vrf_name) {
+    snap_table_t gone;
+    snap_reconcile_t stats;
+    bool complete = false;
+    {
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        if (_snap_pending.erase(vrf_name) == 0) return;
+        auto it = _snap_old.find(vrf_name);
+        if (it != _snap_old.end()) {
+            gone.swap(it->second);
+            _snap_old.erase(it);
+        }
+        snap_reconcile_t &rec = _snap_reconcile[vrf_name];
+        rec.deleted = gone.size();
+        rec.done_us = std_get_uptime(NULL);
+        stats = rec;
+        complete = _snap_pending.empty();
+        if (!gone.empty()) _snap_dirty = true;
+    }
+
+    for (auto &it : gone) {
+        cps_api_object_t obj = nas_os_obj_pool_alloc(RTM_DELADDR);
+        if (obj == nullptr) continue;
+        if (snap_del_to_obj(it.second.del, obj)) {
+            nas_os_publish_event(obj);
+        }
+        nas_os_obj_pool_release(obj);
+    }
+    snap_publish_marker(vrf_name, stats, complete);
+
+    EV_LOGGING(NETLINK, NOTICE, "NL-SNAPSHOT", "VRF:%s reconciled published:%u unchanged:%u deleted:%u "
+               "time:%lums%s", vrf_name.c_str(), stats.published, stats.unchanged, stats.deleted,
+               (stats.done_us - _snap_start_us)/1000, complete ? " - reconciliation complete" : "");
+}
+
+static void snap_payload_add(std::string &out, const void *data, size_t len) {
+    out.append((const char *)data, len);
+}
+
+/* Serialize the live table, _snap_mutex is held */
+static uint64_t snap_serialize(std::string &payload) {
+    uint64_t count = 0;
+    for (auto &vit : _snap_live) {
+        uint16_t name_len = vit.first.size();
+        uint32_t cnt = vit.second.size();
+        snap_payload_add(payload, &name_len, sizeof(name_len));
+        snap_payload_add(payload, vit.first.data(), name_len);
+        snap_payload_add(payload, &cnt, sizeof(cnt));
+        for (auto &it : vit.second) {
+            uint16_t del_len = it.second.del.size();
+            snap_payload_add(payload, &it.first, sizeof(it.first));
+            snap_payload_add(payload, &it.second.content, sizeof(it.second.content));
+            snap_payload_add(payload, &del_len, sizeof(del_len));
+            snap_payload_add(payload, it.second.del.data(), del_len);
+        }
+        count += cnt;
+    }
+    return count;
+}
+
+static bool snap_write(const char *file, const std::string &payload) {
+    nas_os_snapshot_hdr_t hdr;
+    hdr.magic = NAS_OS_SNAPSHOT_MAGIC;
+    hdr.version = NAS_OS_SNAPSHOT_VERSION;
+    hdr.len = payload.size();
+    hdr.checksum = snap_hash(SNAP_HASH_INIT, payload.data(), payload.size());
+
+    std::string tmp = std::string(file) + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    if (fp == nullptr) {
+        EV_LOGGING(NETLINK, ERR, "NL-SNAPSHOT", "Failed to open %s err-no:%d", tmp.c_str(), errno);
+        return false;
+    }
+    bool rc = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1) &&
+              (payload.empty() || fwrite(payload.data(), payload.size(), 1, fp) == 1) &&
+              (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+    fclose(fp);
+    if (!rc || rename(tmp.c_str(), file) != 0) {
+        EV_LOGGING(NETLINK, ERR, "NL-SNAPSHOT", "Failed to write %s err-no:%d", file, errno);
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* Add the VRFs of a snapshot file to the ones being reconciled, _snap_mutex is held */
+static bool snap_load(const char *file) {
+    FILE *fp = fopen(file, "rb");
+    if (fp == nullptr) return false;
+
+    nas_os_snapshot_hdr_t hdr;
+    std::string payload;
+    bool rc = (fread(&hdr, sizeof(hdr), 1, fp) == 1) && hdr.magic == NAS_OS_SNAPSHOT_MAGIC &&
+              hdr.version == NAS_OS_SNAPSHOT_VERSION;
+    if (rc && hdr.len > 0) {
+        payload.resize(hdr.len);
+        rc = (fread(&payload[0], hdr.len, 1, fp) == 1);
+    }
+    fclose(fp);
+    if (!rc || snap_hash(SNAP_HASH_INIT, payload.data(), payload.size()) != hdr.checksum) {
+        EV_LOGGING(NETLINK, ERR, "NL-SNAPSHOT", "Ignoring invalid snapshot %s", file);
+        return false;
+    }
+
+    std::map<std::string, snap_table_t> old;
+    uint64_t load_cnt = 0;
+    size_t off = 0;
+    auto take = [&](void *data, size_t len) -> bool {
+        if (off + len > payload.size()) return false;
+        memcpy(data, &payload[off], len);
+        off += len;
+        return true;
+    };
+    while (off < payload.size()) {
+        uint16_t name_len;
+        uint32_t cnt;
+        std::string vrf_name;
+        if (!take(&name_len, sizeof(name_len))) break;
+        vrf_name.resize(name_len);
+        if ((name_len > 0 && !take(&vrf_name[0], name_len)) || !take(&cnt, sizeof(cnt))) break;
+
+        snap_table_t &table = old[vrf_name];
+        table.reserve(cnt);
+        for (uint32_t ix = 0; ix < cnt; ++ix) {
+            uint64_t ident;
+            uint16_t del_len;
+            snap_entry_t ent;
+            if (!take(&ident, sizeof(ident)) || !take(&ent.content, sizeof(ent.content)) ||
+                !take(&del_len, sizeof(del_len))) {
+                rc = false;
+                break;
+            }
+            ent.del.resize(del_len);
+            if (del_len > 0 && !take(&ent.del[0], del_len)) {
+                rc = false;
+                break;
+            }
+            table.emplace(ident, std::move(ent));
+        }
+        if (!rc) break;
+        load_cnt += cnt;
+    }
+    if (!rc || off != payload.size()) {
+        EV_LOGGING(NETLINK, ERR, "NL-SNAPSHOT", "Ignoring truncated snapshot %s", file);
+        return false;
+    }
+
+    for (auto &it : old) {
+        _snap_pending.insert(it.first);
+        _snap_tracked.insert(it.first);
+        _snap_old[it.first].swap(it.second);
+    }
+    _snap_tracked_cnt = _snap_tracked.size();
+    _snap_load_cnt += load_cnt;
+    return true;
+}
+
+static void snap_writer() {
+    while (true) {
+        std::vector<std::string> expired;
+        std::string payload;
+        uint64_t count = 0;
+        {
+            std::unique_lock<std::mutex> lock(_snap_mutex);
+            _snap_cv.wait_for(lock, std::chrono::seconds(NAS_OS_SNAPSHOT_PERIOD_SEC));
+
+            if (!_snap_pending.empty()) {
+                /* VRFs that are not back in time are reconciled as empty */
+                if (std_get_uptime(NULL) - _snap_start_us < NAS_OS_SNAPSHOT_RECONCILE_SEC * 1000000ULL) {
+                    continue;
+                }
+                expired.assign(_snap_pending.begin(), _snap_pending.end());
+            } else if (_snap_dirty) {
+                count = snap_serialize(payload);
+                _snap_dirty = false;
+            } else {
+                continue;
+            }
+        }
+
+        for (auto &vrf_name : expired) {
+            EV_LOGGING(NETLINK, NOTICE, "NL-SNAPSHOT", "VRF:%s not dumped in %us, reconciling",
+                       vrf_name.c_str(), NAS_OS_SNAPSHOT_RECONCILE_SEC);
+            snap_vrf_reconciled(vrf_name);
+        }
+        if (!expired.empty()) continue;
+
+        /* Written only once reconciled - until then the previous snapshot is still valid */
+        uint64_t start_us = std_get_uptime(NULL);
+        if (snap_write(NAS_OS_SNAPSHOT_FILE, payload)) {
+            std::lock_guard<std::mutex> lock(_snap_mutex);
+            _snap_write_us = std_get_uptime(NULL) - start_us;
+            _snap_write_len = payload.size();
+            _snap_write_cnt = count;
+        } else {
+            std::lock_guard<std::mutex> lock(_snap_mutex);
+            _snap_dirty = true;
+        }
+    }
+}
+
+extern "C" {
+
+t_std_error nas_os_snapshot_init(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        _snap_start_us = std_get_uptime(NULL);
+        _snap_loaded = snap_load(NAS_OS_SNAPSHOT_FILE);
+        _snap_load_us = std_get_uptime(NULL) - _snap_start_us;
+        /* Marker for the default VRF is published on cold start too */
+        _snap_pending.insert(NL_DEFAULT_VRF_NAME);
+        _snap_tracked.insert(NL_DEFAULT_VRF_NAME);
+        _snap_tracked_cnt = _snap_tracked.size();
+        _snap_dirty = true;
+    }
+    if (_snap_loaded) {
+        EV_LOGGING(NETLINK, NOTICE, "NL-SNAPSHOT", "Loaded %lu objects of %lu VRFs from %s in %lums",
+                   _snap_load_cnt, _snap_old.size(), NAS_OS_SNAPSHOT_FILE, _snap_load_us/1000);
+    }
+
+    std_thread_init_struct(&_snap_thr);
+    _snap_thr.name = "db-api-linux-snapshot";
+    _snap_thr.thread_function = (std_thread_function_t)snap_writer;
+    if (std_thread_create(&_snap_thr) != STD_ERR_OK) {
+        EV_LOGGING(NETLINK, ERR, "NL-SNAPSHOT", "Failed to create snapshot writer");
+        return STD_ERR(NAS_OS, FAIL, 0);
+    }
+    return STD_ERR_OK;
+}
+
+bool nas_os_snapshot_warm_restart(void)
+{
+    return _snap_loaded;
+}
+
+bool nas_os_snapshot_track(int rt_msg_type, const char *vrf_name, cps_api_object_t obj)
+{
+    snap_obj_type_t type;
+    /*
+     * Every published object of a VRF is applied to the live table so the snapshot is
+     * the current state, only the first dump is checked against the loaded snapshot
+     */
+    if (_snap_tracked_cnt == 0) return true;
+    if (vrf_name == nullptr || !snap_obj_type(rt_msg_type, obj, &type)) return true;
+
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    if (_snap_tracked.find(vrf_name) == _snap_tracked.end()) return true;
+
+    uint64_t ident = snap_ident_hash(type, obj);
+    bool del = (cps_api_object_type_operation(cps_api_object_key(obj)) == cps_api_oper_DELETE);
+    uint64_t content = del ? 0 : snap_content_hash(obj);
+
+    snap_table_t &live = _snap_live[vrf_name];
+    if (del) {
+        live.erase(ident);
+    } else {
+        snap_entry_t &ent = live[ident];
+        ent.content = content;
+        ent.del = snap_del_obj(type, obj);
+    }
+    _snap_dirty = true;
+
+    if (_snap_pending.find(vrf_name) == _snap_pending.end()) return true;
+
+    snap_reconcile_t &stats = _snap_reconcile[vrf_name];
+    auto vit = _snap_old.find(vrf_name);
+    if (vit != _snap_old.end()) {
+        auto it = vit->second.find(ident);
+        if (it != vit->second.end()) {
+            bool unchanged = (!del && it->second.content == content);
+            vit->second.erase(it);
+            if (unchanged) {
+                ++stats.unchanged;
+                return false;
+            }
+        }
+    }
+    ++stats.published;
+    return true;
+}
+
+void nas_os_snapshot_vrf_add(const char *vrf_name)
+{
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    _snap_tracked.insert(vrf_name);
+    _snap_tracked_cnt = _snap_tracked.size();
+}
+
+void nas_os_snapshot_vrf_synced(const char *vrf_name)
+{
+    snap_vrf_reconciled(vrf_name);
+}
+
+void nas_os_snapshot_vrf_del(const char *vrf_name)
+{
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    if (_snap_live.erase(vrf_name) != 0) _snap_dirty = true;
+    _snap_old.erase(vrf_name);
+    _snap_reconcile.erase(vrf_name);
+    _snap_pending.erase(vrf_name);
+    _snap_tracked.erase(vrf_name);
+    _snap_tracked_cnt = _snap_tracked.size();
+}
+
+t_std_error nas_os_snapshot_save(const char *file)
+{
+    std::string payload;
+    {
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        snap_serialize(payload);
+    }
+    return snap_write(file, payload) ? STD_ERR_OK : STD_ERR(NAS_OS, FAIL, 0);
+}
+
+t_std_error nas_os_snapshot_load(const char *file)
+{
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    return snap_load(file) ? STD_ERR_OK : STD_ERR(NAS_OS, FAIL, 0);
+}
+
+bool nas_os_snapshot_vrf_stats_get(const char *vrf_name, nas_os_snapshot_stats_t *stats)
+{
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    auto it = _snap_reconcile.find(vrf_name);
+    if (it == _snap_reconcile.end()) return false;
+
+    stats->published = it->second.published;
+    stats->unchanged = it->second.unchanged;
+    stats->deleted = it->second.deleted;
+    stats->reconciled = (it->second.done_us != 0);
+    return true;
+}
+
+void os_debug_snapshot_print ()
+{
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    printf("\r\n NETLINK SNAPSHOT file:%s %s load:%lu objects in %lums, last write:%lu objects "
+           "%lu bytes in %lums\r\n", NAS_OS_SNAPSHOT_FILE, _snap_loaded ? "warm-restart" : "cold-start",
+           _snap_load_cnt, _snap_load_us/1000, _snap_write_cnt, _snap_write_len, _snap_write_us/1000);
+    printf("\r %-16s %-10s %-10s %-10s %-10s %-10s %-12s\r\n", "VRF", "Objects", "Pending",
+           "Published", "Unchanged", "Deleted", "Reconciled(ms)");
+    printf("\r=========================================================================\r\n");
+    for (auto &vit : _snap_live) {
+        auto oit = _snap_old.find(vit.first);
+        auto rit = _snap_reconcile.find(vit.first);
+        snap_reconcile_t stats = {};
+        if (rit != _snap_reconcile.end()) stats = rit->second;
+        printf("\r %-16s %-10lu %-10lu %-10u %-10u %-10u %-12lu\r\n", vit.first.c_str(),
+               vit.second.size(), (oit != _snap_old.end()) ? oit->second.size() : 0,
+               stats.published, stats.unchanged, stats.deleted,
+               stats.done_us ? (stats.done_us - _snap_start_us)/1000 : 0);
+    }
+}
+
+}
@@ -31,33 +31,128 @@
 #include "nas_os_if_conversion_utils.h"
 #include "nas_os_mcast_snoop.h"
 #include "hal_if_mapping.h"
+#include "ds_api_linux_interface.h"
+#include "nas_linux_l2.h"
+#include "std_time_tools.h"
 
 #include <netinet/in.h>
 #include <linux/if_bridge.h>
 #include <sys/socket.h>
 
-#include <map>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <atomic>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * STP state of the kernel bridge ports indexed by ifindex. The state is read on every
+ * bridge port netlink event so the read path takes no lock: readers register in the
+ * current epoch, writers (serialized by _if_stp_mutex) replace the array when an
+ * ifindex does not fit and free the old one once the readers of both epochs drained.
+ */
+class os_stp_state_table {
+    static const uint8_t STATE_NONE = 0xff;
+    static const size_t MIN_SIZE = 4096;
+    static const size_t MAX_SIZE = (1 << 24);
+
+    struct table_t {
+        size_t size;
+        std::atomic<uint8_t> *state;
+    };
+
+    std::atomic<table_t *> table_;
+    std::atomic<uint64_t> epoch_;
+    std::atomic<uint64_t> readers_[2];
+
+    static table_t * alloc(size_t size) {
+        table_t *t = new table_t;
+        t->size = size;
+        t->state = new std::atomic<uint8_t>[size];
+        for (size_t ix = 0; ix < size; ++ix) t->state[ix].store(STATE_NONE, std::memory_order_relaxed);
+        return t;
+    }
+
+    void wait_readers() {
+        for (int flip = 0; flip < 2; ++flip) {
+            uint64_t e = epoch_.fetch_add(1);
+            while (readers_[e & 1].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool grow(hal_ifindex_t index) {
+        if ((size_t)index >= MAX_SIZE) return false;
+        table_t *cur = table_.load();
+        size_t size = cur->size;
+        while (size <= (size_t)index) size <<= 1;
+
+        table_t *t = alloc(size);
+        for (size_t ix = 0; ix < cur->size; ++ix) {
+            t->state[ix].store(cur->state[ix].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        table_.store(t);
+        wait_readers();
+        delete [] cur->state;
+        delete cur;
+        return true;
+    }
+
+public:
+    os_stp_state_table() : table_(alloc(MIN_SIZE)), epoch_(0) {
+        readers_[0] = 0;
+        readers_[1] = 0;
+    }
+
+    bool get(hal_ifindex_t index, uint8_t *state) {
+        uint64_t e = epoch_.load();
+        readers_[e & 1].fetch_add(1);
+        table_t *t = table_.load();
+        uint8_t val = ((size_t)index < t->size) ? t->state[index].load(std::memory_order_acquire) : STATE_NONE;
+        readers_[e & 1].fetch_sub(1);
+
+        if (val == STATE_NONE) return false;
+        *state = val;
+        return true;
+    }
+
+    /* Called with _if_stp_mutex held */
+    bool set(hal_ifindex_t index, uint8_t state) {
+        if (index < 0) return false;
+        if ((size_t)index >= table_.load()->size && !grow(index)) return false;
+        table_.load()->state[index].store(state, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() { return table_.load()->size; }
+};
 
 static std::mutex _if_stp_mutex;
-static auto _if_stp_state = new std::map<hal_ifindex_t,uint8_t>;
+static auto & _if_stp_state = *(new os_stp_state_table);
 static const size_t os_stp_fwd_state = 3;
 #define NL_MSG_BUFF_LEN 4096
+/* Bulk updates are sent in batches of back to back SETLINK messages */
+#define NL_STP_BATCH_LEN (32*1024)
+#define NL_STP_MSG_LEN 64
 
 extern "C"{
 
 t_std_error get_if_stp_state(hal_ifindex_t index, uint8_t * state){
-    std::lock_guard<std::mutex> lock(_if_stp_mutex);
-    auto it = _if_stp_state->find(index);
-    if(it != _if_stp_state->end()){
-        *state = it->second;
+    if(_if_stp_state.get(index,state)){
         return STD_ERR_OK;
     }
     return STD_ERR(STG,FAIL,0);
 }
 
 
-static bool _is_untagged_member_of_vlan(hal_ifindex_t ifindex, hal_vlan_id_t vlan_id){
+static bool _get_vlan_bridge_ifindex(hal_vlan_id_t vlan_id, hal_ifindex_t & br_ifindex){
     interface_ctrl_t intf_ctrl;
     memset(&intf_ctrl,0,sizeof(interface_ctrl_t));
     intf_ctrl.q_type = HAL_INTF_INFO_FROM_VLAN;
@@ -67,18 +162,53 @@ static bool _is_untagged_member_of_vlan(hal_ifindex_t ifindex, hal_vlan_id_t vla
     if(dn_hal_get_interface_info(&intf_ctrl) != STD_ERR_OK){
         return false;
     }
+    br_ifindex = intf_ctrl.if_index;
+    return true;
+}
 
-    return nas_os_is_port_part_of_vlan(intf_ctrl.if_index,ifindex);
+static bool _is_untagged_member_of_vlan(hal_ifindex_t ifindex, hal_vlan_id_t vlan_id){
+    hal_ifindex_t br_ifindex;
+    if(!_get_vlan_bridge_ifindex(vlan_id,br_ifindex)){
+        return false;
+    }
+
+    return nas_os_is_port_part_of_vlan(br_ifindex,ifindex);
 
 }
 
+/*
+ * Build the AF_BRIDGE RTM_SETLINK setting the port state in a zeroed buffer,
+ * returns NULL if the buffer is too small
+ */
+static struct nlmsghdr * _nl_stp_msg_build(void *buff, size_t len, hal_ifindex_t ifindex, uint8_t state){
+    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff,len,sizeof(struct nlmsghdr));
+    if(nlh == NULL) return NULL;
+    struct ifinfomsg *ifmsg = (struct ifinfomsg *) nlmsg_reserve(nlh,len,sizeof(struct ifinfomsg));
+    if(ifmsg == NULL) return NULL;
+
+    nlh->nlmsg_pid = 0 ;
+    nlh->nlmsg_seq = 0 ;
+    nlh->nlmsg_flags =  NLM_F_REQUEST | BRIDGE_FLAGS_MASTER ;
+    nlh->nlmsg_type = RTM_SETLINK ;
+
+    ifmsg->ifi_family = AF_BRIDGE;
+    ifmsg->ifi_index = ifindex;
+
+    struct nlattr *stp_attr = nlmsg_nested_start(nlh, len);
+    if(stp_attr == NULL) return NULL;
+    stp_attr->nla_len = 0;
+    stp_attr->nla_type = IFLA_PROTINFO | NLA_F_NESTED;
+    if(nlmsg_add_attr(nlh,len,IFLA_BRPORT_STATE,(void *)&state,sizeof(uint8_t)) == -1) return NULL;
+    nlmsg_nested_end(nlh, stp_attr);
+    return nlh;
+}
+
 t_std_error nl_int_update_stp_state(cps_api_object_t obj){
     std::lock_guard<std::mutex> lock(_if_stp_mutex);
     cps_api_object_attr_t ifindex = cps_api_object_attr_get(obj,BASE_STG_ENTRY_INTF_IF_INDEX_IFINDEX);
     cps_api_object_attr_t stp_state = cps_api_object_attr_get(obj,BASE_STG_ENTRY_INTF_STATE);
     cps_api_object_attr_t vlan_id_attr = cps_api_object_attr_get(obj,BASE_STG_ENTRY_VLAN);
     cps_api_object_attr_t os_update_attr = cps_api_object_attr_get(obj,BASE_STG_ENTRY_INTF_IF);
-    cps_api_object_attr_t if_name_attr = cps_api_object_attr_get(obj,BASE_STG_ENTRY_INTF_IF_NAME);
 
 
     if(ifindex == NULL || stp_state == NULL){
@@ -94,26 +224,21 @@ t_std_error nl_int_update_stp_state(cps_api_object_t obj){
     if(vlan_id_attr != NULL){
         vlan_id = cps_api_object_attr_data_u32(vlan_id_attr);
 
-        if(if_name_attr){
-            const char * intf_name = (const char *)cps_api_object_attr_data_bin(if_name_attr);
-            char vlan_intf_name[HAL_IF_NAME_SZ+1];
-            snprintf(vlan_intf_name,sizeof(vlan_intf_name)-1,"%s.%d",intf_name,vlan_id);
-            if(!get_tagged_intf_index_from_name(vlan_intf_name,vlan_ifindex)){
-                /*
-                 * If tagged interfaces is not part of vlan check if  untagged port
-                 * is part of vlan. if not return
-                 */
-                if(!_is_untagged_member_of_vlan(phy_ifindex,vlan_id)){
-                    return STD_ERR_OK;
-                }
+        if(!nas_os_tagged_intf_get(phy_ifindex,vlan_id,&vlan_ifindex)){
+            /*
+             * If tagged interfaces is not part of vlan check if  untagged port
+             * is part of vlan. if not return
+             */
+            if(!_is_untagged_member_of_vlan(phy_ifindex,vlan_id)){
+                return STD_ERR_OK;
             }
         }
     }
 
     uint8_t state = cps_api_object_attr_data_u32(stp_state);
 
-    auto state_it = _if_stp_state->find(vlan_ifindex);
-    if( state_it != _if_stp_state->end()){
+    uint8_t cur_state;
+    if(_if_stp_state.get(vlan_ifindex,&cur_state)){
         /*
          * To prevent race condition for eg. port was in disabled and becomes oper up
          * kernel puts it in fwd, at that time this function will be invoked to put it
@@ -122,11 +247,11 @@ t_std_error nl_int_update_stp_state(cps_api_object_t obj){
          * state being programmed in the kernel is changed then don't update it
          */
         if(os_update_attr){
-            if (state != state_it->second){
+            if (state != cur_state){
                 return STD_ERR_OK;
             }
         }else{
-            if(state == state_it->second){
+            if(state == cur_state){
                 if(vlan_id && state == os_stp_fwd_state){
                     nas_os_refresh_mcast_querier_status(vlan_id);
                 }
@@ -138,22 +263,7 @@ t_std_error nl_int_update_stp_state(cps_api_object_t obj){
 
     char buff[NL_MSG_BUFF_LEN];
     memset(buff,0,sizeof(buff));
-    struct nlmsghdr *nlh = (struct nlmsghdr *) nlmsg_reserve((struct nlmsghdr *)buff,sizeof(buff),sizeof(struct nlmsghdr));
-    struct ifinfomsg *ifmsg = (struct ifinfomsg *) nlmsg_reserve(nlh,sizeof(buff),sizeof(struct ifinfomsg));
-
-    nlh->nlmsg_pid = 0 ;
-    nlh->nlmsg_seq = 0 ;
-    nlh->nlmsg_flags =  NLM_F_REQUEST | BRIDGE_FLAGS_MASTER ;
-    nlh->nlmsg_type = RTM_SETLINK ;
-
-    ifmsg->ifi_family = AF_BRIDGE;
-    ifmsg->ifi_index = vlan_ifindex;
-
-    struct nlattr *stp_attr = nlmsg_nested_start(nlh, sizeof(buff));
-    stp_attr->nla_len = 0;
-    stp_attr->nla_type = IFLA_PROTINFO | NLA_F_NESTED;
-    nlmsg_add_attr(nlh,sizeof(buff),IFLA_BRPORT_STATE,(void *)&state,sizeof(uint8_t));
-    nlmsg_nested_end(nlh, stp_attr);
+    struct nlmsghdr *nlh = _nl_stp_msg_build(buff,sizeof(buff),vlan_ifindex,state);
 
     if(nl_do_set_request(NL_DEFAULT_VRF_NAME, nas_nl_sock_T_INT,nlh, buff, sizeof(buff)) != STD_ERR_OK){
         EV_LOG(ERR,NAS_L2,0,"NAS_LINUX-STG","Failed to updated STP State to %d for Interface %d "
@@ -162,10 +272,8 @@ t_std_error nl_int_update_stp_state(cps_api_object_t obj){
     }
 
     EV_LOGGING(NAS_OS,DEBUG,"NAS-STG","Updating the state tp %d for port %d in vlan %d",state,vlan_ifindex,vlan_id);
-    if(state_it == _if_stp_state->end()){
-        _if_stp_state->insert({vlan_ifindex,state});
-    }else{
-        state_it->second = state;
+    if(!_if_stp_state.set(vlan_ifindex,state)){
+        EV_LOGGING(NAS_OS,ERR,"NAS-STG","Interface %d out of range of the STP state table",vlan_ifindex);
     }
     /*
      * When STP state of a port changes to forwarding, check if the querier status is enabled for the bridge for which state
@@ -184,4 +292,161 @@ t_std_error nl_int_update_stp_state(cps_api_object_t obj){
     return STD_ERR_OK;
 }
 
+/*
+ * Resolve the kernel interface (tagged sub-interface or untagged port) of every
+ * (port, vlan) pair, the last state wins if several pairs map to the same interface.
+ * entry_target is the target of each entry, NL_STP_NO_TARGET if it is not a VLAN member.
+ */
+#define NL_STP_NO_TARGET ((size_t)-1)
+
+static void _resolve_stp_bulk(const nas_os_stp_port_state_t *entries, size_t count,
+                              std::vector<std::pair<hal_ifindex_t,uint8_t>> & targets,
+                              std::unordered_map<hal_ifindex_t,hal_vlan_id_t> & target_vlan,
+                              std::vector<size_t> & entry_target){
+    std::unordered_map<hal_vlan_id_t,hal_ifindex_t> vlan_bridges;
+    std::unordered_map<hal_ifindex_t,size_t> target_pos;
+
+    entry_target.assign(count,NL_STP_NO_TARGET);
+    for(size_t ix = 0; ix < count; ++ix){
+        hal_ifindex_t target = entries[ix].ifindex;
+        hal_vlan_id_t vlan_id = entries[ix].vlan_id;
+
+        if(vlan_id != 0){
+            if(!nas_os_tagged_intf_get(entries[ix].ifindex,vlan_id,&target)){
+                auto br_it = vlan_bridges.find(vlan_id);
+                if(br_it == vlan_bridges.end()){
+                    hal_ifindex_t br_ifindex = 0;
+                    if(!_get_vlan_bridge_ifindex(vlan_id,br_ifindex)){
+                        br_ifindex = 0;
+                    }
+                    br_it = vlan_bridges.insert({vlan_id,br_ifindex}).first;
+                }
+                if(br_it->second == 0 || !nas_os_is_port_part_of_vlan(br_it->second,entries[ix].ifindex)){
+                    continue;
+                }
+                target = entries[ix].ifindex;
+            }
+        }
+
+        auto pos_it = target_pos.find(target);
+        if(pos_it == target_pos.end()){
+            target_pos[target] = targets.size();
+            entry_target[ix] = targets.size();
+            targets.push_back({target,entries[ix].state});
+        }else{
+            entry_target[ix] = pos_it->second;
+            targets[pos_it->second].second = entries[ix].state;
+        }
+        if(vlan_id != 0) target_vlan[target] = vlan_id;
+    }
+}
+
+t_std_error nl_int_update_stp_state_bulk(const nas_os_stp_port_state_t *entries, size_t count, int *err){
+    if(entries == NULL || count == 0){
+        return STD_ERR_OK;
+    }
+
+    uint64_t start_us = std_get_uptime(NULL);
+    std::vector<std::pair<hal_ifindex_t,uint8_t>> targets;
+    std::unordered_map<hal_ifindex_t,hal_vlan_id_t> target_vlan;
+    std::vector<size_t> entry_target;
+    targets.reserve(count);
+    _resolve_stp_bulk(entries,count,targets,target_vlan,entry_target);
+
+    /* errno of each target, 0 if programmed or already in the state */
+    std::vector<int> target_err(targets.size(),0);
+
+    int sock = nas_nl_sock_create(NL_DEFAULT_VRF_NAME,nas_nl_sock_T_INT,false);
+    if(sock == -1){
+        int rc = errno;
+        EV_LOGGING(NAS_OS,ERR,"NAS-STG","Failed to create socket for bulk STP update err-no:%d",rc);
+        if(err != NULL){
+            for(size_t ix = 0; ix < count; ++ix){
+                err[ix] = (entry_target[ix] == NL_STP_NO_TARGET) ? 0 : rc;
+            }
+        }
+        return STD_ERR(STG,FAIL,0);
+    }
+
+    std::vector<char> batch(NL_STP_BATCH_LEN);
+    std::vector<size_t> batch_pos;      /* targets sent in the batch */
+    std::unordered_set<hal_vlan_id_t> fwd_vlans;
+    size_t msg_len = NLMSG_ALIGN(NL_STP_MSG_LEN);
+    size_t sent = 0, failed = 0;
+    uint32_t seq_base = (uint32_t)std_get_uptime(NULL);
+
+    std::lock_guard<std::mutex> lock(_if_stp_mutex);
+
+    size_t first = 0;
+    while(first < targets.size()){
+        size_t off = 0, last = first;
+        batch_pos.clear();
+        for(; last < targets.size() && off + msg_len <= batch.size(); ++last){
+            hal_ifindex_t ifindex = targets[last].first;
+            uint8_t state = targets[last].second;
+            auto vlan_it = target_vlan.find(ifindex);
+            if(vlan_it != target_vlan.end() && state == os_stp_fwd_state){
+                fwd_vlans.insert(vlan_it->second);
+            }
+
+            uint8_t cur_state;
+            if(_if_stp_state.get(ifindex,&cur_state) && cur_state == state){
+                continue;
+            }
+
+            memset(&batch[off],0,msg_len);
+            struct nlmsghdr *nlh = _nl_stp_msg_build(&batch[off],msg_len,ifindex,state);
+            if(nlh == NULL){
+                target_err[last] = ENOBUFS;
+                continue;
+            }
+            /* Cached only once the kernel acked it, a rejected port is sent again next time */
+            nlh->nlmsg_seq = seq_base + last;
+            nlh->nlmsg_flags |= NLM_F_ACK;
+            off += NLMSG_ALIGN(nlh->nlmsg_len);
+            target_err[last] = -1;
+            batch_pos.push_back(last);
+        }
+        if(!batch_pos.empty()){
+            if(nl_send_nlmsg_batch(sock,&batch[0],off)){
+                nl_read_batch_acks(sock,seq_base,first,last,batch_pos.size(),&target_err[0]);
+            }else{
+                int rc = errno;
+                for(auto pos : batch_pos) target_err[pos] = rc;
+            }
+        }
+        for(auto pos : batch_pos){
+            if(target_err[pos] != 0) continue;
+            _if_stp_state.set(targets[pos].first,targets[pos].second);
+            ++sent;
+        }
+        for(size_t pos = first; pos < last; ++pos){
+            if(target_err[pos] == 0) continue;
+            EV_LOGGING(NAS_OS,ERR,"NAS-STG","Failed to update STP state to %d for interface %d "
+                       "in kernel err-no:%d",targets[pos].second,targets[pos].first,target_err[pos]);
+            ++failed;
+        }
+        first = last;
+    }
+    close(sock);
+
+    /*
+     * Same 3.16 kernel querier limitation as the single update, refreshed once per VLAN
+     * @TODO - remove this when moved to stretch distribution where kernel would be upgraded to 4.9
+     */
+    for(auto vlan_id : fwd_vlans){
+        nas_os_refresh_mcast_querier_status(vlan_id);
+    }
+
+    if(err != NULL){
+        for(size_t ix = 0; ix < count; ++ix){
+            err[ix] = (entry_target[ix] == NL_STP_NO_TARGET) ? 0 : target_err[entry_target[ix]];
+        }
+    }
+
+    EV_LOGGING(NAS_OS,INFO,"NAS-STG","Bulk STP update entries:%zu interfaces:%zu programmed:%zu failed:%zu "
+               "in %" PRIu64 "us",count,targets.size(),sent,failed,std_get_uptime(NULL) - start_us);
+    return (failed == 0) ? STD_ERR_OK : STD_ERR(STG,FAIL,0);
+}
+
 }
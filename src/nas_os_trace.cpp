@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_os_trace.cpp
+ * \brief  Rate limited in-memory trace ring for the netlink hot paths
+ */
+
+#include "nas_os_trace.h"
+#include "std_time_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+
+/*
+ * Writers reserve a slot with a single fetch_add on the ring head and publish it with
+ * the slot sequence number (0 while the slot is being written), so the netlink thread
+ * and the CPS handler threads never block each other. The dump skips the slots whose
+ * sequence changed while they were copied. Records are formatted by the dump only.
+ */
+
+#define NAS_OS_TRACE_RING_SIZE  4096    /* Must be a power of 2 */
+#define NAS_OS_TRACE_MSG_LEN    256
+
+typedef struct {
+    std::atomic<uint64_t> seq;
+    uint64_t ts_us;
+    const nas_os_trace_site_t *site;
+    uint32_t tid;
+    uint32_t nargs;
+    uint64_t args[NAS_OS_TRACE_MAX_ARGS];
+} nas_os_trace_rec_t;
+
+volatile bool nas_os_trace_on = false;
+
+static auto _trace_ring = new nas_os_trace_rec_t[NAS_OS_TRACE_RING_SIZE]();
+static std::atomic<uint64_t> _trace_head(0);
+static std::atomic<uint64_t> _trace_start(0);
+static std::atomic<nas_os_trace_site_t *> _trace_sites(nullptr);
+
+static std::atomic<uint32_t> _trace_rate(100);
+static std::atomic<uint32_t> _trace_burst(200);
+
+static void nas_os_trace_register(nas_os_trace_site_t *site)
+{
+    if (__atomic_test_and_set(&site->registered, __ATOMIC_ACQ_REL)) return;
+
+    nas_os_trace_site_t *head = _trace_sites.load();
+    do {
+        site->next = head;
+    } while (!_trace_sites.compare_exchange_weak(head, site));
+}
+
+/* Format a binary record with the integer conversions of the site format */
+static void nas_os_trace_format(const char *fmt, const uint64_t *args, uint32_t nargs,
+                                char *out, size_t len)
+{
+    size_t pos = 0;
+    uint32_t arg = 0;
+
+    while (*fmt != '\0' && pos + 1 < len) {
+        if (*fmt != '%' || fmt[1] == '%') {
+            out[pos++] = *fmt;
+            fmt += (*fmt == '%') ? 2 : 1;
+            continue;
+        }
+        /* Flags, width and precision are kept, the length modifier decides the cast */
+        char spec[32];
+        size_t sl = 0;
+        spec[sl++] = *fmt++;
+        while (*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL && sl < 16) {
+            spec[sl++] = *fmt++;
+        }
+        int lng = 0;
+        while (*fmt != '\0' && strchr("hlLqjzt", *fmt) != NULL) {
+            lng += (*fmt == 'h') ? -1 : 1;
+            ++fmt;
+        }
+        char conv = *fmt;
+        if (conv == '\0') break;
+        ++fmt;
+
+        uint64_t val = (arg < nargs) ? args[arg] : 0;
+        ++arg;
+        int n = 0;
+        size_t room = len - pos;
+        if (strchr("di", conv) != NULL) {
+            long long v = (lng <= -2) ? (signed char)val : (lng == -1) ? (short)val :
+                          (lng == 0) ? (int)val : (long long)val;
+            memcpy(&spec[sl], "lld", 4);
+            n = snprintf(out + pos, room, spec, v);
+        } else if (strchr("uxXo", conv) != NULL) {
+            unsigned long long v = (lng <= -2) ? (unsigned char)val : (lng == -1) ? (unsigned short)val :
+                                   (lng == 0) ? (unsigned int)val : (unsigned long long)val;
+            spec[sl++] = 'l';
+            spec[sl++] = 'l';
+            spec[sl++] = conv;
+            spec[sl] = '\0';
+            n = snprintf(out + pos, room, spec, v);
+        } else if (conv == 'c') {
+            spec[sl++] = 'c';
+            spec[sl] = '\0';
+            n = snprintf(out + pos, room, spec, (int)val);
+        } else if (conv == 'p') {
+            spec[sl++] = 'p';
+            spec[sl] = '\0';
+            n = snprintf(out + pos, room, spec, (void *)(uintptr_t)val);
+        } else {
+            n = snprintf(out + pos, room, "?");
+        }
+        if (n < 0) break;
+        pos = ((size_t)n >= room) ? len - 1 : pos + n;
+    }
+    out[pos] = '\0';
+}
+
+extern "C" {
+
+bool nas_os_trace_admit(nas_os_trace_site_t *site)
+{
+    nas_os_trace_register(site);
+
+    /* Another thread is refilling this site - treat as rate limited */
+    if (__atomic_test_and_set(&site->lock, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&site->dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    uint64_t now = std_get_uptime(NULL);
+    uint32_t rate = _trace_rate.load(std::memory_order_relaxed);
+    uint32_t burst = _trace_burst.load(std::memory_order_relaxed);
+
+    if (rate != 0 && now > site->refill_us) {
+        uint64_t add = ((now - site->refill_us) * rate) / 1000000;
+        if (add > 0) {
+            site->tokens = (site->tokens + add > burst) ? burst : (uint32_t)(site->tokens + add);
+            site->refill_us = now;
+        }
+    }
+
+    bool admit = (rate == 0) || (site->tokens > 0);
+    if (admit && rate != 0) {
+        site->tokens--;
+    }
+    __atomic_clear(&site->lock, __ATOMIC_RELEASE);
+
+    if (!admit) {
+        __atomic_fetch_add(&site->dropped, 1, __ATOMIC_RELAXED);
+    }
+    return admit;
+}
+
+void nas_os_trace_write(nas_os_trace_site_t *site, const uint64_t *args, size_t nargs)
+{
+    static thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+
+    uint64_t idx = _trace_head.fetch_add(1, std::memory_order_relaxed);
+    nas_os_trace_rec_t &rec = _trace_ring[idx & (NAS_OS_TRACE_RING_SIZE - 1)];
+
+    rec.seq.store(0, std::memory_order_relaxed);
+    /* Record is not seen half written with the previous sequence */
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (nargs > NAS_OS_TRACE_MAX_ARGS) nargs = NAS_OS_TRACE_MAX_ARGS;
+    rec.ts_us = std_get_uptime(NULL);
+    rec.site = site;
+    rec.tid = tid;
+    rec.nargs = (uint32_t)nargs;
+    memcpy(rec.args, args, nargs * sizeof(args[0]));
+
+    rec.seq.store(idx + 1, std::memory_order_release);
+    __atomic_fetch_add(&site->written, 1, __ATOMIC_RELAXED);
+}
+
+void nas_os_trace_enable(bool enable)
+{
+    nas_os_trace_on = enable;
+}
+
+void nas_os_trace_rate_set(uint32_t rate_per_sec, uint32_t burst)
+{
+    _trace_rate = rate_per_sec;
+    _trace_burst = (burst == 0) ? 1 : burst;
+}
+
+void nas_os_trace_clear(void)
+{
+    _trace_start = _trace_head.load();
+}
+
+void nas_os_trace_stats_get(uint64_t *written, uint64_t *dropped)
+{
+    *written = *dropped = 0;
+    for (nas_os_trace_site_t *site = _trace_sites.load(); site != nullptr; site = site->next) {
+        *written += __atomic_load_n(&site->written, __ATOMIC_RELAXED);
+        *dropped += __atomic_load_n(&site->dropped, __ATOMIC_RELAXED);
+    }
+}
+
+void os_debug_trace_print (uint32_t count)
+{
+    uint64_t head = _trace_head.load();
+    uint64_t start = _trace_start.load();
+    if (head - start > NAS_OS_TRACE_RING_SIZE) start = head - NAS_OS_TRACE_RING_SIZE;
+    if (count != 0 && head - start > count) start = head - count;
+
+    printf("\r\n NAS OS TRACE %s rate:%u/s burst:%u records:%lu\r\n",
+           nas_os_trace_on ? "enabled" : "disabled", _trace_rate.load(), _trace_burst.load(),
+           (unsigned long)(head - start));
+    printf("\r=========================================================================\r\n");
+
+    char msg[NAS_OS_TRACE_MSG_LEN];
+    for (uint64_t idx = start; idx < head; ++idx) {
+        nas_os_trace_rec_t &slot = _trace_ring[idx & (NAS_OS_TRACE_RING_SIZE - 1)];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != idx + 1) continue;
+
+        uint64_t ts_us = slot.ts_us;
+        const nas_os_trace_site_t *site = slot.site;
+        uint32_t tid = slot.tid;
+        uint32_t nargs = slot.nargs;
+        uint64_t args[NAS_OS_TRACE_MAX_ARGS];
+        memcpy(args, slot.args, sizeof(args));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        /* Overwritten by a writer while copying */
+        if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+
+        if (nargs > NAS_OS_TRACE_MAX_ARGS) nargs = NAS_OS_TRACE_MAX_ARGS;
+        nas_os_trace_format(site->fmt, args, nargs, msg, sizeof(msg));
+        printf("\r [%lu.%06lu] tid:%u %s %s:%d %s\r\n",
+               (unsigned long)(ts_us / 1000000), (unsigned long)(ts_us % 1000000),
+               tid, site->id, site->file, site->line, msg);
+    }
+
+    printf("\r\n %-20s %-40s %-14s %-14s\r\n", "ID", "Site", "Written", "Rate-limited");
+    printf("\r=========================================================================\r\n");
+    for (nas_os_trace_site_t *site = _trace_sites.load(); site != nullptr; site = site->next) {
+        char loc[64];
+        snprintf(loc, sizeof(loc), "%s:%d", site->file, site->line);
+        printf("\r %-20s %-40s %-14lu %-14lu\r\n", site->id, loc,
+               (unsigned long)site->written, (unsigned long)site->dropped);
+    }
+}
+
+}
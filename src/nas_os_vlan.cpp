@@ -38,6 +38,7 @@
 #include "std_utils.h"
 #include "nas_os_if_conversion_utils.h"
 #include "nas_os_l3_utils.h"
+#include "nas_os_br_attr.h"
 
 #include <sys/socket.h>
 #include <stdio.h>
@@ -47,11 +48,17 @@
 #include <unordered_set>
 #include <mutex>
 #include <map>
+#include <vector>
 
 
 static std::mutex _intf_mutex;
 static auto & _intf_to_tagged_intf_map = *(new std::unordered_map<hal_ifindex_t,std::unordered_set<hal_ifindex_t>>);
-static auto & _intf_str_to_tagged_ifindex_map = *(new std::map<std::string,hal_ifindex_t>);
+/*
+ * Tagged sub-interface index keyed by (parent ifindex, vlan id) and its reverse,
+ * filled from the configuration paths and from the kernel link events
+ */
+static auto & _tagged_intf_index = *(new std::unordered_map<uint64_t,hal_ifindex_t>);
+static auto & _tagged_intf_parent = *(new std::unordered_map<hal_ifindex_t,std::pair<hal_ifindex_t,hal_vlan_id_t>>);
 const static int MAX_CPS_MSG_BUFF=4096;
 
 /*
@@ -63,24 +70,13 @@ extern "C"{
 
 bool nas_os_set_bridge_default_mac_ageing(hal_ifindex_t br_index)
 {
-    const std::string SYSFS_CLASS_NET = "/sys/class/net/";
-
-    char intf_name[HAL_IF_NAME_SZ+1];
-    if(cps_api_interface_if_index_to_name(br_index,intf_name,sizeof(intf_name))==NULL){
-        EV_LOGGING(NAS_OS,ERR,"NAS-LINUX-INTERFACE","Invalid Interface Index %d ",br_index);
-        return false;
+    long ageing = 0;
+    if(nas_os_br_attr_get(br_index,NULL,NAS_OS_BR_ATTR_AGEING_TIME,&ageing) &&
+       ageing == (long)default_bridge_mac_ageing){
+        return true;
     }
-    std::string age_str =  SYSFS_CLASS_NET + std::string(intf_name) + "/bridge/ageing_time";
-    FILE *f = fopen(age_str.c_str(),"w");
-    if(f){
-       if(fprintf(f,"%ld\n",default_bridge_mac_ageing)< 0){
-           EV_LOGGING(NAS_OS,ERR,"NAS-OS","Failed to set mac ageing for bridge index %d",br_index);
-           fclose(f);
-           return false;
-       }
-       fclose(f);
-    }else{
-        EV_LOGGING(NAS_OS,ERR,"NAS-OS","Path %s does not exist",age_str.c_str());
+    if(!nas_os_br_attr_set(br_index,NULL,NAS_OS_BR_ATTR_AGEING_TIME,default_bridge_mac_ageing)){
+        EV_LOGGING(NAS_OS,ERR,"NAS-OS","Failed to set mac ageing for bridge index %d",br_index);
         return false;
     }
 
@@ -89,37 +85,89 @@ bool nas_os_set_bridge_default_mac_ageing(hal_ifindex_t br_index)
     return true;
 }
 
+t_std_error nas_os_set_bridge_default_mac_ageing_bulk(const hal_ifindex_t *br_index, size_t count)
+{
+    std::vector<nas_os_br_attr_cfg_t> cfg;
+    cfg.reserve(count);
+    for(size_t ix = 0; ix < count; ++ix){
+        long ageing = 0;
+        if(nas_os_br_attr_get(br_index[ix],NULL,NAS_OS_BR_ATTR_AGEING_TIME,&ageing) &&
+           ageing == (long)default_bridge_mac_ageing){
+            continue;
+        }
+        nas_os_br_attr_cfg_t ent;
+        memset(&ent,0,sizeof(ent));
+        ent.br_index = br_index[ix];
+        ent.attr_mask = NAS_OS_BR_ATTR_BIT(NAS_OS_BR_ATTR_AGEING_TIME);
+        ent.val[NAS_OS_BR_ATTR_AGEING_TIME] = default_bridge_mac_ageing;
+        cfg.push_back(ent);
+    }
+    if(cfg.empty()) return STD_ERR_OK;
+
+    t_std_error rc = nas_os_br_attr_set_bulk(&cfg[0],cfg.size(),NULL);
+    if(rc != STD_ERR_OK){
+        EV_LOGGING(NAS_OS,ERR,"NAS-OS","Failed to set mac ageing for some of %lu bridges",cfg.size());
+        return rc;
+    }
+
+    EV_LOGGING(NAS_OS,INFO,"NAS-OS","Setted mac ageing for %lu bridges",cfg.size());
+    return STD_ERR_OK;
+}
+
 }
 
-void _update_intf_to_tagged_intf_map(hal_ifindex_t ifname, hal_ifindex_t vlan_index, bool add){
-    std::lock_guard<std::mutex> lock(_intf_mutex);
-    char if_name[HAL_IF_NAME_SZ+1];
-    memset(if_name,0,sizeof(if_name));
+static inline uint64_t _tagged_intf_key(hal_ifindex_t parent, hal_vlan_id_t vlan_id){
+    return ((uint64_t)(uint32_t)parent << 16) | vlan_id;
+}
 
-    if(cps_api_interface_if_index_to_name(vlan_index, if_name, sizeof(if_name)) == NULL){
-        return;
+/* Called with _intf_mutex held */
+static void _tagged_intf_index_del(hal_ifindex_t vlan_index){
+    auto it = _tagged_intf_parent.find(vlan_index);
+    if(it == _tagged_intf_parent.end()) return;
+
+    auto idx_it = _tagged_intf_index.find(_tagged_intf_key(it->second.first,it->second.second));
+    if(idx_it != _tagged_intf_index.end() && idx_it->second == vlan_index){
+        _tagged_intf_index.erase(idx_it);
     }
+    _tagged_intf_parent.erase(it);
+}
+
+/* Called with _intf_mutex held */
+static void _tagged_intf_index_add(hal_ifindex_t parent, hal_vlan_id_t vlan_id, hal_ifindex_t vlan_index){
+    _tagged_intf_index_del(vlan_index);
+
+    auto & cur = _tagged_intf_index[_tagged_intf_key(parent,vlan_id)];
+    if(cur != 0 && cur != vlan_index){
+        _tagged_intf_parent.erase(cur);
+    }
+    cur = vlan_index;
+    _tagged_intf_parent[vlan_index] = std::make_pair(parent,vlan_id);
+}
+
+void _update_intf_to_tagged_intf_map(hal_ifindex_t ifindex, hal_vlan_id_t vlan_id,
+                                     hal_ifindex_t vlan_index, bool add){
+    std::lock_guard<std::mutex> lock(_intf_mutex);
 
     if(add){
-        auto intf_it = _intf_to_tagged_intf_map.find(ifname);
+        auto intf_it = _intf_to_tagged_intf_map.find(ifindex);
         if(intf_it == _intf_to_tagged_intf_map.end()){
             std::unordered_set<hal_ifindex_t> tagged_intf_list;
             tagged_intf_list.insert(vlan_index);
-            _intf_to_tagged_intf_map[ifname] = std::move(tagged_intf_list);
+            _intf_to_tagged_intf_map[ifindex] = std::move(tagged_intf_list);
         }else{
             intf_it->second.insert(vlan_index);
         }
-        _intf_str_to_tagged_ifindex_map[if_name]=vlan_index;
+        _tagged_intf_index_add(ifindex,vlan_id,vlan_index);
 
     }else{
-        auto intf_it = _intf_to_tagged_intf_map.find(ifname);
+        auto intf_it = _intf_to_tagged_intf_map.find(ifindex);
         if(intf_it != _intf_to_tagged_intf_map.end()){
             intf_it->second.erase(vlan_index);
             if(intf_it->second.size()==0){
-                _intf_to_tagged_intf_map.erase(ifname);
+                _intf_to_tagged_intf_map.erase(ifindex);
             }
         }
-        _intf_str_to_tagged_ifindex_map.erase(if_name);
+        _tagged_intf_index_del(vlan_index);
     }
     return;
 }
@@ -135,15 +183,50 @@ bool get_tagged_intf_list(hal_ifindex_t intf_name,std::unordered_set<hal_ifindex
     return false;
 }
 
+extern "C" {
 
-bool get_tagged_intf_index_from_name(const char * intf_name,hal_ifindex_t & intf_index){
+bool nas_os_tagged_intf_get(hal_ifindex_t parent, hal_vlan_id_t vlan_id, hal_ifindex_t *vlan_index){
     std::lock_guard<std::mutex> lock(_intf_mutex);
-    auto it = _intf_str_to_tagged_ifindex_map.find(intf_name);
-    if(it != _intf_str_to_tagged_ifindex_map.end()){
-        intf_index = it->second;
-        return true;
+    auto it = _tagged_intf_index.find(_tagged_intf_key(parent,vlan_id));
+    if(it == _tagged_intf_index.end()) return false;
+    *vlan_index = it->second;
+    return true;
+}
+
+bool nas_os_tagged_intf_parent_get(hal_ifindex_t vlan_index, hal_ifindex_t *parent, hal_vlan_id_t *vlan_id){
+    std::lock_guard<std::mutex> lock(_intf_mutex);
+    auto it = _tagged_intf_parent.find(vlan_index);
+    if(it == _tagged_intf_parent.end()) return false;
+    if(parent) *parent = it->second.first;
+    if(vlan_id) *vlan_id = it->second.second;
+    return true;
+}
+
+void nas_os_tagged_intf_link_event(int rt_msg_type, hal_ifindex_t ifindex, const char *info_kind,
+                                   struct nlattr *link, struct nlattr *info_data){
+    if(rt_msg_type == RTM_DELLINK){
+        std::lock_guard<std::mutex> lock(_intf_mutex);
+        _tagged_intf_index_del(ifindex);
+        return;
     }
-    return false;
+
+    if(rt_msg_type != RTM_NEWLINK || info_kind == NULL || strcmp(info_kind,"vlan") != 0 ||
+       link == NULL || info_data == NULL){
+        return;
+    }
+
+    struct nlattr *vlan[IFLA_VLAN_MAX+1];
+    memset(vlan,0,sizeof(vlan));
+    nla_parse_nested(vlan,IFLA_VLAN_MAX+1,info_data);
+    if(vlan[IFLA_VLAN_ID] == NULL) return;
+
+    hal_ifindex_t parent = *(uint32_t *)nla_data(link);
+    hal_vlan_id_t vlan_id = *(uint16_t *)nla_data(vlan[IFLA_VLAN_ID]);
+
+    std::lock_guard<std::mutex> lock(_intf_mutex);
+    _tagged_intf_index_add(parent,vlan_id,ifindex);
+}
+
 }
 
 /* Used to delete an bridge like br3 */
@@ -198,7 +281,7 @@ t_std_error nas_os_delete_subinterface (cps_api_object_t obj) {
         EV_LOGGING(NAS_OS, ERR, "NAS-OS", "Failed: Failed to del subintf  %s", sub_if.c_str());
         return (STD_ERR(NAS_OS,FAIL, 0));
     }
-    _update_intf_to_tagged_intf_map(phy_index, vlan_index, false);
+    _update_intf_to_tagged_intf_map(phy_index, vlan_id, vlan_index, false);
 
     return STD_ERR_OK;
 }
@@ -532,7 +615,7 @@ t_std_error nas_os_create_subinterface(cps_api_object_t obj) {
         return (STD_ERR(NAS_OS,FAIL, 0));
     }
 
-    _update_intf_to_tagged_intf_map(phy_index, vlan_index,true);
+    _update_intf_to_tagged_intf_map(phy_index, vlan_id, vlan_index,true);
 
     cps_api_object_attr_delete(obj,DELL_BASE_IF_CMN_IF_INTERFACES_INTERFACE_IF_INDEX);
     cps_api_object_attr_add_u32(obj, DELL_BASE_IF_CMN_IF_INTERFACES_INTERFACE_IF_INDEX,vlan_index);
@@ -621,7 +704,7 @@ t_std_error nas_os_t_port_to_vlan(int vlan_id, const char *vlan_name, int port_i
         return (STD_ERR(NAS_OS,FAIL, 0));
     }
 
-    _update_intf_to_tagged_intf_map(port_index,*vlan_index,true);
+    _update_intf_to_tagged_intf_map(port_index,vlan_id,*vlan_index,true);
 
     //Add the interface in the bridge now
     t_std_error ret = nas_os_add_vlan_in_br(*vlan_index, port_index, br_index);
@@ -841,7 +924,7 @@ t_std_error nas_os_del_intf_from_bridge(cps_api_object_t obj) {
         }
         EV_LOGGING(NAS_OS, INFO, "NAS-OS", " NAS OS del tag port from bridge: parent_name %s, index %d",
                                                           parent_name.c_str(), parent_idx);
-        _update_intf_to_tagged_intf_map(parent_idx, idx, false);
+        _update_intf_to_tagged_intf_map(parent_idx, vlan_id, idx, false);
     }
     EV_LOGGING(NAS_OS, INFO, "NAS-OS", " NAS OS del port from bridge name %s index %d", mem_name,idx);
     return nas_os_set_master(idx, 0);
@@ -887,7 +970,7 @@ t_std_error nas_os_del_port_from_vlan(cps_api_object_t obj)
             return (STD_ERR(NAS_OS,FAIL, 0));
         }
 
-        _update_intf_to_tagged_intf_map(port_index,vlan_if_index,false);
+        _update_intf_to_tagged_intf_map(port_index,vlan_id,vlan_if_index,false);
         if(nas_os_change_master(vlan_if_index,0,0) != STD_ERR_OK)
             return (STD_ERR(NAS_OS,FAIL, 0));
                 //Call the interface delete
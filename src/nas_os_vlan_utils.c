@@ -42,28 +42,19 @@ void nas_os_get_vlan_if_name(char *if_name, int len, hal_vlan_id_t vlan_id, char
 // TODO deprecate all calls to this function
 bool nas_os_physical_to_vlan_ifindex(hal_ifindex_t intf_index, hal_vlan_id_t vlan_id,
                                             bool to_vlan,hal_ifindex_t * index){
-    char intf_name[HAL_IF_NAME_SZ+1];
-    char vlan_intf_name[HAL_IF_NAME_SZ+1];
-    char *converted_intf_name = NULL;
-
-    if(cps_api_interface_if_index_to_name(intf_index,intf_name,sizeof(intf_name))==NULL){
-        EV_LOG(ERR,NAS_OS,0,"NAS-LINUX-INTERFACE","Invalid Interface Index %d ",intf_index);
-        return false;
-    }
-
     if(to_vlan){
-        snprintf(vlan_intf_name,sizeof(vlan_intf_name),"%s.%d",intf_name,vlan_id);
-        converted_intf_name = vlan_intf_name;
-    }else{
-        char * saveptr;
-        converted_intf_name = strtok_r(intf_name,".",&saveptr);
+        if(!nas_os_tagged_intf_get(intf_index,vlan_id,index)){
+            EV_LOG(ERR,NAS_OS,0,"NAS-LINUX-INTERFACE","No tagged interface for index %d vlan %d",
+                   intf_index,vlan_id);
+            return false;
+        }
+        return true;
     }
 
-    if(((*index) = cps_api_interface_name_to_if_index(converted_intf_name)) == 0){
-        EV_LOG(ERR,NAS_OS,0,"NAS-LINUX-INTERFACE","Invalid Interface name %s ",converted_intf_name);
-        return false;
+    /* Untagged ports are their own parent */
+    if(!nas_os_tagged_intf_parent_get(intf_index,index,NULL)){
+        *index = intf_index;
     }
-
     return true;
 }
 
@@ -50,6 +50,15 @@
 #include "nas_nlmsg_object_utils.h"
 #include "netlink_stats.h"
 #include "nas_os_vlan_utils.h"
+#include "os_interface_damp.h"
+#include "nas_os_obj_pool.h"
+#include "nas_os_snapshot.h"
+#include "nas_os_if_resolve.h"
+#include "nas_os_rt_shadow.h"
+#include "nas_os_l3.h"
+#include "nas_os_ctl_sock.h"
+#include "nas_os_if_stats.h"
+#include "standard_netlink_requests.h"
 
 #include <limits.h>
 #include <unistd.h>
@@ -63,11 +72,17 @@
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 #include <sys/socket.h>
 #include <linux/rtnetlink.h>
 #include <map>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
 
 /*
  * Global variables
@@ -107,9 +122,6 @@ static uint64_t                     _local_event_count = 0;
 static std_thread_create_param_t      _net_main_thr;
 static cps_api_event_service_handle_t         _handle;
 
-/* This size should be increased incase the no. of path for a route increased beyond 128 */
-const static int MAX_CPS_MSG_SIZE=12000;
-
 static fd_set read_fds;
 static int max_fd = -1;
 static std::mutex _nl_sock_mutex;
@@ -194,14 +206,19 @@ unsigned int rta_add_name( struct nlattr* rtatp,cps_api_object_t obj, uint32_t a
     return len;
 }
 
-static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *data, uint32_t vrf_id) {
-    static char buff[MAX_CPS_MSG_SIZE];
-
-    cps_api_object_t obj = cps_api_object_init(buff,sizeof(buff));
-
-    if (rt_msg_type < RTM_BASE)
-        return false;
+static void nl_publish_event(int sock, int rt_msg_type, void *data, cps_api_object_t obj) {
+    nas_nl_stats_update_pub_msg (sock, rt_msg_type);
+    /* Unchanged since the warm restart snapshot - the applications already have it */
+    if (!nas_os_snapshot_track(rt_msg_type, (const char*)data, obj)) {
+        return;
+    }
+    if (nas_os_publish_event(obj) != cps_api_ret_code_OK) {
+        nas_nl_stats_update_pub_msg_failed (sock, rt_msg_type);
+    }
+}
 
+static bool nl_msg_to_event(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *data,
+                            uint32_t vrf_id, cps_api_object_t obj) {
     EV_LOGGING(NETLINK,INFO,"NL_EVT","VRF name:%s id:%d sock:%d msg_type:%d(%s) ",
                (char*) (data ? data : ""), vrf_id, sock, rt_msg_type,
                ((rt_msg_type <= RTM_SETLINK) ? "Link" : ((rt_msg_type <= RTM_GETADDR) ? "Addr" :
@@ -215,10 +232,7 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
     if (rt_msg_type <= RTM_SETLINK) {
         nas_nl_stats_update_tot_msg (sock, rt_msg_type);
         if (os_interface_to_object(rt_msg_type, hdr,obj, &evt_publish, vrf_id) == STD_ERR_OK && evt_publish) {
-            nas_nl_stats_update_pub_msg (sock, rt_msg_type);
-            if (net_publish_event(obj) != cps_api_ret_code_OK) {
-                nas_nl_stats_update_pub_msg_failed (sock, rt_msg_type);
-            }
+            nl_publish_event(sock, rt_msg_type, data, obj);
         } else {
             nas_nl_stats_update_invalid_msg (sock, rt_msg_type);
         }
@@ -230,11 +244,13 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
      */
     if (rt_msg_type <= RTM_GETADDR) {
         nas_nl_stats_update_tot_msg (sock, rt_msg_type);
+        if (rt_msg_type == RTM_DELADDR && nas_os_route_idempotent_mode_get() &&
+            hdr->nlmsg_len >= NLMSG_LENGTH(sizeof(struct ifaddrmsg))) {
+            /* The kernel flushes the routes using the address without events */
+            nas_os_rt_shadow_if_event(rt_msg_type, ((struct ifaddrmsg *)NLMSG_DATA(hdr))->ifa_index, 0);
+        }
         if (nl_get_ip_info(rt_msg_type,hdr,obj,data, vrf_id)) {
-            nas_nl_stats_update_pub_msg (sock, rt_msg_type);
-            if (net_publish_event(obj) != cps_api_ret_code_OK) {
-                nas_nl_stats_update_pub_msg_failed (sock, rt_msg_type);
-            }
+            nl_publish_event(sock, rt_msg_type, data, obj);
         } else {
             nas_nl_stats_update_invalid_msg (sock, rt_msg_type);
         }
@@ -246,11 +262,12 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
      */
     if (rt_msg_type <= RTM_GETROUTE) {
         nas_nl_stats_update_tot_msg (sock, rt_msg_type);
+        /* Kernel route view is only kept for the idempotent programming mode */
+        if (nas_os_route_idempotent_mode_get()) {
+            nas_os_rt_shadow_event(rt_msg_type, (const char*)data, hdr);
+        }
         if (nl_to_route_info(rt_msg_type,hdr, obj, data, vrf_id)) {
-            nas_nl_stats_update_pub_msg (sock, rt_msg_type);
-            if (net_publish_event(obj) != cps_api_ret_code_OK) {
-                nas_nl_stats_update_pub_msg_failed (sock, rt_msg_type);
-            }
+            nl_publish_event(sock, rt_msg_type, data, obj);
         } else {
             nas_nl_stats_update_invalid_msg (sock, rt_msg_type);
         }
@@ -263,10 +280,7 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
     if (rt_msg_type <= RTM_GETNEIGH) {
         nas_nl_stats_update_tot_msg (sock, rt_msg_type);
         if (nl_to_neigh_info(rt_msg_type, hdr,obj,data, vrf_id)) {
-            nas_nl_stats_update_pub_msg (sock, rt_msg_type);
-            if (net_publish_event(obj) != cps_api_ret_code_OK) {
-                nas_nl_stats_update_pub_msg_failed (sock, rt_msg_type);
-            }
+            nl_publish_event(sock, rt_msg_type, data, obj);
         } else {
             nas_nl_stats_update_invalid_msg (sock, rt_msg_type);
         }
@@ -278,10 +292,7 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
     if (rt_msg_type <= RTM_GETNETCONF) {
         nas_nl_stats_update_tot_msg (sock, rt_msg_type);
         if (nl_get_ip_netconf_info(rt_msg_type,hdr, obj, data, vrf_id)) {
-            nas_nl_stats_update_pub_msg (sock, rt_msg_type);
-            if (net_publish_event(obj) != cps_api_ret_code_OK) {
-                nas_nl_stats_update_pub_msg_failed (sock, rt_msg_type);
-            }
+            nl_publish_event(sock, rt_msg_type, data, obj);
         } else {
             nas_nl_stats_update_invalid_msg (sock, rt_msg_type);
         }
@@ -301,6 +312,24 @@ static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, vo
     return false;
 }
 
+static bool get_netlink_data(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *data, uint32_t vrf_id) {
+    if (rt_msg_type < RTM_BASE)
+        return false;
+
+    /* MDB messages are kept in the snooping table, no event object is built */
+    if (rt_msg_type > RTM_GETNETCONF)
+        return nl_msg_to_event(sock, rt_msg_type, hdr, data, vrf_id, nullptr);
+
+    /* Event object comes from the thread pool and is recycled once published */
+    cps_api_object_t obj = nas_os_obj_pool_alloc(rt_msg_type);
+    if (obj == nullptr)
+        return false;
+
+    bool rc = nl_msg_to_event(sock, rt_msg_type, hdr, data, vrf_id, obj);
+    nas_os_obj_pool_release(obj);
+    return rc;
+}
+
 static void publish_existing()
 {
     struct ifaddrs *if_addr, *ifa;
@@ -347,7 +376,8 @@ static void publish_existing()
                 KN_DEBUG("  get name failed");
 
 
-            cps_api_object_t obj = cps_api_object_create();
+            cps_api_object_t obj = nas_os_obj_pool_alloc(RTM_NEWADDR);
+            if (obj == nullptr) continue;
             cps_api_object_attr_add(obj,cps_api_if_ADDR_A_NAME,
                     ifa->ifa_name,strlen(ifa->ifa_name)+1);
 
@@ -372,7 +402,7 @@ static void publish_existing()
             }
             cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
                     cps_api_obj_cat_INTERFACE,cps_api_int_obj_INTERFACE_ADDR,0);
-            net_publish_event(obj);
+            nas_os_obj_pool_publish(obj);
 
         }
     }
@@ -500,11 +530,325 @@ void os_send_refresh(nas_nl_sock_TYPES type, char *vrf_name, uint32_t vrf_id) {
     }
 }
 
+/*
+ * Startup and VRF re-sync dumps. A VRF is dumped by one of the refresh workers on its
+ * own netlink sockets, the phases are run in order so that an object is never published
+ * before the objects it refers to, while different VRFs are dumped concurrently up to
+ * the configured limit. The event sockets of a VRF are not read while it is being dumped
+ * so the events received meanwhile are published after the dump.
+ */
+typedef struct {
+    const char *name;
+    nas_nl_sock_TYPES sock_type;
+    bool (*request)(int sock, int family, int req_id);
+    int family[2];      /* AF_UNSPEC - not used */
+} os_refresh_phase_t;
+
+static bool os_refresh_link_request(int sock, int family, int req_id) {
+    return nl_route_send_get_all(sock, RTM_GETLINK, family, req_id);
+}
+
+static bool os_refresh_addr_request(int sock, int family, int req_id) {
+    return nl_route_send_get_all(sock, RTM_GETADDR, family, req_id);
+}
+
+static const os_refresh_phase_t _refresh_phases[] = {
+    { "Intf", nas_nl_sock_T_INT, os_refresh_link_request, { AF_PACKET, AF_UNSPEC } },
+    { "Addr", nas_nl_sock_T_INT, os_refresh_addr_request, { AF_INET, AF_INET6 } },
+    { "Nbr", nas_nl_sock_T_NEI, nl_neigh_get_all_request, { AF_INET, AF_INET6 } },
+    { "Route", nas_nl_sock_T_ROUTE, nl_request_existing_routes, { AF_INET, AF_INET6 } },
+    { "NetConf", nas_nl_sock_T_NETCONF, nl_netconf_get_all_request, { AF_INET, AF_INET6 } },
+};
+
+static const size_t OS_REFRESH_PHASE_MAX = sizeof(_refresh_phases)/sizeof(_refresh_phases[0]);
+
+typedef struct {
+    std::string vrf_name;
+    uint32_t vrf_id;
+    uint64_t queued_us;
+} os_refresh_job_t;
+
+typedef struct {
+    size_t pending;         /* Queued or running dumps, event sockets are held while non zero */
+    bool active;
+    uint64_t wait_us;
+    uint64_t phase_us[OS_REFRESH_PHASE_MAX];
+    uint64_t total_us;
+    uint32_t count;
+} os_refresh_vrf_t;
+
+/* Workers are detached and exit after being idle, the slots hold their thread params */
+#define OS_REFRESH_MAX_WORKERS  16
+static const int OS_REFRESH_IDLE_SEC = 30;
+
+static auto & _refresh_mutex = *(new std::mutex);
+static auto & _refresh_cv = *(new std::condition_variable);
+static auto & _refresh_queue = *(new std::deque<os_refresh_job_t>);
+static auto & _refresh_vrfs = *(new std::map<std::string, os_refresh_vrf_t>);
+static std_thread_create_param_t _refresh_thr[OS_REFRESH_MAX_WORKERS];
+static bool _refresh_thr_used[OS_REFRESH_MAX_WORKERS];
+static size_t _refresh_max_parallel = 4;
+static size_t _refresh_workers = 0;
+static size_t _refresh_active = 0;
+static size_t _refresh_active_max = 0;
+static int _refresh_wake_fd[2] = { -1, -1 };
+
+/* Created before the event loop thread is, or before the first dump when a VRF is
+ * added ahead of it, so the event loop never sees the fds change */
+static void os_refresh_wake_init() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        if (pipe(_refresh_wake_fd) != 0) {
+            EV_LOGGING(NETLINK, ERR, "NL-REFRESH", "Failed to create wake up pipe err-no:%d", errno);
+            _refresh_wake_fd[0] = _refresh_wake_fd[1] = -1;
+            return;
+        }
+        fcntl(_refresh_wake_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(_refresh_wake_fd[1], F_SETFL, O_NONBLOCK);
+    });
+}
+
+/* Wake up the event loop to resume reading the sockets of a refreshed VRF */
+static void os_refresh_wake() {
+    char c = 0;
+    if (_refresh_wake_fd[1] != -1 && write(_refresh_wake_fd[1], &c, sizeof(c)) < 0) {
+        EV_LOGGING(NETLINK, DEBUG, "NL-REFRESH", "Wake up write failed err-no:%d", errno);
+    }
+}
+
+static void os_refresh_wake_drain() {
+    char drain[64];
+    while (read(_refresh_wake_fd[0], drain, sizeof(drain)) > 0) {}
+}
+
+/* Remove the event sockets of the VRFs being dumped from the fd set, _nl_sock_mutex is held */
+static void os_refresh_hold_fds(fd_set *fds) {
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    if (_refresh_queue.empty() && _refresh_active == 0) return;
+
+    for (auto it = nlm_sockets->begin(); it != nlm_sockets->end(); ++it) {
+        auto vit = _refresh_vrfs.find(it->second.vrf_name);
+        if (vit != _refresh_vrfs.end() && vit->second.pending != 0) {
+            FD_CLR(it->first, fds);
+        }
+    }
+}
+
+/*
+ * The netlink to CPS converters are not reentrant (static buffers, the interface and
+ * bridge caches) and share the event loop state, only the dump requests and the socket
+ * reads of the VRFs run in parallel - every dumped message is converted and published
+ * under the same lock as the events.
+ */
+static bool os_refresh_process(int sock, int rt_msg_type, struct nlmsghdr *hdr, void *data,
+                               uint32_t vrf_id) {
+    std::lock_guard<std::mutex> lock(_nl_sock_mutex);
+    return get_netlink_data(sock, rt_msg_type, hdr, data, vrf_id);
+}
+
+static void os_refresh_run_phase(const os_refresh_phase_t &phase, os_refresh_job_t &job,
+                                 char *scratch, size_t len) {
+    int sock = nas_nl_sock_create(job.vrf_name.c_str(), phase.sock_type, false);
+    if (sock == -1) {
+        EV_LOGGING(NETLINK, ERR, "NL-REFRESH", "VRF:%s %s dump socket create failed err-no:%d",
+                   job.vrf_name.c_str(), phase.name, errno);
+        return;
+    }
+    int reqid = (int)std_get_uptime(NULL);
+    for (auto family : phase.family) {
+        if (family == AF_UNSPEC) continue;
+        if (phase.request(sock, family, ++reqid)) {
+            netlink_tools_process_socket(sock, os_refresh_process, (void*)job.vrf_name.c_str(),
+                                         scratch, len, &reqid, NULL, job.vrf_id);
+        }
+    }
+    close(sock);
+}
+
+/* Next job whose VRF is not being dumped, _refresh_mutex is held */
+static std::deque<os_refresh_job_t>::iterator os_refresh_next_job() {
+    if (_refresh_active >= _refresh_max_parallel) return _refresh_queue.end();
+    for (auto it = _refresh_queue.begin(); it != _refresh_queue.end(); ++it) {
+        if (!_refresh_vrfs[it->vrf_name].active) return it;
+    }
+    return _refresh_queue.end();
+}
+
+static void os_refresh_worker(void *arg) {
+    size_t slot = (size_t)(uintptr_t)arg;
+    std::vector<char> scratch(NL_SCRATCH_BUFFER_LEN);
+
+    pthread_detach(pthread_self());
+    while (true) {
+        os_refresh_job_t job;
+        {
+            std::unique_lock<std::mutex> lock(_refresh_mutex);
+            if (!_refresh_cv.wait_for(lock, std::chrono::seconds(OS_REFRESH_IDLE_SEC),
+                                      [] { return os_refresh_next_job() != _refresh_queue.end(); })) {
+                /* Idle - the next enqueue starts a new worker */
+                --_refresh_workers;
+                _refresh_thr_used[slot] = false;
+                return;
+            }
+            auto it = os_refresh_next_job();
+            job = *it;
+            _refresh_queue.erase(it);
+            _refresh_vrfs[job.vrf_name].active = true;
+            if (++_refresh_active > _refresh_active_max) _refresh_active_max = _refresh_active;
+        }
+
+        uint64_t start_us = std_get_uptime(NULL);
+        uint64_t phase_us[OS_REFRESH_PHASE_MAX];
+        for (size_t ix = 0; ix < OS_REFRESH_PHASE_MAX; ++ix) {
+            uint64_t phase_start = std_get_uptime(NULL);
+            os_refresh_run_phase(_refresh_phases[ix], job, &scratch[0], scratch.size());
+            phase_us[ix] = std_get_uptime(NULL) - phase_start;
+        }
+        uint64_t end_us = std_get_uptime(NULL);
+
+        EV_LOGGING(NETLINK, NOTICE, "NL-REFRESH", "VRF:%s(%d) dump done wait:%lums total:%lums "
+                   "(intf:%lums addr:%lums nbr:%lums route:%lums netconf:%lums)",
+                   job.vrf_name.c_str(), job.vrf_id, (start_us - job.queued_us)/1000,
+                   (end_us - start_us)/1000, phase_us[0]/1000, phase_us[1]/1000,
+                   phase_us[2]/1000, phase_us[3]/1000, phase_us[4]/1000);
+        /* Deletes of the objects gone since the snapshot go out while the events are still held */
+        nas_os_snapshot_vrf_synced(job.vrf_name.c_str());
+        {
+            std::lock_guard<std::mutex> lock(_refresh_mutex);
+            os_refresh_vrf_t &vrf = _refresh_vrfs[job.vrf_name];
+            vrf.active = false;
+            if (vrf.pending > 0) --vrf.pending;
+            vrf.wait_us = start_us - job.queued_us;
+            memcpy(vrf.phase_us, phase_us, sizeof(vrf.phase_us));
+            vrf.total_us = end_us - start_us;
+            ++vrf.count;
+            --_refresh_active;
+        }
+        _refresh_cv.notify_all();
+        os_refresh_wake();
+    }
+}
+
+static void os_refresh_enqueue(const char *vrf_name, uint32_t vrf_id) {
+    os_refresh_wake_init();
+
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    /* Coalesce with a dump of the VRF that did not start yet */
+    for (auto &job : _refresh_queue) {
+        if (job.vrf_name == vrf_name) return;
+    }
+    _refresh_queue.push_back({ vrf_name, vrf_id, std_get_uptime(NULL) });
+    ++_refresh_vrfs[vrf_name].pending;
+
+    if (_refresh_workers < _refresh_max_parallel) {
+        size_t slot = 0;
+        while (slot < OS_REFRESH_MAX_WORKERS && _refresh_thr_used[slot]) ++slot;
+        if (slot < OS_REFRESH_MAX_WORKERS) {
+            std_thread_create_param_t *thr = &_refresh_thr[slot];
+            std_thread_init_struct(thr);
+            thr->name = "db-api-linux-refresh";
+            thr->thread_function = (std_thread_function_t)os_refresh_worker;
+            thr->param = (void*)(uintptr_t)slot;
+            if (std_thread_create(thr) == STD_ERR_OK) {
+                _refresh_thr_used[slot] = true;
+                ++_refresh_workers;
+            } else {
+                EV_LOGGING(NETLINK, ERR, "NL-REFRESH", "Failed to create refresh worker");
+            }
+        }
+    }
+    if (_refresh_workers == 0) {
+        /* No worker - do not hold the VRF event sockets forever */
+        _refresh_queue.pop_back();
+        --_refresh_vrfs[vrf_name].pending;
+        return;
+    }
+    _refresh_cv.notify_one();
+}
+
+/* Drop the dumps of a deleted VRF that did not start yet */
+static void os_refresh_cancel(const char *vrf_name) {
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    for (auto it = _refresh_queue.begin(); it != _refresh_queue.end();) {
+        if (it->vrf_name == vrf_name) {
+            it = _refresh_queue.erase(it);
+            --_refresh_vrfs[vrf_name].pending;
+        } else {
+            ++it;
+        }
+    }
+    auto vit = _refresh_vrfs.find(vrf_name);
+    if (vit != _refresh_vrfs.end() && vit->second.pending == 0) {
+        _refresh_vrfs.erase(vit);
+    }
+}
+
+void os_refresh_max_parallel_set(size_t max_parallel) {
+    {
+        std::lock_guard<std::mutex> lock(_refresh_mutex);
+        _refresh_max_parallel = (max_parallel == 0) ? 1 :
+                                (max_parallel > OS_REFRESH_MAX_WORKERS) ? OS_REFRESH_MAX_WORKERS :
+                                max_parallel;
+        _refresh_active_max = _refresh_active;
+    }
+    _refresh_cv.notify_all();
+}
+
+bool os_refresh_vrf_stats_get(const char *vrf_name, os_refresh_vrf_stats_t *stats) {
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    auto it = _refresh_vrfs.find(vrf_name);
+    if (it == _refresh_vrfs.end()) return false;
+
+    stats->count = it->second.count;
+    stats->pending = (uint32_t)it->second.pending;
+    stats->wait_us = it->second.wait_us;
+    stats->total_us = it->second.total_us;
+    return true;
+}
+
+size_t os_refresh_active_max_get(void) {
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    return _refresh_active_max;
+}
+
+void os_debug_refresh_print() {
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    printf("\r\n NETLINK REFRESH max-parallel:%lu workers:%lu active:%lu (max:%lu) queued:%lu\r\n",
+           _refresh_max_parallel, _refresh_workers, _refresh_active, _refresh_active_max,
+           _refresh_queue.size());
+    printf("\r %-16s %-6s %-8s %-10s %-10s %-10s %-10s %-10s %-10s %-10s\r\n", "VRF", "Count",
+           "Pending", "Wait(ms)", "Intf(ms)", "Addr(ms)", "Nbr(ms)", "Route(ms)", "NetConf(ms)", "Total(ms)");
+    printf("\r=========================================================================\r\n");
+    for (auto &it : _refresh_vrfs) {
+        printf("\r %-16s %-6u %-8lu %-10lu %-10lu %-10lu %-10lu %-10lu %-10lu %-10lu\r\n",
+               it.first.c_str(), it.second.count, it.second.pending, it.second.wait_us/1000,
+               it.second.phase_us[0]/1000, it.second.phase_us[1]/1000, it.second.phase_us[2]/1000,
+               it.second.phase_us[3]/1000, it.second.phase_us[4]/1000, it.second.total_us/1000);
+    }
+}
+
+/* Dampened final link state - same stats and snapshot tracking as the kernel events */
+static void os_if_damp_publish(cps_api_object_t obj) {
+    std::lock_guard<std::mutex> lock(_nl_sock_mutex);
+    int sock = -1;
+    for ( auto it = nlm_sockets->begin(); it != nlm_sockets->end() ; ++it) {
+        if ((it->second.sock_type == nas_nl_sock_T_INT) &&
+            (strncmp(it->second.vrf_name, NL_DEFAULT_VRF_NAME, NAS_VRF_NAME_SZ) == 0)) {
+            sock = it->first;
+            break;
+        }
+    }
+    nl_publish_event(sock, RTM_NEWLINK, (void*)NL_DEFAULT_VRF_NAME, obj);
+    cps_api_object_delete(obj);
+}
+
 int net_main() {
     fd_set sel_fds;
 
-    //Publish existing..
-    publish_existing();
+    //Publish existing.. on warm restart the address dump is reconciled instead
+    if (!nas_os_snapshot_warm_restart()) {
+        publish_existing();
+    }
 
     g_if_db = new (std::nothrow) (INTERFACE);
     g_if_bridge_db = new (std::nothrow) (if_bridge);
@@ -525,11 +869,35 @@ int net_main() {
             /* Take the lock and update the select fds from read fds */
             std::lock_guard<std::mutex> lock(_nl_sock_mutex);
             memcpy ((char *) &sel_fds, (char *) &read_fds, sizeof(fd_set));
+            os_refresh_hold_fds(&sel_fds);
+        }
+        int sel_max_fd = max_fd;
+        if (_refresh_wake_fd[0] != -1) {
+            add_fd_set(_refresh_wake_fd[0], sel_fds, sel_max_fd);
+        }
+        /* Wake up for the pending final link state of dampened interfaces */
+        struct timeval tv;
+        struct timeval *p_tv = NULL;
+        uint64_t wait_us = 0;
+        if (os_if_damp_next_timeout(&wait_us)) {
+            tv.tv_sec = wait_us / 1000000;
+            tv.tv_usec = wait_us % 1000000;
+            p_tv = &tv;
+        }
+        int rc = select((sel_max_fd+1), &sel_fds, NULL, NULL, p_tv);
+        if (p_tv != NULL) {
+            os_if_damp_flush(os_if_damp_publish);
         }
-        if(select((max_fd+1), &sel_fds, NULL, NULL, NULL) <= 0)
+        if(rc <= 0)
             continue;
 
+        if (_refresh_wake_fd[0] != -1 && FD_ISSET(_refresh_wake_fd[0], &sel_fds)) {
+            os_refresh_wake_drain();
+        }
+
         std::lock_guard<std::mutex> lock(_nl_sock_mutex);
+        /* A dump may have been queued for the VRF meanwhile */
+        os_refresh_hold_fds(&sel_fds);
         for ( auto it = nlm_sockets->begin(); it != nlm_sockets->end() ; ++it) {
             if (FD_ISSET(it->first,&sel_fds)) {
                 netlink_tools_receive_event(it->first,nlm_handlers->at((it->second).sock_type).process,
@@ -559,6 +927,14 @@ t_std_error cps_api_net_notify_init(void) {
     if((rc = nas_os_mac_init()) != STD_ERR_OK){
         return rc;
     }
+    if((rc = nas_os_mcast_snoop_init()) != STD_ERR_OK){
+        return rc;
+    }
+    /* Snapshot of the previous run has to be loaded before the first kernel dump */
+    if (nas_os_snapshot_init() != STD_ERR_OK) {
+        EV_LOGGING(NETLINK, ERR, "NET-NOTIFY", "Warm restart snapshot is not available");
+    }
+    os_refresh_wake_init();
     std_thread_init_struct(&_net_main_thr);
     _net_main_thr.name = "db-api-linux-events";
     _net_main_thr.thread_function = (std_thread_function_t)net_main;
@@ -604,17 +980,7 @@ bool os_nflog_enable ()
 }
 
 void os_refresh_netlink_info(const char *vrf_name, uint32_t vrf_id) {
-    nas_nl_sock_TYPES _refresh_list[] = {
-            nas_nl_sock_T_INT,
-            nas_nl_sock_T_NEI,
-            nas_nl_sock_T_ROUTE,
-            nas_nl_sock_T_NETCONF
-    };
-    size_t ix = 0;
-    size_t refresh_mx = sizeof(_refresh_list)/sizeof(*_refresh_list);
-    for ( ; ix < refresh_mx ; ++ix ) {
-        os_send_refresh(_refresh_list[ix], (char*)vrf_name, vrf_id);
-    }
+    os_refresh_enqueue(vrf_name, vrf_id);
 }
 
 t_std_error os_create_netlink_sock(const char *vrf_name, uint32_t vrf_id) {
@@ -656,6 +1022,7 @@ t_std_error os_create_netlink_sock(const char *vrf_name, uint32_t vrf_id) {
         nas_nl_stats_init (sock);
     }
 
+    nas_os_snapshot_vrf_add(vrf_name);
     os_refresh_netlink_info(vrf_name, vrf_id);
     return STD_ERR_OK;
 }
@@ -664,6 +1031,13 @@ t_std_error os_del_netlink_sock(const char *vrf_name) {
     /* Take the lock to update the read_fds */
     std::lock_guard<std::mutex> lock(_nl_sock_mutex);
 
+    os_refresh_cancel(vrf_name);
+    nas_os_snapshot_vrf_del(vrf_name);
+    nas_os_if_resolve_vrf_del(vrf_name);
+    nas_os_rt_shadow_vrf_del(vrf_name);
+    nas_os_ctl_sock_vrf_del(vrf_name);
+    nas_os_if_stats_engine_vrf_del(vrf_name);
+
     for ( auto it = nlm_sockets->begin(); it != nlm_sockets->end();) {
         EV_LOGGING(NETLINK,DEBUG,"NL_SOCK","Existig VRF:%s id:%d sock:%d", it->second.vrf_name, it->second.vrf_id, it->first);
         if (strncmp(vrf_name, it->second.vrf_name, NAS_VRF_NAME_SZ) == 0) {
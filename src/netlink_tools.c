@@ -29,6 +29,7 @@
 #include "nas_nlmsg.h"
 #include "nas_os_interface.h"
 #include "netlink_stats.h"
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -36,6 +37,8 @@
 #include <sys/socket.h>
 #include <errno.h>
 #include <time.h>
+#include <poll.h>
+#include <arpa/inet.h>
 
 #include <linux/netfilter/nfnetlink.h>
 #include <linux/netfilter/nfnetlink_log.h>
@@ -346,6 +349,63 @@ bool nl_send_nlmsg(int sock, struct nlmsghdr *m) {
     return sendmsg(sock,&msg,0)==(m->nlmsg_len);
 }
 
+/* Send a buffer of back to back netlink messages with a single system call */
+bool nl_send_nlmsg_batch(int sock, void *buff, size_t len) {
+    struct sockaddr_nl nladdr ;
+    memset(&nladdr,0,sizeof(nladdr));
+    nladdr.nl_family = AF_NETLINK;
+    nladdr.nl_groups = 0;
+
+    struct iovec iov[1] = {
+        { .iov_base = buff, .iov_len = len }
+    };
+    struct msghdr msg = {
+        .msg_name = &nladdr,
+        .msg_namelen =     sizeof(nladdr),
+        .msg_iov = iov,
+        .msg_iovlen = 1,
+    };
+
+    return sendmsg(sock,&msg,0)==(ssize_t)len;
+}
+
+#define NL_BATCH_ACK_BUFF_LEN 8192
+/* Max wait for the next ACK, the messages still waiting then fail with ETIMEDOUT */
+#define NL_BATCH_ACK_TIMEOUT_MS 2000
+
+/* Collect the ACKs of the messages [first, last) of a batch sent with sequence numbers seq_base + ix */
+void nl_read_batch_acks(int sock, uint32_t seq_base, size_t first, size_t last, size_t pending, int *err) {
+    char buff[NL_BATCH_ACK_BUFF_LEN];
+    struct pollfd pfd = { sock, POLLIN, 0 };
+    while (pending > 0) {
+        int len = poll(&pfd, 1, NL_BATCH_ACK_TIMEOUT_MS);
+        if (len > 0) {
+            len = recv(sock, buff, sizeof(buff), MSG_DONTWAIT);
+        } else if (len == 0) {
+            errno = ETIMEDOUT;
+            len = -1;
+        }
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            int rc = errno;
+            size_t ix;
+            for (ix = first; ix < last; ++ix) {
+                if (err[ix] == -1) err[ix] = rc;
+            }
+            return;
+        }
+        struct nlmsghdr *nh;
+        for (nh = (struct nlmsghdr *)buff; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type != NLMSG_ERROR) continue;
+            size_t ix = (size_t)(uint32_t)(nh->nlmsg_seq - seq_base);
+            if (ix < first || ix >= last || err[ix] != -1) continue;
+            /* Netlink error is returned as a -ve number */
+            err[ix] = -((struct nlmsgerr *)NLMSG_DATA(nh))->error;
+            --pending;
+        }
+    }
+}
+
 bool nl_send_request(int sock, int type, int flags, int seq, void * req, size_t len ) {
     struct nlmsghdr nlh;
 
@@ -750,14 +810,102 @@ int nas_os_bind_nf_sub(int fd, int family, int type, int queue_num)
     return 0;
 }
 
-int nas_os_nl_nflog_init ()
-{
 /* NFLOG socket group used. This is the one used in ebtable rule */
 #define NL_NFLOG_GROUP        100
 /* Netfilter NFLOG protocol family */
 #define NL_NFLOG_FAMILY       AF_BRIDGE
 /* NFLOG socket buffer. customized this as required. */
 #define NL_NFLOG_SOCK_BUFFER  65000
+
+static nas_nflog_stats_t _nflog_stats;
+/* Next expected NFULA_SEQ of the instance, gaps are packets lost on the way */
+static uint32_t _nflog_next_seq;
+static bool _nflog_seq_valid = false;
+
+static int nas_os_nf_attr_add(char *buf, int len, int type, const void *data, int data_len)
+{
+    struct nfattr *nfa = (struct nfattr *) (buf + len);
+    nfa->nfa_type = type;
+    nfa->nfa_len = NFA_LENGTH(data_len);
+    memcpy(NFA_DATA(nfa), data, data_len);
+    return len + NFA_ALIGN(nfa->nfa_len);
+}
+
+/* Configures copy range, kernel buffer, queue threshold and flush timeout of the instance */
+static int nas_os_nflog_cfg_set(int fd, int family, int queue_num, const nas_nflog_cfg_t *cfg)
+{
+    char buf[512];
+    static int seq_no = 1345;
+    int error = 0;
+
+    int len = nlmsg_prep_nful_msg(buf, family, NFNL_SUBSYS_ULOG, queue_num, seq_no);
+    struct nlmsghdr *nl_hdr = (struct nlmsghdr *) buf;
+
+    struct nfulnl_msg_config_mode mode;
+    memset(&mode, 0, sizeof(mode));
+    mode.copy_range = htonl(cfg->copy_range);
+    mode.copy_mode = NFULNL_COPY_PACKET;
+    len = nas_os_nf_attr_add(buf, len, NFULA_CFG_MODE, &mode, sizeof(mode));
+
+    uint32_t val = htonl(cfg->nlbufsiz);
+    len = nas_os_nf_attr_add(buf, len, NFULA_CFG_NLBUFSIZ, &val, sizeof(val));
+    val = htonl(cfg->qthreshold);
+    len = nas_os_nf_attr_add(buf, len, NFULA_CFG_QTHRESH, &val, sizeof(val));
+    /* Kernel timeout is in 1/100 seconds */
+    val = htonl((cfg->flush_timeout_ms + 9) / 10);
+    len = nas_os_nf_attr_add(buf, len, NFULA_CFG_TIMEOUT, &val, sizeof(val));
+    uint16_t flags = htons(NFULNL_CFG_F_SEQ);
+    len = nas_os_nf_attr_add(buf, len, NFULA_CFG_FLAGS, &flags, sizeof(flags));
+    nl_hdr->nlmsg_len = len;
+
+    nl_send_nlmsg (fd, nl_hdr);
+    netlink_tools_process_socket(fd,_process_set_fun,NULL,buf,sizeof(buf),&seq_no, &error, NL_DEFAULT_VRF_ID);
+    seq_no++;
+
+    if (error != 0) {
+        EV_LOGGING(NETLINK, ERR, "NK-SOCKCR-NFLOG", "NFLOG queue configuration failed: %d", error);
+        return -1;
+    }
+    return 0;
+}
+
+int nas_os_nl_nflog_init_cfg (const nas_nflog_cfg_t *cfg)
+{
+    nas_nflog_cfg_t nf_cfg;
+    memset(&nf_cfg, 0, sizeof(nf_cfg));
+    if (cfg != NULL) nf_cfg = *cfg;
+
+    if (nf_cfg.sock_buf_len == 0) nf_cfg.sock_buf_len = NL_NFLOG_DEF_SOCK_BUFFER;
+    if (nf_cfg.copy_range == 0) nf_cfg.copy_range = NL_NFLOG_DEF_COPY_RANGE;
+    if (nf_cfg.nlbufsiz == 0) nf_cfg.nlbufsiz = NL_NFLOG_DEF_NLBUFSIZ;
+    if (nf_cfg.qthreshold == 0) nf_cfg.qthreshold = NL_NFLOG_DEF_QTHRESHOLD;
+    if (nf_cfg.flush_timeout_ms == 0) nf_cfg.flush_timeout_ms = NL_NFLOG_DEF_FLUSH_MS;
+
+    int fd = nl_sock_create(NL_DEFAULT_VRF_NAME, NL_NFLOG_GROUP, NETLINK_NETFILTER, true,
+                            nf_cfg.sock_buf_len);
+    if (fd < 0) {
+        EV_LOGGING(NETLINK, ERR, "NK-SOCKCR-NFLOG", "NFLOG initialization failed: %d", errno);
+        return -1;
+    }
+
+    // For now let us monitor only the ULOG subsystem
+    nas_os_bind_nf_sub(fd, NL_NFLOG_FAMILY, NFNL_SUBSYS_ULOG, NL_NFLOG_GROUP);
+    if (nas_os_nflog_cfg_set(fd, NL_NFLOG_FAMILY, NL_NFLOG_GROUP, &nf_cfg) != 0) {
+        close(fd);
+        return -1;
+    }
+    _nflog_seq_valid = false;
+
+    // enable NFLOG
+    os_nflog_enable ();
+    EV_LOGGING(NETLINK, DEBUG,"NK-SOCKCR-NFLOG",
+               "NFLOG initialization success sock buf %d nlbufsiz %u qthreshold %u timeout %ums",
+               nf_cfg.sock_buf_len, nf_cfg.nlbufsiz, nf_cfg.qthreshold, nf_cfg.flush_timeout_ms);
+    return fd;
+}
+
+int nas_os_nl_nflog_init ()
+{
     int fd;
     int netlink_type = NETLINK_NETFILTER;
 
@@ -776,3 +924,138 @@ int nas_os_nl_nflog_init ()
     EV_LOGGING(NETLINK, DEBUG,"NK-SOCKCR-NFLOG","NFLOG initialization success");
     return fd;
 }
+
+static bool nas_nl_parse_nflog_pkt (struct nlmsghdr *nl_hdr, nas_nflog_pkt_t *pkt)
+{
+    struct nfattr *attr = (struct nfattr *) ((char *) nl_hdr +
+                                             NLMSG_SPACE(sizeof(struct nfgenmsg)));
+    int rem_len = nl_hdr->nlmsg_len - ((char *) attr - (char *) nl_hdr);
+    bool seq_found = false;
+    uint32_t seq = 0;
+
+    memset(pkt, 0, sizeof(*pkt));
+    while (NFA_OK(attr, rem_len)) {
+        const char *data = (const char *) NFA_DATA(attr);
+        switch (NFA_TYPE(attr)) {
+            case NFULA_PACKET_HDR:
+                pkt->hw_protocol = ((const struct nfulnl_msg_packet_hdr *) data)->hw_protocol;
+                break;
+            case NFULA_IFINDEX_INDEV:
+                pkt->in_ifindex = ntohl(*(const uint32_t *) data);
+                break;
+            case NFULA_IFINDEX_OUTDEV:
+                pkt->out_ifindex = ntohl(*(const uint32_t *) data);
+                break;
+            case NFULA_PAYLOAD:
+                pkt->payload = (const uint8_t *) data;
+                pkt->payload_len = NFA_PAYLOAD(attr);
+                break;
+            case NFULA_SEQ:
+                seq = ntohl(*(const uint32_t *) data);
+                seq_found = true;
+                break;
+            default:
+                break;
+        }
+        attr = NFA_NEXT(attr, rem_len);
+    }
+
+    if (seq_found) {
+        if (_nflog_seq_valid && seq != _nflog_next_seq) {
+            __atomic_fetch_add(&_nflog_stats.dropped, (uint32_t)(seq - _nflog_next_seq), __ATOMIC_RELAXED);
+        }
+        _nflog_next_seq = seq + 1;
+        _nflog_seq_valid = true;
+    }
+    return pkt->payload != NULL;
+}
+
+int nas_os_nl_nflog_parse (const uint8_t *buf, int size,
+                           nas_nflog_pkt_t *pkts, size_t max_pkts)
+{
+    struct nlmsghdr *nl_hdr = (struct nlmsghdr *) buf;
+    int rem_len = size;
+    size_t count = 0;
+    nas_nflog_pkt_t pkt;
+
+    for (; NLMSG_OK(nl_hdr, rem_len); nl_hdr = NLMSG_NEXT(nl_hdr, rem_len)) {
+        if (nl_hdr->nlmsg_type == NLMSG_ERROR) {
+            struct nlmsgerr *msg_err = (struct nlmsgerr *) NLMSG_DATA(nl_hdr);
+            if (msg_err->error != 0) {
+                EV_LOGGING(NETLINK, ERR,"NK-SOCK-NFLOG",
+                           "Error in processing NFLOG params - %s", strerror(-msg_err->error));
+            }
+            continue;
+        }
+        if (nl_hdr->nlmsg_type != ((NFNL_SUBSYS_ULOG << 8) | NFULNL_MSG_PACKET)) {
+            continue;
+        }
+        if (!nas_nl_parse_nflog_pkt(nl_hdr, (count < max_pkts) ? &pkts[count] : &pkt)) {
+            __atomic_fetch_add(&_nflog_stats.errors, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (count >= max_pkts) {
+            __atomic_fetch_add(&_nflog_stats.dropped, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        count++;
+    }
+    if (rem_len > 0) {
+        EV_LOGGING(NETLINK, ERR,"NK-SOCK-NFLOG","NFLOG datagram with %d trailing bytes", rem_len);
+        __atomic_fetch_add(&_nflog_stats.errors, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&_nflog_stats.packets, count, __ATOMIC_RELAXED);
+    return (int) count;
+}
+
+int nas_os_nl_nflog_recv (int fd, uint8_t *buf, int size,
+                          nas_nflog_pkt_t *pkts, size_t max_pkts)
+{
+    struct iovec iov = { buf, (size_t) size };
+    struct sockaddr_nl snl;
+    struct msghdr msg = { (void *) &snl, sizeof snl, &iov, 1, NULL, 0, 0 };
+    int len;
+
+    do {
+        len = recvmsg(fd, &msg, 0);
+    } while (len < 0 && errno == EINTR);
+
+    if (len < 0) {
+        if (errno == ENOBUFS) {
+            /* Lost packets are accounted from the sequence gap of the next datagram */
+            __atomic_fetch_add(&_nflog_stats.overruns, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        return -1;
+    }
+    __atomic_fetch_add(&_nflog_stats.datagrams, 1, __ATOMIC_RELAXED);
+
+    if (msg.msg_flags & MSG_TRUNC) {
+        EV_LOGGING(NETLINK, ERR,"NK-SOCK-NFLOG","NFLOG datagram truncated to %d bytes", len);
+        __atomic_fetch_add(&_nflog_stats.errors, 1, __ATOMIC_RELAXED);
+    }
+    return nas_os_nl_nflog_parse(buf, len, pkts, max_pkts);
+}
+
+void nas_os_nl_nflog_stats_get (nas_nflog_stats_t *stats)
+{
+    stats->datagrams = __atomic_load_n(&_nflog_stats.datagrams, __ATOMIC_RELAXED);
+    stats->packets = __atomic_load_n(&_nflog_stats.packets, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&_nflog_stats.dropped, __ATOMIC_RELAXED);
+    stats->overruns = __atomic_load_n(&_nflog_stats.overruns, __ATOMIC_RELAXED);
+    stats->errors = __atomic_load_n(&_nflog_stats.errors, __ATOMIC_RELAXED);
+}
+
+void os_debug_nflog_print ()
+{
+    nas_nflog_stats_t stats;
+    nas_os_nl_nflog_stats_get(&stats);
+
+    printf("\r\n %-12s | %-12s | %-12s | %-12s | %-12s\r\n",
+           "#datagrams", "#packets", "#dropped", "#overruns", "#errors");
+    printf("\r %-12lu | %-12lu | %-12lu | %-12lu | %-12lu\r\n",
+           (unsigned long)stats.datagrams, (unsigned long)stats.packets,
+           (unsigned long)stats.dropped, (unsigned long)stats.overruns,
+           (unsigned long)stats.errors);
+}
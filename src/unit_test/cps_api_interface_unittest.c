@@ -23,11 +23,173 @@
 #include "nas_os_interface.h"
 #include "dell-base-if.h"
 #include "dell-base-if-linux.h"
+#include "dell-base-common.h"
 #include "cps_api_object_key.h"
+#include "ietf-interfaces.h"
+#include "db_api_linux_init.h"
 
+#include <net/if.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UT_CHECK(cond) \
+    do { if (!(cond)) { printf("%s:%d check failed: %s\n", __FILE__, __LINE__, #cond); return false; } } while (0)
+
+static bool ut_obj_name_is(cps_api_object_t o, const char *name) {
+    cps_api_object_attr_t attr = cps_api_object_attr_get(o, IF_INTERFACES_INTERFACE_NAME);
+    return (attr != NULL) && (strcmp((const char *)cps_api_object_attr_data_bin(attr), name) == 0);
+}
+
+static bool ut_list_has(cps_api_object_list_t lst, const char *name) {
+    size_t ix = 0;
+    for ( ; ix < cps_api_object_list_size(lst) ; ++ix ) {
+        if (ut_obj_name_is(cps_api_object_list_get(lst,ix), name)) return true;
+    }
+    return false;
+}
+
+/* Filtered gets return exactly the interfaces matching the filter */
+static bool ut_filtered_gets(void) {
+    cps_api_object_list_t lst = cps_api_object_list_create();
+    cps_api_object_t filter = cps_api_object_create();
+    size_t ix = 0;
+
+    /* By name */
+    cps_api_object_attr_add(filter,IF_INTERFACES_INTERFACE_NAME,"ut-get-d1",strlen("ut-get-d1")+1);
+    nas_os_get_interface(filter,lst);
+    UT_CHECK(cps_api_object_list_size(lst) == 1);
+    UT_CHECK(ut_obj_name_is(cps_api_object_list_get(lst,0), "ut-get-d1"));
+    cps_api_object_list_destroy(lst,true);
+    cps_api_object_delete(filter);
+
+    /* By master - the members of the bridge only */
+    lst = cps_api_object_list_create();
+    filter = cps_api_object_create();
+    cps_api_object_attr_add_u32(filter,BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_MASTER,if_nametoindex("ut-get-br"));
+    nas_os_get_interface(filter,lst);
+    UT_CHECK(cps_api_object_list_size(lst) == 2);
+    UT_CHECK(ut_list_has(lst, "ut-get-d0") && ut_list_has(lst, "ut-get-d1"));
+    cps_api_object_list_destroy(lst,true);
+    cps_api_object_delete(filter);
+
+    /* By type - dummy interfaces are loopbacks */
+    lst = cps_api_object_list_create();
+    filter = cps_api_object_create();
+    cps_api_object_attr_add(filter,IF_INTERFACES_INTERFACE_TYPE,"ianaift:softwareLoopback",
+                            strlen("ianaift:softwareLoopback")+1);
+    nas_os_get_interface(filter,lst);
+    UT_CHECK(ut_list_has(lst, "ut-get-d2"));
+    UT_CHECK(!ut_list_has(lst, "ut-get-br"));
+    for ( ; ix < cps_api_object_list_size(lst) ; ++ix ) {
+        cps_api_object_attr_t attr = cps_api_object_attr_get(cps_api_object_list_get(lst,ix),
+                                                             BASE_IF_LINUX_IF_INTERFACES_INTERFACE_DELL_TYPE);
+        UT_CHECK(attr != NULL && cps_api_object_attr_data_uint(attr) == BASE_CMN_INTERFACE_TYPE_LOOPBACK);
+    }
+    cps_api_object_list_destroy(lst,true);
+    cps_api_object_delete(filter);
+
+    /* Everything */
+    lst = cps_api_object_list_create();
+    filter = cps_api_object_create();
+    nas_os_get_interface(filter,lst);
+    UT_CHECK(ut_list_has(lst, "lo") && ut_list_has(lst, "ut-get-br") && ut_list_has(lst, "ut-get-d2"));
+    cps_api_object_list_destroy(lst,true);
+    cps_api_object_delete(filter);
+    return true;
+}
+
+#define UT_SCALE_SUBIFS 4000
+
+/* Interface cache and get counters of the library, with the time of the last get */
+extern void os_debug_if_cache_print(void);
+
+/* VLAN sub-interfaces ut-get-sc.<1..UT_SCALE_SUBIFS> of a dummy, created with one ip batch */
+static bool ut_scale_create(void) {
+    const char *file = "/tmp/ut_get_scale.batch";
+    FILE *fp = fopen(file, "w");
+    int id = 1;
+    if (fp == NULL) return false;
+    fprintf(fp, "link add ut-get-sc type dummy\n");
+    for ( ; id <= UT_SCALE_SUBIFS ; ++id ) {
+        fprintf(fp, "link add link ut-get-sc name ut-get-sc.%d type vlan id %d\n", id, id);
+    }
+    fclose(fp);
+    bool rc = (system("ip -batch /tmp/ut_get_scale.batch") == 0);
+    unlink(file);
+    return rc;
+}
+
+static size_t ut_scale_count(cps_api_object_list_t lst) {
+    size_t ix = 0, cnt = 0;
+    for ( ; ix < cps_api_object_list_size(lst) ; ++ix ) {
+        cps_api_object_attr_t attr = cps_api_object_attr_get(cps_api_object_list_get(lst,ix),
+                                                             IF_INTERFACES_INTERFACE_NAME);
+        if (attr != NULL && strncmp((const char *)cps_api_object_attr_data_bin(attr), "ut-get-sc.", 10) == 0) {
+            ++cnt;
+        }
+    }
+    return cnt;
+}
+
+/*
+ * Get all with the 4K sub-interfaces and a get by name among them, wait_sec is given
+ * for the interface cache to be filled
+ */
+static bool ut_scale_gets(int wait_sec) {
+    cps_api_object_list_t lst = NULL;
+    cps_api_object_t filter = cps_api_object_create();
+    size_t cnt = 0;
+
+    do {
+        if (lst != NULL) {
+            cps_api_object_list_destroy(lst,true);
+            sleep(1);
+        }
+        lst = cps_api_object_list_create();
+        nas_os_get_interface(filter,lst);
+        cnt = ut_scale_count(lst);
+    } while (cnt != UT_SCALE_SUBIFS && wait_sec-- > 0);
+    cps_api_object_list_destroy(lst,true);
+    cps_api_object_delete(filter);
+    os_debug_if_cache_print();
+    UT_CHECK(cnt == UT_SCALE_SUBIFS);
+
+    lst = cps_api_object_list_create();
+    filter = cps_api_object_create();
+    cps_api_object_attr_add(filter,IF_INTERFACES_INTERFACE_NAME,"ut-get-sc.2000",strlen("ut-get-sc.2000")+1);
+    nas_os_get_interface(filter,lst);
+    os_debug_if_cache_print();
+    UT_CHECK(cps_api_object_list_size(lst) == 1);
+    UT_CHECK(ut_obj_name_is(cps_api_object_list_get(lst,0), "ut-get-sc.2000"));
+    cps_api_object_list_destroy(lst,true);
+    cps_api_object_delete(filter);
+    return true;
+}
 
 int main() {
+    if (system("ip link add ut-get-br type bridge && ip link add ut-get-d0 type dummy && "
+               "ip link add ut-get-d1 type dummy && ip link add ut-get-d2 type dummy && "
+               "ip link set ut-get-d0 master ut-get-br && ip link set ut-get-d1 master ut-get-br") != 0) {
+        printf("Test interfaces not created\n");
+        return 1;
+    }
+    /* Served by a kernel dump, then by the interface cache once it is filled */
+    bool rc = ut_scale_create() && ut_filtered_gets() && ut_scale_gets(0);
+    if (rc && cps_api_linux_init() == STD_ERR_OK) {
+        sleep(2);
+        rc = ut_filtered_gets() && ut_scale_gets(30);
+    }
+    if (system("ip link del ut-get-sc") != 0) {
+        printf("Scale interfaces not deleted\n");
+    }
+    if (system("ip link del ut-get-d0; ip link del ut-get-d1; ip link del ut-get-d2; ip link del ut-get-br") != 0) {
+        printf("Test interfaces not deleted\n");
+    }
+    if (!rc) return 1;
+
     cps_api_object_list_t lst = cps_api_object_list_create();
     cps_api_object_t filter = cps_api_object_create();
     nas_os_get_interface(filter,lst);
@@ -25,6 +25,7 @@
 #include "cps_api_interface_types.h"
 #include "cps_api_operation.h"
 #include "cps_api_route.h"
+#include "dell-base-routing.h"
 
 #include "private/netlink_tools.h"
 #include "db_api_linux_init.h"
@@ -227,6 +228,74 @@ bool test_get_all_neigh(void) {
     return rc;
 }
 
+static size_t get_routes(cps_api_object_t start, uint32_t page_count, cps_api_object_list_t out) {
+    cps_api_get_params_t gp;
+    cps_api_get_request_init(&gp);
+
+    cps_api_object_t filt = cps_api_object_list_create_obj_and_append(gp.filters);
+    cps_api_key_init(cps_api_object_key(filt),cps_api_qualifier_TARGET,
+            cps_api_obj_cat_ROUTE,cps_api_route_obj_ROUTE,0);
+    if (start != nullptr) {
+        cps_api_object_attr_t af = cps_api_object_attr_get(start,BASE_ROUTE_OBJ_ENTRY_AF);
+        cps_api_object_attr_t prefix = cps_api_object_attr_get(start,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX);
+        cps_api_object_attr_t len = cps_api_object_attr_get(start,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN);
+        if (af != nullptr) cps_api_object_attr_add_u32(filt,BASE_ROUTE_OBJ_ENTRY_AF,cps_api_object_attr_data_u32(af));
+        if (prefix != nullptr) cps_api_object_attr_add(filt,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,
+                cps_api_object_attr_data_bin(prefix),cps_api_object_attr_len(prefix));
+        if (len != nullptr) cps_api_object_attr_add_u32(filt,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,cps_api_object_attr_data_u32(len));
+    }
+    if (page_count != 0) cps_api_object_attr_add_u32(filt,cps_api_if_ROUTE_A_PAGE_COUNT,page_count);
+
+    size_t count = 0;
+    if (cps_api_get(&gp)==cps_api_ret_code_OK) {
+        count = cps_api_object_list_size(gp.list);
+        for (size_t ix = 0; ix < count; ++ix) {
+            cps_api_object_t obj = cps_api_object_create();
+            cps_api_object_clone(obj,cps_api_object_list_get(gp.list,ix));
+            cps_api_object_list_append(out,obj);
+        }
+    }
+    cps_api_get_request_close(&gp);
+    return count;
+}
+
+bool test_get_routes_paged() {
+    cps_api_object_list_t all = cps_api_object_list_create();
+    cps_api_object_list_t paged = cps_api_object_list_create();
+
+    size_t total = get_routes(nullptr, 0, all);
+    cps_api_object_t start = nullptr;
+    while (cps_api_object_list_size(paged) <= total) {
+        /* Small pages to go through several of them */
+        if (get_routes(start, 2, paged) == 0) break;
+        start = cps_api_object_list_get(paged, cps_api_object_list_size(paged)-1);
+    }
+    bool rc = (cps_api_object_list_size(paged) == total);
+
+    /* Same key without a count is a plain get - the keyed route is returned */
+    if (total > 0) {
+        cps_api_object_list_t keyed = cps_api_object_list_create();
+        cps_api_object_t first = cps_api_object_list_get(all, 0);
+        rc = rc && (get_routes(first, 0, keyed) > 0);
+        cps_api_object_attr_t want = cps_api_object_attr_get(first,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX);
+        bool found = false;
+        for (size_t ix = 0; ix < cps_api_object_list_size(keyed) && !found; ++ix) {
+            cps_api_object_attr_t prefix = cps_api_object_attr_get(cps_api_object_list_get(keyed, ix),
+                                                                   BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX);
+            found = (want == nullptr) ? (prefix == nullptr) :
+                    (prefix != nullptr && cps_api_object_attr_len(prefix) == cps_api_object_attr_len(want) &&
+                     memcmp(cps_api_object_attr_data_bin(prefix), cps_api_object_attr_data_bin(want),
+                            cps_api_object_attr_len(want)) == 0);
+        }
+        rc = rc && found;
+        cps_api_object_list_destroy(keyed,true);
+    }
+
+    cps_api_object_list_destroy(paged,true);
+    cps_api_object_list_destroy(all,true);
+    return rc;
+}
+
 TEST(std_route_test, get_all_routes) {
     ASSERT_EQ(STD_ERR_OK,cps_api_linux_init()); //test that after registration service starts up
     ASSERT_TRUE(cps_api_unittest_init());
@@ -236,6 +305,10 @@ TEST(std_route_test, get_all_routes) {
     ASSERT_EQ(true,test_get_all_neigh());
 }
 
+TEST(std_route_test, get_routes_paged) {
+    ASSERT_EQ(true,test_get_routes_paged());
+}
+
 TEST(std_route_test_nl, get_nl_routes) {
     ASSERT_EQ(true,test_netlink());
 }
@@ -25,7 +25,15 @@
 #include "dell-base-stg.h"
 
 #include <gtest/gtest.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 static bool run_test_mode = false;
 
@@ -80,12 +88,167 @@ bool nas_linux_vlan_stg_set(){
     return true;
 }
 
+/*
+ * Full MSTP instance convergence - every port/VLAN pair of the instance is moved
+ * to blocking and then to forwarding with one bulk call each
+ */
+bool nas_linux_stg_bulk_set(){
+    std::vector<int> ports;
+    int vlan_start, vlan_count;
+    if (!run_test_mode) {
+        int port_count, first_port;
+        std::cout<<"Please Enter first Interface Index, number of ports, first VLAN ID and number of VLANs"<<std::endl;
+        std::cin>>first_port;
+        std::cin>>port_count;
+        std::cin>>vlan_start;
+        std::cin>>vlan_count;
+        for (int ix = 0; ix < port_count; ++ix) ports.push_back(first_port + ix);
+    } else {
+        ports.push_back(20);
+        vlan_start = 1;
+        vlan_count = 1000;
+    }
+
+    std::vector<nas_os_stp_port_state_t> entries;
+    for (auto port : ports) {
+        for (int vlan = vlan_start; vlan < vlan_start + vlan_count; ++vlan) {
+            entries.push_back({(hal_ifindex_t)port, (hal_vlan_id_t)vlan, BASE_STG_INTERFACE_STATE_BLOCKING});
+        }
+    }
+
+    /* Nothing to program */
+    if(nl_int_update_stp_state_bulk(NULL, 0, NULL) != STD_ERR_OK){
+        std::cout<<"Empty bulk STP state update failed"<<std::endl;
+        return false;
+    }
+
+    for (auto state : {BASE_STG_INTERFACE_STATE_BLOCKING, BASE_STG_INTERFACE_STATE_FORWARDING}) {
+        for (auto &entry : entries) entry.state = state;
+        if(nl_int_update_stp_state_bulk(&entries[0], entries.size(), NULL) != STD_ERR_OK){
+            std::cout<<"Bulk STP state update failed"<<std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Reader contention under an STP storm - reader threads look up the port state the
+ * way the bridge port event handler does while the state keeps flipping
+ */
+bool nas_linux_stg_read_storm(){
+    const int reader_cnt = 8;
+    const int duration_ms = 2000;
+    const int ifindex = 20;
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> reads(0);
+    std::atomic<uint64_t> bad_reads(0);
+    uint64_t flips = 0;
+
+    /* Only the two states programmed below can be read back */
+    std::vector<std::thread> readers;
+    for (int ix = 0; ix < reader_cnt; ++ix) {
+        readers.emplace_back([&]() {
+            uint64_t cnt = 0, bad = 0;
+            uint8_t state;
+            while (!stop) {
+                if (get_if_stp_state(ifindex, &state) == STD_ERR_OK &&
+                    state != BASE_STG_INTERFACE_STATE_FORWARDING && state != BASE_STG_INTERFACE_STATE_BLOCKING) {
+                    ++bad;
+                }
+                ++cnt;
+            }
+            reads += cnt;
+            bad_reads += bad;
+        });
+    }
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+    while (std::chrono::steady_clock::now() < end) {
+        cps_api_object_t obj = cps_api_object_create();
+        cps_api_object_attr_add_u32(obj,BASE_STG_ENTRY_INTF_IF_INDEX_IFINDEX,ifindex);
+        cps_api_object_attr_add_u32(obj,BASE_STG_ENTRY_INTF_STATE,(flips & 1) ?
+                                    BASE_STG_INTERFACE_STATE_FORWARDING : BASE_STG_INTERFACE_STATE_BLOCKING);
+        nl_int_update_stp_state(obj);
+        cps_api_object_delete(obj);
+        ++flips;
+    }
+    stop = true;
+    for (auto &th : readers) th.join();
+
+    if (bad_reads != 0) {
+        std::cout<<bad_reads<<" of "<<reads<<" state reads were not a programmed state"<<std::endl;
+        return false;
+    }
+    return reads != 0 && flips != 0;
+}
+
+/* Bridge port state of the kernel, -1 if not a bridge port */
+static int nas_linux_stg_port_state(const char *if_name){
+    std::string path = std::string("/sys/class/net/") + if_name + "/brport/state";
+    FILE *fp = fopen(path.c_str(), "r");
+    if (fp == NULL) return -1;
+    int state = -1;
+    if (fscanf(fp, "%d", &state) != 1) state = -1;
+    fclose(fp);
+    return state;
+}
+
+/*
+ * A port the kernel rejects is not cached as programmed - the next bulk call
+ * programs it once it is a bridge port
+ */
+bool nas_linux_stg_bulk_reject(){
+    if (system("ip link add ut-stg-br type bridge && ip link add ut-stg-p0 type dummy && "
+               "ip link add ut-stg-p1 type dummy && ip link set ut-stg-p0 master ut-stg-br") != 0) {
+        std::cout<<"Failed to create the test bridge"<<std::endl;
+        return false;
+    }
+    std::vector<nas_os_stp_port_state_t> entries = {
+        {(hal_ifindex_t)if_nametoindex("ut-stg-p0"), 0, BASE_STG_INTERFACE_STATE_BLOCKING},
+        {(hal_ifindex_t)if_nametoindex("ut-stg-p1"), 0, BASE_STG_INTERFACE_STATE_BLOCKING},
+    };
+    int err[2] = {-1, -1};
+    uint8_t state;
+
+    /* ut-stg-p1 is not a bridge port yet */
+    bool rc = nl_int_update_stp_state_bulk(&entries[0], entries.size(), err) != STD_ERR_OK &&
+              err[0] == 0 && err[1] != 0 &&
+              nas_linux_stg_port_state("ut-stg-p0") == BASE_STG_INTERFACE_STATE_BLOCKING &&
+              (get_if_stp_state(entries[1].ifindex, &state) != STD_ERR_OK ||
+               state != BASE_STG_INTERFACE_STATE_BLOCKING);
+    if (!rc) std::cout<<"Rejected port not reported, err "<<err[0]<<" "<<err[1]<<std::endl;
+
+    if (rc && system("ip link set ut-stg-p1 master ut-stg-br") == 0) {
+        rc = nl_int_update_stp_state_bulk(&entries[0], entries.size(), err) == STD_ERR_OK &&
+             err[0] == 0 && err[1] == 0 &&
+             nas_linux_stg_port_state("ut-stg-p1") == BASE_STG_INTERFACE_STATE_BLOCKING &&
+             get_if_stp_state(entries[1].ifindex, &state) == STD_ERR_OK &&
+             state == BASE_STG_INTERFACE_STATE_BLOCKING;
+        if (!rc) std::cout<<"Rejected port not programmed on retry, err "<<err[1]<<std::endl;
+    }
+
+    system("ip link del ut-stg-p0; ip link del ut-stg-p1; ip link del ut-stg-br");
+    return rc;
+}
 
 TEST(nas_linux_stg_test, update_stp_state) {
     ASSERT_TRUE(nas_linux_stg_set());
     ASSERT_TRUE(nas_linux_vlan_stg_set());
 }
 
+TEST(nas_linux_stg_test, update_stp_state_bulk) {
+    ASSERT_TRUE(nas_linux_stg_bulk_set());
+}
+
+TEST(nas_linux_stg_test, update_stp_state_bulk_reject) {
+    ASSERT_TRUE(nas_linux_stg_bulk_reject());
+}
+
+TEST(nas_linux_stg_test, stp_state_read_storm) {
+    ASSERT_TRUE(nas_linux_stg_read_storm());
+}
+
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
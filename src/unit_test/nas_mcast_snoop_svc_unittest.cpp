@@ -20,7 +20,12 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "cps_class_map.h"
 #include "cps_api_operation.h"
@@ -52,11 +57,27 @@ static int event_reg = false;
 static int event_type = 0;
 static cps_api_key_t mc_igmp_obj_key;
 static cps_api_key_t mc_mld_obj_key;
+static std::atomic<uint32_t> storm_grp_add(0);
+static std::atomic<uint32_t> storm_grp_del(0);
+
+/* Count the group list entries of a (batched) group event */
+static void _ut_count_groups(cps_api_object_t evt_obj, cps_api_attr_id_t grp_id, cps_api_operation_types_t op)
+{
+    cps_api_object_it_t it;
+    cps_api_object_it_begin(evt_obj, &it);
+    if (!cps_api_object_it_find(&it, grp_id)) return;
+
+    for (cps_api_object_it_inside(&it); cps_api_object_it_valid(&it); cps_api_object_it_next(&it)) {
+        if (op == cps_api_oper_CREATE) ++storm_grp_add;
+        else if (op == cps_api_oper_DELETE) ++storm_grp_del;
+    }
+}
 
 static bool mc_event_handler(cps_api_object_t evt_obj, void *param)
 {
     cps_api_object_attr_t vlan_id_attr;
     cps_api_attr_id_t mrouter_id;
+    cps_api_attr_id_t grp_id;
 
     std::cout<<"IGMP/MLD event back handler"<<std::endl;
     if (cps_api_key_matches(&mc_igmp_obj_key,
@@ -67,6 +88,7 @@ static bool mc_event_handler(cps_api_object_t evt_obj, void *param)
                 IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_IGMP_SNOOPING_VLANS_VLAN_VLAN_ID);
 
         mrouter_id = IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_IGMP_SNOOPING_VLANS_VLAN_MROUTER_INTERFACE;
+        grp_id = IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_IGMP_SNOOPING_VLANS_VLAN_GROUP;
     } else if (cps_api_key_matches(&mc_mld_obj_key,
                     cps_api_object_key(evt_obj), 1) == 0) {
         event_type = 2;
@@ -75,6 +97,7 @@ static bool mc_event_handler(cps_api_object_t evt_obj, void *param)
                 IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_MLD_SNOOPING_VLANS_VLAN_VLAN_ID);
 
         mrouter_id = IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_MLD_SNOOPING_VLANS_VLAN_MROUTER_INTERFACE;
+        grp_id = IGMP_MLD_SNOOPING_RT_ROUTING_STATE_CONTROL_PLANE_PROTOCOLS_MLD_SNOOPING_VLANS_VLAN_GROUP;
     } else {
         char key_buf[KEY_PRINT_BUF_LEN];
         std::cout<<"Unsupported object key: "<<cps_api_key_print(cps_api_object_key(evt_obj), key_buf, sizeof(key_buf))<<std::endl;
@@ -98,6 +121,8 @@ static bool mc_event_handler(cps_api_object_t evt_obj, void *param)
                    " operation : "<<received_op<<std::endl;
     }
 
+    _ut_count_groups(evt_obj, grp_id, received_op);
+
     cps_api_object_it_t it;
     for (cps_api_object_it_begin(evt_obj, &it); cps_api_object_it_valid(&it);
          cps_api_object_it_next(&it)) {
@@ -435,6 +460,63 @@ TEST(std_mcast_snoop_test, mcast_snoop_status) {
 
 }
 
+static bool _ut_wait_groups(std::atomic<uint32_t> &counter, uint32_t expected, int timeout_sec)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+    while (counter < expected) {
+        if (std::chrono::steady_clock::now() > end) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+/* Batch file of "bridge -batch" commands, empty name on failure */
+static std::string _ut_mdb_batch_file(const char *cmd, uint32_t groups)
+{
+    char path[] = "/tmp/nas_mdb_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) return "";
+    FILE *fp = fdopen(fd, "w");
+    if (fp == nullptr) {
+        close(fd);
+        unlink(path);
+        return "";
+    }
+    for (uint32_t ix = 0; ix < groups; ++ix) {
+        fprintf(fp, "mdb %s dev %s port %s grp 239.1.%u.%u\n", cmd, vlan_name.c_str(), mem_port1.c_str(),
+                ix / 250, ix % 250 + 1);
+    }
+    fclose(fp);
+    return path;
+}
+
+/* Scale test - run with --gtest_also_run_disabled_tests */
+TEST(std_mcast_snoop_test, DISABLED_mcast_snoop_join_leave_storm) {
+    /* Join and leave 8K groups, every group event has to be received */
+    const uint32_t storm_groups = 8192;
+    std::string join_file = _ut_mdb_batch_file("add", storm_groups);
+    std::string leave_file = _ut_mdb_batch_file("del", storm_groups);
+    ASSERT_FALSE(join_file.empty());
+    ASSERT_FALSE(leave_file.empty());
+
+    storm_grp_add = 0;
+    int join_rc = system(("bridge -force -batch " + join_file).c_str());
+    bool joined = (join_rc == 0) && _ut_wait_groups(storm_grp_add, storm_groups, 60);
+
+    storm_grp_del = 0;
+    int leave_rc = system(("bridge -force -batch " + leave_file).c_str());
+    bool left = (leave_rc == 0) && _ut_wait_groups(storm_grp_del, storm_groups, 60);
+
+    unlink(join_file.c_str());
+    unlink(leave_file.c_str());
+    ASSERT_EQ(join_rc, 0);
+    ASSERT_EQ(leave_rc, 0);
+    ASSERT_TRUE(joined);
+    ASSERT_TRUE(left);
+    ASSERT_EQ(storm_grp_add.load(), storm_groups);
+    ASSERT_EQ(storm_grp_del.load(), storm_groups);
+}
+
 TEST(std_mcast_snoop_test, mcast_base_snoop_cleanup) {
 
     std::string tagged_mem_port3 = mem_port3+'.'+std::to_string(vlan_id);
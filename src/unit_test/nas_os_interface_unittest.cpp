@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * nas_os_interface_unittest.cpp
+ */
+
+#include "nas_os_interface.h"
+#include "dell-base-if-linux.h"
+#include "cps_api_object.h"
+#include "private/nas_os_int_utils.h"
+#include "private/os_interface_damp.h"
+#include "private/nas_os_trace.h"
+#include "private/nas_os_br_attr.h"
+#include "private/nas_os_ctl_sock.h"
+#include "private/nas_os_if_stats.h"
+
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/rtnetlink.h>
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netfilter/nfnetlink_log.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static auto & _damp_published = *(new std::vector<unsigned int>);
+
+static void damp_publish(cps_api_object_t obj) {
+    cps_api_object_attr_t attr = cps_api_object_attr_get(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_FLAGS);
+    _damp_published.push_back(attr ? cps_api_object_attr_data_u32(attr) : 0);
+    cps_api_object_delete(obj);
+}
+
+static bool damp_event(hal_ifindex_t ifindex, unsigned int flags) {
+    cps_api_object_t obj = cps_api_object_create();
+    cps_api_object_attr_add_u32(obj, BASE_IF_LINUX_IF_INTERFACES_INTERFACE_IF_FLAGS, flags);
+    bool rc = os_if_damp_event(ifindex, OS_IF_OPER_CHANGE, obj);
+    cps_api_object_delete(obj);
+    return rc;
+}
+
+TEST(nas_os_if_test, link_event_damp) {
+    const hal_ifindex_t ifindex = 10000;
+    nas_os_if_damp_cfg_t dflt, cfg;
+    uint64_t wait_us = 0;
+
+    /* Off by default - every event goes out */
+    ASSERT_EQ(nas_os_if_damp_config_get(&dflt), STD_ERR_OK);
+    ASSERT_EQ(dflt.hold_down_ms, 0U);
+    ASSERT_TRUE(damp_event(ifindex, IFF_UP));
+    ASSERT_TRUE(damp_event(ifindex, IFF_UP | IFF_RUNNING));
+
+    cfg = dflt;
+    cfg.hold_down_ms = 100;
+    cfg.suppress_threshold = 0;
+    cfg.reuse_threshold = 0;
+    ASSERT_EQ(nas_os_if_damp_config_set(&cfg), STD_ERR_OK);
+
+    /* First transition out right away, the rest of the window is coalesced */
+    ASSERT_TRUE(damp_event(ifindex, IFF_UP));
+    ASSERT_FALSE(damp_event(ifindex, IFF_UP | IFF_RUNNING));
+    ASSERT_FALSE(damp_event(ifindex, IFF_UP));
+    ASSERT_FALSE(damp_event(ifindex, IFF_UP | IFF_RUNNING));
+    ASSERT_TRUE(os_if_damp_next_timeout(&wait_us));
+
+    _damp_published.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.hold_down_ms + 10));
+    os_if_damp_flush(damp_publish);
+    ASSERT_EQ(_damp_published.size(), 1U);
+    ASSERT_EQ(_damp_published[0], (unsigned int)(IFF_UP | IFF_RUNNING));
+
+    /* Flapped back to the published state - nothing to publish */
+    ASSERT_FALSE(damp_event(ifindex, IFF_UP));
+    ASSERT_FALSE(damp_event(ifindex, IFF_UP | IFF_RUNNING));
+    _damp_published.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.hold_down_ms + 10));
+    os_if_damp_flush(damp_publish);
+    ASSERT_TRUE(_damp_published.empty());
+
+    nas_os_if_damp_stats_t stats;
+    ASSERT_EQ(nas_os_if_damp_stats_get(ifindex, &stats), STD_ERR_OK);
+    ASSERT_EQ(stats.suppressed, 5U);
+
+    os_if_damp_delete(ifindex);
+    ASSERT_EQ(nas_os_if_damp_config_set(&dflt), STD_ERR_OK);
+}
+
+TEST(nas_os_if_test, trace_ring) {
+    uint64_t written, dropped, base_written, base_dropped;
+
+    /* Off by default - nothing recorded */
+    ASSERT_FALSE(nas_os_trace_on);
+    nas_os_trace_stats_get(&base_written, &base_dropped);
+    for (int ix = 0; ix < 10; ++ix) {
+        NAS_OS_TRACE("UT", "ifindex %d flags 0x%x", ix, IFF_UP);
+    }
+    nas_os_trace_stats_get(&written, &dropped);
+    ASSERT_EQ(written, base_written);
+    ASSERT_EQ(dropped, base_dropped);
+
+    /* A burst of 2 per call site, the rest is rate limited */
+    nas_os_trace_rate_set(1, 2);
+    nas_os_trace_enable(true);
+    for (int ix = 0; ix < 10; ++ix) {
+        NAS_OS_TRACE("UT", "ifindex %d flags 0x%x", ix, IFF_UP);
+    }
+    nas_os_trace_enable(false);
+    nas_os_trace_stats_get(&written, &dropped);
+    ASSERT_EQ(written - base_written, 2U);
+    ASSERT_EQ(dropped - base_dropped, 8U);
+
+    nas_os_trace_rate_set(100, 200);
+    nas_os_trace_clear();
+}
+
+TEST(nas_os_if_test, br_attr_cache) {
+    const char *br_name = "ut-br-attr";
+    long val = -1;
+
+    ASSERT_EQ(system("ip link add ut-br-attr type bridge"), 0);
+    hal_ifindex_t br_index = if_nametoindex(br_name);
+    ASSERT_NE(br_index, 0);
+
+    ASSERT_TRUE(nas_os_br_attr_set(br_index, br_name, NAS_OS_BR_ATTR_MCAST_QUERIER, 1));
+    ASSERT_TRUE(nas_os_br_attr_get(br_index, br_name, NAS_OS_BR_ATTR_MCAST_QUERIER, &val));
+    ASSERT_EQ(val, 1);
+
+    /* Written through sysfs by another process - never answered from a stale cache */
+    ASSERT_EQ(system("echo 0 > /sys/class/net/ut-br-attr/bridge/multicast_querier"), 0);
+    ASSERT_TRUE(nas_os_br_attr_get(br_index, br_name, NAS_OS_BR_ATTR_MCAST_QUERIER, &val));
+    ASSERT_EQ(val, 0);
+
+    nas_os_br_attr_link_event(RTM_DELLINK, br_index, br_name, "bridge", NULL);
+    ASSERT_EQ(system("ip link del ut-br-attr"), 0);
+}
+
+static void nflog_ut_attr(std::vector<uint8_t> &buf, uint16_t type, const void *data, size_t len) {
+    struct nlattr nla;
+    nla.nla_len = NLA_HDRLEN + len;
+    nla.nla_type = type;
+    size_t off = buf.size();
+    buf.resize(off + NLA_ALIGN(nla.nla_len), 0);
+    memcpy(&buf[off], &nla, sizeof(nla));
+    memcpy(&buf[off + NLA_HDRLEN], data, len);
+}
+
+/* Appends one NFULNL_MSG_PACKET message, no payload when payload_len is 0 */
+static void nflog_ut_pkt(std::vector<uint8_t> &buf, uint32_t in_ifindex, uint32_t seq,
+                         const char *payload, size_t payload_len) {
+    size_t off = buf.size();
+    buf.resize(off + NLMSG_SPACE(sizeof(struct nfgenmsg)), 0);
+
+    struct nfulnl_msg_packet_hdr pkt_hdr;
+    memset(&pkt_hdr, 0, sizeof(pkt_hdr));
+    pkt_hdr.hw_protocol = htons(0x0806);
+    nflog_ut_attr(buf, NFULA_PACKET_HDR, &pkt_hdr, sizeof(pkt_hdr));
+    uint32_t val = htonl(in_ifindex);
+    nflog_ut_attr(buf, NFULA_IFINDEX_INDEV, &val, sizeof(val));
+    if (payload_len != 0) nflog_ut_attr(buf, NFULA_PAYLOAD, payload, payload_len);
+    val = htonl(seq);
+    nflog_ut_attr(buf, NFULA_SEQ, &val, sizeof(val));
+
+    struct nlmsghdr *nlh = (struct nlmsghdr *)&buf[off];
+    nlh->nlmsg_len = buf.size() - off;
+    nlh->nlmsg_type = (NFNL_SUBSYS_ULOG << 8) | NFULNL_MSG_PACKET;
+    struct nfgenmsg *nfg = (struct nfgenmsg *)NLMSG_DATA(nlh);
+    nfg->nfgen_family = AF_BRIDGE;
+    nfg->version = NFNETLINK_V0;
+    nfg->res_id = htons(100);
+}
+
+TEST(nas_os_if_test, nflog_parse) {
+    std::vector<uint8_t> buf;
+    nas_nflog_pkt_t pkts[2];
+    nas_nflog_stats_t base, stats;
+
+    nas_os_nl_nflog_stats_get(&base);
+
+    /* Two packets of one datagram */
+    nflog_ut_pkt(buf, 11, 1, "arp-req", 7);
+    nflog_ut_pkt(buf, 12, 2, "arp-reply", 9);
+    ASSERT_EQ(nas_os_nl_nflog_parse(&buf[0], buf.size(), pkts, 2), 2);
+    ASSERT_EQ(pkts[0].hw_protocol, htons(0x0806));
+    ASSERT_EQ(pkts[0].in_ifindex, 11U);
+    ASSERT_EQ(pkts[0].payload_len, 7);
+    ASSERT_EQ(memcmp(pkts[0].payload, "arp-req", 7), 0);
+    /* Payload is returned in place, not copied */
+    ASSERT_TRUE(pkts[0].payload > &buf[0] && pkts[0].payload < &buf[0] + buf.size());
+    ASSERT_EQ(pkts[1].in_ifindex, 12U);
+    ASSERT_EQ(pkts[1].payload_len, 9);
+    ASSERT_EQ(memcmp(pkts[1].payload, "arp-reply", 9), 0);
+
+    /* Sequence gap of 2, a packet past the caller array and one without payload */
+    buf.clear();
+    nflog_ut_pkt(buf, 13, 5, "a", 1);
+    nflog_ut_pkt(buf, 14, 6, "b", 1);
+    nflog_ut_pkt(buf, 15, 7, NULL, 0);
+    ASSERT_EQ(nas_os_nl_nflog_parse(&buf[0], buf.size(), pkts, 1), 1);
+    ASSERT_EQ(pkts[0].in_ifindex, 13U);
+
+    /* Truncated datagram - the partial message is not returned */
+    buf.clear();
+    nflog_ut_pkt(buf, 16, 8, "c", 1);
+    ASSERT_EQ(nas_os_nl_nflog_parse(&buf[0], buf.size() - 4, pkts, 2), 0);
+
+    nas_os_nl_nflog_stats_get(&stats);
+    ASSERT_EQ(stats.packets - base.packets, 3U);
+    ASSERT_EQ(stats.dropped - base.dropped, 3U);
+    ASSERT_EQ(stats.errors - base.errors, 2U);
+}
+
+TEST(nas_os_if_test, ctl_sock_pool) {
+    const int iterations = 100;
+    nas_os_ctl_sock_stats_t before, after;
+    unsigned int mtu = 0;
+
+    nas_os_ctl_sock_stats_get(&before);
+    for (int it = 0; it < iterations; ++it) {
+        ASSERT_EQ(nas_os_util_int_mtu_get("lo", &mtu), STD_ERR_OK);
+    }
+    nas_os_ctl_sock_stats_get(&after);
+
+    /* At most one socket opened for the default VRF */
+    ASSERT_EQ(after.gets, before.gets + iterations);
+    ASSERT_LE(after.creates, before.creates + 1);
+    ASSERT_EQ(after.failures, before.failures);
+
+    /* Same answer as an ioctl on a socket of our own */
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, "lo", sizeof(ifr.ifr_name)-1);
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(sock, -1);
+    ASSERT_GE(ioctl(sock, SIOCGIFMTU, &ifr), 0);
+    close(sock);
+    ASSERT_EQ(mtu, (unsigned int)ifr.ifr_mtu);
+
+    /* Users of a VRF share its socket */
+    int sock1 = nas_os_ctl_sock_get(NULL);
+    int sock2 = nas_os_ctl_sock_get(NULL);
+    ASSERT_NE(sock1, -1);
+    ASSERT_EQ(sock1, sock2);
+    nas_os_ctl_sock_put(sock2);
+    nas_os_ctl_sock_put(sock1);
+    nas_os_ctl_sock_stats_get(&before);
+    ASSERT_EQ(before.creates, after.creates);
+}
+
+TEST(nas_os_if_test, if_stats_bulk) {
+    ASSERT_EQ(system("ip link add ut-stats-v0 type veth peer name ut-stats-v1"), 0);
+    ASSERT_EQ(system("ip link set ut-stats-v0 up && ip link set ut-stats-v1 up"), 0);
+    hal_ifindex_t if_index = (hal_ifindex_t)if_nametoindex("ut-stats-v0");
+    hal_ifindex_t peer_index = (hal_ifindex_t)if_nametoindex("ut-stats-v1");
+    ASSERT_NE(if_index, 0);
+    ASSERT_NE(peer_index, 0);
+
+    nas_os_if_stats_tbl_t *tbl = nas_os_if_stats_tbl_create(NULL, 8192);
+    ASSERT_TRUE(tbl != NULL);
+    ASSERT_EQ(nas_os_if_stats_tbl_poll(tbl), STD_ERR_OK);
+
+    /* Both ends of the pair in the dump, each entry found by its ifindex */
+    size_t count = 0;
+    const nas_os_if_stats_ent_t *ents = nas_os_if_stats_tbl_entries(tbl, &count);
+    ASSERT_GE(count, 2U);
+    for (size_t ix = 0; ix < count; ++ix) {
+        ASSERT_EQ(nas_os_if_stats_tbl_get(tbl, ents[ix].ifindex), &ents[ix].stats);
+    }
+    const os_int_stats_t *stats = nas_os_if_stats_tbl_get(tbl, if_index);
+    ASSERT_TRUE(stats != NULL);
+    ASSERT_TRUE(nas_os_if_stats_tbl_get(tbl, peer_index) != NULL);
+    os_int_stats_t first = *stats;
+
+    /* Only the filtered interface is kept, the counters do not go back */
+    nas_os_if_stats_tbl_filter(tbl, if_index, true);
+    ASSERT_EQ(nas_os_if_stats_tbl_poll(tbl), STD_ERR_OK);
+    ents = nas_os_if_stats_tbl_entries(tbl, &count);
+    ASSERT_EQ(count, 1U);
+    ASSERT_EQ(ents[0].ifindex, if_index);
+    ASSERT_TRUE(nas_os_if_stats_tbl_get(tbl, peer_index) == NULL);
+    ASSERT_GE(ents[0].stats.output_packets, first.output_packets);
+    ASSERT_GE(ents[0].stats.input_packets, first.input_packets);
+
+    nas_os_if_stats_tbl_stats_t tbl_stats;
+    nas_os_if_stats_tbl_stats_get(tbl, &tbl_stats);
+    ASSERT_EQ(tbl_stats.polls, 2U);
+    ASSERT_EQ(tbl_stats.entries, 1U);
+    ASSERT_EQ(tbl_stats.skipped, 0U);
+    nas_os_if_stats_tbl_delete(tbl);
+
+    /* The interfaces over the table size are counted, not kept */
+    tbl = nas_os_if_stats_tbl_create(NULL, 1);
+    ASSERT_TRUE(tbl != NULL);
+    ASSERT_EQ(nas_os_if_stats_tbl_poll(tbl), STD_ERR_OK);
+    nas_os_if_stats_tbl_entries(tbl, &count);
+    ASSERT_EQ(count, 1U);
+    nas_os_if_stats_tbl_stats_get(tbl, &tbl_stats);
+    ASSERT_GE(tbl_stats.skipped, 1U);
+    nas_os_if_stats_tbl_delete(tbl);
+
+    ASSERT_EQ(system("ip link del ut-stats-v0"), 0);
+}
+
+/* A reset counter is counted from zero - the delta is never over the counter */
+static void if_stats_sample_check(const nas_os_if_stats_sample_t &sample) {
+    ASSERT_LE(sample.delta.input_packets, sample.stats.input_packets);
+    ASSERT_LE(sample.delta.input_bytes, sample.stats.input_bytes);
+    ASSERT_LE(sample.delta.output_packets, sample.stats.output_packets);
+    ASSERT_LE(sample.delta.output_bytes, sample.stats.output_bytes);
+}
+
+static bool if_stats_sample_wait(hal_ifindex_t if_index, unsigned int interval_ms, nas_os_if_stats_sample_t *sample) {
+    for (int it = 0; it < 20; ++it) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        if (nas_os_if_stats_engine_get(NULL, if_index, sample)) return true;
+    }
+    return false;
+}
+
+TEST(nas_os_if_test, if_stats_engine) {
+    const char *add = "ip link add ut-eng-v0 index 4000 type veth peer name ut-eng-v1 && "
+                      "ip link set ut-eng-v0 up && ip link set ut-eng-v1 up && "
+                      "ip addr add 10.251.0.1/24 dev ut-eng-v0";
+    /* ARP requests out of ut-eng-v0, no answer needed */
+    const char *traffic = "ping -c 3 -i 0.2 -W 1 10.251.0.2 > /dev/null 2>&1; true";
+    nas_os_if_stats_cfg_t cfg = {100, 4};
+    nas_os_if_stats_sample_t sample;
+    hal_ifindex_t if_index = 4000;
+
+    ASSERT_EQ(system(add), 0);
+    ASSERT_EQ(system(traffic), 0);
+
+    ASSERT_EQ(nas_os_if_stats_config_set(&cfg), STD_ERR_OK);
+    /* The first read adds the VRF to the sampler */
+    nas_os_if_stats_engine_get(NULL, if_index, &sample);
+    ASSERT_TRUE(if_stats_sample_wait(if_index, cfg.interval_ms, &sample));
+    ASSERT_NE(sample.interval_ms, 0U);
+    if_stats_sample_check(sample);
+
+    /* Same ifindex with the counters back from zero, the RTM_DELLINK drops the old samples */
+    ASSERT_EQ(system("ip link del ut-eng-v0"), 0);
+    nas_os_if_stats_engine_if_reset(if_index);
+    ASSERT_FALSE(nas_os_if_stats_engine_get(NULL, if_index, &sample));
+    ASSERT_EQ(system(add), 0);
+    for (unsigned int it = 0; it < cfg.ring_len + 2; ++it) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cfg.interval_ms));
+        if (nas_os_if_stats_engine_get(NULL, if_index, &sample)) if_stats_sample_check(sample);
+    }
+    ASSERT_TRUE(if_stats_sample_wait(if_index, cfg.interval_ms, &sample));
+    if_stats_sample_check(sample);
+    ASSERT_EQ(system("ip link del ut-eng-v0"), 0);
+
+    /* Stopped engine - the readers go back to the ethtool read */
+    cfg.interval_ms = 0;
+    ASSERT_EQ(nas_os_if_stats_config_set(&cfg), STD_ERR_OK);
+    ASSERT_FALSE(nas_os_if_stats_engine_get(NULL, if_index, &sample));
+
+    cfg.ring_len = 1;
+    ASSERT_NE(nas_os_if_stats_config_set(&cfg), STD_ERR_OK);
+}
+
+TEST(nas_os_if_test, if_stats_ctr_delta) {
+    /* 32 bit counter sampled at 0xFFFFFFF0, 0x10 and 0x30 */
+    ASSERT_EQ(nas_os_if_stats_ctr_delta(0xFFFFFFF0ULL, 0x10, true), 0x20ULL);
+    ASSERT_EQ(nas_os_if_stats_ctr_delta(0x10, 0x30, true), 0x20ULL);
+    /* 64 bit counter, a decrease is a reset */
+    ASSERT_EQ(nas_os_if_stats_ctr_delta(0xFFFFFFF0ULL, 0x10, false), 0x10ULL);
+    /* Past 32 bits the counter is not 32 bit, a decrease is a reset */
+    ASSERT_EQ(nas_os_if_stats_ctr_delta(0x1FFFFFFFFULL, 5, true), 5ULL);
+    ASSERT_EQ(nas_os_if_stats_ctr_delta(5, 1000, true), 995ULL);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -35,12 +35,25 @@
 #include "dell-base-routing.h"
 #include "ietf-network-instance.h"
 #include "nas_os_l3.h"
+#include "nas_os_interface.h"
+#include "private/nas_os_l3_utils.h"
+#include "private/nas_os_if_resolve.h"
+#include "private/nas_os_rt_shadow.h"
+#include "private/netlink_tools.h"
+#include "private/nas_os_snapshot.h"
 #include "ds_api_linux_neigh.h"
 #include "ds_common_types.h"
 
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <net/if.h>
+#include <unistd.h>
+#include <linux/rtnetlink.h>
+#include <errno.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
 
 static bool run_test_mode = false;
 
@@ -1186,6 +1199,421 @@ TEST(std_nas_route_test, nas_os_vrf_cfg) {
     ASSERT_TRUE(rc == cps_api_ret_code_OK);
 }
 
+#define NAS_UT_RT_MAX_THREADS   16
+#define NAS_UT_RT_PER_THREAD    1000
+
+static std::string nas_ut_rt_vrf_name(int thread_id)
+{
+    return std::string("ut-rt-vrf") + std::to_string(thread_id);
+}
+
+/* Program/remove NAS_UT_RT_PER_THREAD blackhole routes 10.<thread>.x.y/32 in the VRF of the thread */
+static void nas_ut_rt_thread(int thread_id, bool is_add, int *failed)
+{
+    nas_os_rt_encode_buf_t buf;
+    std::string vrf_name = nas_ut_rt_vrf_name(thread_id);
+    char obj_buff[1024];
+
+    *failed = 0;
+    for (int ix = 0; ix < NAS_UT_RT_PER_THREAD; ++ix) {
+        cps_api_object_t obj = cps_api_object_init(obj_buff, sizeof(obj_buff));
+        uint32_t ip = htonl((10 << 24) | (thread_id << 16) | ix);
+
+        cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_VRF_NAME, vrf_name.c_str(), vrf_name.size()+1);
+        cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_AF, AF_INET);
+        cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX, &ip, sizeof(ip));
+        cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN, 32);
+        cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_SPECIAL_NEXT_HOP,
+                                    BASE_ROUTE_SPECIAL_NEXT_HOP_BLACKHOLE);
+
+        t_std_error rc = is_add ? nas_os_add_route_r(obj, &buf) : nas_os_del_route_r(obj, &buf);
+        if (rc != STD_ERR_OK) ++(*failed);
+    }
+}
+
+static int nas_ut_rt_kernel_count(int thread_id)
+{
+    std::string cmd = "ip netns exec " + nas_ut_rt_vrf_name(thread_id) +
+                      " ip route show type blackhole | grep -c \"10\\.\"";
+    int count = -1;
+    FILE *fp = popen(cmd.c_str(), "r");
+    if (fp == NULL) return count;
+    if (fscanf(fp, "%d", &count) != 1) count = -1;
+    pclose(fp);
+    return count;
+}
+
+/* Program the routes from n_threads threads and check every VRF got all of them */
+static void nas_ut_rt_run(int n_threads, bool is_add)
+{
+    std::vector<std::thread> threads;
+    std::vector<int> failed(n_threads, 0);
+
+    for (int ix = 0; ix < n_threads; ++ix) {
+        threads.push_back(std::thread(nas_ut_rt_thread, ix, is_add, &failed[ix]));
+    }
+    for (auto &t : threads) t.join();
+
+    for (int ix = 0; ix < n_threads; ++ix) {
+        EXPECT_EQ(failed[ix], 0) << "VRF " << nas_ut_rt_vrf_name(ix);
+        EXPECT_EQ(nas_ut_rt_kernel_count(ix), is_add ? NAS_UT_RT_PER_THREAD : 0)
+            << "VRF " << nas_ut_rt_vrf_name(ix);
+    }
+}
+
+static void nas_ut_rt_vrfs_cfg(bool is_add)
+{
+    for (int ix = 0; ix < NAS_UT_RT_MAX_THREADS; ++ix) {
+        std::string vrf_name = nas_ut_rt_vrf_name(ix);
+        if (is_add) system(("mkdir -p /etc/netns/" + vrf_name).c_str());
+        ASSERT_TRUE(nas_os_vrf_cfg(vrf_name.c_str(), is_add) == cps_api_ret_code_OK);
+        if (!is_add) system(("rmdir /etc/netns/" + vrf_name).c_str());
+    }
+}
+
+TEST(std_nas_route_test, nas_os_rt_multi_thread_stress) {
+    nas_ut_rt_vrfs_cfg(true);
+    nas_ut_rt_run(NAS_UT_RT_MAX_THREADS, true);
+    nas_ut_rt_run(NAS_UT_RT_MAX_THREADS, false);
+    nas_ut_rt_vrfs_cfg(false);
+}
+
+/* Routes of a VRF are not lost or leaked into another VRF whatever the thread count */
+TEST(std_nas_route_test, nas_os_rt_multi_thread_scaling) {
+    nas_ut_rt_vrfs_cfg(true);
+    for (int n_threads = 1; n_threads <= NAS_UT_RT_MAX_THREADS; n_threads *= 2) {
+        nas_ut_rt_run(n_threads, true);
+        for (int ix = n_threads; ix < NAS_UT_RT_MAX_THREADS; ++ix) {
+            ASSERT_EQ(nas_ut_rt_kernel_count(ix), 0) << "VRF " << nas_ut_rt_vrf_name(ix);
+        }
+        nas_ut_rt_run(n_threads, false);
+    }
+    nas_ut_rt_vrfs_cfg(false);
+}
+
+TEST(std_nas_route_test, nas_os_vrf_refresh_parallel) {
+    const size_t max_parallel = 2;
+    nas_ut_rt_vrfs_cfg(true);
+    os_refresh_max_parallel_set(max_parallel);
+    for (int ix = 0; ix < NAS_UT_RT_MAX_THREADS; ++ix) {
+        ASSERT_EQ(os_create_netlink_sock(nas_ut_rt_vrf_name(ix).c_str(), 1000 + ix), STD_ERR_OK);
+    }
+
+    /* Every VRF dumped once, never more VRFs than the limit at the same time */
+    for (int ix = 0; ix < NAS_UT_RT_MAX_THREADS; ++ix) {
+        os_refresh_vrf_stats_t stats = {};
+        for (int wait = 0; wait < 100; ++wait) {
+            if (os_refresh_vrf_stats_get(nas_ut_rt_vrf_name(ix).c_str(), &stats) &&
+                stats.pending == 0) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        EXPECT_EQ(stats.count, 1U) << "VRF " << nas_ut_rt_vrf_name(ix);
+        EXPECT_EQ(stats.pending, 0U) << "VRF " << nas_ut_rt_vrf_name(ix);
+    }
+    EXPECT_GE(os_refresh_active_max_get(), 1U);
+    EXPECT_LE(os_refresh_active_max_get(), max_parallel);
+
+    for (int ix = 0; ix < NAS_UT_RT_MAX_THREADS; ++ix) {
+        ASSERT_EQ(os_del_netlink_sock(nas_ut_rt_vrf_name(ix).c_str()), STD_ERR_OK);
+        os_refresh_vrf_stats_t stats;
+        ASSERT_FALSE(os_refresh_vrf_stats_get(nas_ut_rt_vrf_name(ix).c_str(), &stats));
+    }
+    os_refresh_max_parallel_set(4);
+    nas_ut_rt_vrfs_cfg(false);
+}
+
+/* Route 10.200.<id>.0/24 as published from the kernel, nh_count is the content */
+static cps_api_object_t nas_ut_snap_rt_obj(uint8_t id, uint32_t nh_count)
+{
+    cps_api_object_t obj = cps_api_object_create();
+    uint8_t prefix[4] = { 10, 200, id, 0 };
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_AF, AF_INET);
+    cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX, prefix, sizeof(prefix));
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN, 24);
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_NH_COUNT, nh_count);
+    return obj;
+}
+
+static bool nas_ut_snap_rt_track(const char *vrf_name, uint8_t id, uint32_t nh_count, bool del = false)
+{
+    cps_api_object_t obj = nas_ut_snap_rt_obj(id, nh_count);
+    if (del) cps_api_object_set_type_operation(cps_api_object_key(obj), cps_api_oper_DELETE);
+    bool rc = nas_os_snapshot_track(del ? RTM_DELROUTE : RTM_NEWROUTE, vrf_name, obj);
+    cps_api_object_delete(obj);
+    return rc;
+}
+
+TEST(std_nas_route_test, nas_os_snapshot_replay) {
+    const char *vrf_name = "ut-snap";
+    const char *file = "/tmp/nas_os_ut.snapshot";
+    nas_os_snapshot_stats_t stats;
+
+    /* The reconcile deletes and marker are published - a dumped VRF brings up the handle */
+    std::string dump_vrf = nas_ut_rt_vrf_name(0);
+    system(("mkdir -p /etc/netns/" + dump_vrf).c_str());
+    ASSERT_TRUE(nas_os_vrf_cfg(dump_vrf.c_str(), true) == cps_api_ret_code_OK);
+    ASSERT_EQ(os_create_netlink_sock(dump_vrf.c_str(), 1000), STD_ERR_OK);
+
+    /* First dump of the VRF: 1, 2, 3 and 6 */
+    nas_os_snapshot_vrf_add(vrf_name);
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 1, 1));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 2, 1));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 3, 1));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 6, 1));
+    nas_os_snapshot_vrf_synced(vrf_name);
+
+    /* Events after the reconcile update the snapshot: 1 changed, 4 added, 3 deleted */
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 1, 3));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 4, 1));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 3, 1, true));
+    ASSERT_EQ(os_del_netlink_sock(dump_vrf.c_str()), STD_ERR_OK);
+    ASSERT_EQ(nas_os_snapshot_save(file), STD_ERR_OK);
+
+    /* Restart: 1 and 4 unchanged since the save, 2 changed, 5 new, 6 gone */
+    nas_os_snapshot_vrf_del(vrf_name);
+    ASSERT_EQ(nas_os_snapshot_load(file), STD_ERR_OK);
+    ASSERT_FALSE(nas_ut_snap_rt_track(vrf_name, 1, 3));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 2, 2));
+    ASSERT_FALSE(nas_ut_snap_rt_track(vrf_name, 4, 1));
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 5, 1));
+    ASSERT_TRUE(nas_os_snapshot_vrf_stats_get(vrf_name, &stats));
+    ASSERT_EQ(stats.published, 2U);
+    ASSERT_EQ(stats.unchanged, 2U);
+    ASSERT_FALSE(stats.reconciled);
+
+    nas_os_snapshot_vrf_synced(vrf_name);
+    ASSERT_TRUE(nas_os_snapshot_vrf_stats_get(vrf_name, &stats));
+    ASSERT_EQ(stats.deleted, 1U);
+    ASSERT_TRUE(stats.reconciled);
+
+    /* Reconciled - nothing is suppressed any more */
+    ASSERT_TRUE(nas_ut_snap_rt_track(vrf_name, 1, 3));
+
+    nas_os_snapshot_vrf_del(vrf_name);
+    unlink(file);
+    ASSERT_TRUE(nas_os_vrf_cfg(dump_vrf.c_str(), false) == cps_api_ret_code_OK);
+    system(("rmdir /etc/netns/" + dump_vrf).c_str());
+}
+
+/* Route object with nh_count next hops carrying address, ifindex and weight */
+static cps_api_object_t nas_ut_rt_ecmp_obj(size_t nh_count)
+{
+    cps_api_object_t obj = cps_api_object_create();
+    uint32_t ip = htonl(0x0b000000);
+
+    cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_VRF_NAME, FIB_DEFAULT_VRF_NAME, sizeof(FIB_DEFAULT_VRF_NAME));
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_AF, AF_INET);
+    cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX, &ip, sizeof(ip));
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN, 24);
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_NH_COUNT, nh_count);
+
+    cps_api_attr_id_t ids[3] = { BASE_ROUTE_OBJ_ENTRY_NH_LIST, 0, 0 };
+    const int ids_len = sizeof(ids)/sizeof(*ids);
+    for (size_t ix = 0; ix < nh_count; ++ix) {
+        uint32_t nh = htonl(0x0c000000 | ix);
+        uint32_t ifindex = 100 + ix;
+        uint32_t weight = 1;
+        ids[1] = ix;
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+        cps_api_object_e_add(obj, ids, ids_len, cps_api_object_ATTR_T_BIN, &nh, sizeof(nh));
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFINDEX;
+        cps_api_object_e_add(obj, ids, ids_len, cps_api_object_ATTR_T_U32, &ifindex, sizeof(ifindex));
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT;
+        cps_api_object_e_add(obj, ids, ids_len, cps_api_object_ATTR_T_U32, &weight, sizeof(weight));
+    }
+    return obj;
+}
+
+TEST(std_nas_route_test, nas_os_rt_decode) {
+    static nas_os_rt_decoded_t rt;
+    const size_t nh_counts[] = { 1, 8, 64, 256 };
+
+    for (size_t nh_count : nh_counts) {
+        cps_api_object_t obj = nas_ut_rt_ecmp_obj(nh_count);
+
+        nas_os_rt_decode(obj, &rt);
+        ASSERT_TRUE(rt.prefix != NULL && rt.has_af && rt.has_prefix_len);
+        ASSERT_EQ(rt.nh_count, nh_count);
+        ASSERT_EQ(rt.nh_seen, nh_count);
+        for (size_t ix = 0; ix < nh_count; ++ix) {
+            ASSERT_TRUE(rt.nh[ix].addr != NULL);
+            ASSERT_EQ(*(const uint32_t *)rt.nh[ix].addr, htonl(0x0c000000 | ix));
+            ASSERT_TRUE(rt.nh[ix].has_ifindex && rt.nh[ix].has_weight);
+            ASSERT_EQ(rt.nh[ix].ifindex, 100 + ix);
+            ASSERT_TRUE(rt.nh[ix].if_name == NULL);
+
+            /* Same answer as the per next hop lookups done before the decoder */
+            cps_api_attr_id_t ids[3] = { BASE_ROUTE_OBJ_ENTRY_NH_LIST, ix, BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR };
+            ASSERT_EQ(rt.nh[ix].addr, cps_api_object_attr_data_bin(cps_api_object_e_get(obj, ids, 3)));
+        }
+        cps_api_object_delete(obj);
+    }
+}
+
+TEST(std_nas_route_test, nas_os_if_resolve_cache) {
+    nas_os_if_resolve_stats_t before, after;
+    hal_ifindex_t if_index = 0;
+
+    nas_os_if_resolve_stats_get(&before);
+    ASSERT_EQ(nas_os_if_resolve(FIB_DEFAULT_VRF_NAME, test_phy_intf_1, &if_index, NULL), STD_ERR_OK);
+    ASSERT_EQ(if_index, (hal_ifindex_t)if_nametoindex(test_phy_intf_1));
+    ASSERT_EQ(nas_os_if_resolve(FIB_DEFAULT_VRF_NAME, test_phy_intf_1, &if_index, NULL), STD_ERR_OK);
+    nas_os_if_resolve_stats_get(&after);
+    ASSERT_GE(after.hits, before.hits + 1);
+
+    /* A link delete drops the cached name */
+    nas_os_if_resolve_link_event(RTM_DELLINK, if_index, test_phy_intf_1);
+    nas_os_if_resolve_stats_get(&before);
+    ASSERT_EQ(nas_os_if_resolve(FIB_DEFAULT_VRF_NAME, test_phy_intf_1, &if_index, NULL), STD_ERR_OK);
+    nas_os_if_resolve_stats_get(&after);
+    ASSERT_EQ(after.misses, before.misses + 1);
+}
+
+#define NAS_UT_RT_BATCH 4U
+
+/* Blackhole route 10.250.0.<ix>/32 in the default VRF */
+static cps_api_object_t nas_ut_rt_batch_obj(size_t ix, cps_api_operation_types_t op)
+{
+    cps_api_object_t obj = cps_api_object_create();
+    uint32_t ip = htonl((10 << 24) | (250 << 16) | ix);
+
+    cps_api_object_set_type_operation(cps_api_object_key(obj), op);
+    cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_VRF_NAME, FIB_DEFAULT_VRF_NAME, sizeof(FIB_DEFAULT_VRF_NAME));
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_AF, AF_INET);
+    cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX, &ip, sizeof(ip));
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN, 32);
+    cps_api_object_attr_add_u32(obj, BASE_ROUTE_OBJ_ENTRY_SPECIAL_NEXT_HOP,
+                                BASE_ROUTE_SPECIAL_NEXT_HOP_BLACKHOLE);
+    return obj;
+}
+
+/* Kernel RTM_NEWROUTE of the route above, as received by the netlink thread */
+static struct nlmsghdr *nas_ut_rt_batch_kernel_msg(size_t ix, uint32_t metric, char *buff, size_t len)
+{
+    memset(buff, 0, len);
+
+    struct nlmsghdr *nlh = (struct nlmsghdr *)buff;
+    nlh->nlmsg_type = RTM_NEWROUTE;
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+
+    struct rtmsg *rm = (struct rtmsg *)NLMSG_DATA(nlh);
+    rm->rtm_family = AF_INET;
+    rm->rtm_dst_len = 32;
+    rm->rtm_table = RT_TABLE_MAIN;
+    rm->rtm_protocol = RTPROT_STATIC;
+    rm->rtm_scope = RT_SCOPE_NOWHERE;
+    rm->rtm_type = RTN_BLACKHOLE;
+
+    uint32_t ip = htonl((10 << 24) | (250 << 16) | ix);
+    struct rtattr *rta = (struct rtattr *)((char *)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+    rta->rta_type = RTA_DST;
+    rta->rta_len = RTA_LENGTH(sizeof(ip));
+    memcpy(RTA_DATA(rta), &ip, sizeof(ip));
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+    if (metric != 0) {
+        rta = (struct rtattr *)((char *)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+        rta->rta_type = RTA_PRIORITY;
+        rta->rta_len = RTA_LENGTH(sizeof(metric));
+        memcpy(RTA_DATA(rta), &metric, sizeof(metric));
+        nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+    }
+    return nlh;
+}
+
+static void nas_ut_rt_batch_kernel_event(size_t ix)
+{
+    char buff[256];
+    nas_os_rt_shadow_event(RTM_NEWROUTE, FIB_DEFAULT_VRF_NAME, nas_ut_rt_batch_kernel_msg(ix, 0, buff, sizeof(buff)));
+}
+
+static void nas_ut_rt_batch_run(cps_api_operation_types_t op, nas_os_rt_batch_stats_t *stats)
+{
+    nas_os_rt_encode_buf_t buf;
+    cps_api_object_t objs[NAS_UT_RT_BATCH];
+
+    for (size_t ix = 0; ix < NAS_UT_RT_BATCH; ++ix) objs[ix] = nas_ut_rt_batch_obj(ix, op);
+    ASSERT_EQ(nas_os_route_batch_r(objs, NAS_UT_RT_BATCH, &buf, stats), STD_ERR_OK);
+    for (size_t ix = 0; ix < NAS_UT_RT_BATCH; ++ix) cps_api_object_delete(objs[ix]);
+}
+
+TEST(std_nas_route_test, nas_os_rt_idempotent_batch) {
+    nas_os_rt_batch_stats_t stats;
+
+    nas_os_route_idempotent_mode_set(true);
+
+    /* Not known to be in the kernel - sent as is */
+    nas_ut_rt_batch_run(cps_api_oper_CREATE, &stats);
+    ASSERT_EQ(stats.added, NAS_UT_RT_BATCH);
+    ASSERT_EQ(stats.failed, 0);
+
+    /* Re-download once the kernel reported the routes - nothing sent */
+    for (size_t ix = 0; ix < NAS_UT_RT_BATCH; ++ix) nas_ut_rt_batch_kernel_event(ix);
+    nas_ut_rt_batch_run(cps_api_oper_CREATE, &stats);
+    ASSERT_EQ(stats.skipped, NAS_UT_RT_BATCH);
+    ASSERT_EQ(stats.added + stats.replaced, 0);
+
+    nas_ut_rt_batch_run(cps_api_oper_DELETE, &stats);
+    ASSERT_EQ(stats.deleted, NAS_UT_RT_BATCH);
+    ASSERT_EQ(stats.failed, 0);
+
+    nas_os_route_idempotent_mode_set(false);
+}
+
+TEST(std_nas_route_test, nas_os_rt_shadow_key) {
+    char buff[256];
+    nas_os_rt_shadow_stats_t stats;
+
+    nas_os_route_idempotent_mode_set(true);
+
+    /* Same prefix with another metric is another route */
+    nas_os_rt_shadow_event(RTM_NEWROUTE, FIB_DEFAULT_VRF_NAME, nas_ut_rt_batch_kernel_msg(0, 20, buff, sizeof(buff)));
+    ASSERT_EQ(nas_os_rt_shadow_check(FIB_DEFAULT_VRF_NAME, nas_ut_rt_batch_kernel_msg(0, 0, buff, sizeof(buff))),
+              NAS_OS_RT_SHADOW_UNKNOWN);
+    ASSERT_EQ(nas_os_rt_shadow_check(FIB_DEFAULT_VRF_NAME, nas_ut_rt_batch_kernel_msg(0, 20, buff, sizeof(buff))),
+              NAS_OS_RT_SHADOW_SAME);
+    /* Nor is the same route of another VRF */
+    ASSERT_EQ(nas_os_rt_shadow_check("ut-rt-vrf0", nas_ut_rt_batch_kernel_msg(0, 20, buff, sizeof(buff))),
+              NAS_OS_RT_SHADOW_UNKNOWN);
+    nas_os_rt_shadow_stats_get(&stats);
+    ASSERT_GE(stats.entries, 1U);
+
+    /* The view is not kept once the mode is off */
+    nas_os_route_idempotent_mode_set(false);
+    nas_os_rt_shadow_stats_get(&stats);
+    ASSERT_EQ(stats.entries, 0U);
+}
+
+TEST(std_nas_route_test, nas_os_nbr_bulk_refresh) {
+    nas_os_nbr_bulk_entry_t entries[3];
+    int err[3];
+    nas_os_nbr_bulk_result_t result;
+
+    memset(entries, 0, sizeof(entries));
+    for (size_t ix = 0; ix < 3; ++ix) {
+        entries[ix].if_index = if_nametoindex(test_phy_intf_1);
+        entries[ix].ip.af_index = HAL_INET4_FAMILY;
+        entries[ix].ip.u.v4_addr = htonl((7 << 24) | (9 << 16) | (1 << 8) | (ix + 10));
+        entries[ix].mac[0] = 0x00;
+        entries[ix].mac[1] = 0x09;
+        entries[ix].mac[5] = ix + 10;
+    }
+    ASSERT_EQ(nas_os_refresh_neighbor_bulk(entries, 3, 30, err, &result), STD_ERR_OK);
+    ASSERT_EQ(result.ok, 3);
+    ASSERT_EQ(result.failed, 0);
+
+    /* Per entry result of an unknown interface */
+    entries[1].if_index = 0x7fffffff;
+    ASSERT_NE(nas_os_resolve_neighbor_bulk(entries, 3, 0, err, &result), STD_ERR_OK);
+    ASSERT_EQ(result.ok, 2);
+    ASSERT_EQ(result.failed, 1);
+    ASSERT_EQ(err[1], ENODEV);
+    ASSERT_EQ(result.first_err, ENODEV);
+
+    std::string cmd = std::string("ip neigh flush dev ") + test_phy_intf_1 + " to 7.9.1.0/24";
+    if(system(cmd.c_str()));
+}
+
 TEST(std_nas_route_test, nas_os_verify_proxy_arp) {
     int val = 0;
     FILE * result = NULL;
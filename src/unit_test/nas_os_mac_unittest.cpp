@@ -19,12 +19,17 @@
 #include "std_error_codes.h"
 #include "ds_common_types.h"
 #include "cps_api_object.h"
+#include "private/nas_os_vlan_utils.h"
 
 #include <netinet/in.h>
 #include <linux/if_bridge.h>
 #include <net/if.h>
+#include <stdlib.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <thread>
+
 TEST(nas_os_mac_test,change_learning) {
 
     hal_ifindex_t index = if_nametoindex("e101-001-0");
@@ -32,6 +37,30 @@ TEST(nas_os_mac_test,change_learning) {
     ASSERT_EQ(nas_os_mac_change_learning(index,false), STD_ERR_OK);
 }
 
+TEST(nas_os_mac_test,set_learning_scope) {
+
+    hal_ifindex_t index = if_nametoindex("e101-001-0");
+    nas_os_mac_learn_result_t results[16];
+    size_t count = sizeof(results)/sizeof(results[0]);
+
+    ASSERT_EQ(nas_os_mac_set_learning(index,false,NAS_OS_MAC_LEARN_SCOPE_ALL,results,&count), STD_ERR_OK);
+    ASSERT_GE(count, 1);
+    ASSERT_EQ(results[0].ifindex, index);
+    ASSERT_EQ(results[0].rc, STD_ERR_OK);
+    ASSERT_FALSE(nas_os_mac_get_learning(index));
+
+    count = sizeof(results)/sizeof(results[0]);
+    ASSERT_EQ(nas_os_mac_set_learning(index,true,NAS_OS_MAC_LEARN_SCOPE_PORT,results,&count), STD_ERR_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_TRUE(nas_os_mac_get_learning(index));
+
+    ASSERT_EQ(nas_os_mac_set_learning(index,true,NAS_OS_MAC_LEARN_SCOPE_TAGGED,NULL,NULL), STD_ERR_OK);
+
+    /* Tagged scope leaves the learning state of the port itself alone */
+    nas_os_mac_set_learning(index,false,NAS_OS_MAC_LEARN_SCOPE_TAGGED,NULL,NULL);
+    ASSERT_TRUE(nas_os_mac_get_learning(index));
+}
+
 TEST(nas_os_mac_test,add_entry) {
     static char buff[10000];
 
@@ -71,6 +100,56 @@ TEST(nas_os_mac_test,add_entry) {
 
 }
 
+static t_std_error ut_mac_dynamic_add(hal_ifindex_t ifindex, const char *ifname, hal_vlan_id_t vid,
+                                      uint8_t *mac_addr) {
+    char buff[1024];
+    cps_api_object_t obj = cps_api_object_init(buff,sizeof(buff));
+    cps_api_object_set_type_operation(cps_api_object_key(obj),cps_api_oper_CREATE);
+    cps_api_object_attr_add_u16(obj,BASE_MAC_TABLE_VLAN,vid);
+    cps_api_object_attr_add(obj,BASE_MAC_TABLE_IFNAME,ifname,strlen(ifname)+1);
+    cps_api_object_attr_add_u32(obj,BASE_MAC_TABLE_IFINDEX,ifindex);
+    cps_api_object_attr_add(obj,BASE_MAC_TABLE_MAC_ADDRESS,(void *)mac_addr,6);
+    return nas_os_mac_update_entry(obj);
+}
+
+TEST(nas_os_mac_test,pending_mac_replay) {
+    ASSERT_EQ(nas_os_mac_init(), STD_ERR_OK);
+    ASSERT_EQ(system("ip link add br3999 type bridge && ip link add ut-mac-port type dummy && "
+                     "ip link set ut-mac-port master br3999 && ip link set ut-mac-port up && "
+                     "ip link set br3999 up"), 0);
+    hal_ifindex_t index = if_nametoindex("ut-mac-port");
+    ASSERT_NE(index, 0);
+
+    nas_os_mac_pending_stats_t base, stats;
+    nas_os_mac_pending_stats_get(&base);
+
+    /* Kernel rejects dynamic MACs on a blocking port - they are queued */
+    ASSERT_EQ(system("bridge link set dev ut-mac-port state 4"), 0);
+    uint8_t mac_addr[6]={0x00,0x02,0x03,0x04,0x05,0x10};
+    for (uint8_t ix = 0; ix < 4; ++ix) {
+        mac_addr[5] = 0x10 + ix;
+        ASSERT_EQ(ut_mac_dynamic_add(index,"ut-mac-port",3999,mac_addr), STD_ERR_OK);
+    }
+    nas_os_mac_pending_stats_get(&stats);
+    ASSERT_EQ(stats.parked - base.parked, 4U);
+    ASSERT_EQ(stats.depth - base.depth, 4U);
+
+    /* Forwarding transitions coalesce into one replay of the whole port */
+    ASSERT_EQ(system("bridge link set dev ut-mac-port state 3"), 0);
+    ASSERT_EQ(nas_os_mac_add_pending_mac_if_event(index), STD_ERR_OK);
+    ASSERT_EQ(nas_os_mac_add_pending_mac_if_event(index), STD_ERR_OK);
+    for (int ix = 0; ix < 100 && stats.depth != base.depth; ++ix) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        nas_os_mac_pending_stats_get(&stats);
+    }
+    ASSERT_EQ(stats.depth, base.depth);
+    ASSERT_EQ(stats.replayed - base.replayed, 4U);
+    ASSERT_EQ(stats.replays - base.replays, 1U);
+    ASSERT_EQ(stats.replay_failed, base.replay_failed);
+
+    ASSERT_EQ(system("ip link del ut-mac-port && ip link del br3999"), 0);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -5,6 +5,7 @@
 #include "dell-base-if.h"
 #include "dell-interface.h"
 #include "nas_os_vlan.h"
+#include "private/nas_os_vlan_utils.h"
 #include <netinet/in.h>
 #include <linux/if_bridge.h>
 #include <net/if.h>
@@ -27,6 +28,24 @@ TEST(nas_vlan_create, VLAN_OS_create) {
    std::cout <<"bridge20 created with index "<< idx << std::endl;
 }
 
+TEST(nas_vlan_create, VLAN_OS_tagged_intf_index) {
+   int br_idx = if_nametoindex("bridge20");
+   int port_idx = if_nametoindex("e101-001-0");
+   int vlan_idx = 0;
+   ASSERT_EQ(nas_os_t_port_to_vlan(20, "e101-001-0.20", port_idx, br_idx, &vlan_idx), STD_ERR_OK);
+
+   hal_ifindex_t idx = 0;
+   ASSERT_TRUE(nas_os_tagged_intf_get(port_idx, 20, &idx));
+   ASSERT_EQ(idx, vlan_idx);
+
+   hal_ifindex_t parent = 0;
+   hal_vlan_id_t vid = 0;
+   ASSERT_TRUE(nas_os_tagged_intf_parent_get(vlan_idx, &parent, &vid));
+   ASSERT_EQ(parent, port_idx);
+   ASSERT_EQ(vid, 20);
+   ASSERT_FALSE(nas_os_tagged_intf_get(port_idx, 21, &idx));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -0,0 +1,99 @@
+#!/usr/bin/python
+# Copyright (c) 2018 Dell Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may
+# not use this file except in compliance with the License. You may obtain
+# a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+# THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+# LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+# FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+#
+# See the Apache Version 2.0 License for specific language governing
+# permissions and limitations under the License.
+
+import struct
+
+import dn_base_mcast_snoop_utils as mc
+
+br_index = 100
+br_name = 'br100'
+port_index = 10
+port_name = 'e101-001-0'
+
+def nla(nla_type, payload):
+    nla_len = 4 + len(payload)
+    return struct.pack('=HH', nla_len, nla_type) + payload + '\0' * (((nla_len + 3) & ~3) - nla_len)
+
+def nlmsg(nl_type, body):
+    return struct.pack('=IHHII', mc.NLMSG_HDR_LEN + len(body), nl_type, 0, 0, 0) + body
+
+def link_msg(nl_type, ifindex, if_name):
+    body = struct.pack('=BxHiII', 0, 0, ifindex, 0, 0) + nla(mc.IFLA_IFNAME, if_name + '\0')
+    return nlmsg(nl_type, body)
+
+def mrouter_msg(nl_type, ifindex):
+    port = nla(mc.MDBA_ROUTER_PORT, struct.pack('=I', ifindex))
+    body = struct.pack('=B3xI', mc.AF_BRIDGE, br_index) + nla(mc.MDBA_ROUTER, port)
+    return nlmsg(nl_type, body)
+
+def cache_mgr(published):
+    mgr = mc.McastSnoopCacheMgr()
+    mgr.publish_event = lambda pub_set, op: published.extend([(item, op) for item in pub_set])
+    mgr.synced = True
+    return mgr
+
+def init_names():
+    mc._mdb_if_names.clear()
+    mc._mdb_if_names[br_index] = br_name
+    mc._mdb_if_names[port_index] = port_name
+
+def test_link_event_names():
+    init_names()
+    mgr = cache_mgr([])
+
+    # Same name - still cached
+    mgr.handle_event(link_msg(mc.RTM_NEWLINK, port_index, port_name))
+    assert mc._mdb_if_names.get(port_index) == port_name
+
+    # Renamed or deleted - looked up again on the next use
+    mgr.handle_event(link_msg(mc.RTM_NEWLINK, port_index, 'e101-002-0'))
+    assert port_index not in mc._mdb_if_names
+    mgr.handle_event(link_msg(mc.RTM_DELLINK, br_index, br_name))
+    assert br_index not in mc._mdb_if_names
+
+def test_mrouter_poll(monkeypatch):
+    published = []
+    mgr = cache_mgr(published)
+    mrouter = mc.McastRouterInfo(br_name, port_name)
+    dump = {'mrouter': set([mrouter]), 'group': set()}
+    monkeypatch.setattr(mc, '_mdb_dump', lambda br_name = None: dump)
+
+    assert mgr.update_mrouters()
+    assert published == [(mrouter, 'create')]
+    assert mgr.br_mrouter_map[br_name] == set([port_name])
+
+    # Unchanged - nothing published
+    del published[:]
+    assert mgr.update_mrouters()
+    assert published == []
+
+    dump['mrouter'] = set()
+    assert mgr.update_mrouters()
+    assert published == [(mrouter, 'delete')]
+
+def test_mrouter_event():
+    init_names()
+    published = []
+    mgr = cache_mgr(published)
+    assert not mgr.mrouter_events
+
+    # Kernel notifies the mrouter ports - short poll is no longer needed
+    mgr.handle_event(mrouter_msg(mc.RTM_NEWMDB, port_index))
+    assert mgr.mrouter_events
+    assert published == [(mc.McastRouterInfo(br_name, port_name), 'create')]
+
+    del published[:]
+    mgr.handle_event(mrouter_msg(mc.RTM_DELMDB, port_index))
+    assert published == [(mc.McastRouterInfo(br_name, port_name), 'delete')]